@@ -0,0 +1,12 @@
+#ifndef APP_H
+#define APP_H
+
+/**
+ * @brief Boots the firmware: USB, configuration, hardware, watchdog and
+ * registers all main loop tasks with the scheduler.
+ * @note main() calls sched_run() afterwards, the host simulator drives
+ * sched_run_once() itself.
+ */
+void app_init(void);
+
+#endif // APP_H
@@ -8,4 +8,23 @@
  */
 void cmd_handle_get_conf(void);
 
+/**
+ * @brief Handles the GET_SCHED command.
+ * @note Usage: GET_SCHED or GET_SCHED|RESET
+ * Sends scheduler loop budget and per task run-time accounting,
+ * RESET clears the counters after sending.
+ * @param args Optional argument after the '|' (may be NULL).
+ */
+void cmd_handle_get_sched(const char *args);
+
+/**
+ * @brief Handles the GET_MIDI_STATS command.
+ * @note Usage: GET_MIDI_STATS or GET_MIDI_STATS|RESET
+ * Sends the MIDI output counters
+ * (MIDI_STATS|events|coalesced|flushes|overflows|dropped),
+ * RESET clears them after sending.
+ * @param args Optional argument after the '|' (may be NULL).
+ */
+void cmd_handle_get_midi_stats(const char *args);
+
 #endif // CDC_CMD_READ_H
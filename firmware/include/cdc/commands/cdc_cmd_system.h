@@ -31,6 +31,36 @@ void cmd_handle_set_config_mode(const char *args);
  */
 void cmd_handle_set_oled_timeout(const char *args);
 
+/**
+ * @brief Handles the SET_KB_LAYOUT|layout command.
+ * @note Usage: SET_KB_LAYOUT|DE or SET_KB_LAYOUT|1
+ * Sets the host keyboard layout used for typing text (US, DE, PL, FR, UK,
+ * DVORAK).
+ * @param args Pointer to the argument (layout name or index).
+ */
+void cmd_handle_set_kb_layout(const char *args);
+
+/**
+ * @brief Handles the SET_UNICODE_TIMING|platform|mode|settle|key|commit
+ * command.
+ * @note Usage: SET_UNICODE_TIMING|0|0|15|2|2
+ * Tunes unicode input for one host (0-Linux, 1-Win, 2-Mac): mode
+ * (1 = macOS Unicode Hex Input), IME settle time, delay after every hex
+ * report and after the commit, in ms (0-255, 0 = USB pace only).
+ * @param args Pointer to the arguments.
+ */
+void cmd_handle_set_unicode_timing(const char *args);
+
+/**
+ * @brief Handles the SET_SEQ_TIMING|platform|hold|gap|mod command.
+ * @note Usage: SET_SEQ_TIMING|0|10|5|5
+ * Timing profile of key sequences for one host (0-Linux, 1-Win, 2-Mac):
+ * key hold time, pause after the key goes up and after a modifier
+ * change, in ms (0-255, 0 = USB pace only).
+ * @param args Pointer to the arguments.
+ */
+void cmd_handle_set_seq_timing(const char *args);
+
 /**
  * @brief Handles the BOOTSEL command.
  * @note Usage: BOOTSEL
@@ -38,4 +68,12 @@ void cmd_handle_set_oled_timeout(const char *args);
  */
 void cmd_handle_bootsel(void);
 
+/**
+ * @brief Handles the PROFILE command.
+ * @note Usage: PROFILE, PROFILE|RESET or PROFILE|STREAM|ms (0 stops)
+ * Requires a firmware built with TALOS_PROFILING.
+ * @param args Optional argument after the '|' (may be NULL).
+ */
+void cmd_handle_profile(const char *args);
+
 #endif // CDC_CMD_SYSTEM_H
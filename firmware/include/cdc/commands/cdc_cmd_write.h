@@ -16,10 +16,22 @@ void cmd_handle_set_macro(char *args);
  */
 void cmd_handle_set_layer_name(char *args);
 
+/**
+ * @brief Handles the SET_LAYER_COUNT|... command.
+ * Adds empty layers at the end or drops the last ones (their arena data is
+ * freed). Only existing layers are saved to flash.
+ * @note Usage: SET_LAYER_COUNT|count (1..MAX_LAYERS)
+ * @param args String with parameters.
+ */
+void cmd_handle_set_layer_count(char *args);
+
 /**
  * @brief Handles the SET_MACRO_SEQ|... command.
- * Parses and stores a macro key sequence.
- * @note Usage: SET_MACRO_SEQ|layer|button|count|step1|step2|...|stepN
+ * Parses and stores a macro key sequence in the arena. Sequences longer
+ * than one line come in chunks: offset is the index of the first step of
+ * the line, 0 (or no offset) starts a new sequence, the next chunk has to
+ * start at the end of the stored part.
+ * @note Usage: SET_MACRO_SEQ|layer|button|name|emoji|count|k,m,d,...[|offset]
  * @param args String with parameters separated by '|'.
  */
 void cmd_handle_set_macro_seq(char *args);
@@ -33,4 +45,36 @@ void cmd_handle_set_macro_seq(char *args);
  */
 void cmd_handle_set_macro_script(char *args);
 
+/**
+ * @brief Handles the SET_MACRO_PROG|... command.
+ * Stores MACRO_TYPE_PROGRAM bytecode (see macro_vm.h) in the arena, longer
+ * programs come in several chunks: offset 0 starts a new program, the
+ * next chunk has to start at the end of the stored part.
+ * @note Usage: SET_MACRO_PROG|layer|button|offset|hexbytes
+ * @param args String with parameters separated by '|'.
+ */
+void cmd_handle_set_macro_prog(char *args);
+
+/**
+ * @brief Handles the REC_START|layer|button command.
+ * Starts record mode, the companion then sends REC_KEY events.
+ * @param args String with parameters separated by '|'.
+ */
+void cmd_handle_rec_start(char *args);
+
+/**
+ * @brief Handles the REC_KEY|down|keycode|delta_ms command.
+ * One recorded key event (down 1/0, HID keycode, 0xE0-0xE7 modifiers,
+ * time since the previous event).
+ * @param args String with parameters separated by '|'.
+ */
+void cmd_handle_rec_key(char *args);
+
+/**
+ * @brief Handles the REC_STOP command.
+ * Compresses the recording into a MACRO_TYPE_PROGRAM and saves it to
+ * flash, replies OK|program_bytes.
+ */
+void cmd_handle_rec_stop(void);
+
 #endif // CDC_CMD_WRITE_H
@@ -0,0 +1,200 @@
+#ifndef CONFIG_MIGRATE_H
+#define CONFIG_MIGRATE_H
+
+#include "macro_config.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// ==================== UKLAD WERSJI 1 ====================
+// konfiguracja bez pola version: skrypt i sekwencje w makrze, CRC za makrami
+// (liczone od poczatku struktury)
+#define CONFIG_V1_LAYERS 4
+#define CONFIG_V1_SEQUENCE_STEPS 5
+
+typedef struct {
+  macro_type_t type;
+  uint16_t value;
+  int16_t move_x;
+  int16_t move_y;
+  uint16_t repeat_count;
+  uint16_t repeat_interval;
+  char macro_string[MACRO_STRING_LEN];
+  char name[MAX_NAME_LEN];
+  uint8_t emoji_index;
+  char script[MAX_SCRIPT_SIZE];
+  uint8_t script_platform;
+  key_step_t terminal_shortcut[CONFIG_V1_SEQUENCE_STEPS];
+  uint8_t terminal_shortcut_length;
+  key_step_t sequence[CONFIG_V1_SEQUENCE_STEPS];
+  uint8_t sequence_length;
+} macro_entry_v1_t;
+
+typedef struct {
+  char layer_names[CONFIG_V1_LAYERS][MAX_NAME_LEN];
+  uint8_t layer_emojis[CONFIG_V1_LAYERS];
+  macro_entry_v1_t macros[CONFIG_V1_LAYERS][NUM_BUTTONS];
+  uint32_t crc32;
+  uint8_t global_text_platform;
+  uint32_t oled_timeout_s;
+} config_v1_t;
+
+// ==================== UKLAD WERSJI 2 ====================
+// CRC i wersja na poczatku, uklad klawiatury za ustawieniami
+typedef struct {
+  uint32_t crc32;
+  uint16_t version;
+  char layer_names[CONFIG_V1_LAYERS][MAX_NAME_LEN];
+  uint8_t layer_emojis[CONFIG_V1_LAYERS];
+  macro_entry_v1_t macros[CONFIG_V1_LAYERS][NUM_BUTTONS];
+  uint8_t global_text_platform;
+  uint32_t oled_timeout_s;
+  uint8_t kb_layout;
+} config_v2_t;
+
+// ==================== UKLAD WERSJI 3 ====================
+// wersja 2 + czasy wprowadzania unicode
+typedef struct {
+  uint32_t crc32;
+  uint16_t version;
+  char layer_names[CONFIG_V1_LAYERS][MAX_NAME_LEN];
+  uint8_t layer_emojis[CONFIG_V1_LAYERS];
+  macro_entry_v1_t macros[CONFIG_V1_LAYERS][NUM_BUTTONS];
+  uint8_t global_text_platform;
+  uint32_t oled_timeout_s;
+  uint8_t kb_layout;
+  unicode_timing_t unicode_timing[UNICODE_PLATFORMS];
+} config_v3_t;
+
+// ==================== UKLAD WERSJI 4 ====================
+// wersja 3 + arena programow (jeden slot na makro, bez wyrownania)
+#define CONFIG_V4_ARENA_SIZE 4096
+
+typedef struct {
+  uint16_t used;
+  arena_ref_t refs[CONFIG_V1_LAYERS][NUM_BUTTONS];
+  uint8_t data[CONFIG_V4_ARENA_SIZE];
+} macro_arena_v4_t;
+
+typedef struct {
+  uint32_t crc32;
+  uint16_t version;
+  char layer_names[CONFIG_V1_LAYERS][MAX_NAME_LEN];
+  uint8_t layer_emojis[CONFIG_V1_LAYERS];
+  macro_entry_v1_t macros[CONFIG_V1_LAYERS][NUM_BUTTONS];
+  uint8_t global_text_platform;
+  uint32_t oled_timeout_s;
+  uint8_t kb_layout;
+  unicode_timing_t unicode_timing[UNICODE_PLATFORMS];
+  macro_arena_v4_t arena;
+} config_v4_t;
+
+// ==================== UKLAD WERSJI 5 ====================
+// sekwencje i skroty terminala w arenie (wyrownanej, trzy sloty na makro)
+#define CONFIG_V5_ARENA_SIZE 8192
+#define CONFIG_V5_ARENA_SLOTS 3
+
+typedef struct {
+  macro_type_t type;
+  uint16_t value;
+  int16_t move_x;
+  int16_t move_y;
+  uint16_t repeat_count;
+  uint16_t repeat_interval;
+  char macro_string[MACRO_STRING_LEN];
+  char name[MAX_NAME_LEN];
+  uint8_t emoji_index;
+  char script[MAX_SCRIPT_SIZE];
+  uint8_t script_platform;
+} macro_entry_v5_t;
+
+typedef struct {
+  uint32_t used;
+  arena_ref_t refs[CONFIG_V1_LAYERS][NUM_BUTTONS][CONFIG_V5_ARENA_SLOTS];
+  uint8_t data[CONFIG_V5_ARENA_SIZE];
+} macro_arena_v5_t;
+
+typedef struct {
+  uint32_t crc32;
+  uint16_t version;
+  char layer_names[CONFIG_V1_LAYERS][MAX_NAME_LEN];
+  uint8_t layer_emojis[CONFIG_V1_LAYERS];
+  macro_entry_v5_t macros[CONFIG_V1_LAYERS][NUM_BUTTONS];
+  uint8_t global_text_platform;
+  uint32_t oled_timeout_s;
+  uint8_t kb_layout;
+  unicode_timing_t unicode_timing[UNICODE_PLATFORMS];
+  macro_arena_v5_t arena;
+} config_v5_t;
+
+// ==================== UKLAD WERSJI 6 I 7 ====================
+// wersja 5 + czasy sekwencji klawiszy (7: skrypty moga byc spakowane LZSS)
+typedef struct {
+  uint32_t crc32;
+  uint16_t version;
+  char layer_names[CONFIG_V1_LAYERS][MAX_NAME_LEN];
+  uint8_t layer_emojis[CONFIG_V1_LAYERS];
+  macro_entry_v5_t macros[CONFIG_V1_LAYERS][NUM_BUTTONS];
+  uint8_t global_text_platform;
+  uint32_t oled_timeout_s;
+  uint8_t kb_layout;
+  unicode_timing_t unicode_timing[UNICODE_PLATFORMS];
+  macro_arena_v5_t arena;
+  seq_timing_t seq_timing[UNICODE_PLATFORMS];
+} config_v6_t;
+
+// ==================== UKLAD WERSJI 8 ====================
+// skrypty w arenie (czwarty slot), stale cztery warstwy, odwolania w arenie
+#define CONFIG_V8_ARENA_SIZE 24576
+#define CONFIG_V8_ARENA_SLOTS 4
+
+typedef struct {
+  macro_type_t type;
+  uint16_t value;
+  int16_t move_x;
+  int16_t move_y;
+  uint16_t repeat_count;
+  uint16_t repeat_interval;
+  char macro_string[MACRO_STRING_LEN];
+  char name[MAX_NAME_LEN];
+  uint8_t emoji_index;
+  uint8_t script_platform;
+} macro_entry_v8_t;
+
+typedef struct {
+  uint32_t used;
+  arena_ref_t refs[CONFIG_V1_LAYERS][NUM_BUTTONS][CONFIG_V8_ARENA_SLOTS];
+  uint8_t data[CONFIG_V8_ARENA_SIZE];
+} macro_arena_v8_t;
+
+typedef struct {
+  uint32_t crc32;
+  uint16_t version;
+  char layer_names[CONFIG_V1_LAYERS][MAX_NAME_LEN];
+  uint8_t layer_emojis[CONFIG_V1_LAYERS];
+  macro_entry_v8_t macros[CONFIG_V1_LAYERS][NUM_BUTTONS];
+  uint8_t global_text_platform;
+  uint32_t oled_timeout_s;
+  uint8_t kb_layout;
+  unicode_timing_t unicode_timing[UNICODE_PLATFORMS];
+  macro_arena_v8_t arena;
+  seq_timing_t seq_timing[UNICODE_PLATFORMS];
+} config_v8_t;
+
+typedef enum {
+  CONFIG_MIGRATE_UNKNOWN = 0, // no known older layout (or its CRC is wrong)
+  CONFIG_MIGRATE_OK,          // config_get() holds all of the old data
+  CONFIG_MIGRATE_NO_SPACE     // some scripts or programs did not fit the arena
+} config_migrate_result_t;
+
+/**
+ * @brief Loads a configuration saved in an older layout into config_get().
+ * Layers, macros and their scripts, sequences and programs are kept, fields
+ * the old layout did not have get their factory defaults.
+ * @param flash Start of the saved configuration (XIP).
+ * @param version Receives the layout version of the old data.
+ * @return CONFIG_MIGRATE_NO_SPACE leaves config_get() with the data that fit.
+ */
+config_migrate_result_t config_migrate(const uint8_t *flash,
+                                       uint16_t *version);
+
+#endif // CONFIG_MIGRATE_H
@@ -47,7 +47,8 @@ static const uint8_t emoji_bitmaps[21][8] = {
 };
 
 #define MAX_EMOJIS 21
-static const char *emoji_strings[MAX_EMOJIS] = {
+// text form of each bitmap, not every includer uses it
+static const char *emoji_strings[MAX_EMOJIS] __attribute__((unused)) = {
     "🎮", "💼", "🏠", "🔧", "⚡", "📧", "💻", "🎵", "📝", "☕", "🗡️",
     "❤️",  "🔔", "🧪", "🔒", "☂️",  "🦕", "👻", "🔫", "⏳", "🌷"};
 
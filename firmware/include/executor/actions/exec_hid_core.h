@@ -32,11 +32,14 @@ void send_key_with_modifiers(uint8_t modifiers, uint8_t keycode,
 void press_sequence(uint8_t modifiers, uint8_t keycode);
 
 /**
- * @brief Executes a sequence of key steps.
- * @param sequence Pointer to an array of key steps.
+ * @brief Executes a sequence of key steps with the minimal report
+ * sequence (modifiers down, key down, key up, modifiers up) and the
+ * seq_timing profile of the host. Adjacent steps with the same modifiers
+ * keep them held, a step duration is an extra wait after the step.
+ * @param sequence Pointer to an array of key steps (arena, any length).
  * @param len Length of the key steps array.
  */
-void exec_key_sequence(const key_step_t *sequence, uint8_t len);
+void exec_key_sequence(const key_step_t *sequence, uint16_t len);
 
 /**
  * @brief Repeats a key press a specified number of times with a given interval.
@@ -55,4 +58,16 @@ void exec_key_repeat(uint8_t keycode, uint16_t count, uint16_t interval);
  */
 void exec_key_repeat_fast(uint8_t keycode, uint16_t count, uint16_t interval);
 
+/**
+ * @brief Stores the keyboard LED state the host sent (SET_REPORT of the
+ * keyboard report, bit 0 Num Lock, bit 1 Caps Lock).
+ * @param leds LED bitmask.
+ */
+void hid_host_leds_set(uint8_t leds);
+
+/**
+ * @brief Number of keyboard LED changes the host sent so far.
+ */
+uint32_t hid_host_led_changes(void);
+
 #endif // EXEC_HID_CORE_H
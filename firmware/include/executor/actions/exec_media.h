@@ -0,0 +1,27 @@
+#ifndef EXEC_MEDIA_H
+#define EXEC_MEDIA_H
+
+#include <stdint.h>
+
+// System Control report values (TUD_HID_REPORT_DESC_SYSTEM_CONTROL)
+#define SYSTEM_KEY_POWER_DOWN 1
+#define SYSTEM_KEY_SLEEP 2
+#define SYSTEM_KEY_WAKE_UP 3
+
+/**
+ * @brief Taps a Consumer Control key (report ID 4): volume, mute,
+ * play/pause, next/previous track, brightness.
+ * @param usage Consumer page usage (e.g. 0x00E9 volume up).
+ * @param count Number of taps (0 = 1).
+ * @param interval Interval in milliseconds between taps.
+ * @note One press and one release report per tap, no script or terminal.
+ */
+void exec_consumer_key(uint16_t usage, uint16_t count, uint16_t interval);
+
+/**
+ * @brief Taps a System Control key (report ID 5).
+ * @param code SYSTEM_KEY_POWER_DOWN, SYSTEM_KEY_SLEEP or SYSTEM_KEY_WAKE_UP.
+ */
+void exec_system_key(uint8_t code);
+
+#endif // EXEC_MEDIA_H
@@ -1,15 +1,20 @@
 #ifndef EXEC_MIDI_CORE_H
 #define EXEC_MIDI_CORE_H
 
+#include <stdbool.h>
 #include <stdint.h>
 
 /**
- * @brief Sends a MIDI Note On followed by Note Off.
+ * @brief Sends a MIDI Note On, the Note Off follows later (midi_voice.h).
  * @param note MIDI Note number (0-127).
  * @param velocity Note velocity (0-127).
  * @param channel MIDI Channel (1-16).
+ * @param gate_ms Note length in ms, 0 = while the key is held.
+ * @param button Key that plays the note.
+ * @note Does not block, notes of several keys overlap.
  */
-void exec_midi_note(uint8_t note, uint8_t velocity, uint8_t channel);
+void exec_midi_note(uint8_t note, uint8_t velocity, uint8_t channel,
+                    uint16_t gate_ms, uint8_t button);
 
 /**
  * @brief Sends a MIDI Control Change message.
@@ -19,4 +24,17 @@ void exec_midi_note(uint8_t note, uint8_t velocity, uint8_t channel);
  */
 void exec_midi_cc(uint8_t controller, uint8_t value, uint8_t channel);
 
+/**
+ * @brief Sends or ramps a 7-bit, 14-bit or NRPN controller (midi_cc.h).
+ * @param mode Controller number and MIDI_CC_* bits (macro value).
+ * @param value Value or ramp target (0-127, 0-16383 for 14-bit / NRPN).
+ * @param channel MIDI Channel (1-16).
+ * @param param NRPN parameter number (0-16383).
+ * @param ramp_ms Ramp time of the whole range, 0 = default.
+ * @param button Key that holds the ramp.
+ * @return true if a ramp started, it stops when the key is released.
+ */
+bool exec_midi_controller(uint16_t mode, uint16_t value, uint8_t channel,
+                          uint16_t param, uint16_t ramp_ms, uint8_t button);
+
 #endif // EXEC_MIDI_CORE_H
@@ -17,12 +17,26 @@ void exec_mouse_click(uint8_t buttons, uint16_t count, uint16_t interval,
  * @brief Moves the mouse cursor.
  * @param total_x Total distance to move in the X direction.
  * @param total_y Total distance to move in the Y direction.
- * @param count Number of steps to divide the movement into.
- * @param interval Interval in milliseconds between each movement step.
+ * @param count Number of times to repeat the move (0 = until cancelled).
+ * @param interval Interval in milliseconds between repetitions.
+ * @param motion_value Curve, speed and bend of the path (mouse_motion.h).
  * @param trigger_btn Button that triggered the action (for cancellation).
+ * @note The move is sent at the full HID poll rate with sub-pixel
+ * accumulation, both axes stay proportional along the whole path.
  */
 void exec_mouse_move(int16_t total_x, int16_t total_y, uint16_t count,
-                     uint16_t interval, uint8_t trigger_btn);
+                     uint16_t interval, uint16_t motion_value,
+                     uint8_t trigger_btn);
+
+/**
+ * @brief Places the cursor at absolute screen coordinates with one report
+ * of the digitizer interface (report ID 3), then optionally clicks there.
+ * @param x Horizontal position, 0 (left) to ABS_MOUSE_MAX (right, macro_config.h).
+ * @param y Vertical position, 0 (top) to ABS_MOUSE_MAX (bottom).
+ * @param buttons Mouse buttons to click at the position (0 = move only).
+ * @note Not affected by host pointer acceleration.
+ */
+void exec_mouse_move_abs(int16_t x, int16_t y, uint8_t buttons);
 
 /**
  * @brief Scrolls the mouse wheel.
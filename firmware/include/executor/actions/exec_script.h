@@ -4,15 +4,30 @@
 #include "macro_config.h"
 #include <stdint.h>
 
+// terminal handshake: a typed probe writes the sentinel to the CDC port (or
+// toggles Num Lock when the port is not accessible) once the shell runs
+#define SCRIPT_READY_SENTINEL "TALOS_READY"
+#define SCRIPT_READY_SETTLE_MS 300   // after the terminal shortcut
+#define SCRIPT_READY_PROBE_MS 1500   // no answer -> cancel, probe again
+#define SCRIPT_READY_TIMEOUT_MS 5000 // no answer at all -> type anyway
+
+// SCRIPT_DELIVERY_CDC: a typed one-liner reads the script from the CDC port
+#define SCRIPT_PULL_REQUEST "GET_SCRIPT" // line the bootstrap sends
+#define SCRIPT_PULL_END "SCRIPT_END"     // line after the script body
+#define SCRIPT_PULL_TIMEOUT_MS 4000      // no request -> the script is typed
+
 /**
  * @brief Executes a script by opening a terminal and typing commands.
  * This function encapsulates the logic from the MACRO_TYPE_SCRIPT case.
- * @param script Script content to be typed.
- * @param platform Platform (0=Linux, 1=Win, 2=Mac).
+ * Typing starts when the shell answers the ready probe.
+ * @param script Stored script (arena blob, text or packed, decoded while it
+ * is typed or sent, see script_codec.h).
+ * @param platform Platform (0=Linux, 1=Win, 2=Mac), with SCRIPT_DELIVERY_CDC
+ * only a bootstrap is typed and the body goes over the CDC port.
  * @param shortcut Array of key steps for the terminal shortcut.
  * @param shortcut_len Length of the shortcut array.
  */
 void exec_script(const char *script, uint8_t platform,
-                 const key_step_t *shortcut, uint8_t shortcut_len);
+                 const key_step_t *shortcut, uint16_t shortcut_len);
 
 #endif // EXEC_SCRIPT_H
@@ -13,27 +13,16 @@
 void send_unicode(uint8_t platform, uint32_t codepoint);
 
 /**
- * @brief Checks if a string contains only pure ASCII characters.
- * @param str Input string to check.
- * @return true if the string is pure ASCII, false otherwise.
- */
-bool is_pure_ascii(const char *str);
-
-/**
- * @brief Types text quickly assuming it is pure ASCII.
- * @param text ASCII text to type.
- */
-void type_text_turbo_ascii(const char *text);
-
-/**
- * @brief Types text content considering platform-specific methods.
+ * @brief Types text live (compiled one character at a time), keys of the
+ * active host layout or platform-specific unicode input.
  * @param text Text to type.
  * @param platform Target platform (0-Linux, 1-Win, 2-Mac).
  */
 void type_text_content(const char *text, uint8_t platform);
 
 /**
- * @brief Automatically types text, optimizing for pure ASCII when possible.
+ * @brief Types text on the detected platform, used when the macro has no
+ * cached report stream (see text_stream.h).
  * @param text Text to type.
  */
 void exec_type_text_auto(const char *text);
@@ -0,0 +1,49 @@
+#ifndef MACRO_RECORDER_H
+#define MACRO_RECORDER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Record mode: a host companion feeds key events with their timing over
+// CDC (REC_KEY), the recorder compresses them into a MACRO_TYPE_PROGRAM
+// (macro_vm.h). Delays are quantized to REC_QUANTUM_MS, identical taps in
+// a row become one VM_OP_LOOP.
+#define REC_MAX_PROGRAM 2048 // bytes of one recording
+#define REC_QUANTUM_MS 5     // delay resolution (jitter of a human typist)
+
+/**
+ * @brief Starts recording into the program of a macro.
+ * @param layer Target layer.
+ * @param button Target button.
+ * @return false if the target is invalid or a recording is running.
+ */
+bool recorder_start(uint8_t layer, uint8_t button);
+
+/**
+ * @brief Adds one key event.
+ * @param down true for a press, false for a release.
+ * @param keycode HID keycode, 0xE0-0xE7 are the modifiers.
+ * @param delta_ms Time since the previous event.
+ * @return false if nothing is recorded or the program is full.
+ */
+bool recorder_feed(bool down, uint8_t keycode, uint32_t delta_ms);
+
+/**
+ * @brief Ends the recording, stores the program in the arena and saves
+ * the configuration to flash.
+ * @param len Receives the program length (may be NULL).
+ * @return false if nothing was recorded or the arena is full.
+ */
+bool recorder_stop(uint16_t *len);
+
+/**
+ * @brief Drops the recording, the macro stays unchanged.
+ */
+void recorder_cancel(void);
+
+/**
+ * @brief true while recording.
+ */
+bool recorder_active(void);
+
+#endif // MACRO_RECORDER_H
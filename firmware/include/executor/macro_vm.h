@@ -0,0 +1,90 @@
+#ifndef MACRO_VM_H
+#define MACRO_VM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// MACRO_TYPE_PROGRAM bytecode (stored in the arena, ARENA_SLOT_PROGRAM).
+// One opcode byte, then its operands; 16-bit operands are little endian.
+//   VM_OP_END                      end of program (also end of the blob)
+//   VM_OP_KEY_DOWN key mods        key and modifiers go down (held)
+//   VM_OP_KEY_UP key mods          key and modifiers go up
+//   VM_OP_TAP key mods             press + release
+//   VM_OP_TEXT len bytes[len]      type UTF-8 text (host layout / unicode)
+//   VM_OP_MOUSE_BUTTON buttons     mouse buttons held (0 = released)
+//   VM_OP_MOUSE_MOVE dx dy         relative move (int8 each)
+//   VM_OP_MOUSE_WHEEL delta        wheel (int8)
+//   VM_OP_MIDI status d1 d2        raw 3 byte MIDI message
+//   VM_OP_DELAY ms16               wait
+//   VM_OP_LOOP count16             repeat until VM_OP_END_LOOP, 0 = until
+//                                  the button is pressed again
+//   VM_OP_END_LOOP
+//   VM_OP_LAYER layer              switch layer (VM_LAYER_NEXT = cycle)
+//   VM_OP_WAIT_RELEASE             wait until the trigger button is released
+//   VM_OP_IF_HELD skip16           skip forward unless the button is held
+//   VM_OP_IF_PLATFORM os skip16    skip forward unless the host is os
+//   VM_OP_JUMP skip16              skip forward (else branches)
+//   VM_OP_SYNC grid16              wait for the next MIDI clock grid line
+//                                  (ticks, 24 = beat), one grid at the last
+//                                  tempo when no clock is running
+#define VM_OP_END 0x00
+#define VM_OP_KEY_DOWN 0x01
+#define VM_OP_KEY_UP 0x02
+#define VM_OP_TAP 0x03
+#define VM_OP_TEXT 0x04
+#define VM_OP_MOUSE_BUTTON 0x05
+#define VM_OP_MOUSE_MOVE 0x06
+#define VM_OP_MOUSE_WHEEL 0x07
+#define VM_OP_MIDI 0x08
+#define VM_OP_DELAY 0x09
+#define VM_OP_LOOP 0x0A
+#define VM_OP_END_LOOP 0x0B
+#define VM_OP_LAYER 0x0C
+#define VM_OP_WAIT_RELEASE 0x0D
+#define VM_OP_IF_HELD 0x0E
+#define VM_OP_IF_PLATFORM 0x0F
+#define VM_OP_JUMP 0x10
+#define VM_OP_SYNC 0x11
+
+#define VM_LAYER_NEXT 0xFF
+
+#define VM_MAX_LOOP_DEPTH 4 // nested loops
+#define VM_TICK_BUDGET 16   // instructions per scheduler pass
+
+/**
+ * @brief Starts the program of a macro in the background. Pressing the
+ * button of the running program again stops it, another program replaces
+ * it.
+ * @param layer Layer index.
+ * @param button Button index (trigger for waits, conditions and cancel).
+ * @return false if the macro has no program.
+ */
+bool macro_vm_start(uint8_t layer, uint8_t button);
+
+/**
+ * @brief Stops the running program and releases everything it holds.
+ */
+void macro_vm_stop(void);
+
+/**
+ * @brief true while a program is running.
+ */
+bool macro_vm_running(void);
+
+/**
+ * @brief Scheduler task: runs up to VM_TICK_BUDGET instructions, never
+ * blocks (waits for delays and the HID endpoint across passes).
+ */
+void macro_vm_task(void);
+
+/**
+ * @brief Checks a program before it runs (macro_vm_start): known opcodes,
+ * operands inside the program, jumps forward inside the program, balanced
+ * loops. Chunked uploads are not checked, the last chunk is not marked.
+ * @param code Program bytes.
+ * @param len Program length.
+ * @return Offset of the first bad instruction or -1 if the program is valid.
+ */
+int macro_vm_verify(const uint8_t *code, uint16_t len);
+
+#endif // MACRO_VM_H
@@ -0,0 +1,87 @@
+#ifndef MIDI_CC_H
+#define MIDI_CC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Continuous controller engine: 7-bit CC, 14-bit CC (MSB + LSB pair) and
+// NRPN, either one value per press or a ramp that moves while the key is
+// held. The last value of each controller is remembered, so two keys
+// ramping up and down act as a fader. Output is limited per millisecond to
+// what the MIDI TX FIFO takes without blocking; a ramp sends its newest
+// value only, intermediate ones are skipped when the budget runs out.
+#define MIDI_CC_MAX_STATES 16        // remembered controller values
+#define MIDI_CC_DEFAULT_RAMP_MS 1000 // full range ramp time (interval 0)
+
+// MACRO_TYPE_MIDI_CC value: bits 0-6 controller, 8-9 resolution,
+// 10-11 curve, 12 ramp while held
+#define MIDI_CC_CONTROLLER_MASK 0x007F
+#define MIDI_CC_RES_SHIFT 8
+#define MIDI_CC_CURVE_SHIFT 10
+#define MIDI_CC_RAMP (1 << 12)
+
+typedef enum {
+  MIDI_CC_RES_7BIT = 0,  // one CC message
+  MIDI_CC_RES_14BIT = 1, // controller 0-31 (MSB) + controller 32-63 (LSB)
+  MIDI_CC_RES_NRPN = 2,  // CC 99/98 parameter, CC 6/38 data entry
+} midi_cc_res_t;
+
+typedef enum {
+  MIDI_CC_CURVE_LINEAR = 0,
+  MIDI_CC_CURVE_EXP = 1, // slow start, fine control near the start value
+  MIDI_CC_CURVE_LOG = 2, // fast start, slows down toward the target
+} midi_cc_curve_t;
+
+typedef struct {
+  uint8_t channel;    // 0-15
+  uint8_t resolution; // midi_cc_res_t
+  uint8_t controller; // CC number (MSB controller for 14-bit)
+  uint16_t param;     // NRPN parameter number (0-16383)
+} midi_cc_dest_t;
+
+/**
+ * @brief Forgets all ramps and remembered values (no MIDI is sent).
+ */
+void midi_cc_init(void);
+
+/**
+ * @brief Largest value of a resolution (127 or 16383).
+ */
+uint16_t midi_cc_max(uint8_t resolution);
+
+/**
+ * @brief Sends one value right away and remembers it.
+ * @param dest Controller.
+ * @param value Value, clamped to midi_cc_max().
+ */
+void midi_cc_set(const midi_cc_dest_t *dest, uint16_t value);
+
+/**
+ * @brief Starts moving a controller from its last value toward a target,
+ * the key LED is on while the ramp moves.
+ * @param button Key that holds the ramp, its release stops it.
+ * @param dest Controller.
+ * @param target Value where the ramp ends.
+ * @param curve midi_cc_curve_t.
+ * @param full_ms Time for the whole range, 0 = MIDI_CC_DEFAULT_RAMP_MS.
+ */
+void midi_cc_ramp(uint8_t button, const midi_cc_dest_t *dest, uint16_t target,
+                  uint8_t curve, uint16_t full_ms);
+
+/**
+ * @brief Stops the ramp of a released key at its current value.
+ * @param button Released key.
+ */
+void midi_cc_release(uint8_t button);
+
+/**
+ * @brief Last value sent to a controller (0 if never sent).
+ */
+uint16_t midi_cc_value(const midi_cc_dest_t *dest);
+
+/**
+ * @brief Scheduler task, advances the ramps within the output budget.
+ */
+void midi_cc_task(void);
+
+#endif // MIDI_CC_H
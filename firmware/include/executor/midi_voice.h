@@ -0,0 +1,53 @@
+#ifndef MIDI_VOICE_H
+#define MIDI_VOICE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// MIDI voice scheduler: Note On goes out right away, the matching Note Off
+// either waits in a timer wheel (gate length) or for the release of the key
+// that started the note (gate 0). Notes of different keys overlap freely.
+#define MIDI_MAX_VOICES 16     // notes sounding at the same time
+#define MIDI_WHEEL_SLOTS 32    // timer wheel slots, one per millisecond
+#define MIDI_VOICE_NO_BUTTON 0xFF
+
+/**
+ * @brief Clears all voices (no MIDI is sent).
+ */
+void midi_voice_init(void);
+
+/**
+ * @brief Starts a note without blocking.
+ * A note already sounding on the same channel is retriggered (Note Off
+ * first), with all voices busy the oldest one is stopped.
+ * @param button Key that plays the note (MIDI_VOICE_NO_BUTTON if none).
+ * @param note MIDI Note number (0-127).
+ * @param velocity Note velocity (0-127).
+ * @param channel MIDI channel (0-15).
+ * @param gate_ms Note length in ms, 0 = until the key is released.
+ */
+void midi_voice_note_on(uint8_t button, uint8_t note, uint8_t velocity,
+                        uint8_t channel, uint16_t gate_ms);
+
+/**
+ * @brief Ends the held notes (gate 0) of a released key.
+ * @param button Released key.
+ */
+void midi_voice_release(uint8_t button);
+
+/**
+ * @brief Sends Note Off for every sounding note.
+ */
+void midi_voice_all_off(void);
+
+/**
+ * @brief Number of notes sounding right now.
+ */
+uint8_t midi_voice_active(void);
+
+/**
+ * @brief Scheduler task, sends the Note Off events that are due.
+ */
+void midi_voice_task(void);
+
+#endif // MIDI_VOICE_H
@@ -0,0 +1,54 @@
+#ifndef MOUSE_MOTION_H
+#define MOUSE_MOTION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Mouse motion engine: a move is split into one report per HID poll
+// (HID_POLL_INTERVAL_MS). The path position is kept in 24.8 fixed point,
+// every report carries the whole pixels reached since the previous one, so
+// the sub-pixel remainder is never lost and both axes end together.
+//
+// MACRO_TYPE_MOUSE_MOVE value: bits 0-2 curve, bits 3-7 speed in px per
+// report (0 = MOTION_DEFAULT_SPEED), bits 8-15 Bezier bend (int8, percent
+// of the distance to the side of the straight line).
+#define MOTION_CURVE_LINEAR 0      // constant speed
+#define MOTION_CURVE_EASE_IN_OUT 1 // accelerate, then decelerate
+#define MOTION_CURVE_BEZIER 2      // eased cubic Bezier arc
+#define MOTION_DEFAULT_SPEED 4     // px per report (4000 px/s at 1 ms)
+#define MOTION_MAX_STEPS 4096      // reports of one path
+
+#define MOTION_CURVE(value) ((value) & 0x07)
+#define MOTION_SPEED(value) (((value) >> 3) & 0x1F)
+#define MOTION_BEND(value) ((int8_t)((value) >> 8))
+
+typedef struct {
+  int32_t p1_x, p1_y;     // Bezier control points (24.8)
+  int32_t p2_x, p2_y;
+  int32_t end_x, end_y;   // target (24.8)
+  int32_t sent_x, sent_y; // whole pixels already reported
+  uint16_t steps;         // reports along the path
+  uint16_t step;
+  uint8_t curve;
+} mouse_motion_t;
+
+/**
+ * @brief Plans a relative move.
+ * @param motion Motion state to fill.
+ * @param dx Distance in the X direction (px).
+ * @param dy Distance in the Y direction (px).
+ * @param value Curve, speed and bend (see above).
+ */
+void mouse_motion_init(mouse_motion_t *motion, int16_t dx, int16_t dy,
+                       uint16_t value);
+
+/**
+ * @brief Gives the deltas of the next report.
+ * @param motion Motion state.
+ * @param dx Receives the X delta (may be 0 at slow parts of the path).
+ * @param dy Receives the Y delta.
+ * @return false once the whole distance has been reported.
+ */
+bool mouse_motion_next(mouse_motion_t *motion, int8_t *dx, int8_t *dy);
+
+#endif // MOUSE_MOTION_H
@@ -0,0 +1,133 @@
+#ifndef TEXT_STREAM_H
+#define TEXT_STREAM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Text macros compiled into a HID report stream (bytecode):
+//   TS_OP_TAP mods key     press + release, each at USB pace (endpoint ready)
+//   TS_OP_REPORT mods key  one keyboard report (key 0 = keys up)
+//   TS_OP_DELAY ms         wait (unicode input methods need time)
+//   TS_OP_ROLL mods k1 k2  report with k1 still held and k2 newly pressed
+#define TS_OP_TAP 0x01
+#define TS_OP_REPORT 0x02
+#define TS_OP_DELAY 0x03
+#define TS_OP_ROLL 0x04
+
+#define TEXT_STREAM_PLATFORMS 3         // Linux, Windows, macOS
+#define TEXT_STREAM_POOL_SIZE 8192      // cache for all compiled macros
+#define TEXT_STREAM_CODEPOINT_MAX 128   // worst case stream of one codepoint
+
+typedef struct {
+  uint8_t *buf;
+  uint16_t cap;
+  uint16_t len;
+  bool overflow;     // buffer too small, stream is incomplete
+  bool used_unicode; // contains platform specific unicode input
+  bool in_unicode;   // last codepoint was unicode input (session reuse)
+  bool hex_session;  // macOS Unicode Hex Input: Option still held
+} text_stream_t;
+
+/**
+ * @brief Prepares an empty stream over a caller provided buffer.
+ */
+void text_stream_init(text_stream_t *stream, uint8_t *buf, uint16_t cap);
+
+/**
+ * @brief Compiles one character: a key on the host layout or, if there is
+ * none, the platform unicode input sequence.
+ * @param stream Target stream.
+ * @param codepoint Unicode codepoint.
+ * @param layout Host keyboard layout (kb_layout_t).
+ * @param platform Target platform (0-Linux, 1-Win, 2-Mac).
+ * @return false if the stream overflowed.
+ */
+bool text_stream_compile_codepoint(text_stream_t *stream, uint32_t codepoint,
+                                   uint8_t layout, uint8_t platform);
+
+/**
+ * @brief Compiles only the unicode input sequence of a codepoint, with the
+ * method and timings of config unicode_timing[platform]. Hex digits roll
+ * (one new key per report) and consecutive codepoints reuse the open input
+ * session where the input method allows it.
+ * @return false if the stream overflowed.
+ */
+bool text_stream_compile_unicode(text_stream_t *stream, uint32_t codepoint,
+                                 uint8_t layout, uint8_t platform);
+
+/**
+ * @brief Compiles a whole UTF-8 string (finished, see text_stream_finish).
+ * @return false if the stream overflowed.
+ */
+bool text_stream_compile(text_stream_t *stream, const char *text,
+                         uint8_t layout, uint8_t platform);
+
+/**
+ * @brief Closes an input session still open after the last codepoint
+ * (macOS Unicode Hex Input releases Option).
+ * @return false if the stream overflowed.
+ */
+bool text_stream_finish(text_stream_t *stream);
+
+/**
+ * @brief Replays a compiled stream (blocking).
+ * @param code Stream bytes.
+ * @param len Number of bytes.
+ */
+void text_stream_play(const uint8_t *code, uint16_t len);
+
+// ==================== NON-BLOCKING PLAYER ====================
+
+typedef enum {
+  TS_STEP_DONE,  // end of the stream
+  TS_STEP_SENT,  // one report went out
+  TS_STEP_BUSY,  // endpoint busy, step again later
+  TS_STEP_DELAY, // wait delay_ms before the next step
+} ts_step_t;
+
+typedef struct {
+  const uint8_t *code;
+  uint16_t len;
+  uint16_t pc;
+  bool release_pending; // second half of a TS_OP_TAP
+} text_stream_player_t;
+
+/**
+ * @brief Starts replaying a stream one step at a time (macro_vm).
+ */
+void text_stream_player_start(text_stream_player_t *player,
+                              const uint8_t *code, uint16_t len);
+
+/**
+ * @brief Runs one step of the stream, never waits.
+ * @param player Player started with text_stream_player_start().
+ * @param delay_ms Receives the wait of a TS_STEP_DELAY step.
+ * @return What the step did (ts_step_t).
+ */
+ts_step_t text_stream_step(text_stream_player_t *player, uint16_t *delay_ms);
+
+// ==================== MACRO CACHE ====================
+
+/**
+ * @brief Compiles every TEXT_STRING macro for every platform into the
+ * cache. Called after the configuration is loaded or changed over CDC.
+ * @note Macros that do not fit TEXT_STREAM_POOL_SIZE stay uncached and
+ * are typed live.
+ */
+void text_stream_cache_rebuild(void);
+
+/**
+ * @brief Replays the cached stream of a TEXT_STRING macro.
+ * @note A macro changed without a rebuild (text, layout) triggers one.
+ * @return false if the macro has no cached stream (caller types it live).
+ */
+bool text_stream_cache_play(uint8_t layer, uint8_t button, uint8_t platform);
+
+/**
+ * @brief Cache statistics.
+ * @param used_bytes Receives the used pool bytes (may be NULL).
+ * @param cached_macros Receives the number of cached macros (may be NULL).
+ */
+void text_stream_cache_stats(uint16_t *used_bytes, uint8_t *cached_macros);
+
+#endif // TEXT_STREAM_H
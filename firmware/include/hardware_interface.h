@@ -23,10 +23,10 @@ void led_rgb_init(void);
 void led_rgb_set(bool r, bool g, bool b);
 void led_rgb_update_os(uint8_t platform);
 
-// helpery
+// helpery (map_char_to_hid uses the active host layout)
 bool map_char_to_hid(char c, uint8_t *keycode, uint8_t *modifiers);
 uint32_t utf8_to_codepoint(const char **str);
 const char *get_key_name(uint8_t keycode);
-const char *format_sequence_short(key_step_t *sequence, uint8_t len);
+const char *format_sequence_short(const key_step_t *sequence, uint16_t len);
 
 #endif // HARDWARE_INTERFACE_H
@@ -0,0 +1,66 @@
+#ifndef KEYBOARD_LAYOUT_H
+#define KEYBOARD_LAYOUT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// host keyboard layouts, the index is stored in config_data_t.kb_layout
+typedef enum {
+  KB_LAYOUT_US = 0,
+  KB_LAYOUT_DE = 1,     // QWERTZ
+  KB_LAYOUT_PL = 2,     // Polish (programmer's)
+  KB_LAYOUT_FR = 3,     // AZERTY
+  KB_LAYOUT_UK = 4,     // UK ISO
+  KB_LAYOUT_DVORAK = 5, // US Dvorak
+  KB_LAYOUT_COUNT
+} kb_layout_t;
+
+// no per macro override, use the device layout
+#define KB_LAYOUT_DEVICE 0xFF
+
+// TEXT_STRING macro value: KB_LAYOUT_MACRO_FLAG | layout overrides the
+// device layout for that macro (0 or any other value = device layout)
+#define KB_LAYOUT_MACRO_FLAG 0x0100
+
+/**
+ * @brief Maps a character to the key that produces it on a host layout.
+ * @param layout Layout index (kb_layout_t).
+ * @param codepoint Unicode codepoint (ASCII is a direct table lookup,
+ * layout specific characters like ą, ß or é come from a short extra table).
+ * @param keycode Receives the HID keycode.
+ * @param modifiers Receives the modifier bitmask (shift / AltGr).
+ * @return false if the layout has no (non dead) key for the character.
+ */
+bool kb_layout_map(uint8_t layout, uint32_t codepoint, uint8_t *keycode,
+                   uint8_t *modifiers);
+
+/**
+ * @brief Layout used for typing right now: the per macro override if one is
+ * set, otherwise the device layout from the configuration.
+ */
+uint8_t kb_layout_active(void);
+
+/**
+ * @brief Sets or clears (KB_LAYOUT_DEVICE) the per macro override.
+ */
+void kb_layout_set_override(uint8_t layout);
+
+/**
+ * @brief Decodes the layout override of a TEXT_STRING macro value.
+ * @return Layout index or KB_LAYOUT_DEVICE if the value holds no override.
+ */
+uint8_t kb_layout_from_macro_value(uint16_t value);
+
+/**
+ * @brief Short layout name ("US", "DE", ...), "?" for an invalid index.
+ */
+const char *kb_layout_name(uint8_t layout);
+
+/**
+ * @brief Parses a layout name or index.
+ * @param text Name (case insensitive) or decimal index.
+ * @return Layout index or -1 if unknown.
+ */
+int kb_layout_parse(const char *text);
+
+#endif // KEYBOARD_LAYOUT_H
@@ -0,0 +1,70 @@
+#ifndef MACRO_ARENA_H
+#define MACRO_ARENA_H
+
+#include "macro_config.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Variable length macro data (config_data_t.arena, saved to flash with the
+// rest of the configuration). Blobs are packed without gaps (each padded to
+// MACRO_ARENA_ALIGN): freeing or growing one moves the data behind it and
+// fixes the offsets. Equal blobs are interned: refs of several macros point
+// at one copy, it is freed with its last user and copied before it grows.
+// The refs are kept in the layers (layer_t.refs), only layers below
+// config_layer_count() are addressable.
+
+/**
+ * @brief Returns the blob of a macro slot.
+ * @param layer Layer index.
+ * @param button Button index.
+ * @param slot Slot (arena_slot_t).
+ * @param len Receives the blob length (0 if empty, may be NULL).
+ * @return Pointer into the arena or NULL if the slot is empty.
+ * @note The pointer is valid until the next arena modification.
+ */
+const uint8_t *macro_arena_get(uint8_t layer, uint8_t button, uint8_t slot,
+                               uint16_t *len);
+
+/**
+ * @brief Replaces the blob of a macro slot, content already stored for
+ * another macro is shared instead of copied.
+ * @param data Blob data (NULL or len 0 clears the slot).
+ * @param len Blob length.
+ * @return false if the arena has no space (the old blob is kept).
+ */
+bool macro_arena_set(uint8_t layer, uint8_t button, uint8_t slot,
+                     const uint8_t *data, uint16_t len);
+
+/**
+ * @brief Appends data to the blob of a macro slot (chunked CDC uploads).
+ * @return false if the arena has no space (the blob is unchanged).
+ */
+bool macro_arena_append(uint8_t layer, uint8_t button, uint8_t slot,
+                        const uint8_t *data, uint16_t len);
+
+/**
+ * @brief Returns the key steps of a sequence / shortcut slot.
+ * @param count Receives the number of steps (0 if empty, may be NULL).
+ * @return Pointer into the arena or NULL if the slot is empty.
+ * @note The pointer is valid until the next arena modification.
+ */
+const key_step_t *macro_arena_steps(uint8_t layer, uint8_t button,
+                                    uint8_t slot, uint16_t *count);
+
+/**
+ * @brief Frees the blob of a macro slot.
+ */
+void macro_arena_clear(uint8_t layer, uint8_t button, uint8_t slot);
+
+/**
+ * @brief Free bytes left in the arena.
+ */
+uint16_t macro_arena_free_bytes(void);
+
+/**
+ * @brief Checks the arena loaded from flash and empties it if the refs do
+ * not add up to the used bytes.
+ */
+void macro_arena_validate(void);
+
+#endif // MACRO_ARENA_H
@@ -2,17 +2,22 @@
 #define MACRO_CONFIG_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 // ==================== CONFIGURATION CONSTANTS ====================
-#define MAX_LAYERS 4
 #define NUM_BUTTONS 7
+#define MAX_LAYERS 32         // gorny limit warstw (rozmiar w RAM)
+#define DEFAULT_LAYER_COUNT 4 // warstwy konfiguracji fabrycznej
 #define MACRO_STRING_LEN 32
 #define MAX_NAME_LEN 16
 #define MAX_EMOJI_LEN 8
-#define MAX_SCRIPT_SIZE 2048
+#define MAX_SCRIPT_SIZE 2048 // jeden skrypt w arenie (po spakowaniu)
+// script_platform: platforma w bitach 0-3 (0 Linux, 1 Windows, 2 macOS)
+#define SCRIPT_PLATFORM_MASK 0x0F
+#define SCRIPT_DELIVERY_CDC 0x10 // bootstrap pobiera skrypt z portu CDC
 #define FLASH_SECTOR_SIZE_CALC                                                 \
-  ((sizeof(config_data_t) + 4095) & ~4095) // zaokraglenie do wieloktronosci 4KB
+  ((config_stored_size() + 4095) & ~4095) // zaokraglenie do wieloktronosci 4KB
 
 // ==================== SEKWENCJE KLAWISZY ====================
 typedef struct {
@@ -21,7 +26,6 @@ typedef struct {
   uint16_t duration; // czas trzymania (ms) lub ilosc powtorzen
 } key_step_t;
 
-#define MAX_SEQUENCE_STEPS 5
 #define MODIFIER_LEFT_CTRL (1 << 0)   // 0x01
 #define MODIFIER_LEFT_SHIFT (1 << 1)  // 0x02
 #define MODIFIER_LEFT_ALT (1 << 2)    // 0x04
@@ -31,6 +35,9 @@ typedef struct {
 #define MODIFIER_RIGHT_ALT (1 << 6)   // 0x40
 #define MODIFIER_RIGHT_GUI (1 << 7)   // 0x80
 
+// zakres wspolrzednych MACRO_TYPE_MOUSE_MOVE_ABS (raport HID ID 3)
+#define ABS_MOUSE_MAX 32767
+
 // ==================== TYPY MAKR ====================
 typedef enum {
   MACRO_TYPE_KEY_PRESS = 0,    // pojedynczy klawisz (HID keycode)
@@ -43,13 +50,25 @@ typedef enum {
   MACRO_TYPE_MOUSE_WHEEL = 7,  // scroll
   MACRO_TYPE_MIDI_NOTE = 8,    // odtworzenie nuty MIDI
   MACRO_TYPE_MIDI_CC = 9,      // wyslanie komunikatu MIDI CC
-  MACRO_TYPE_GAME = 10         // Atari Breakout Game
+  MACRO_TYPE_GAME = 10,        // Atari Breakout Game
+  MACRO_TYPE_PROGRAM = 11,     // program bajtkodu (arena, macro_vm)
+  MACRO_TYPE_RECORD = 12,      // nagrywanie do przycisku value (CDC REC_KEY)
+  MACRO_TYPE_MOUSE_MOVE_ABS = 13, // skok kursora (X, Y: 0..32767 ekranu)
+  MACRO_TYPE_MEDIA_KEY = 14,      // klawisz multimedialny (usage Consumer)
+  MACRO_TYPE_SYSTEM_KEY = 15      // uspienie / wylaczenie / wybudzenie
 } macro_type_t;
 
+// MACRO_TYPE_LAYER_TOGGLE: tryb w starszym bajcie value, warstwa w mlodszym
+#define LAYER_SWITCH_TARGET_MASK 0x00FF
+#define LAYER_SWITCH_MODE_MASK 0xFF00
+#define LAYER_SWITCH_CYCLE 0x0000     // nastepna warstwa (z zawinieciem)
+#define LAYER_SWITCH_JUMP 0x0100      // skok do warstwy docelowej
+#define LAYER_SWITCH_MOMENTARY 0x0200 // warstwa aktywna do puszczenia przycisku
+
 // ==================== STRUKTURA MAKRA ====================
 typedef struct {
   macro_type_t type;
-  uint16_t value;        // keycode lub target layer
+  uint16_t value;        // keycode, target layer lub uklad tekstu
   int16_t move_x;        // ruch myszy X
   int16_t move_y;        // ruch myszy move_y
   uint16_t repeat_count; // ilosc powtorzen
@@ -57,22 +76,81 @@ typedef struct {
   char macro_string[MACRO_STRING_LEN];              // tekst makra
   char name[MAX_NAME_LEN];                          // nazwa makra
   uint8_t emoji_index;                              // indeks emoji
-  char script[MAX_SCRIPT_SIZE];                     // skrypt makra
-  uint8_t script_platform;                          // platforma skryptu
-  key_step_t terminal_shortcut[MAX_SEQUENCE_STEPS]; // skrot terminala
-  uint8_t terminal_shortcut_length;                 // dlugosc skrotu
-  key_step_t sequence[MAX_SEQUENCE_STEPS];          // sekwencja klawiszy
-  uint8_t sequence_length;                          // dlugosc sekwencji
+  uint8_t script_platform;                          // platforma skryptu + flagi
+  // sekwencja klawiszy, skrot terminala i skrypt leza w arenie
 } macro_entry_t;
 
+// ==================== WPROWADZANIE UNICODE ====================
+#define UNICODE_PLATFORMS 3    // Linux, Windows, macOS
+#define UNICODE_MODE_DEFAULT 0 // Ctrl+Shift+U / hex + Alt+X / Ctrl+Cmd+Space
+#define UNICODE_MODE_HEX_INPUT 1 // macOS "Unicode Hex Input" (Option + hex)
+
+typedef struct {
+  uint8_t mode;      // UNICODE_MODE_*
+  uint8_t settle_ms; // czas na otwarcie metody wprowadzania (IME)
+  uint8_t key_ms;    // przerwa po kazdym raporcie cyfr hex
+  uint8_t commit_ms; // przerwa po zatwierdzeniu znaku
+} unicode_timing_t;
+
+// ==================== CZASY SEKWENCJI ====================
+// profil czasow MACRO_TYPE_KEY_SEQUENCE dla systemu (0 = tempo USB)
+typedef struct {
+  uint8_t hold_ms; // klawisz wcisniety
+  uint8_t gap_ms;  // przerwa po puszczeniu klawisza
+  uint8_t mod_ms;  // przerwa po zmianie modyfikatorow
+  uint8_t reserved;
+} seq_timing_t;
+
+// ==================== ARENA ====================
+// dane zmiennej dlugosci (programy, sekwencje, skrypty), odwolania
+// offset/dlugosc; identyczne bloby sa zapisane raz i wspoldzielone
+#define MACRO_ARENA_SIZE 24576
+#define MACRO_ARENA_ALIGN 4 // bloby zaczynaja sie na granicy 4 bajtow
+
+typedef enum {
+  ARENA_SLOT_PROGRAM = 0,  // bajtkod MACRO_TYPE_PROGRAM
+  ARENA_SLOT_SEQUENCE = 1, // kroki MACRO_TYPE_KEY_SEQUENCE (key_step_t)
+  ARENA_SLOT_SHORTCUT = 2, // skrot terminala MACRO_TYPE_SCRIPT (key_step_t)
+  ARENA_SLOT_SCRIPT = 3,   // skrypt (tekst z NUL lub LZSS, script_codec.h)
+  ARENA_SLOT_COUNT
+} arena_slot_t;
+
+typedef struct {
+  uint16_t offset;
+  uint16_t len; // 0 = pusty
+} arena_ref_t;
+
+typedef struct {
+  uint32_t used; // zajete bajty, dane sa ciagle (bez dziur)
+  uint8_t data[MACRO_ARENA_SIZE]; // offset wyrownany do 4
+} macro_arena_t;
+
+// ==================== WARSTWA ====================
+typedef struct {
+  char name[MAX_NAME_LEN];                         // nazwa warstwy
+  uint8_t emoji;                                   // emoji warstwy
+  macro_entry_t macros[NUM_BUTTONS];               // makra przyciskow
+  arena_ref_t refs[NUM_BUTTONS][ARENA_SLOT_COUNT]; // bloby makr w arenie
+} layer_t;
+
 // ==================== GLOBALNA KONFIGURACJA ====================
+// wersja ukladu zapisu; kazda zmiana ukladu zwieksza CONFIG_VERSION i dodaje
+// krok w config_migrate.c (1 = uklad bez pola version)
+#define CONFIG_VERSION 9
+
+// warstwy sa na koncu: do flash trafiaja tylko istniejace (layer_count)
 typedef struct {
-  char layer_names[MAX_LAYERS][MAX_NAME_LEN];    // nazwy warstw
-  uint8_t layer_emojis[MAX_LAYERS];              // emoji warstw
-  macro_entry_t macros[MAX_LAYERS][NUM_BUTTONS]; // wszystkie makra
-  uint32_t crc32;                                // checksum
-  uint8_t global_text_platform;                  // domyslna platforma tekstu
-  uint32_t oled_timeout_s;                       // timeout wygaszacza OLED
+  uint32_t crc32;               // checksum zapisanej czesci (bez tego pola)
+  uint16_t version;             // CONFIG_VERSION
+  uint8_t layer_count;          // liczba warstw (1..MAX_LAYERS)
+  uint8_t global_text_platform; // domyslna platforma tekstu
+  uint32_t oled_timeout_s;      // timeout wygaszacza OLED
+  uint8_t kb_layout;            // uklad klawiatury hosta
+  // czasy wprowadzania unicode dla kazdego systemu
+  unicode_timing_t unicode_timing[UNICODE_PLATFORMS];
+  seq_timing_t seq_timing[UNICODE_PLATFORMS]; // czasy sekwencji klawiszy
+  macro_arena_t arena; // dane zmiennej dlugosci, patrz macro_arena.h
+  layer_t layers[MAX_LAYERS];
 } config_data_t;
 
 // ==================== FLASH STORAGE ====================
@@ -84,10 +162,25 @@ typedef struct {
 void config_init(void);
 config_data_t *config_get(void);
 bool config_save(void);
+// wersja starego ukladu, ktorej dane nie zmiescily sie w arenie (0 = brak);
+// flash trzyma ja do pierwszego config_save()
+uint16_t config_unmigrated_version(void);
 void config_set_factory_defaults(void);
 uint32_t config_calculate_crc(const config_data_t *config);
+uint32_t config_crc32(const uint8_t *data, size_t len);
+uint32_t config_stored_size(void);
+
+// warstwy
+uint8_t config_layer_count(void);
+bool config_set_layer_count(uint8_t count);
+layer_t *config_get_layer(uint8_t layer);
+macro_entry_t *config_get_macro(uint8_t layer, uint8_t button);
 uint8_t config_get_current_layer(void);
+void config_set_current_layer(uint8_t layer);
 void config_cycle_layer(void);
+// warstwy chwilowe (LAYER_SWITCH_MOMENTARY), zdejmowane po puszczeniu
+void config_layer_push(uint8_t layer, uint8_t button);
+bool config_layer_release(uint8_t button);
 uint8_t detect_platform(void);
 
 #endif // MACRO_CONFIG_H
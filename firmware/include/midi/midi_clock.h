@@ -0,0 +1,66 @@
+#ifndef MIDI_CLOCK_H
+#define MIDI_CLOCK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// MIDI Clock follower: the host (DAW) sends 24 Timing Clock bytes per beat
+// plus Start / Continue / Stop. The tick period is filtered against USB
+// jitter, the position counts ticks since Start for phase-locked waits.
+#define MIDI_CLOCK_PPQN 24          // ticks per quarter note
+#define MIDI_CLOCK_DEFAULT_BPM 120  // tempo before the first clock
+#define MIDI_CLOCK_TIMEOUT_MS 500   // no tick this long -> clock lost
+#define MIDI_CLOCK_RELOCK_SAMPLES 3 // outliers in a row = tempo change
+#define MIDI_CLOCK_MAX_BPM 300      // shorter intervals are USB bursts
+
+// repeat_interval / gate with this bit set counts clock ticks, not ms
+#define MIDI_INTERVAL_TICKS 0x8000
+
+/**
+ * @brief Back to the default tempo, position and running state cleared.
+ */
+void midi_clock_init(void);
+
+/**
+ * @brief Handles a real-time byte of the input stream.
+ * @param byte 0xF8 Timing Clock, 0xFA Start, 0xFB Continue or 0xFC Stop,
+ * other bytes are ignored.
+ */
+void midi_clock_realtime(uint8_t byte);
+
+/**
+ * @brief true between Start/Continue and Stop while ticks keep coming.
+ */
+bool midi_clock_running(void);
+
+/**
+ * @brief Index of the last tick since Start (-1 before the first one).
+ */
+int32_t midi_clock_position(void);
+
+/**
+ * @brief Filtered tick period in microseconds.
+ */
+uint32_t midi_clock_tick_us(void);
+
+/**
+ * @brief Tempo in tenths of BPM (1200 = 120.0 BPM).
+ */
+uint16_t midi_clock_bpm_x10(void);
+
+/**
+ * @brief Converts a macro interval to milliseconds at the current tempo.
+ * @param interval Milliseconds, or ticks with MIDI_INTERVAL_TICKS set
+ * (24 = one beat).
+ * @return Milliseconds, clamped to 65535.
+ */
+uint16_t midi_clock_interval_ms(uint16_t interval);
+
+/**
+ * @brief First grid position after the current one, for phase-locked waits.
+ * @param grid Grid in ticks (6 = 16th note, 24 = beat, 96 = 4/4 bar).
+ * @return Tick position to wait for (midi_clock_position() >= it).
+ */
+int32_t midi_clock_next_grid(uint16_t grid);
+
+#endif // MIDI_CLOCK_H
@@ -0,0 +1,33 @@
+#ifndef MIDI_RX_H
+#define MIDI_RX_H
+
+#include <stdint.h>
+
+// MIDI input (host -> device, MIDI OUT endpoint) drives the feedback of the
+// pad: a DAW lights the key LEDs, the RGB LED and the OLED meters the same
+// way it lights a controller. Messages on every channel are accepted.
+#define MIDI_RX_LED_NOTE_BASE 36 // Note 36..42 -> key LEDs 1..7
+#define MIDI_RX_RGB_CC_BASE 80   // CC 80/81/82 -> RGB red/green/blue (>= 64)
+#define MIDI_RX_METER_CC_BASE 16 // CC 16..19 -> OLED meters 1..4
+#define MIDI_RX_BUF_SIZE 64      // bytes per endpoint read
+
+/**
+ * @brief Clears the parser state (running status) and the RGB feedback.
+ */
+void midi_rx_init(void);
+
+/**
+ * @brief Feeds one byte of the MIDI stream.
+ * Running status is kept across messages, real-time bytes (0xF8-0xFF) may
+ * come between data bytes and go to midi_clock, SysEx and system common
+ * messages clear it.
+ * @param byte Next stream byte.
+ */
+void midi_rx_parse(uint8_t byte);
+
+/**
+ * @brief Scheduler task, reads the MIDI OUT endpoint and parses it.
+ */
+void midi_rx_task(void);
+
+#endif // MIDI_RX_H
@@ -0,0 +1,56 @@
+#ifndef MIDI_TX_H
+#define MIDI_TX_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// MIDI output batcher: messages of one scheduler pass are queued and leave
+// in a single stream write, so a chord fills one 64 byte USB-MIDI transfer
+// instead of one transfer per note. A Control Change to a controller that
+// is still queued only replaces the value (RPN/NRPN controllers excepted,
+// their order matters).
+#define MIDI_TX_MAX_EVENTS 16 // 64 byte transfer, 4 bytes per USB-MIDI event
+
+typedef struct {
+  uint32_t events;    // messages queued
+  uint32_t coalesced; // CC updates merged into a queued message
+  uint32_t flushes;   // stream writes
+  uint32_t overflows; // queue full, flushed before the end of the pass
+  uint32_t dropped;   // messages the TX FIFO did not take
+} midi_tx_stats_t;
+
+/**
+ * @brief Empties the queue and clears the statistics.
+ */
+void midi_tx_init(void);
+
+/**
+ * @brief Queues one MIDI message, sent by midi_tx_task.
+ * @param status Status byte (channel messages and system messages).
+ * @param data1 First data byte (ignored by 1 byte messages).
+ * @param data2 Second data byte (ignored by 1 and 2 byte messages).
+ * @return false if the MIDI interface is not mounted.
+ */
+bool midi_tx_message(uint8_t status, uint8_t data1, uint8_t data2);
+
+/**
+ * @brief Writes the queued messages to the TX FIFO in one call.
+ */
+void midi_tx_flush(void);
+
+/**
+ * @brief Scheduler task (critical, also runs inside long macros).
+ */
+void midi_tx_task(void);
+
+/**
+ * @brief Copies the output statistics.
+ */
+void midi_tx_get_stats(midi_tx_stats_t *stats);
+
+/**
+ * @brief Clears the output statistics (GET_MIDI_STATS|RESET).
+ */
+void midi_tx_reset_stats(void);
+
+#endif // MIDI_TX_H
@@ -9,6 +9,8 @@
 #define OLED_SPI spi0
 #define OLED_WIDTH 128
 #define OLED_HEIGHT 64
+#define OLED_METER_COUNT 4     // level meters of the MIDI feedback screen
+#define OLED_METER_FRAME_MS 40 // meter redraw interval (25 fps)
 
 // SSD1306 COMMANDS
 #define OLED_CMD_SET_CONTRAST 0x81
@@ -94,6 +96,15 @@ void oled_write_data(const uint8_t *data, size_t len);
  */
 void oled_trigger_preview(uint8_t layer, uint8_t button);
 
+/**
+ * @brief Sets a level meter of the MIDI feedback screen.
+ * Only stores the value, oled_ui_task redraws the screen at most once per
+ * OLED_METER_FRAME_MS and reverts to layer info like a preview.
+ * @param index Meter index (0 - OLED_METER_COUNT-1).
+ * @param value Level (0-127).
+ */
+void oled_show_meter(uint8_t index, uint8_t value);
+
 /**
  * @brief Handles UI timeouts (like reverting preview to layer info).
  * Should be called in the main loop.
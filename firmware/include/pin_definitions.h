@@ -1,6 +1,7 @@
 #ifndef PIN_DEFINITIONS_H
 #define PIN_DEFINITIONS_H
 
+#include "macro_config.h"
 #include <stdint.h>
 
 // ==================== GPIO PINS ====================
@@ -39,10 +40,6 @@
 #define USB_VID 0x2E8A
 #define USB_PID 0x0032
 
-// ==================== DEVICE CONSTANTS ====================
-#define NUM_BUTTONS 7
-#define MAX_LAYERS 4
-
 // nazwy pinow
 static const uint8_t BUTTON_PINS[NUM_BUTTONS] = {
     BTN_PIN_1, BTN_PIN_2, BTN_PIN_3, BTN_PIN_4,
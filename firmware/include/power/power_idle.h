@@ -0,0 +1,38 @@
+#ifndef POWER_IDLE_H
+#define POWER_IDLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// longest single sleep, keeps watchdog_update() well inside the 8s window
+#define POWER_IDLE_MAX_SLEEP_MS 1000
+
+/**
+ * @brief Initializes the idle helper.
+ * Enables SEVONPEND so that any interrupt becoming pending also wakes a
+ * pending WFE, even if it fired just before the core went to sleep.
+ */
+void power_idle_init(void);
+
+/**
+ * @brief Requests that the next idle sleep ends no later than the given time.
+ * @note Requests are collected during one main loop pass and cleared by
+ * power_idle_wait(). The earliest request wins.
+ * @param at_ms Absolute time in milliseconds since boot.
+ */
+void power_idle_request_wakeup(uint32_t at_ms);
+
+/**
+ * @brief Marks that there is pending work for the main loop.
+ * @note Safe to call from interrupt handlers.
+ */
+void power_idle_notify_event(void);
+
+/**
+ * @brief Sleeps (WFE) until the nearest requested deadline or until a USB,
+ * GPIO or timer interrupt arrives.
+ * Returns immediately if work is already pending.
+ */
+void power_idle_wait(void);
+
+#endif // POWER_IDLE_H
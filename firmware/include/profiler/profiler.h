@@ -0,0 +1,96 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Run-time profiler, compiled in only with -DTALOS_PROFILING=ON.
+// Without it every call below is an empty inline / macro.
+
+#define PROF_MAX_ZONES 24
+#define PROF_HIST_SUB_BITS 2 // 4 buckets per power of two (~19% resolution)
+#define PROF_HIST_BUCKETS (32 << PROF_HIST_SUB_BITS)
+#define PROF_SYSTICK_MAX_US 100000 // longer spans fall back to the us timer
+
+#ifdef TALOS_PROFILING
+
+/**
+ * @brief Start timestamp of a measured span.
+ */
+typedef struct {
+  uint32_t us;   // 1us RP2040 timer
+  uint32_t tick; // SysTick (24 bit, counts down at clk_sys)
+} prof_stamp_t;
+
+/**
+ * @brief Accumulated samples of one zone, all times in clk_sys cycles.
+ */
+typedef struct {
+  const char *name;
+  uint32_t count;
+  uint32_t min_cycles;
+  uint32_t max_cycles;
+  uint64_t total_cycles;
+  uint32_t streamed_count; // count at the last stream line
+  uint16_t hist[PROF_HIST_BUCKETS];
+} prof_zone_t;
+
+/**
+ * @brief Starts SysTick as a free running cycle counter and registers the
+ * (disabled) streaming task with the scheduler.
+ */
+void profiler_init(void);
+
+/**
+ * @brief Registers a zone, or returns the id of an existing zone with the
+ * same name.
+ * @param name Zone name (must stay valid, string literals only).
+ * @return Zone id, or -1 if the zone table is full.
+ */
+int profiler_register(const char *name);
+
+/**
+ * @brief Takes a start timestamp.
+ */
+prof_stamp_t profiler_start(void);
+
+/**
+ * @brief Records the time elapsed since start in the given zone.
+ * @param zone Zone id (negative ids are ignored).
+ * @param start Timestamp from profiler_start().
+ */
+void profiler_stop(int zone, prof_stamp_t start);
+
+/**
+ * @brief Sends all zones over CDC (PROF_START, PROF lines, PROF_END).
+ */
+void profiler_dump(void);
+
+/**
+ * @brief Clears all samples, zones stay registered.
+ */
+void profiler_reset(void);
+
+/**
+ * @brief Enables continuous streaming of changed zones.
+ * @param interval_ms Stream period, 0 stops streaming.
+ */
+void profiler_set_stream(uint32_t interval_ms);
+
+#define PROF_BEGIN(stamp) const prof_stamp_t stamp = profiler_start()
+#define PROF_END(zone, stamp) profiler_stop((zone), (stamp))
+
+#else
+
+static inline void profiler_init(void) {}
+static inline int profiler_register(const char *name) {
+  (void)name;
+  return -1;
+}
+
+#define PROF_BEGIN(stamp) ((void)0)
+#define PROF_END(zone, stamp) ((void)(zone))
+
+#endif // TALOS_PROFILING
+
+#endif // PROFILER_H
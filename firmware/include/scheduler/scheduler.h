@@ -0,0 +1,125 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SCHED_MAX_TASKS 16 ///< Maximum number of registered tasks
+
+/**
+ * @brief Task priorities, lower value runs first.
+ * CRITICAL tasks (USB) are additionally run between every other task and
+ * inside sched_delay_ms(), so they keep their timing during long work.
+ */
+typedef enum {
+  SCHED_PRIO_CRITICAL = 0,
+  SCHED_PRIO_HIGH,
+  SCHED_PRIO_NORMAL,
+  SCHED_PRIO_LOW,
+  SCHED_PRIO_COUNT
+} sched_priority_t;
+
+typedef void (*sched_task_fn_t)(void);
+
+/**
+ * @brief Registered task with its timing and run-time accounting.
+ */
+typedef struct {
+  const char *name;
+  sched_task_fn_t fn;
+  sched_priority_t priority;
+  uint32_t period_ms;   // 0 = run on every scheduler pass
+  uint32_t deadline_us; // run-time budget, 0 = unbounded
+  uint32_t next_run_ms; // next release time for periodic tasks
+  bool enabled;
+  int prof_zone; // profiler zone, -1 without TALOS_PROFILING
+
+  // accounting
+  uint32_t runs;
+  uint64_t total_us;
+  uint32_t max_us;
+  uint32_t overruns;  // runs longer than deadline_us
+  uint32_t late_runs; // periodic releases missed by more than one period
+} sched_task_t;
+
+/**
+ * @brief Clears the task table and all accounting.
+ */
+void sched_init(void);
+
+/**
+ * @brief Registers a task.
+ * @param name Short task name (used in GET_SCHED output).
+ * @param fn Task function.
+ * @param priority Task priority.
+ * @param period_ms Period in ms, 0 to run on every pass.
+ * @param deadline_us Run-time budget in us, 0 for no budget.
+ * @return Task id, or -1 if the task table is full.
+ */
+int sched_register(const char *name, sched_task_fn_t fn,
+                   sched_priority_t priority, uint32_t period_ms,
+                   uint32_t deadline_us);
+
+/**
+ * @brief Enables or disables a registered task.
+ * @param id Task id returned by sched_register().
+ * @param enabled true to enable.
+ */
+void sched_set_enabled(int id, bool enabled);
+
+/**
+ * @brief Changes the period of a registered task.
+ * @param id Task id returned by sched_register().
+ * @param period_ms New period in ms, 0 to run on every pass.
+ */
+void sched_set_period(int id, uint32_t period_ms);
+
+/**
+ * @brief Runs one scheduler pass: due tasks by priority, then idles until
+ * the next deadline or interrupt.
+ */
+void sched_run_once(void);
+
+/**
+ * @brief Scheduler main loop, never returns.
+ */
+void sched_run(void);
+
+/**
+ * @brief Runs all CRITICAL tasks once (re-entrancy safe).
+ */
+void sched_service_critical(void);
+
+/**
+ * @brief Blocking delay that keeps CRITICAL tasks serviced.
+ * @note Use instead of sleep_ms() in long running code (macros, game loop).
+ * @param ms Delay in milliseconds.
+ */
+void sched_delay_ms(uint32_t ms);
+
+/**
+ * @brief Number of registered tasks.
+ */
+uint8_t sched_task_count(void);
+
+/**
+ * @brief Returns a registered task (read only), or NULL for invalid id.
+ * @param id Task id.
+ */
+const sched_task_t *sched_get_task(uint8_t id);
+
+/**
+ * @brief Loop budget statistics since the last reset.
+ * @param passes Number of scheduler passes.
+ * @param busy_us Time spent running tasks.
+ * @param idle_us Time spent sleeping in power_idle_wait().
+ */
+void sched_get_loop_stats(uint32_t *passes, uint64_t *busy_us,
+                          uint64_t *idle_us);
+
+/**
+ * @brief Clears all run-time accounting.
+ */
+void sched_reset_stats(void);
+
+#endif // SCHEDULER_H
@@ -0,0 +1,75 @@
+#ifndef SCRIPT_CODEC_H
+#define SCRIPT_CODEC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// The ARENA_SLOT_SCRIPT blob of a macro holds either NUL terminated plain
+// text or a packed script:
+//   0xFF, text length (u16 LE), stream length (u16 LE), LZSS stream
+// 0xFF never starts UTF-8 text. The stream is a flag byte (LSB first, 1 =
+// literal byte, 0 = match) per 8 items, a match is two bytes:
+//   b0 = (distance - 1) & 0xFF, b1 = (distance - 1) >> 8 << 6 | (length - 3)
+// The encoder is in the web configurator (lib/utils/script-codec.ts).
+#define SCRIPT_PACKED_MAGIC 0xFF
+#define SCRIPT_PACKED_HEADER 5
+#define SCRIPT_LZ_WINDOW 1024 // 10 bit distance
+#define SCRIPT_LZ_MIN_MATCH 3
+#define SCRIPT_LZ_MAX_MATCH 66 // 6 bit length
+#define MAX_SCRIPT_TEXT 8192   // decoded size of a packed script
+
+// streaming decoder, the window is the only history kept (static storage,
+// too large for the stack)
+typedef struct {
+  const uint8_t *src;
+  uint16_t src_len;
+  uint16_t src_pos;
+  uint16_t left; // text bytes not produced yet
+  uint8_t flags;
+  uint8_t flag_bits;
+  uint16_t copy_dist; // match in progress
+  uint8_t copy_len;
+  uint16_t head;
+  bool packed;
+  uint8_t window[SCRIPT_LZ_WINDOW];
+} script_reader_t;
+
+/**
+ * @brief Checks if a stored script is packed.
+ * @param stored ARENA_SLOT_SCRIPT blob of the macro.
+ */
+bool script_is_packed(const char *stored);
+
+/**
+ * @brief Checks a received script before it is stored.
+ * @param stored Received bytes.
+ * @param size Number of received bytes.
+ * @return true for plain text or a packed script that decodes to exactly its
+ * text length without references before the start.
+ */
+bool script_check(const char *stored, size_t size);
+
+/**
+ * @brief Length of the script text (decoded length of a packed script).
+ */
+uint16_t script_text_len(const char *stored);
+
+/**
+ * @brief Starts reading the text of a stored script.
+ * @param r Reader state.
+ * @param stored ARENA_SLOT_SCRIPT blob of the macro (checked by
+ * script_check).
+ */
+void script_reader_open(script_reader_t *r, const char *stored);
+
+/**
+ * @brief Reads the next part of the script text.
+ * @param r Reader state.
+ * @param out Output buffer (not NUL terminated).
+ * @param cap Output buffer size.
+ * @return Number of bytes read, 0 at the end of the script.
+ */
+size_t script_reader_read(script_reader_t *r, char *out, size_t cap);
+
+#endif // SCRIPT_CODEC_H
@@ -60,6 +60,9 @@ extern "C" {
 // HID buffer size should be sufficient to hold ID (if any) + Data
 #define CFG_TUD_HID_EP_BUFSIZE 16
 
+// HID endpoint bInterval, 1 ms = full speed maximum (1000 reports/s)
+#define HID_POLL_INTERVAL_MS 1
+
 // CDC FIFO size of TX and RX
 #define CFG_TUD_CDC_RX_BUFSIZE 256
 #define CFG_TUD_CDC_TX_BUFSIZE 256
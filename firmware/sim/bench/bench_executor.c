@@ -0,0 +1,377 @@
+/*
+ * executor benchmark - runs every macro type on every platform in the
+ * simulator and reports end-to-end duration, HID reports/s and chars/s.
+ *
+ * ./run_sim_bench <baseline>           compare, exit 1 on regression or
+ *                                      a case missing from the baseline
+ * ./run_sim_bench <baseline> --update  rewrite the baseline
+ *
+ * virtual time is deterministic, so any slowdown is a real code change
+ */
+
+#include "executor/actions/exec_script.h"
+#include "executor/macro_executor.h"
+#include "hid/keyboard_layout.h"
+#include "macro_arena.h"
+#include "macro_config.h"
+#include "sim/sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// allowed slowdown against the baseline before the run fails
+#define BENCH_TOLERANCE_PCT 5
+
+#define BENCH_PLATFORMS 3
+
+extern volatile uint8_t g_detected_platform;
+
+typedef struct {
+  const char *name;
+  void (*setup)(macro_entry_t *macro);
+  bool counts_chars; // chars/s is meaningful for this case
+} bench_case_t;
+
+typedef struct {
+  const char *name;
+  uint8_t platform;
+  uint64_t duration_us;
+  uint32_t reports;
+  uint32_t dropped; // sent while the endpoint was busy
+  uint32_t chars;
+  uint32_t midi_bytes;
+} bench_result_t;
+
+static const char *const PLATFORM_NAMES[BENCH_PLATFORMS] = {"linux", "windows",
+                                                            "macos"};
+
+static const char TEXT_ASCII[] =
+    "The quick brown fox jumps over the lazy dog 0123456789!?";
+static const char TEXT_UNICODE[] = "Zażółć gęślą jaźń €";
+static const char TEXT_UNICODE_BURST[] = "→→→→→→→→"; // no key on any layout
+
+// ==================== CASES ====================
+
+static void setup_key_press(macro_entry_t *m) {
+  m->type = MACRO_TYPE_KEY_PRESS;
+  m->value = 0x04;
+}
+
+static void setup_key_repeat(macro_entry_t *m) {
+  setup_key_press(m);
+  m->repeat_count = 20;
+  m->repeat_interval = 0;
+}
+
+static void setup_text_ascii(macro_entry_t *m) {
+  m->type = MACRO_TYPE_TEXT_STRING;
+  strcpy(m->macro_string, TEXT_ASCII);
+}
+
+static void setup_text_unicode(macro_entry_t *m) {
+  m->type = MACRO_TYPE_TEXT_STRING;
+  strcpy(m->macro_string, TEXT_UNICODE);
+}
+
+// same text on a Polish host layout: AltGr keys instead of unicode input
+static void setup_text_unicode_pl(macro_entry_t *m) {
+  setup_text_unicode(m);
+  m->value = KB_LAYOUT_MACRO_FLAG | KB_LAYOUT_PL;
+}
+
+// consecutive codepoints: reused input session
+static void setup_unicode_burst(macro_entry_t *m) {
+  m->type = MACRO_TYPE_TEXT_STRING;
+  strcpy(m->macro_string, TEXT_UNICODE_BURST);
+}
+
+// macOS Unicode Hex Input (Option + hex) instead of the character viewer,
+// no IME window to wait for -> SET_UNICODE_TIMING|2|1|5|0|5
+static void setup_unicode_hex_input(macro_entry_t *m) {
+  setup_unicode_burst(m);
+  config_get()->unicode_timing[2] = (unicode_timing_t){
+      .mode = UNICODE_MODE_HEX_INPUT, .settle_ms = 5, .key_ms = 0,
+      .commit_ms = 5};
+}
+
+static void setup_layer_toggle(macro_entry_t *m) {
+  m->type = MACRO_TYPE_LAYER_TOGGLE;
+}
+
+// the shell answers the first terminal ready probe
+static void set_script_text(const char *text) {
+  macro_arena_set(0, 0, ARENA_SLOT_SCRIPT, (const uint8_t *)text,
+                  (uint16_t)(strlen(text) + 1));
+}
+
+static void setup_script(macro_entry_t *m) {
+  m->type = MACRO_TYPE_SCRIPT;
+  m->script_platform = g_detected_platform;
+  set_script_text("echo talos\nls -la\n");
+  sim_cdc_input(SCRIPT_READY_SENTINEL "\n");
+}
+
+// near MAX_SCRIPT_SIZE, typed and pulled over CDC
+static void setup_script_2k(macro_entry_t *m) {
+  static char text[MAX_SCRIPT_SIZE];
+  setup_script(m);
+  text[0] = '\0';
+  while (strlen(text) + 24 < MAX_SCRIPT_SIZE)
+    strcat(text, "echo talos >> /tmp/log\n");
+  set_script_text(text);
+}
+
+// the host bootstrap asks for the body right away
+static void setup_script_2k_cdc(macro_entry_t *m) {
+  setup_script_2k(m);
+  m->script_platform |= SCRIPT_DELIVERY_CDC;
+  sim_cdc_input(SCRIPT_PULL_REQUEST "\n");
+}
+
+// the bench runs L0 B0, steps live in its arena slot
+static void set_steps(macro_entry_t *m, int count) {
+  key_step_t steps[64];
+  for (int i = 0; i < count; i++) {
+    steps[i].keycode = 0x04 + i % 26;
+    steps[i].modifiers = (i == 0) ? 0x01 : 0;
+    steps[i].duration = 20;
+  }
+  m->type = MACRO_TYPE_KEY_SEQUENCE;
+  macro_arena_set(0, 0, ARENA_SLOT_SEQUENCE, (const uint8_t *)steps,
+                  count * sizeof(key_step_t));
+}
+
+static void setup_key_sequence(macro_entry_t *m) { set_steps(m, 4); }
+
+// per step cost must not grow with the length
+static void setup_key_sequence_64(macro_entry_t *m) { set_steps(m, 64); }
+
+static void setup_mouse_button(macro_entry_t *m) {
+  m->type = MACRO_TYPE_MOUSE_BUTTON;
+  m->value = 1;
+}
+
+static void setup_mouse_move(macro_entry_t *m) {
+  m->type = MACRO_TYPE_MOUSE_MOVE;
+  m->move_x = 300;
+  m->move_y = -150;
+  m->repeat_count = 1; // 0 moves until cancelled
+}
+
+// click at a screen position in one absolute report
+static void setup_mouse_abs(macro_entry_t *m) {
+  m->type = MACRO_TYPE_MOUSE_MOVE_ABS;
+  m->move_x = ABS_MOUSE_MAX / 2;
+  m->move_y = ABS_MOUSE_MAX / 4;
+  m->value = 1;
+}
+
+static void setup_media_key(macro_entry_t *m) {
+  m->type = MACRO_TYPE_MEDIA_KEY;
+  m->value = 0x00E9; // volume up
+}
+
+static void setup_mouse_wheel(macro_entry_t *m) {
+  m->type = MACRO_TYPE_MOUSE_WHEEL;
+  m->value = -3;
+}
+
+static void setup_midi_note(macro_entry_t *m) {
+  m->type = MACRO_TYPE_MIDI_NOTE;
+  m->value = 60;
+  m->move_x = 100;
+  m->move_y = 1;
+  m->repeat_interval = 100; // gate, Note Off from the voice task
+}
+
+static void setup_midi_cc(macro_entry_t *m) {
+  m->type = MACRO_TYPE_MIDI_CC;
+  m->value = 7;
+  m->move_x = 64;
+  m->move_y = 1;
+}
+
+// MACRO_TYPE_GAME is interactive (runs until a button press) -> not benched
+static const bench_case_t CASES[] = {
+    {"key_press", setup_key_press, false},
+    {"key_repeat_20", setup_key_repeat, false},
+    {"text_ascii", setup_text_ascii, true},
+    {"text_unicode", setup_text_unicode, true},
+    {"text_unicode_pl", setup_text_unicode_pl, true},
+    {"unicode_burst", setup_unicode_burst, true},
+    {"unicode_hex_in", setup_unicode_hex_input, true},
+    {"layer_toggle", setup_layer_toggle, false},
+    {"script", setup_script, false},
+    {"script_2k", setup_script_2k, false},
+    {"script_2k_cdc", setup_script_2k_cdc, false},
+    {"key_sequence", setup_key_sequence, false},
+    {"key_sequence_64", setup_key_sequence_64, false},
+    {"mouse_button", setup_mouse_button, false},
+    {"mouse_move", setup_mouse_move, false},
+    {"mouse_abs_click", setup_mouse_abs, false},
+    {"mouse_wheel", setup_mouse_wheel, false},
+    {"media_key", setup_media_key, false},
+    {"midi_note", setup_midi_note, false},
+    {"midi_cc", setup_midi_cc, false},
+};
+
+#define CASE_COUNT (sizeof(CASES) / sizeof(CASES[0]))
+#define RESULT_COUNT (CASE_COUNT * BENCH_PLATFORMS)
+
+// ==================== RUN ====================
+
+static uint32_t utf8_chars(const char *s) {
+  uint32_t n = 0;
+  for (; *s; s++) {
+    if (((uint8_t)*s & 0xC0) != 0x80)
+      n++;
+  }
+  return n;
+}
+
+static void run_case(const bench_case_t *bc, uint8_t platform,
+                     bench_result_t *out) {
+  sim_boot();
+  g_detected_platform = platform;
+
+  macro_entry_t *macro = &config_get()->layers[0].macros[0];
+  memset(macro, 0, sizeof(*macro));
+  strcpy(macro->name, bc->name);
+  bc->setup(macro);
+
+  sim_clear_records();
+  uint64_t start = sim_time_us();
+  execute_macro(0, 0);
+
+  out->name = bc->name;
+  out->platform = platform;
+  out->duration_us = sim_time_us() - start;
+  out->reports = (uint32_t)sim_hid_report_count();
+  out->dropped = sim_hid_dropped_reports();
+  out->chars = bc->counts_chars ? utf8_chars(macro->macro_string) : 0;
+  size_t midi_len = 0;
+  sim_midi_bytes(&midi_len);
+  out->midi_bytes = (uint32_t)midi_len;
+}
+
+static double per_second(uint32_t count, uint64_t us) {
+  return us ? (double)count * 1000000.0 / (double)us : 0.0;
+}
+
+static void print_results(const bench_result_t *results, size_t count) {
+  printf("\n%-16s %-8s %12s %8s %7s %10s %9s %6s\n", "case", "platform",
+         "duration_us", "reports", "dropped", "reports/s", "chars/s", "midi");
+  for (size_t i = 0; i < count; i++) {
+    const bench_result_t *r = &results[i];
+    printf("%-16s %-8s %12llu %8lu %7lu %10.1f %9.1f %6lu\n", r->name,
+           PLATFORM_NAMES[r->platform], (unsigned long long)r->duration_us,
+           (unsigned long)r->reports, (unsigned long)r->dropped,
+           per_second(r->reports, r->duration_us),
+           per_second(r->chars, r->duration_us), (unsigned long)r->midi_bytes);
+  }
+}
+
+// ==================== BASELINE ====================
+
+static bool write_baseline(const char *path, const bench_result_t *results,
+                           size_t count) {
+  FILE *f = fopen(path, "w");
+  if (!f)
+    return false;
+
+  fprintf(f, "# executor benchmark baseline (virtual time)\n");
+  fprintf(f, "# regenerate: run_sim_bench <this file> --update\n");
+  fprintf(f, "# case platform duration_us\n");
+  for (size_t i = 0; i < count; i++) {
+    fprintf(f, "%s %s %llu\n", results[i].name,
+            PLATFORM_NAMES[results[i].platform],
+            (unsigned long long)results[i].duration_us);
+  }
+
+  fclose(f);
+  return true;
+}
+
+static int compare_baseline(const char *path, const bench_result_t *results,
+                            size_t count) {
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    printf("[BENCH] ERROR: cannot open baseline %s\n", path);
+    return 1;
+  }
+
+  static bool found[RESULT_COUNT];
+  memset(found, 0, sizeof(found));
+
+  int regressions = 0;
+  char line[128];
+  while (fgets(line, sizeof(line), f)) {
+    char name[32];
+    char platform[16];
+    unsigned long long base_us;
+
+    if (line[0] == '#' ||
+        sscanf(line, "%31s %15s %llu", name, platform, &base_us) != 3)
+      continue;
+
+    for (size_t i = 0; i < count; i++) {
+      const bench_result_t *r = &results[i];
+      if (strcmp(r->name, name) != 0 ||
+          strcmp(PLATFORM_NAMES[r->platform], platform) != 0)
+        continue;
+      found[i] = true;
+
+      uint64_t limit = base_us + base_us * BENCH_TOLERANCE_PCT / 100;
+      if (r->duration_us > limit) {
+        printf("[BENCH] REGRESSION %s/%s: %llu us (baseline %llu us)\n",
+               name, platform, (unsigned long long)r->duration_us, base_us);
+        regressions++;
+      } else if (r->duration_us < base_us) {
+        printf("[BENCH] faster %s/%s: %llu us (baseline %llu us)\n", name,
+               platform, (unsigned long long)r->duration_us, base_us);
+      }
+    }
+  }
+
+  fclose(f);
+
+  // a new or renamed case would never be gated
+  for (size_t i = 0; i < count; i++) {
+    if (!found[i]) {
+      printf("[BENCH] MISSING %s/%s: not in the baseline, run --update\n",
+             results[i].name, PLATFORM_NAMES[results[i].platform]);
+      regressions++;
+    }
+  }
+  return regressions;
+}
+
+int main(int argc, char **argv) {
+  static bench_result_t results[RESULT_COUNT];
+  size_t count = 0;
+
+  for (size_t c = 0; c < CASE_COUNT; c++) {
+    for (uint8_t p = 0; p < BENCH_PLATFORMS; p++) {
+      run_case(&CASES[c], p, &results[count++]);
+    }
+  }
+
+  print_results(results, count);
+
+  if (argc < 2)
+    return 0;
+
+  if (argc > 2 && strcmp(argv[2], "--update") == 0) {
+    if (!write_baseline(argv[1], results, count)) {
+      printf("[BENCH] ERROR: cannot write %s\n", argv[1]);
+      return 1;
+    }
+    printf("\n[BENCH] Baseline written to %s\n", argv[1]);
+    return 0;
+  }
+
+  int regressions = compare_baseline(argv[1], results, count);
+  printf("\n[BENCH] %d regression(s) or missing case(s), tolerance %d%%\n",
+         regressions, BENCH_TOLERANCE_PCT);
+  return regressions == 0 ? 0 : 1;
+}
@@ -0,0 +1,199 @@
+#ifndef SIM_H
+#define SIM_H
+
+// Host simulator runtime: virtual clock, scripted inputs and recorders for
+// the outputs of the real firmware sources (see sim/sdk for the SDK side).
+
+#include "pico/types.h"
+
+#define SIM_POLL_US 10         // clock step of a time_reached() busy poll
+#define SIM_MAX_TIMERS 8       // concurrently armed repeating timers
+#define SIM_MAX_EVENTS 256     // scripted input events
+#define SIM_HID_LOG_SIZE 8192  // recorded HID reports
+#define SIM_HID_MAX_REPORT 16  // bytes per recorded report
+#define SIM_HID_INTERVAL_US 1000 // HID_POLL_INTERVAL_MS (tusb_config.h)
+#define SIM_MIDI_LOG_SIZE 8192 // recorded MIDI bytes
+#define SIM_CDC_BUF_SIZE 65536 // CDC input and output buffers
+
+// flash timing (W25Q16 typical values)
+#define SIM_FLASH_ERASE_SECTOR_US 45000
+#define SIM_FLASH_PROGRAM_PAGE_US 400
+
+// ==================== RUNTIME ====================
+
+/**
+ * @brief Resets the clock, gpio, timers, recorders and erases the flash.
+ */
+void sim_reset(void);
+
+/**
+ * @brief Test fixture: sim_reset(), app_init() and sim_clear_records(), the
+ * firmware booted with empty recorders.
+ */
+void sim_boot(void);
+
+/**
+ * @brief Resets only the recorders (HID, MIDI, SPI, CDC output, flash
+ * statistics), keeps time and state.
+ */
+void sim_clear_records(void);
+
+// ==================== VIRTUAL CLOCK ====================
+
+uint64_t sim_time_us(void);
+
+/**
+ * @brief Advances the clock, firing timers and scripted inputs in order.
+ * @param t_us Absolute target time (ignored if in the past).
+ */
+void sim_advance_to_us(uint64_t t_us);
+
+/**
+ * @brief Advances the clock by a relative amount.
+ * @param us Microseconds to advance.
+ */
+void sim_advance_us(uint64_t us);
+
+/**
+ * @brief Time of the next armed timer or scripted input, UINT64_MAX if none.
+ */
+uint64_t sim_next_event_us(void);
+
+/**
+ * @brief Runs the firmware main loop (sched_run_once) until the clock
+ * reaches the given time.
+ * @param t_us Absolute end time.
+ */
+void sim_run_until_us(uint64_t t_us);
+
+/**
+ * @brief Runs the firmware main loop for a relative amount of time.
+ * @param ms Milliseconds to run.
+ */
+void sim_run_for_ms(uint32_t ms);
+
+// ==================== GPIO / BUTTONS ====================
+
+/**
+ * @brief Drives an input pin now (fires the edge IRQ if enabled).
+ */
+void sim_gpio_set_input(uint gpio, bool level);
+
+/**
+ * @brief Output level last written by the firmware.
+ */
+bool sim_gpio_get_output(uint gpio);
+
+/**
+ * @brief Schedules an input level change at an absolute time.
+ * @return false if the event queue is full.
+ */
+bool sim_script_gpio(uint64_t at_us, uint gpio, bool level);
+
+/**
+ * @brief Schedules a press and release of a macro button (active low).
+ * @param button Button index (0-6, BUTTON_PINS order).
+ * @param at_us Absolute press time.
+ * @param hold_ms How long the button stays pressed.
+ */
+bool sim_script_button(uint8_t button, uint64_t at_us, uint32_t hold_ms);
+
+// ==================== RECORDERS ====================
+
+typedef struct {
+  uint64_t time_us;
+  uint8_t report_id;
+  uint8_t len;
+  uint8_t data[SIM_HID_MAX_REPORT];
+} sim_hid_report_t;
+
+size_t sim_hid_report_count(void);
+const sim_hid_report_t *sim_hid_report(size_t index);
+
+/**
+ * @brief Reports the firmware sent while the endpoint was still busy with
+ * the previous one (tud_hid_report returned false, never reached the host).
+ */
+uint32_t sim_hid_dropped_reports(void);
+
+/**
+ * @brief Recorded MIDI stream bytes.
+ * @param len Receives the number of bytes.
+ */
+const uint8_t *sim_midi_bytes(size_t *len);
+uint32_t sim_midi_write_calls(void);
+
+/**
+ * @brief Time a recorded MIDI byte was written, UINT64_MAX past the end.
+ * @param index Byte index in sim_midi_bytes().
+ */
+uint64_t sim_midi_byte_time_us(size_t index);
+
+/**
+ * @brief Queues host to device MIDI stream bytes (MIDI OUT endpoint).
+ * @param data Raw MIDI bytes, running status allowed.
+ * @param len Number of bytes.
+ */
+void sim_midi_input(const uint8_t *data, size_t len);
+
+/**
+ * @brief Schedules host to device MIDI stream bytes at an absolute time.
+ * @param data Raw MIDI bytes, must stay valid until delivered.
+ * @return false if the event queue is full.
+ */
+bool sim_script_midi_input(uint64_t at_us, const uint8_t *data, size_t len);
+
+uint64_t sim_spi_bytes(void);
+uint32_t sim_spi_write_calls(void);
+
+/**
+ * @brief Queues host to device CDC bytes.
+ * @param text NUL terminated input, e.g. "GET_CONF\n".
+ */
+void sim_cdc_input(const char *text);
+
+/**
+ * @brief Queues binary host to device CDC bytes (packed script uploads).
+ */
+void sim_cdc_input_bytes(const void *data, size_t len);
+
+/**
+ * @brief Schedules host to device CDC bytes at an absolute time.
+ * @param text NUL terminated input, must stay valid until delivered.
+ * @return false if the event queue is full.
+ */
+bool sim_script_cdc_input(uint64_t at_us, const char *text);
+
+/**
+ * @brief Schedules binary host to device CDC bytes at an absolute time.
+ * @param data Input, must stay valid until delivered.
+ * @return false if the event queue is full.
+ */
+bool sim_script_cdc_bytes(uint64_t at_us, const void *data, size_t len);
+
+/**
+ * @brief Schedules a keyboard LED report of the host (SET_REPORT).
+ * @param leds LED bitmask (bit 0 Num Lock, bit 1 Caps Lock).
+ * @return false if the event queue is full.
+ */
+bool sim_script_hid_leds(uint64_t at_us, uint8_t leds);
+
+/**
+ * @brief Device to host CDC output since the last clear (NUL terminated).
+ */
+const char *sim_cdc_output(void);
+void sim_cdc_clear_output(void);
+
+typedef struct {
+  uint32_t sectors_erased;
+  uint32_t pages_programmed;
+  uint32_t misaligned_ops;
+  uint64_t busy_us;
+} sim_flash_stats_t;
+
+const sim_flash_stats_t *sim_flash_stats(void);
+
+uint32_t sim_watchdog_updates(void);
+uint32_t sim_usb_boot_requests(void);
+
+#endif // SIM_H
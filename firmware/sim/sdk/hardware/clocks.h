@@ -0,0 +1,12 @@
+#ifndef SIM_HARDWARE_CLOCKS_H
+#define SIM_HARDWARE_CLOCKS_H
+
+#include <stdint.h>
+
+enum clock_index { clk_gpout0 = 0, clk_ref = 4, clk_sys = 5, clk_usb = 7 };
+
+static inline uint32_t clock_get_hz(enum clock_index clk_index) {
+  return clk_index == clk_usb ? 48000000 : 125000000;
+}
+
+#endif // SIM_HARDWARE_CLOCKS_H
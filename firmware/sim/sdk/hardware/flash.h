@@ -0,0 +1,18 @@
+#ifndef SIM_HARDWARE_FLASH_H
+#define SIM_HARDWARE_FLASH_H
+
+#include "pico/types.h"
+
+#define FLASH_PAGE_SIZE 256
+#define FLASH_SECTOR_SIZE 4096
+#define SIM_FLASH_SIZE (2 * 1024 * 1024)
+
+// XIP reads go straight to the simulated flash array
+extern uint8_t sim_flash_memory[SIM_FLASH_SIZE];
+#define XIP_BASE ((uintptr_t)sim_flash_memory)
+
+void flash_range_erase(uint32_t flash_offs, size_t count);
+void flash_range_program(uint32_t flash_offs, const uint8_t *data,
+                         size_t count);
+
+#endif // SIM_HARDWARE_FLASH_H
@@ -0,0 +1,23 @@
+#ifndef SIM_HARDWARE_SPI_H
+#define SIM_HARDWARE_SPI_H
+
+#include "pico/types.h"
+
+typedef struct spi_inst {
+  uint baudrate;
+} spi_inst_t;
+
+extern spi_inst_t sim_spi_inst[2];
+
+#define spi0 (&sim_spi_inst[0])
+#define spi1 (&sim_spi_inst[1])
+
+uint spi_init(spi_inst_t *spi, uint baudrate);
+
+/**
+ * @brief Records the bytes and advances the virtual clock by the transfer
+ * time at the configured baudrate.
+ */
+int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len);
+
+#endif // SIM_HARDWARE_SPI_H
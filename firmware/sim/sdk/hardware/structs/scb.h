@@ -0,0 +1,19 @@
+#ifndef SIM_HARDWARE_STRUCTS_SCB_H
+#define SIM_HARDWARE_STRUCTS_SCB_H
+
+#include <stdint.h>
+
+#define M0PLUS_SCR_SEVONPEND_BITS 0x00000010u
+
+typedef struct {
+  uint32_t cpuid;
+  uint32_t icsr;
+  uint32_t vtor;
+  uint32_t aircr;
+  uint32_t scr;
+} armv6m_scb_hw_t;
+
+extern armv6m_scb_hw_t sim_scb;
+#define scb_hw (&sim_scb)
+
+#endif // SIM_HARDWARE_STRUCTS_SCB_H
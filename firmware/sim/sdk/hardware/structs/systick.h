@@ -0,0 +1,19 @@
+#ifndef SIM_HARDWARE_STRUCTS_SYSTICK_H
+#define SIM_HARDWARE_STRUCTS_SYSTICK_H
+
+#include <stdint.h>
+
+#define M0PLUS_SYST_CSR_CLKSOURCE_BITS 0x00000004u
+#define M0PLUS_SYST_CSR_ENABLE_BITS 0x00000001u
+
+typedef struct {
+  uint32_t csr;
+  uint32_t rvr;
+  uint32_t cvr;
+  uint32_t calib;
+} systick_hw_t;
+
+extern systick_hw_t sim_systick;
+#define systick_hw (&sim_systick)
+
+#endif // SIM_HARDWARE_STRUCTS_SYSTICK_H
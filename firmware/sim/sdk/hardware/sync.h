@@ -0,0 +1,13 @@
+#ifndef SIM_HARDWARE_SYNC_H
+#define SIM_HARDWARE_SYNC_H
+
+#include <stdint.h>
+
+static inline uint32_t save_and_disable_interrupts(void) { return 0; }
+static inline void restore_interrupts(uint32_t status) { (void)status; }
+
+static inline void __sev(void) {}
+static inline void __wfe(void) {}
+static inline void __wfi(void) {}
+
+#endif // SIM_HARDWARE_SYNC_H
@@ -0,0 +1,10 @@
+#ifndef SIM_PICO_BOOTROM_H
+#define SIM_PICO_BOOTROM_H
+
+#include <stdint.h>
+
+// recorded by the simulator instead of rebooting
+void reset_usb_boot(uint32_t usb_activity_gpio_pin_mask,
+                    uint32_t disable_interface_mask);
+
+#endif // SIM_PICO_BOOTROM_H
@@ -0,0 +1,12 @@
+#ifndef SIM_PICO_STDLIB_H
+#define SIM_PICO_STDLIB_H
+
+#include "hardware/gpio.h"
+#include "pico/time.h"
+#include "pico/types.h"
+#include <stdio.h>
+#include <string.h>
+
+static inline bool stdio_init_all(void) { return true; }
+
+#endif // SIM_PICO_STDLIB_H
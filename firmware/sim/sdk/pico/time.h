@@ -0,0 +1,74 @@
+#ifndef SIM_PICO_TIME_H
+#define SIM_PICO_TIME_H
+
+#include "hardware/timer.h"
+#include "pico/types.h"
+
+// virtual clock, see sim/src/sim_clock.c
+
+absolute_time_t get_absolute_time(void);
+
+static inline uint32_t to_ms_since_boot(absolute_time_t t) {
+  return (uint32_t)(t / 1000);
+}
+
+static inline uint64_t to_us_since_boot(absolute_time_t t) { return t; }
+
+static inline absolute_time_t from_us_since_boot(uint64_t us) { return us; }
+
+static inline absolute_time_t delayed_by_ms(absolute_time_t t, uint32_t ms) {
+  return t + (uint64_t)ms * 1000;
+}
+
+static inline absolute_time_t make_timeout_time_ms(uint32_t ms) {
+  return get_absolute_time() + (uint64_t)ms * 1000;
+}
+
+static inline absolute_time_t make_timeout_time_us(uint64_t us) {
+  return get_absolute_time() + us;
+}
+
+/**
+ * @brief Polls a deadline. A poll that is not yet reached advances the
+ * virtual clock by SIM_POLL_US, so busy-wait loops make progress.
+ */
+bool time_reached(absolute_time_t t);
+
+void sleep_ms(uint32_t ms);
+void sleep_us(uint64_t us);
+
+/**
+ * @brief Jumps the virtual clock to the timeout or the next timer / scripted
+ * input, whichever comes first.
+ * @return true if the timeout was reached.
+ */
+bool best_effort_wfe_or_timeout(absolute_time_t timeout_timestamp);
+
+static inline void tight_loop_contents(void) {}
+
+struct repeating_timer;
+typedef bool (*repeating_timer_callback_t)(struct repeating_timer *rt);
+
+struct repeating_timer {
+  int64_t delay_us;
+  uint64_t next_us;
+  repeating_timer_callback_t callback;
+  void *user_data;
+  bool active;
+};
+
+bool add_repeating_timer_us(int64_t delay_us,
+                            repeating_timer_callback_t callback,
+                            void *user_data, struct repeating_timer *out);
+
+static inline bool add_repeating_timer_ms(int32_t delay_ms,
+                                          repeating_timer_callback_t callback,
+                                          void *user_data,
+                                          struct repeating_timer *out) {
+  return add_repeating_timer_us((int64_t)delay_ms * 1000, callback, user_data,
+                                out);
+}
+
+bool cancel_repeating_timer(struct repeating_timer *timer);
+
+#endif // SIM_PICO_TIME_H
@@ -0,0 +1,13 @@
+#ifndef SIM_PICO_TYPES_H
+#define SIM_PICO_TYPES_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef unsigned int uint;
+
+// microseconds since boot, same representation as a release pico-sdk build
+typedef uint64_t absolute_time_t;
+
+#endif // SIM_PICO_TYPES_H
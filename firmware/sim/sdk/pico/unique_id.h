@@ -0,0 +1,8 @@
+#ifndef SIM_PICO_UNIQUE_ID_H
+#define SIM_PICO_UNIQUE_ID_H
+
+#include "pico/types.h"
+
+void pico_get_unique_board_id_string(char *id_out, uint len);
+
+#endif // SIM_PICO_UNIQUE_ID_H
@@ -0,0 +1,55 @@
+#ifndef SIM_TUSB_H
+#define SIM_TUSB_H
+
+// TinyUSB device API as used by the firmware. Reports and MIDI bytes are
+// recorded with timestamps, CDC reads come from sim_cdc_input().
+
+#include "pico/stdlib.h"
+#include "tusb_config.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+typedef enum {
+  HID_REPORT_TYPE_INVALID = 0,
+  HID_REPORT_TYPE_INPUT,
+  HID_REPORT_TYPE_OUTPUT,
+  HID_REPORT_TYPE_FEATURE
+} hid_report_type_t;
+
+static inline bool tusb_init(void) { return true; }
+void tud_task(void);
+bool tud_task_event_ready(void);
+bool tud_mounted(void);
+
+// CDC
+bool tud_cdc_connected(void);
+uint32_t tud_cdc_available(void);
+int32_t tud_cdc_read_char(void);
+uint32_t tud_cdc_read(void *buffer, uint32_t bufsize);
+uint32_t tud_cdc_write(const void *buffer, uint32_t bufsize);
+uint32_t tud_cdc_write_char(char ch);
+uint32_t tud_cdc_write_str(const char *str);
+uint32_t tud_cdc_write_available(void);
+uint32_t tud_cdc_write_flush(void);
+
+// HID
+bool tud_hid_ready(void);
+bool tud_hid_report(uint8_t report_id, const void *report, uint16_t len);
+bool tud_hid_keyboard_report(uint8_t report_id, uint8_t modifier,
+                             const uint8_t keycode[6]);
+bool tud_hid_mouse_report(uint8_t report_id, uint8_t buttons, int8_t x,
+                          int8_t y, int8_t vertical, int8_t horizontal);
+bool tud_hid_abs_mouse_report(uint8_t report_id, uint8_t buttons, int16_t x,
+                              int16_t y, int8_t vertical, int8_t horizontal);
+
+// MIDI
+bool tud_midi_mounted(void);
+uint32_t tud_midi_available(void);
+uint32_t tud_midi_stream_read(void *buffer, uint32_t bufsize);
+uint32_t tud_midi_stream_write(uint8_t cable_num, const uint8_t *buffer,
+                               uint32_t bufsize);
+bool tud_midi_packet_read(uint8_t packet[4]);
+bool tud_midi_packet_write(const uint8_t packet[4]);
+
+#endif // SIM_TUSB_H
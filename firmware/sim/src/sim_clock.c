@@ -0,0 +1,269 @@
+#include "sim/sim.h"
+
+#include "app.h"
+#include "executor/actions/exec_hid_core.h"
+#include "pico/time.h"
+#include "power/power_idle.h"
+#include "scheduler/scheduler.h"
+#include "sim_internal.h"
+#include <string.h>
+
+typedef enum {
+  SIM_EVENT_GPIO,
+  SIM_EVENT_CDC,
+  SIM_EVENT_MIDI,
+  SIM_EVENT_HID_LEDS
+} sim_event_kind_t;
+
+typedef struct {
+  uint64_t at_us;
+  sim_event_kind_t kind;
+  uint gpio;
+  bool level;
+  const void *data; // SIM_EVENT_CDC, SIM_EVENT_MIDI
+  size_t len;
+  uint8_t leds; // SIM_EVENT_HID_LEDS
+} sim_event_t;
+
+static uint64_t now_us = 0;
+
+static struct repeating_timer *timers[SIM_MAX_TIMERS];
+
+static sim_event_t events[SIM_MAX_EVENTS];
+static size_t event_count = 0;
+
+// ==================== RUNTIME ====================
+
+void sim_reset(void) {
+  now_us = 0;
+  memset(timers, 0, sizeof(timers));
+  event_count = 0;
+
+  sim_gpio_reset();
+  sim_usb_reset();
+  sim_periph_reset();
+}
+
+void sim_boot(void) {
+  sim_reset();
+  app_init();
+  sim_clear_records();
+}
+
+void sim_clear_records(void) {
+  sim_usb_clear_records();
+  sim_periph_clear_records();
+}
+
+// ==================== VIRTUAL CLOCK ====================
+
+uint64_t sim_time_us(void) { return now_us; }
+
+uint64_t time_us_64(void) { return now_us; }
+
+absolute_time_t get_absolute_time(void) { return now_us; }
+
+static int next_timer_index(void) {
+  int best = -1;
+  for (int i = 0; i < SIM_MAX_TIMERS; i++) {
+    if (timers[i] == NULL || !timers[i]->active)
+      continue;
+    if (best < 0 || timers[i]->next_us < timers[best]->next_us)
+      best = i;
+  }
+  return best;
+}
+
+uint64_t sim_next_event_us(void) {
+  uint64_t next = UINT64_MAX;
+
+  int t = next_timer_index();
+  if (t >= 0)
+    next = timers[t]->next_us;
+  if (event_count > 0 && events[0].at_us < next)
+    next = events[0].at_us;
+
+  return next;
+}
+
+static void fire_timer(struct repeating_timer *rt) {
+  uint64_t period = rt->delay_us < 0 ? -rt->delay_us : rt->delay_us;
+
+  if (rt->callback(rt) && rt->active) {
+    rt->next_us = now_us + period;
+  } else {
+    rt->active = false;
+  }
+}
+
+static void fire_event(void) {
+  sim_event_t ev = events[0];
+  event_count--;
+  memmove(&events[0], &events[1], event_count * sizeof(sim_event_t));
+
+  switch (ev.kind) {
+  case SIM_EVENT_GPIO:
+    sim_gpio_set_input(ev.gpio, ev.level);
+    break;
+  case SIM_EVENT_CDC:
+    sim_cdc_input_bytes(ev.data, ev.len);
+    break;
+  case SIM_EVENT_MIDI:
+    sim_midi_input(ev.data, ev.len);
+    break;
+  case SIM_EVENT_HID_LEDS:
+    hid_host_leds_set(ev.leds); // what tud_hid_set_report_cb forwards
+    break;
+  }
+}
+
+void sim_advance_to_us(uint64_t t_us) {
+  while (1) {
+    uint64_t next = sim_next_event_us();
+    if (next == UINT64_MAX || next > t_us)
+      break;
+
+    if (next > now_us)
+      now_us = next;
+
+    // inputs before timers due at the same time (IRQ sees the edge first)
+    if (event_count > 0 && events[0].at_us <= now_us) {
+      fire_event();
+    } else {
+      fire_timer(timers[next_timer_index()]);
+    }
+  }
+
+  if (t_us > now_us)
+    now_us = t_us;
+}
+
+void sim_advance_us(uint64_t us) { sim_advance_to_us(now_us + us); }
+
+bool time_reached(absolute_time_t t) {
+  if (now_us >= t)
+    return true;
+
+  uint64_t step = now_us + SIM_POLL_US;
+  sim_advance_to_us(step < t ? step : t);
+  return now_us >= t;
+}
+
+void sleep_us(uint64_t us) { sim_advance_us(us); }
+
+void sleep_ms(uint32_t ms) { sim_advance_us((uint64_t)ms * 1000); }
+
+bool best_effort_wfe_or_timeout(absolute_time_t timeout_timestamp) {
+  if (now_us >= timeout_timestamp)
+    return true;
+
+  // any timer or scripted input is an interrupt that ends the WFE
+  uint64_t next = sim_next_event_us();
+  sim_advance_to_us(next < timeout_timestamp ? next : timeout_timestamp);
+
+  return now_us >= timeout_timestamp;
+}
+
+bool add_repeating_timer_us(int64_t delay_us,
+                            repeating_timer_callback_t callback,
+                            void *user_data, struct repeating_timer *out) {
+  int slot = -1;
+  for (int i = 0; i < SIM_MAX_TIMERS; i++) {
+    if (timers[i] == out) {
+      slot = i;
+      break;
+    }
+    if (slot < 0 && (timers[i] == NULL || !timers[i]->active))
+      slot = i;
+  }
+  if (slot < 0)
+    return false;
+
+  uint64_t period = delay_us < 0 ? -delay_us : delay_us;
+  out->delay_us = delay_us;
+  out->next_us = now_us + period;
+  out->callback = callback;
+  out->user_data = user_data;
+  out->active = true;
+  timers[slot] = out;
+
+  return true;
+}
+
+bool cancel_repeating_timer(struct repeating_timer *timer) {
+  for (int i = 0; i < SIM_MAX_TIMERS; i++) {
+    if (timers[i] == timer) {
+      bool was_active = timer->active;
+      timer->active = false;
+      timers[i] = NULL;
+      return was_active;
+    }
+  }
+  return false;
+}
+
+// ==================== MAIN LOOP ====================
+
+void sim_run_until_us(uint64_t t_us) {
+  while (now_us < t_us) {
+    uint64_t before = now_us;
+
+    // the idle sleep must not run past the requested end
+    power_idle_request_wakeup((uint32_t)((t_us + 999) / 1000));
+    sched_run_once();
+
+    // a pass that neither slept nor waited still costs time
+    if (now_us == before)
+      sim_advance_us(1);
+  }
+}
+
+void sim_run_for_ms(uint32_t ms) {
+  sim_run_until_us(now_us + (uint64_t)ms * 1000);
+}
+
+// ==================== SCRIPTED INPUT ====================
+
+static bool schedule(const sim_event_t *ev) {
+  if (event_count >= SIM_MAX_EVENTS)
+    return false;
+
+  // sorted by time, equal times keep their scripting order
+  size_t pos = event_count;
+  while (pos > 0 && events[pos - 1].at_us > ev->at_us)
+    pos--;
+
+  memmove(&events[pos + 1], &events[pos],
+          (event_count - pos) * sizeof(sim_event_t));
+  events[pos] = *ev;
+  event_count++;
+
+  return true;
+}
+
+bool sim_script_gpio(uint64_t at_us, uint gpio, bool level) {
+  sim_event_t ev = {
+      .at_us = at_us, .kind = SIM_EVENT_GPIO, .gpio = gpio, .level = level};
+  return schedule(&ev);
+}
+
+bool sim_script_cdc_input(uint64_t at_us, const char *text) {
+  return sim_script_cdc_bytes(at_us, text, strlen(text));
+}
+
+bool sim_script_cdc_bytes(uint64_t at_us, const void *data, size_t len) {
+  sim_event_t ev = {
+      .at_us = at_us, .kind = SIM_EVENT_CDC, .data = data, .len = len};
+  return schedule(&ev);
+}
+
+bool sim_script_midi_input(uint64_t at_us, const uint8_t *data, size_t len) {
+  sim_event_t ev = {
+      .at_us = at_us, .kind = SIM_EVENT_MIDI, .data = data, .len = len};
+  return schedule(&ev);
+}
+
+bool sim_script_hid_leds(uint64_t at_us, uint8_t leds) {
+  sim_event_t ev = {.at_us = at_us, .kind = SIM_EVENT_HID_LEDS, .leds = leds};
+  return schedule(&ev);
+}
@@ -0,0 +1,101 @@
+#include "sim/sim.h"
+
+#include "hardware/gpio.h"
+#include "pin_definitions.h"
+#include "sim_internal.h"
+#include <string.h>
+
+#define SIM_GPIO_COUNT 30
+
+static bool levels[SIM_GPIO_COUNT];
+static bool outputs[SIM_GPIO_COUNT];
+static bool driven[SIM_GPIO_COUNT]; // input forced by the simulator
+static uint32_t irq_masks[SIM_GPIO_COUNT];
+static gpio_irq_callback_t irq_callback = NULL;
+
+void sim_gpio_reset(void) {
+  memset(levels, 0, sizeof(levels));
+  memset(outputs, 0, sizeof(outputs));
+  memset(driven, 0, sizeof(driven));
+  memset(irq_masks, 0, sizeof(irq_masks));
+  irq_callback = NULL;
+}
+
+void gpio_init(uint gpio) {
+  if (gpio >= SIM_GPIO_COUNT)
+    return;
+  outputs[gpio] = false;
+  irq_masks[gpio] = 0;
+}
+
+void gpio_set_dir(uint gpio, bool out) {
+  if (gpio < SIM_GPIO_COUNT)
+    outputs[gpio] = out;
+}
+
+void gpio_put(uint gpio, bool value) {
+  if (gpio < SIM_GPIO_COUNT && outputs[gpio])
+    levels[gpio] = value;
+}
+
+bool gpio_get(uint gpio) { return gpio < SIM_GPIO_COUNT && levels[gpio]; }
+
+void gpio_pull_up(uint gpio) {
+  if (gpio < SIM_GPIO_COUNT && !driven[gpio])
+    levels[gpio] = true;
+}
+
+void gpio_pull_down(uint gpio) {
+  if (gpio < SIM_GPIO_COUNT && !driven[gpio])
+    levels[gpio] = false;
+}
+
+void gpio_set_function(uint gpio, enum gpio_function fn) {
+  (void)gpio;
+  (void)fn;
+}
+
+void gpio_set_irq_enabled(uint gpio, uint32_t event_mask, bool enabled) {
+  if (gpio >= SIM_GPIO_COUNT)
+    return;
+
+  if (enabled)
+    irq_masks[gpio] |= event_mask;
+  else
+    irq_masks[gpio] &= ~event_mask;
+}
+
+void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t event_mask,
+                                        bool enabled,
+                                        gpio_irq_callback_t callback) {
+  gpio_set_irq_enabled(gpio, event_mask, enabled);
+  irq_callback = callback;
+}
+
+void sim_gpio_set_input(uint gpio, bool level) {
+  if (gpio >= SIM_GPIO_COUNT)
+    return;
+
+  driven[gpio] = true;
+  if (levels[gpio] == level)
+    return;
+  levels[gpio] = level;
+
+  uint32_t edge = level ? GPIO_IRQ_EDGE_RISE : GPIO_IRQ_EDGE_FALL;
+  if ((irq_masks[gpio] & edge) && irq_callback != NULL)
+    irq_callback(gpio, edge);
+}
+
+bool sim_gpio_get_output(uint gpio) {
+  return gpio < SIM_GPIO_COUNT && outputs[gpio] && levels[gpio];
+}
+
+bool sim_script_button(uint8_t button, uint64_t at_us, uint32_t hold_ms) {
+  if (button >= NUM_BUTTONS)
+    return false;
+
+  // active low, the pin idles high on its pull-up
+  return sim_script_gpio(at_us, BUTTON_PINS[button], false) &&
+         sim_script_gpio(at_us + (uint64_t)hold_ms * 1000, BUTTON_PINS[button],
+                         true);
+}
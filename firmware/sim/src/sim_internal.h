@@ -0,0 +1,14 @@
+#ifndef SIM_INTERNAL_H
+#define SIM_INTERNAL_H
+
+// Hooks between the simulator runtime files, not for tests.
+
+#include "pico/types.h"
+
+void sim_gpio_reset(void);
+void sim_usb_reset(void);
+void sim_usb_clear_records(void);
+void sim_periph_reset(void);
+void sim_periph_clear_records(void);
+
+#endif // SIM_INTERNAL_H
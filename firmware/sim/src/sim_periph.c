@@ -0,0 +1,134 @@
+#include "sim/sim.h"
+
+#include "hardware/flash.h"
+#include "hardware/spi.h"
+#include "hardware/structs/scb.h"
+#include "hardware/structs/systick.h"
+#include "hardware/watchdog.h"
+#include "pico/bootrom.h"
+#include "pico/unique_id.h"
+#include "sim_internal.h"
+#include <string.h>
+
+uint8_t sim_flash_memory[SIM_FLASH_SIZE];
+spi_inst_t sim_spi_inst[2];
+armv6m_scb_hw_t sim_scb;
+systick_hw_t sim_systick;
+
+static sim_flash_stats_t flash_stats;
+
+static uint64_t spi_bytes = 0;
+static uint32_t spi_calls = 0;
+static uint64_t spi_ns_remainder = 0;
+
+static uint32_t watchdog_updates = 0;
+static uint32_t usb_boot_requests = 0;
+
+void sim_periph_reset(void) {
+  memset(sim_flash_memory, 0xFF, sizeof(sim_flash_memory));
+  memset(sim_spi_inst, 0, sizeof(sim_spi_inst));
+  memset(&sim_scb, 0, sizeof(sim_scb));
+  memset(&sim_systick, 0, sizeof(sim_systick));
+
+  spi_ns_remainder = 0;
+  watchdog_updates = 0;
+  usb_boot_requests = 0;
+  sim_periph_clear_records();
+}
+
+void sim_periph_clear_records(void) {
+  memset(&flash_stats, 0, sizeof(flash_stats));
+  spi_bytes = 0;
+  spi_calls = 0;
+}
+
+// ==================== SPI ====================
+
+uint spi_init(spi_inst_t *spi, uint baudrate) {
+  spi->baudrate = baudrate;
+  return baudrate;
+}
+
+int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len) {
+  (void)src;
+
+  spi_bytes += len;
+  spi_calls++;
+
+  // wire time at the configured clock, fractions carried to the next write
+  if (spi->baudrate > 0) {
+    spi_ns_remainder += (uint64_t)len * 8 * 1000000000ull / spi->baudrate;
+    sim_advance_us(spi_ns_remainder / 1000);
+    spi_ns_remainder %= 1000;
+  }
+
+  return (int)len;
+}
+
+uint64_t sim_spi_bytes(void) { return spi_bytes; }
+
+uint32_t sim_spi_write_calls(void) { return spi_calls; }
+
+// ==================== FLASH ====================
+
+void flash_range_erase(uint32_t flash_offs, size_t count) {
+  if (flash_offs % FLASH_SECTOR_SIZE || count % FLASH_SECTOR_SIZE ||
+      flash_offs + count > SIM_FLASH_SIZE) {
+    flash_stats.misaligned_ops++;
+    return;
+  }
+
+  memset(&sim_flash_memory[flash_offs], 0xFF, count);
+
+  uint32_t sectors = (uint32_t)(count / FLASH_SECTOR_SIZE);
+  flash_stats.sectors_erased += sectors;
+  flash_stats.busy_us += (uint64_t)sectors * SIM_FLASH_ERASE_SECTOR_US;
+  sim_advance_us((uint64_t)sectors * SIM_FLASH_ERASE_SECTOR_US);
+}
+
+void flash_range_program(uint32_t flash_offs, const uint8_t *data,
+                         size_t count) {
+  if (flash_offs % FLASH_PAGE_SIZE || count % FLASH_PAGE_SIZE ||
+      flash_offs + count > SIM_FLASH_SIZE) {
+    flash_stats.misaligned_ops++;
+    return;
+  }
+
+  // NOR flash: programming can only clear bits
+  for (size_t i = 0; i < count; i++)
+    sim_flash_memory[flash_offs + i] &= data[i];
+
+  uint32_t pages = (uint32_t)(count / FLASH_PAGE_SIZE);
+  flash_stats.pages_programmed += pages;
+  flash_stats.busy_us += (uint64_t)pages * SIM_FLASH_PROGRAM_PAGE_US;
+  sim_advance_us((uint64_t)pages * SIM_FLASH_PROGRAM_PAGE_US);
+}
+
+const sim_flash_stats_t *sim_flash_stats(void) { return &flash_stats; }
+
+// ==================== MISC ====================
+
+void watchdog_enable(uint32_t delay_ms, bool pause_on_debug) {
+  (void)delay_ms;
+  (void)pause_on_debug;
+}
+
+void watchdog_update(void) { watchdog_updates++; }
+
+uint32_t sim_watchdog_updates(void) { return watchdog_updates; }
+
+void reset_usb_boot(uint32_t usb_activity_gpio_pin_mask,
+                    uint32_t disable_interface_mask) {
+  (void)usb_activity_gpio_pin_mask;
+  (void)disable_interface_mask;
+  usb_boot_requests++;
+}
+
+uint32_t sim_usb_boot_requests(void) { return usb_boot_requests; }
+
+void pico_get_unique_board_id_string(char *id_out, uint len) {
+  if (len == 0)
+    return;
+  strncpy(id_out, "E6605838834F2A31", len - 1);
+  id_out[len - 1] = '\0';
+}
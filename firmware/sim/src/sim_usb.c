@@ -0,0 +1,257 @@
+#include "sim/sim.h"
+
+#include "sim_internal.h"
+#include "tusb.h"
+#include <string.h>
+
+static char cdc_in[SIM_CDC_BUF_SIZE];
+static size_t cdc_in_head = 0;
+static size_t cdc_in_tail = 0;
+
+static char cdc_out[SIM_CDC_BUF_SIZE];
+static size_t cdc_out_len = 0;
+
+static sim_hid_report_t hid_log[SIM_HID_LOG_SIZE];
+static size_t hid_count = 0;
+static uint64_t hid_busy_until = 0; // next host poll of the pending report
+static uint32_t hid_dropped = 0;
+
+static uint8_t midi_log[SIM_MIDI_LOG_SIZE];
+static uint64_t midi_time[SIM_MIDI_LOG_SIZE];
+static size_t midi_len = 0;
+static uint32_t midi_calls = 0;
+
+static uint8_t midi_in[SIM_MIDI_LOG_SIZE];
+static size_t midi_in_head = 0;
+static size_t midi_in_tail = 0;
+
+void sim_usb_reset(void) {
+  cdc_in_head = 0;
+  cdc_in_tail = 0;
+  midi_in_head = 0;
+  midi_in_tail = 0;
+  hid_busy_until = 0;
+  sim_usb_clear_records();
+}
+
+void sim_usb_clear_records(void) {
+  cdc_out_len = 0;
+  cdc_out[0] = '\0';
+  hid_count = 0;
+  hid_dropped = 0;
+  midi_len = 0;
+  midi_calls = 0;
+}
+
+// ==================== DEVICE ====================
+
+// a busy poll on a pending HID report costs one poll step
+void tud_task(void) {
+  if (sim_time_us() < hid_busy_until)
+    sim_advance_us(SIM_POLL_US);
+}
+
+bool tud_task_event_ready(void) {
+  return cdc_in_head != cdc_in_tail || midi_in_head != midi_in_tail;
+}
+
+bool tud_mounted(void) { return true; }
+
+// ==================== CDC ====================
+
+void sim_cdc_input(const char *text) {
+  sim_cdc_input_bytes(text, strlen(text));
+}
+
+void sim_cdc_input_bytes(const void *data, size_t len) {
+  // compact consumed input before appending
+  if (cdc_in_tail > 0) {
+    memmove(cdc_in, &cdc_in[cdc_in_tail], cdc_in_head - cdc_in_tail);
+    cdc_in_head -= cdc_in_tail;
+    cdc_in_tail = 0;
+  }
+  if (len > sizeof(cdc_in) - cdc_in_head)
+    len = sizeof(cdc_in) - cdc_in_head;
+
+  memcpy(&cdc_in[cdc_in_head], data, len);
+  cdc_in_head += len;
+}
+
+const char *sim_cdc_output(void) { return cdc_out; }
+
+void sim_cdc_clear_output(void) {
+  cdc_out_len = 0;
+  cdc_out[0] = '\0';
+}
+
+bool tud_cdc_connected(void) { return true; }
+
+uint32_t tud_cdc_available(void) {
+  return (uint32_t)(cdc_in_head - cdc_in_tail);
+}
+
+int32_t tud_cdc_read_char(void) {
+  if (cdc_in_head == cdc_in_tail)
+    return -1;
+  return (uint8_t)cdc_in[cdc_in_tail++];
+}
+
+uint32_t tud_cdc_read(void *buffer, uint32_t bufsize) {
+  uint32_t n = tud_cdc_available();
+  if (n > bufsize)
+    n = bufsize;
+
+  memcpy(buffer, &cdc_in[cdc_in_tail], n);
+  cdc_in_tail += n;
+  return n;
+}
+
+uint32_t tud_cdc_write(const void *buffer, uint32_t bufsize) {
+  uint32_t n = bufsize;
+  if (n > sizeof(cdc_out) - 1 - cdc_out_len)
+    n = (uint32_t)(sizeof(cdc_out) - 1 - cdc_out_len);
+
+  memcpy(&cdc_out[cdc_out_len], buffer, n);
+  cdc_out_len += n;
+  cdc_out[cdc_out_len] = '\0';
+  return bufsize;
+}
+
+uint32_t tud_cdc_write_char(char ch) { return tud_cdc_write(&ch, 1); }
+
+uint32_t tud_cdc_write_str(const char *str) {
+  return tud_cdc_write(str, (uint32_t)strlen(str));
+}
+
+// the host drains instantly, the FIFO is always empty
+uint32_t tud_cdc_write_available(void) { return CFG_TUD_CDC_TX_BUFSIZE; }
+
+uint32_t tud_cdc_write_flush(void) { return 0; }
+
+// ==================== HID ====================
+
+// the endpoint holds one report until the host polls it (every bInterval)
+bool tud_hid_ready(void) { return sim_time_us() >= hid_busy_until; }
+
+bool tud_hid_report(uint8_t report_id, const void *report, uint16_t len) {
+  if (!tud_hid_ready()) {
+    hid_dropped++;
+    return false;
+  }
+  if (hid_count >= SIM_HID_LOG_SIZE)
+    return false;
+
+  uint64_t now = sim_time_us();
+  hid_busy_until = (now / SIM_HID_INTERVAL_US + 1) * SIM_HID_INTERVAL_US;
+
+  sim_hid_report_t *entry = &hid_log[hid_count++];
+  entry->time_us = sim_time_us();
+  entry->report_id = report_id;
+  entry->len = len > SIM_HID_MAX_REPORT ? SIM_HID_MAX_REPORT : (uint8_t)len;
+  memset(entry->data, 0, sizeof(entry->data));
+  if (report != NULL)
+    memcpy(entry->data, report, entry->len);
+
+  return true;
+}
+
+bool tud_hid_keyboard_report(uint8_t report_id, uint8_t modifier,
+                             const uint8_t keycode[6]) {
+  uint8_t report[8] = {modifier, 0};
+  if (keycode != NULL)
+    memcpy(&report[2], keycode, 6);
+  return tud_hid_report(report_id, report, sizeof(report));
+}
+
+bool tud_hid_mouse_report(uint8_t report_id, uint8_t buttons, int8_t x,
+                          int8_t y, int8_t vertical, int8_t horizontal) {
+  uint8_t report[5] = {buttons, (uint8_t)x, (uint8_t)y, (uint8_t)vertical,
+                       (uint8_t)horizontal};
+  return tud_hid_report(report_id, report, sizeof(report));
+}
+
+bool tud_hid_abs_mouse_report(uint8_t report_id, uint8_t buttons, int16_t x,
+                              int16_t y, int8_t vertical, int8_t horizontal) {
+  uint8_t report[7] = {buttons,          (uint8_t)x, (uint8_t)(x >> 8),
+                       (uint8_t)y,       (uint8_t)(y >> 8), (uint8_t)vertical,
+                       (uint8_t)horizontal};
+  return tud_hid_report(report_id, report, sizeof(report));
+}
+
+size_t sim_hid_report_count(void) { return hid_count; }
+
+uint32_t sim_hid_dropped_reports(void) { return hid_dropped; }
+
+const sim_hid_report_t *sim_hid_report(size_t index) {
+  return index < hid_count ? &hid_log[index] : NULL;
+}
+
+// ==================== MIDI ====================
+
+bool tud_midi_mounted(void) { return true; }
+
+void sim_midi_input(const uint8_t *data, size_t len) {
+  // compact consumed input before appending
+  if (midi_in_tail > 0) {
+    memmove(midi_in, &midi_in[midi_in_tail], midi_in_head - midi_in_tail);
+    midi_in_head -= midi_in_tail;
+    midi_in_tail = 0;
+  }
+  if (len > sizeof(midi_in) - midi_in_head)
+    len = sizeof(midi_in) - midi_in_head;
+
+  memcpy(&midi_in[midi_in_head], data, len);
+  midi_in_head += len;
+}
+
+uint32_t tud_midi_available(void) {
+  return (uint32_t)(midi_in_head - midi_in_tail);
+}
+
+uint32_t tud_midi_stream_read(void *buffer, uint32_t bufsize) {
+  uint32_t n = tud_midi_available();
+  if (n > bufsize)
+    n = bufsize;
+
+  memcpy(buffer, &midi_in[midi_in_tail], n);
+  midi_in_tail += n;
+  return n;
+}
+
+uint32_t tud_midi_stream_write(uint8_t cable_num, const uint8_t *buffer,
+                               uint32_t bufsize) {
+  (void)cable_num;
+  midi_calls++;
+
+  uint32_t n = bufsize;
+  if (n > sizeof(midi_log) - midi_len)
+    n = (uint32_t)(sizeof(midi_log) - midi_len);
+
+  memcpy(&midi_log[midi_len], buffer, n);
+  for (uint32_t i = 0; i < n; i++)
+    midi_time[midi_len + i] = sim_time_us();
+  midi_len += n;
+  return bufsize;
+}
+
+bool tud_midi_packet_read(uint8_t packet[4]) {
+  (void)packet;
+  return false;
+}
+
+bool tud_midi_packet_write(const uint8_t packet[4]) {
+  // packet[0] is the cable/CIN header, the stream log keeps MIDI bytes only
+  return tud_midi_stream_write(0, &packet[1], 3) == 3;
+}
+
+const uint8_t *sim_midi_bytes(size_t *len) {
+  if (len != NULL)
+    *len = midi_len;
+  return midi_log;
+}
+
+uint64_t sim_midi_byte_time_us(size_t index) {
+  return index < midi_len ? midi_time[index] : UINT64_MAX;
+}
+
+uint32_t sim_midi_write_calls(void) { return midi_calls; }
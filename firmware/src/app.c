@@ -0,0 +1,210 @@
+#include "app.h"
+
+#include "cdc/cdc_dispatcher.h"
+#include "cdc/cdc_transport.h"
+#include "easter_egg.h"
+#include "executor/macro_executor.h"
+#include "executor/macro_vm.h"
+#include "executor/midi_cc.h"
+#include "executor/midi_voice.h"
+#include "executor/text_stream.h"
+#include "hardware/watchdog.h"
+#include "hardware_interface.h"
+#include "macro_config.h"
+#include "midi/midi_clock.h"
+#include "midi/midi_rx.h"
+#include "midi/midi_tx.h"
+#include "oled/oled_display.h"
+#include "pico/stdlib.h"
+#include "pin_definitions.h"
+#include "power/power_idle.h"
+#include "profiler/profiler.h"
+#include "scheduler/scheduler.h"
+#include "tusb.h"
+#include <stdio.h>
+
+volatile uint8_t g_detected_platform = 0;
+
+uint8_t detect_platform(void) { return g_detected_platform; }
+
+static bool button_processed[NUM_BUTTONS] = {false};
+static uint32_t last_button_time[NUM_BUTTONS] = {0};
+static const uint32_t DEBOUNCE_MS = 5;
+static bool prev_os_btn_state = true;
+static uint32_t last_os_toggle_time = 0;
+
+void check_os_toggle_button(void) {
+  bool current_state = gpio_get(BTN_OS_TOGGLE_PIN);
+  uint32_t now = to_ms_since_boot(get_absolute_time());
+
+  if (prev_os_btn_state == true && current_state == false) {
+    if (now - last_os_toggle_time > 200) {
+
+      // platform: 0 -> 1 -> 2 -> 0 ...
+      g_detected_platform++;
+      if (g_detected_platform > 2) {
+        g_detected_platform = 0;
+      }
+
+      switch (g_detected_platform) {
+      case 0: // Linux
+        cdc_log("[OS] Switched to LINUX (Manual)\n");
+        break;
+
+      case 1: // Windows
+        cdc_log("[OS] Switched to WINDOWS (Manual)\n");
+        break;
+
+      case 2: // macOS
+        cdc_log("[OS] Switched to MACOS (Manual)\n");
+        break;
+      }
+
+      last_os_toggle_time = now;
+
+      led_rgb_update_os(g_detected_platform);
+      oled_wake_up();
+      oled_display_layer_info(config_get_current_layer());
+    }
+  }
+  prev_os_btn_state = current_state;
+}
+
+static void buttons_task(void) {
+  uint32_t now = to_ms_since_boot(get_absolute_time());
+
+  for (int i = 0; i < NUM_BUTTONS; i++) {
+    bool pressed = button_is_pressed(i);
+
+    if (pressed && !button_processed[i] &&
+        (now - last_button_time[i] > DEBOUNCE_MS)) {
+      // read per press, a held layer key may have changed it this pass
+      uint8_t current_layer = config_get_current_layer();
+
+      if (oled_is_active()) {
+        // ekran aktywny -> wykonaj makro
+        cdc_log("[MAIN] Button %d pressed! Executing macro.\n", i + 1);
+        oled_wake_up(); // reset timera bezczynnosci
+        execute_macro(current_layer, i);
+      } else {
+        // ekran wylaczony -> wybudz
+        cdc_log("[MAIN] Button %d pressed! Waking up OLED.\n", i + 1);
+        oled_wake_up();
+        oled_display_layer_info(current_layer);
+      }
+
+      last_button_time[i] = now;
+      button_processed[i] = true;
+    } else if (pressed && !button_processed[i]) {
+      // held inside the debounce window -> re-check once it expires
+      power_idle_request_wakeup(last_button_time[i] + DEBOUNCE_MS + 1);
+    } else if (!pressed) {
+      if (button_processed[i]) {
+        midi_voice_release(i); // held notes end with the key
+        midi_cc_release(i);    // and controller ramps stop
+
+        // a momentary layer ends with its key
+        if (config_layer_release(i)) {
+          leds_update_for_layer(config_get_current_layer());
+          oled_display_layer_info(config_get_current_layer());
+        }
+      }
+      button_processed[i] = false; // reset after release
+    }
+  }
+}
+
+// a task missing from the table would never run, say so at boot
+static void register_task(const char *name, sched_task_fn_t fn,
+                          sched_priority_t priority, uint32_t period_ms,
+                          uint32_t deadline_us) {
+  if (sched_register(name, fn, priority, period_ms, deadline_us) < 0)
+    cdc_log("[MAIN] ERROR: task table full, %s not registered\n", name);
+}
+
+static void print_boot_message(void) {
+  sleep_ms(4000); // czekanie na CDC connection
+
+  cdc_log("\n");
+  cdc_log("========================================\n");
+  cdc_log("  MACRO KEYBOARD FIRMWARE \n");
+  cdc_log("========================================\n");
+  cdc_log("Device: Raspberry Pi Pico (RP2040)\n");
+  cdc_log("USB VID:PID = 0x%04X:0x%04X\n", USB_VID, USB_PID);
+  cdc_log("Buttons: %d (GP%d-GP%d)\n", NUM_BUTTONS, BTN_PIN_1, BTN_PIN_7);
+  cdc_log("LEDs: %d (GP%d-GP%d)\n", NUM_BUTTONS, LED_PIN_1, LED_PIN_7);
+  cdc_log("OLED: SPI0 (MOSI=GP%d, SCK=GP%d)\n", OLED_MOSI_PIN, OLED_SCK_PIN);
+  cdc_log("Layers: up to %d\n", MAX_LAYERS);
+  cdc_log("========================================\n");
+  cdc_log("\n");
+}
+
+void app_init(void) {
+  stdio_init_all();
+  tusb_init();
+  sleep_ms(1000);
+
+  cdc_log("[BOOT] Waiting for CDC connection...\n");
+  tud_task();
+  if (tud_cdc_connected()) {
+    cdc_log("[BOOT] CDC connected!\n");
+  }
+  sleep_ms(100);
+
+  print_boot_message();
+
+  cdc_log("[MAIN] Loading configuration...\n");
+  config_init();
+  text_stream_cache_rebuild();
+
+  cdc_log("[MAIN] Initializing CDC protocol...\n");
+  cdc_protocol_init();
+
+  cdc_log("[MAIN] Initializing hardware...\n");
+  hardware_init();
+  midi_tx_init();
+  midi_voice_init();
+  midi_cc_init();
+  midi_rx_init();
+  midi_clock_init();
+  led_rgb_update_os(0); // default to Linux
+
+  oled_display_layer_info(config_get_current_layer());
+  leds_update_for_layer(config_get_current_layer());
+
+  cdc_log("[MAIN] System ready!\n");
+  cdc_log("[MAIN] Press Button 1 (GP%d) to test\n", BTN_PIN_1);
+  cdc_log("\n");
+
+  oled_wake_up();
+
+  watchdog_enable(8000, 1);
+  cdc_log("[MAIN] Watchdog enabled (8s timeout)\n");
+
+  power_idle_init();
+  // the profiler registers its stream task, the table must be empty by then
+  sched_init();
+  profiler_init();
+
+  // usb runs on every pass and inside sched_delay_ms() during long macros
+  register_task("usb", tud_task, SCHED_PRIO_CRITICAL, 0, 1000);
+  // Note Off events of the timer wheel, it requests its own wakeups; gates
+  // end on time also while a blocking macro runs
+  register_task("midi_voice", midi_voice_task, SCHED_PRIO_CRITICAL, 0, 500);
+  // controller ramps, one budgeted update per millisecond at most
+  register_task("midi_cc", midi_cc_task, SCHED_PRIO_CRITICAL, 0, 500);
+  // host -> device MIDI drives the LED and OLED feedback and the clock,
+  // ticks are read as they come also during long macros
+  register_task("midi_rx", midi_rx_task, SCHED_PRIO_CRITICAL, 0, 1000);
+  // MIDI of a whole pass leaves in one write, also during long macros
+  register_task("midi_tx", midi_tx_task, SCHED_PRIO_CRITICAL, 0, 500);
+  register_task("cdc", cdc_protocol_task, SCHED_PRIO_HIGH, 0, 5000);
+  register_task("buttons", buttons_task, SCHED_PRIO_HIGH, 0, 0);
+  // macro programs run in the background, a budget of instructions per pass
+  register_task("macro_vm", macro_vm_task, SCHED_PRIO_NORMAL, 0, 2000);
+  register_task("os_toggle", check_os_toggle_button, SCHED_PRIO_NORMAL, 0,
+                1000);
+  register_task("oled_power", oled_power_save_task, SCHED_PRIO_LOW, 0,
+                20000);
+  register_task("oled_ui", oled_ui_task, SCHED_PRIO_LOW, 0, 20000);
+}
@@ -3,12 +3,17 @@
 #include "cdc/commands/cdc_cmd_read.h"
 #include "cdc/commands/cdc_cmd_system.h"
 #include "cdc/commands/cdc_cmd_write.h"
+#include "executor/actions/exec_script.h"
+#include "executor/macro_recorder.h"
 #include "hardware/watchdog.h"
+#include "macro_arena.h"
 #include "macro_config.h"
+#include "script_codec.h"
 #include "tusb.h"
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 void process_command(const char *cmd_input) {
   printf("[CDC] Command received: %s\n", cmd_input);
@@ -45,19 +50,66 @@ void process_command(const char *cmd_input) {
     return;
   }
 
-  config_data_t *config = config_get();
+  // late answer of an extra terminal probe (exec_script), no reply
+  if (strcmp(cmd_ptr, SCRIPT_READY_SENTINEL) == 0)
+    return;
 
   if (strcmp(cmd_ptr, "GET_CONF") == 0) {
     cmd_handle_get_conf();
     return;
   }
 
+  if (strcmp(cmd_ptr, "GET_SCHED") == 0) {
+    cmd_handle_get_sched(NULL);
+    return;
+  }
+
+  if (strncmp(cmd_ptr, "GET_SCHED|", 10) == 0) {
+    cmd_handle_get_sched(cmd_ptr + 10);
+    return;
+  }
+
+  if (strcmp(cmd_ptr, "GET_MIDI_STATS") == 0) {
+    cmd_handle_get_midi_stats(NULL);
+    return;
+  }
+
+  if (strncmp(cmd_ptr, "GET_MIDI_STATS|", 15) == 0) {
+    cmd_handle_get_midi_stats(cmd_ptr + 15);
+    return;
+  }
+
+  if (strcmp(cmd_ptr, "PROFILE") == 0) {
+    cmd_handle_profile(NULL);
+    return;
+  }
+
+  if (strncmp(cmd_ptr, "PROFILE|", 8) == 0) {
+    cmd_handle_profile(cmd_ptr + 8);
+    return;
+  }
+
   if (strncmp(cmd_ptr, "SET_OLED_TIMEOUT|", 17) == 0) {
     char *token = cmd_ptr + 17;
     cmd_handle_set_oled_timeout(token);
     return;
   }
 
+  if (strncmp(cmd_ptr, "SET_KB_LAYOUT|", 14) == 0) {
+    cmd_handle_set_kb_layout(cmd_ptr + 14);
+    return;
+  }
+
+  if (strncmp(cmd_ptr, "SET_UNICODE_TIMING|", 19) == 0) {
+    cmd_handle_set_unicode_timing(cmd_ptr + 19);
+    return;
+  }
+
+  if (strncmp(cmd_ptr, "SET_SEQ_TIMING|", 15) == 0) {
+    cmd_handle_set_seq_timing(cmd_ptr + 15);
+    return;
+  }
+
   if (strncmp(cmd_ptr, "SET_MACRO|", 10) == 0) {
     char *token = cmd_ptr + 10;
     cmd_handle_set_macro(token);
@@ -70,6 +122,11 @@ void process_command(const char *cmd_input) {
     return;
   }
 
+  if (strncmp(cmd_ptr, "SET_LAYER_COUNT|", 16) == 0) {
+    cmd_handle_set_layer_count(cmd_ptr + 16);
+    return;
+  }
+
   if (strncmp(cmd_ptr, "SET_MACRO_SCRIPT|", 17) == 0) {
     char *token = cmd_ptr + 17;
     cmd_handle_set_macro_script(token);
@@ -87,6 +144,32 @@ void process_command(const char *cmd_input) {
     return;
   }
 
+  if (strncmp(cmd_ptr, "REC_START|", 10) == 0) {
+    cmd_handle_rec_start(cmd_ptr + 10);
+    return;
+  }
+
+  if (strncmp(cmd_ptr, "REC_KEY|", 8) == 0) {
+    cmd_handle_rec_key(cmd_ptr + 8);
+    return;
+  }
+
+  if (strcmp(cmd_ptr, "REC_STOP") == 0) {
+    cmd_handle_rec_stop();
+    return;
+  }
+
+  if (strcmp(cmd_ptr, "REC_CANCEL") == 0) {
+    recorder_cancel();
+    cdc_send_response("OK");
+    return;
+  }
+
+  if (strncmp(cmd_ptr, "SET_MACRO_PROG|", 15) == 0) {
+    cmd_handle_set_macro_prog(cmd_ptr + 15);
+    return;
+  }
+
   if (strncmp(cmd_ptr, "SET_MACRO_SEQ|", 14) == 0) {
     char *token = cmd_ptr + 14;
     cmd_handle_set_macro_seq(token);
@@ -107,12 +190,14 @@ void process_command(const char *cmd_input) {
   cdc_send_response("ERROR|Unknown command");
 }
 
+// the script is checked before it goes to the arena
+static char script_rx[MAX_SCRIPT_SIZE];
+
 void cdc_receive_script(uint8_t layer, uint8_t button, uint8_t platform,
                         uint16_t script_size) {
   cdc_set_binary_mode(true);
 
-  config_data_t *config = config_get();
-  macro_entry_t *macro = &config->macros[layer][button];
+  macro_entry_t *macro = config_get_macro(layer, button);
 
   printf("[CDC] Receiving script: L%d B%d Platform=%d Size=%d\n", layer, button,
          platform, script_size);
@@ -131,7 +216,7 @@ void cdc_receive_script(uint8_t layer, uint8_t button, uint8_t platform,
 
     if (tud_cdc_available()) {
       char c = tud_cdc_read_char();
-      macro->script[received++] = c;
+      script_rx[received++] = c;
       timeout_start = time_us_32();
     }
 
@@ -140,18 +225,29 @@ void cdc_receive_script(uint8_t layer, uint8_t button, uint8_t platform,
     sleep_us(100);
   }
 
-  macro->script[received] = '\0';
+  script_rx[received] = '\0';
+  cdc_set_binary_mode(false);
+  if (!script_check(script_rx, received)) {
+    cdc_send_response("ERROR|Invalid packed script");
+    return;
+  }
+  // stored with the NUL, a script used on several layers is kept once
+  if (!macro_arena_set(layer, button, ARENA_SLOT_SCRIPT,
+                       (const uint8_t *)script_rx, received + 1)) {
+    cdc_send_response("ERROR|Arena full");
+    return;
+  }
   macro->type = MACRO_TYPE_SCRIPT;
   macro->script_platform = platform;
 
-  cdc_set_binary_mode(false);
   cdc_send_response("OK");
-  printf("[CDC] Script received successfully (%d bytes)\n", received);
+  printf("[CDC] Script received successfully (%d bytes, %d text)\n", received,
+         script_text_len(script_rx));
 }
 
 void cdc_receive_sequence(uint8_t layer, uint8_t button, uint8_t count,
                           uint8_t *steps) {
-  if (layer >= MAX_LAYERS || button >= NUM_BUTTONS) {
+  if (layer >= config_layer_count() || button >= NUM_BUTTONS) {
     cdc_send_response("ERROR|Invalid layer or button");
     return;
   }
@@ -161,20 +257,17 @@ void cdc_receive_sequence(uint8_t layer, uint8_t button, uint8_t count,
     return;
   }
 
-  if (count > MAX_SEQUENCE_STEPS) {
-    count = MAX_SEQUENCE_STEPS;
-  }
-
-  config_data_t *config = config_get();
-  macro_entry_t *macro = &config->macros[layer][button];
-
-  macro->type = MACRO_TYPE_KEY_SEQUENCE;
-  macro->sequence_length = count;
-
+  // steps go to the arena one by one, no length limit of a local buffer
+  macro_arena_clear(layer, button, ARENA_SLOT_SEQUENCE);
   for (int i = 0; i < count; i++) {
-    macro->sequence[i].keycode = steps[i * 2];
-    macro->sequence[i].modifiers = steps[i * 2 + 1];
+    key_step_t step = {.keycode = steps[i * 2], .modifiers = steps[i * 2 + 1]};
+    if (!macro_arena_append(layer, button, ARENA_SLOT_SEQUENCE,
+                            (const uint8_t *)&step, sizeof(step))) {
+      cdc_send_response("ERROR|Arena full");
+      return;
+    }
   }
 
+  config_get_macro(layer, button)->type = MACRO_TYPE_KEY_SEQUENCE;
   cdc_send_response("OK");
 }
@@ -2,12 +2,41 @@
 
 #include "cdc/cdc_transport.h"
 #include "firmware_version.h"
+#include "macro_arena.h"
 #include "macro_config.h"
+#include "midi/midi_tx.h"
+#include "scheduler/scheduler.h"
+#include "script_codec.h"
 #include "tusb.h"
 #include <stddef.h>
 #include <stdio.h>
 #include <string.h>
 
+#define PROG_CHUNK_BYTES 64
+
+// SCRIPT_DATA sends the text of packed scripts
+static script_reader_t reader;
+
+// bytecode in the same chunks SET_MACRO_PROG accepts
+static void send_program(int layer, int btn) {
+  uint16_t len = 0;
+  const uint8_t *code = macro_arena_get(layer, btn, ARENA_SLOT_PROGRAM, &len);
+
+  for (uint16_t offset = 0; offset < len; offset += PROG_CHUNK_BYTES) {
+    char hex[PROG_CHUNK_BYTES * 2 + 1];
+    uint16_t n = len - offset;
+    if (n > PROG_CHUNK_BYTES)
+      n = PROG_CHUNK_BYTES;
+
+    for (uint16_t i = 0; i < n; i++)
+      snprintf(&hex[i * 2], 3, "%02x", code[offset + i]);
+    hex[n * 2] = '\0';
+
+    cdc_send_response_fmt("PROG_DATA|%d|%d|%u|%s", layer, btn, offset, hex);
+    tud_cdc_write_flush();
+  }
+}
+
 void cmd_handle_get_conf(void) {
   config_data_t *config = config_get();
 
@@ -16,35 +45,54 @@ void cmd_handle_get_conf(void) {
   cdc_send_response("CONF_START");
   cdc_send_response_fmt("VERSION|%d.%d.%d", FW_VERSION_MAJOR, FW_VERSION_MINOR,
                         FW_VERSION_PATCH);
+  // the flash still holds an older layout whose data did not all fit
+  if (config_unmigrated_version() != 0)
+    cdc_send_response_fmt("MIGRATION_FAILED|%u", config_unmigrated_version());
   tud_cdc_write_flush();
 
   // global settings
-  cdc_send_response_fmt("SETTINGS|%lu", config->oled_timeout_s);
+  cdc_send_response_fmt("SETTINGS|%lu|%u", config->oled_timeout_s,
+                        config->kb_layout);
+  for (int p = 0; p < UNICODE_PLATFORMS; p++) {
+    const unicode_timing_t *t = &config->unicode_timing[p];
+    cdc_send_response_fmt("UNICODE_TIMING|%d|%u|%u|%u|%u", p, t->mode,
+                          t->settle_ms, t->key_ms, t->commit_ms);
+  }
+  for (int p = 0; p < UNICODE_PLATFORMS; p++) {
+    const seq_timing_t *t = &config->seq_timing[p];
+    cdc_send_response_fmt("SEQ_TIMING|%d|%u|%u|%u", p, t->hold_ms, t->gap_ms,
+                          t->mod_ms);
+  }
 
-  // layer names and emojis
-  for (int layer = 0; layer < MAX_LAYERS; layer++) {
+  // layer count (and the most the firmware can hold), names and emojis
+  cdc_send_response_fmt("LAYERS|%d|%d", config_layer_count(), MAX_LAYERS);
+  for (int layer = 0; layer < config_layer_count(); layer++) {
     cdc_send_response_fmt("LAYER_NAME|%d|%s|%d", layer,
-                          config->layer_names[layer],
-                          config->layer_emojis[layer]);
+                          config->layers[layer].name,
+                          config->layers[layer].emoji);
     tud_cdc_write_flush();
   }
-  printf("[CDC] Sent %d layer names\n", MAX_LAYERS);
+  printf("[CDC] Sent %d layer names\n", config_layer_count());
 
   // all macros
-  for (int layer = 0; layer < MAX_LAYERS; layer++) {
+  for (int layer = 0; layer < config_layer_count(); layer++) {
     for (int btn = 0; btn < NUM_BUTTONS; btn++) {
-      macro_entry_t *macro = &config->macros[layer][btn];
+      macro_entry_t *macro = &config->layers[layer].macros[btn];
+      uint16_t step_count = 0;
+      const key_step_t *steps = NULL;
+
       if (macro->type == MACRO_TYPE_SCRIPT) {
+        steps = macro_arena_steps(layer, btn, ARENA_SLOT_SHORTCUT, &step_count);
+
         // just metadata first
         cdc_send_response_fmt(
             "MACRO|%d|%d|%d|%d|%s|%s|%d|%d|%d", layer, btn, macro->type,
             macro->value, macro->macro_string, macro->name, macro->emoji_index,
-            macro->script_platform, macro->terminal_shortcut_length);
+            macro->script_platform, step_count);
 
-        for (int i = 0; i < macro->terminal_shortcut_length; i++) {
+        for (int i = 0; i < step_count; i++) {
           cdc_send_response_fmt("SCRIPT_SHORTCUT|%d|%d|%d|%d|%d", layer, btn, i,
-                                macro->terminal_shortcut[i].keycode,
-                                macro->terminal_shortcut[i].modifiers);
+                                steps[i].keycode, steps[i].modifiers);
         }
 
         // WHOLE script content streamingly
@@ -54,40 +102,44 @@ void cmd_handle_get_conf(void) {
                  macro->script_platform);
         tud_cdc_write_str(header);
 
-        // content char by char directly to usb
-        size_t len = strlen(macro->script);
-        for (size_t i = 0; i < len; i++) {
-          char c = macro->script[i];
-          if (c == '\n')
-            tud_cdc_write_str("\\n");
-          else if (c == '\r')
-            tud_cdc_write_str("\\r");
-          else if (c == '|')
-            tud_cdc_write_str("\\|");
-          else if (c == '\\')
-            tud_cdc_write_str("\\\\");
-          else
-            tud_cdc_write_char(c);
-
-          // flushing the buffer from time to time to avoid filling TinyUSB FIFO
-          if (i % 64 == 0)
-            tud_task();
+        // content char by char directly to usb (packed scripts decoded)
+        char part[64];
+        size_t n;
+        const uint8_t *script =
+            macro_arena_get(layer, btn, ARENA_SLOT_SCRIPT, NULL);
+        script_reader_open(&reader, script ? (const char *)script : "");
+        while ((n = script_reader_read(&reader, part, sizeof(part))) > 0) {
+          for (size_t i = 0; i < n; i++) {
+            char c = part[i];
+            if (c == '\n')
+              tud_cdc_write_str("\\n");
+            else if (c == '\r')
+              tud_cdc_write_str("\\r");
+            else if (c == '|')
+              tud_cdc_write_str("\\|");
+            else if (c == '\\')
+              tud_cdc_write_str("\\\\");
+            else
+              tud_cdc_write_char(c);
+          }
+
+          // flushing the buffer every part to avoid filling TinyUSB FIFO
+          tud_task();
         }
 
         // SCRIPT_DATA end line
         tud_cdc_write_str("\r\n");
         tud_cdc_write_flush();
       } else if (macro->type == MACRO_TYPE_KEY_SEQUENCE &&
-                 macro->sequence_length > 0) {
+                 (steps = macro_arena_steps(layer, btn, ARENA_SLOT_SEQUENCE,
+                                            &step_count)) != NULL) {
         cdc_send_response_fmt("MACRO_SEQ|%d|%d|%s|%d|%d", layer, btn,
-                              macro->name, macro->emoji_index,
-                              macro->sequence_length);
+                              macro->name, macro->emoji_index, step_count);
 
-        for (int i = 0; i < macro->sequence_length; i++) {
+        for (int i = 0; i < step_count; i++) {
           cdc_send_response_fmt("SEQ_STEP|%d|%d|%d|%d|%d|%d", layer, btn, i,
-                                macro->sequence[i].keycode,
-                                macro->sequence[i].modifiers,
-                                macro->sequence[i].duration);
+                                steps[i].keycode, steps[i].modifiers,
+                                steps[i].duration);
         }
       } else {
         cdc_send_response_fmt(
@@ -95,10 +147,13 @@ void cmd_handle_get_conf(void) {
             macro->value, macro->macro_string, macro->name, macro->emoji_index,
             macro->repeat_count, macro->repeat_interval, macro->move_x,
             macro->move_y);
+
+        if (macro->type == MACRO_TYPE_PROGRAM)
+          send_program(layer, btn);
       }
     }
   }
-  printf("[CDC] Sent %d macros\n", MAX_LAYERS * NUM_BUTTONS);
+  printf("[CDC] Sent %d macros\n", config_layer_count() * NUM_BUTTONS);
 
   printf("[CDC] About to send CONF_END...\n");
   cdc_send_response("CONF_END");
@@ -109,3 +164,52 @@ void cmd_handle_get_conf(void) {
   tud_cdc_write_flush();
   printf("[CDC] Configuration sent complete\n");
 }
+
+void cmd_handle_get_sched(const char *args) {
+  uint32_t passes = 0;
+  uint64_t busy_us = 0;
+  uint64_t idle_us = 0;
+  sched_get_loop_stats(&passes, &busy_us, &idle_us);
+
+  cdc_send_response("SCHED_START");
+  cdc_send_response_fmt("SCHED_LOOP|%lu|%llu|%llu", (unsigned long)passes,
+                        (unsigned long long)busy_us,
+                        (unsigned long long)idle_us);
+
+  for (uint8_t i = 0; i < sched_task_count(); i++) {
+    const sched_task_t *task = sched_get_task(i);
+    uint32_t avg_us = task->runs ? (uint32_t)(task->total_us / task->runs) : 0;
+
+    cdc_send_response_fmt("SCHED_TASK|%s|%d|%lu|%lu|%lu|%lu|%lu|%lu|%lu",
+                          task->name, task->priority,
+                          (unsigned long)task->period_ms,
+                          (unsigned long)task->deadline_us,
+                          (unsigned long)task->runs, (unsigned long)avg_us,
+                          (unsigned long)task->max_us,
+                          (unsigned long)task->overruns,
+                          (unsigned long)task->late_runs);
+    tud_cdc_write_flush();
+  }
+
+  cdc_send_response("SCHED_END");
+
+  if (args != NULL && strcmp(args, "RESET") == 0) {
+    sched_reset_stats();
+  }
+}
+
+void cmd_handle_get_midi_stats(const char *args) {
+  midi_tx_stats_t stats;
+  midi_tx_get_stats(&stats);
+
+  cdc_send_response_fmt("MIDI_STATS|%lu|%lu|%lu|%lu|%lu",
+                        (unsigned long)stats.events,
+                        (unsigned long)stats.coalesced,
+                        (unsigned long)stats.flushes,
+                        (unsigned long)stats.overflows,
+                        (unsigned long)stats.dropped);
+
+  if (args != NULL && strcmp(args, "RESET") == 0) {
+    midi_tx_reset_stats();
+  }
+}
@@ -2,13 +2,17 @@
 
 #include "cdc/cdc_transport.h"
 #include "cdc/commands/cdc_cmd_write.h"
+#include "executor/text_stream.h"
 #include "hardware_interface.h"
+#include "hid/keyboard_layout.h"
 #include "macro_config.h"
 #include "oled/oled_display.h"
 #include "pico/bootrom.h"
 #include "pico/stdlib.h"
+#include "profiler/profiler.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 void cmd_handle_save_flash(void) {
   if (config_save()) {
@@ -22,6 +26,7 @@ void cmd_handle_save_flash(void) {
 void cmd_handle_reload_config(void) {
   printf("[CDC] RELOAD_CONFIG command received\n");
   config_init();
+  text_stream_cache_rebuild();
   oled_display_layer_info(0);
   cdc_send_response("OK");
   printf("[CDC] Config reloaded\n");
@@ -59,6 +64,74 @@ void cmd_handle_set_oled_timeout(const char *args) {
   cdc_send_response("OK");
 }
 
+void cmd_handle_set_kb_layout(const char *args) {
+  int layout = kb_layout_parse(args);
+  if (layout < 0) {
+    cdc_send_response("ERROR|Unknown layout");
+    return;
+  }
+
+  config_get()->kb_layout = (uint8_t)layout;
+  text_stream_cache_rebuild();
+  cdc_log("[CDC] Keyboard layout: %s\n", kb_layout_name(layout));
+  cdc_send_response("OK");
+}
+
+void cmd_handle_set_unicode_timing(const char *args) {
+  int platform, mode, settle_ms, key_ms, commit_ms;
+
+  if (sscanf(args, "%d|%d|%d|%d|%d", &platform, &mode, &settle_ms, &key_ms,
+             &commit_ms) != 5) {
+    cdc_send_response("ERROR|Invalid SET_UNICODE_TIMING format");
+    return;
+  }
+
+  if (platform < 0 || platform >= UNICODE_PLATFORMS || mode < 0 ||
+      mode > UNICODE_MODE_HEX_INPUT || settle_ms < 0 || settle_ms > 255 ||
+      key_ms < 0 || key_ms > 255 || commit_ms < 0 || commit_ms > 255) {
+    cdc_send_response("ERROR|Invalid parameters");
+    return;
+  }
+
+  unicode_timing_t *t = &config_get()->unicode_timing[platform];
+  t->mode = (uint8_t)mode;
+  t->settle_ms = (uint8_t)settle_ms;
+  t->key_ms = (uint8_t)key_ms;
+  t->commit_ms = (uint8_t)commit_ms;
+
+  text_stream_cache_rebuild();
+  cdc_log("[CDC] Unicode timing P%d: mode %d, %d/%d/%d ms\n", platform, mode,
+          settle_ms, key_ms, commit_ms);
+  cdc_send_response("OK");
+}
+
+void cmd_handle_set_seq_timing(const char *args) {
+  int platform, hold_ms, gap_ms, mod_ms;
+
+  if (sscanf(args, "%d|%d|%d|%d", &platform, &hold_ms, &gap_ms, &mod_ms) !=
+      4) {
+    cdc_send_response("ERROR|Invalid SET_SEQ_TIMING format");
+    return;
+  }
+
+  if (platform < 0 || platform >= UNICODE_PLATFORMS || hold_ms < 0 ||
+      hold_ms > 255 || gap_ms < 0 || gap_ms > 255 || mod_ms < 0 ||
+      mod_ms > 255) {
+    cdc_send_response("ERROR|Invalid parameters");
+    return;
+  }
+
+  seq_timing_t *t = &config_get()->seq_timing[platform];
+  t->hold_ms = (uint8_t)hold_ms;
+  t->gap_ms = (uint8_t)gap_ms;
+  t->mod_ms = (uint8_t)mod_ms;
+  t->reserved = 0;
+
+  cdc_log("[CDC] Sequence timing P%d: %d/%d/%d ms\n", platform, hold_ms,
+          gap_ms, mod_ms);
+  cdc_send_response("OK");
+}
+
 void cmd_handle_bootsel(void) {
   cdc_log("[SYSTEM] Entering BOOTSEL mode...\n");
 
@@ -72,3 +145,34 @@ void cmd_handle_bootsel(void) {
 
   reset_usb_boot(0, 0);
 }
+
+void cmd_handle_profile(const char *args) {
+#ifdef TALOS_PROFILING
+  if (args == NULL) {
+    profiler_dump();
+    return;
+  }
+
+  if (strcmp(args, "RESET") == 0) {
+    profiler_reset();
+    cdc_send_response("OK");
+    return;
+  }
+
+  if (strncmp(args, "STREAM|", 7) == 0) {
+    int interval = atoi(args + 7);
+    if (interval < 0) {
+      cdc_send_response("ERROR|Invalid interval");
+      return;
+    }
+    profiler_set_stream((uint32_t)interval);
+    cdc_send_response("OK");
+    return;
+  }
+
+  cdc_send_response("ERROR|Invalid PROFILE format");
+#else
+  (void)args;
+  cdc_send_response("ERROR|Profiling disabled");
+#endif
+}
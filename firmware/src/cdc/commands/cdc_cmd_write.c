@@ -2,13 +2,36 @@
 
 #include "cdc/cdc_dispatcher.h"
 #include "cdc/cdc_transport.h"
+#include "executor/macro_recorder.h"
+#include "executor/macro_vm.h"
+#include "executor/text_stream.h"
 #include "hardware_interface.h"
+#include "macro_arena.h"
 #include "macro_config.h"
+#include "oled/oled_display.h"
+#include "pico/stdlib.h"
 #include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+// steps of one SET_MACRO_SEQ / SET_MACRO_SCRIPT line, "k,m," at the least
+#define STEPS_PER_LINE (CDC_MAX_COMMAND_LEN / 4)
+
+// arena data belongs to one macro type, a new type frees the rest
+static void clear_unused_slots(uint8_t layer, uint8_t button, uint8_t type) {
+  if (type != MACRO_TYPE_PROGRAM) {
+    macro_vm_stop();
+    macro_arena_clear(layer, button, ARENA_SLOT_PROGRAM);
+  }
+  if (type != MACRO_TYPE_KEY_SEQUENCE)
+    macro_arena_clear(layer, button, ARENA_SLOT_SEQUENCE);
+  if (type != MACRO_TYPE_SCRIPT) {
+    macro_arena_clear(layer, button, ARENA_SLOT_SHORTCUT);
+    macro_arena_clear(layer, button, ARENA_SLOT_SCRIPT);
+  }
+}
+
 void cmd_handle_set_macro(char *args) {
   int layer, button, type, value;
   int rep_cnt = 1, rep_int = 0, mx = 0, my = 0;
@@ -105,9 +128,10 @@ void cmd_handle_set_macro(char *args) {
   }
 
   // validation and assignment
-  if (layer >= 0 && layer < MAX_LAYERS && button >= 0 && button < NUM_BUTTONS) {
+  if (layer >= 0 && layer < config_layer_count() && button >= 0 &&
+      button < NUM_BUTTONS) {
 
-    macro_entry_t *macro = &config->macros[layer][button];
+    macro_entry_t *macro = &config->layers[layer].macros[button];
     macro->type = type;
     macro->value = value;
     strncpy(macro->macro_string, macro_string, MACRO_STRING_LEN - 1);
@@ -118,6 +142,12 @@ void cmd_handle_set_macro(char *args) {
     macro->move_x = (int16_t)mx;
     macro->move_y = (int16_t)my;
 
+    if (macro->type == MACRO_TYPE_TEXT_STRING)
+      text_stream_cache_rebuild();
+
+    // programs / steps come with their own commands
+    clear_unused_slots(layer, button, macro->type);
+
     cdc_send_response("OK");
     printf("[CDC] Macro set: L%d B%d '%s' %d\n", layer, button, name,
            emoji_index);
@@ -161,9 +191,9 @@ void cmd_handle_set_layer_name(char *args) {
     emoji_index = 0;
   }
 
-  if (layer >= 0 && layer < MAX_LAYERS) {
-    strncpy(config->layer_names[layer], name, MAX_NAME_LEN - 1);
-    config->layer_emojis[layer] = emoji_index;
+  if (layer >= 0 && layer < config_layer_count()) {
+    strncpy(config->layers[layer].name, name, MAX_NAME_LEN - 1);
+    config->layers[layer].emoji = emoji_index;
 
     cdc_send_response("OK");
     printf("[CDC] Layer name set: L%d = %d %s\n", layer, emoji_index, name);
@@ -172,6 +202,24 @@ void cmd_handle_set_layer_name(char *args) {
   }
 }
 
+void cmd_handle_set_layer_count(char *args) {
+  int count = atoi(args);
+
+  if (count < 1 || count > MAX_LAYERS ||
+      !config_set_layer_count((uint8_t)count)) {
+    cdc_send_response("ERROR|Invalid layer count");
+    return;
+  }
+
+  // dropped layers may have held cached text streams or the active layer
+  text_stream_cache_rebuild();
+  oled_display_layer_info(config_get_current_layer());
+  leds_update_for_layer(config_get_current_layer());
+
+  cdc_send_response("OK");
+  printf("[CDC] Layer count set: %d\n", count);
+}
+
 void cmd_handle_set_macro_seq(char *args) {
   int layer, button, step_count;
   char name[MAX_NAME_LEN] = {0};
@@ -215,7 +263,6 @@ void cmd_handle_set_macro_seq(char *args) {
     cdc_send_response("ERROR|Invalid SET_MACRO_SEQ format");
     return;
   }
-  size_t emoji_len = end_emoji - token;
   emoji_index = atoi(token);
   token = end_emoji + 1;
 
@@ -225,16 +272,16 @@ void cmd_handle_set_macro_seq(char *args) {
     return;
   token++;
 
-  config_data_t *config = config_get();
-  macro_entry_t *macro = &config->macros[layer][button];
-
-  macro->type = MACRO_TYPE_KEY_SEQUENCE;
-  macro->sequence_length = step_count;
-  strncpy(macro->name, name, MAX_NAME_LEN - 1);
-  macro->emoji_index = emoji_index;
+  if (layer < 0 || layer >= config_layer_count() || button < 0 ||
+      button >= NUM_BUTTONS || step_count < 0 || step_count > STEPS_PER_LINE) {
+    cdc_send_response("ERROR|Invalid parameters");
+    return;
+  }
 
   args = token; // start of the sequence data (steps)
 
+  key_step_t steps[STEPS_PER_LINE];
+  int parsed = 0;
   for (int i = 0; i < step_count; i++) {
     int keycode = 0, mods = 0, duration = 0;
     int chars_read = 0;
@@ -242,11 +289,10 @@ void cmd_handle_set_macro_seq(char *args) {
     // %n to know how many characters to move
     if (sscanf(args, "%d,%d,%d%n", &keycode, &mods, &duration, &chars_read) >=
         2) {
-      macro->sequence[i].keycode = (uint8_t)keycode;
-      macro->sequence[i].modifiers = (uint8_t)mods;
-      macro->sequence[i].duration = (uint16_t)duration;
-
-      printf("[CDC] Step %d: k=%d m=%d d=%d\n", i, keycode, mods, duration);
+      steps[i].keycode = (uint8_t)keycode;
+      steps[i].modifiers = (uint8_t)mods;
+      steps[i].duration = (uint16_t)duration;
+      parsed++;
 
       // moving pointer for the offest: readed data + 1 (for comma)
       args += chars_read;
@@ -258,7 +304,43 @@ void cmd_handle_set_macro_seq(char *args) {
     }
   }
 
+  // optional |offset: index of the first step, longer sequences come in
+  // several lines (0 starts a new one, the next continues at the end)
+  int offset = 0;
+  char *offset_field = strchr(args, '|');
+  if (offset_field)
+    offset = atoi(offset_field + 1);
+
+  uint16_t stored = 0;
+  macro_arena_steps(layer, button, ARENA_SLOT_SEQUENCE, &stored);
+
+  bool ok;
+  if (offset == 0) {
+    ok = macro_arena_set(layer, button, ARENA_SLOT_SEQUENCE,
+                         (const uint8_t *)steps, parsed * sizeof(key_step_t));
+  } else if (offset == stored) {
+    ok = macro_arena_append(layer, button, ARENA_SLOT_SEQUENCE,
+                            (const uint8_t *)steps,
+                            parsed * sizeof(key_step_t));
+  } else {
+    cdc_send_response("ERROR|Invalid offset");
+    return;
+  }
+
+  if (!ok) {
+    cdc_send_response("ERROR|Arena full");
+    return;
+  }
+
+  macro_entry_t *macro = &config_get()->layers[layer].macros[button];
+  macro->type = MACRO_TYPE_KEY_SEQUENCE;
+  strncpy(macro->name, name, MAX_NAME_LEN - 1);
+  macro->emoji_index = emoji_index;
+  clear_unused_slots(layer, button, MACRO_TYPE_KEY_SEQUENCE);
+
   cdc_send_response("OK");
+  printf("[CDC] Sequence L%d B%d: %d steps at %d, %u bytes free\n", layer,
+         button, parsed, offset, macro_arena_free_bytes());
 }
 
 void cmd_handle_set_macro_script(char *args) {
@@ -266,7 +348,7 @@ void cmd_handle_set_macro_script(char *args) {
   int layer, button, platform, size, shortcut_len;
   char name[MAX_NAME_LEN] = {0};
   uint8_t emoji_index = 0;
-  key_step_t temp_shortcut[MAX_SEQUENCE_STEPS];
+  key_step_t temp_shortcut[STEPS_PER_LINE];
   memset(temp_shortcut, 0, sizeof(temp_shortcut));
 
   char *token = args;
@@ -331,8 +413,10 @@ void cmd_handle_set_macro_script(char *args) {
   token = end_emoji + 1;
 
   shortcut_len = atoi(token);
-  if (shortcut_len > MAX_SEQUENCE_STEPS)
-    shortcut_len = MAX_SEQUENCE_STEPS;
+  if (shortcut_len < 0)
+    shortcut_len = 0;
+  if (shortcut_len > STEPS_PER_LINE)
+    shortcut_len = STEPS_PER_LINE;
 
   // format: k,m,k,m...
   char *step_token = strchr(token, '|');
@@ -354,19 +438,23 @@ void cmd_handle_set_macro_script(char *args) {
   }
 
   // validation and assignment
-  if (layer >= 0 && layer < MAX_LAYERS && button >= 0 && button < NUM_BUTTONS &&
-      platform >= 0 && platform <= 2 && size > 0 &&
+  if (layer >= 0 && layer < config_layer_count() && button >= 0 &&
+      button < NUM_BUTTONS && platform >= 0 &&
+      (platform & ~SCRIPT_DELIVERY_CDC) <= 2 && size > 0 &&
       size < MAX_SCRIPT_SIZE) { // leave room for null terminator
 
     config_data_t *config = config_get();
-    macro_entry_t *macro = &config->macros[layer][button];
+    macro_entry_t *macro = &config->layers[layer].macros[button];
 
     strncpy(macro->name, name, MAX_NAME_LEN - 1);
     macro->emoji_index = emoji_index;
 
-    macro->terminal_shortcut_length = shortcut_len;
-    for (int i = 0; i < MAX_SEQUENCE_STEPS; i++) {
-      macro->terminal_shortcut[i] = temp_shortcut[i];
+    clear_unused_slots(layer, button, MACRO_TYPE_SCRIPT);
+    if (!macro_arena_set(layer, button, ARENA_SLOT_SHORTCUT,
+                         (const uint8_t *)temp_shortcut,
+                         shortcut_len * sizeof(key_step_t))) {
+      cdc_send_response("ERROR|Arena full");
+      return;
     }
 
     // wait for the host to finish sending the command string
@@ -375,8 +463,8 @@ void cmd_handle_set_macro_script(char *args) {
     // flush any pending data in RX buffer to ensure clean state
     cdc_flush_rx();
 
-    // clear the script buffer to prevent garbage from previous runs
-    memset(macro->script, 0, MAX_SCRIPT_SIZE);
+    // drop the previous script, its space is free for the new one
+    macro_arena_clear(layer, button, ARENA_SLOT_SCRIPT);
 
     cdc_send_response("READY");
     cdc_receive_script(layer, button, platform, size);
@@ -384,3 +472,123 @@ void cmd_handle_set_macro_script(char *args) {
     cdc_send_response("ERROR|Invalid parameters");
   }
 }
+
+static int hex_nibble(char c) {
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+
+void cmd_handle_set_macro_prog(char *args) {
+  int layer, button, offset, consumed = 0;
+
+  if (sscanf(args, "%d|%d|%d|%n", &layer, &button, &offset, &consumed) < 3 ||
+      consumed == 0) {
+    cdc_send_response("ERROR|Invalid SET_MACRO_PROG format");
+    return;
+  }
+
+  if (layer < 0 || layer >= config_layer_count() || button < 0 ||
+      button >= NUM_BUTTONS) {
+    cdc_send_response("ERROR|Invalid parameters");
+    return;
+  }
+
+  // hex bytes of this chunk
+  uint8_t chunk[CDC_MAX_COMMAND_LEN / 2];
+  uint16_t len = 0;
+  for (const char *p = args + consumed; p[0] && p[1]; p += 2) {
+    int hi = hex_nibble(p[0]);
+    int lo = hex_nibble(p[1]);
+    if (hi < 0 || lo < 0) {
+      cdc_send_response("ERROR|Invalid hex");
+      return;
+    }
+    chunk[len++] = (uint8_t)(hi << 4 | lo);
+  }
+
+  // a program must not change under the running VM
+  macro_vm_stop();
+
+  uint16_t stored = 0;
+  macro_arena_get(layer, button, ARENA_SLOT_PROGRAM, &stored);
+
+  bool ok;
+  if (offset == 0) {
+    // the first chunk replaces the macro, its steps make room for the program
+    clear_unused_slots(layer, button, MACRO_TYPE_PROGRAM);
+    ok = macro_arena_set(layer, button, ARENA_SLOT_PROGRAM, chunk, len);
+  } else if (offset == stored) {
+    ok = macro_arena_append(layer, button, ARENA_SLOT_PROGRAM, chunk, len);
+  } else {
+    cdc_send_response("ERROR|Invalid offset");
+    return;
+  }
+
+  if (!ok) {
+    cdc_send_response("ERROR|Arena full");
+    return;
+  }
+
+  config_get()->layers[layer].macros[button].type = MACRO_TYPE_PROGRAM;
+  cdc_send_response("OK");
+  printf("[CDC] Program L%d B%d: %u bytes at %d, %u bytes free\n", layer,
+         button, len, offset, macro_arena_free_bytes());
+}
+
+void cmd_handle_rec_start(char *args) {
+  int layer, button;
+
+  if (sscanf(args, "%d|%d", &layer, &button) != 2 || layer < 0 ||
+      layer >= config_layer_count() || button < 0 || button >= NUM_BUTTONS) {
+    cdc_send_response("ERROR|Invalid parameters");
+    return;
+  }
+
+  if (!recorder_start((uint8_t)layer, (uint8_t)button)) {
+    cdc_send_response("ERROR|Recording in progress");
+    return;
+  }
+  cdc_send_response("OK");
+}
+
+void cmd_handle_rec_key(char *args) {
+  int down, keycode;
+  unsigned long delta_ms;
+
+  if (sscanf(args, "%d|%d|%lu", &down, &keycode, &delta_ms) != 3 ||
+      keycode < 0 || keycode > 255) {
+    cdc_send_response("ERROR|Invalid REC_KEY format");
+    return;
+  }
+
+  if (!recorder_active()) {
+    cdc_send_response("ERROR|Not recording");
+    return;
+  }
+
+  if (!recorder_feed(down != 0, (uint8_t)keycode, delta_ms)) {
+    cdc_send_response("ERROR|Recording full");
+    return;
+  }
+  cdc_send_response("OK");
+}
+
+void cmd_handle_rec_stop(void) {
+  uint16_t len = 0;
+
+  if (!recorder_active()) {
+    cdc_send_response("ERROR|Not recording");
+    return;
+  }
+
+  if (!recorder_stop(&len)) {
+    cdc_send_response("ERROR|Recording not stored");
+    return;
+  }
+  cdc_send_response_fmt("OK|%u", len);
+}
@@ -0,0 +1,350 @@
+#include "config_migrate.h"
+#include "hid/keyboard_layout.h"
+#include "macro_arena.h"
+#include "script_codec.h"
+#include <stdio.h>
+#include <string.h>
+
+// ==================== ARENA ====================
+// liczba blobow, ktore nie zmiescily sie w arenie (migracja bez zapisu)
+static uint16_t g_dropped;
+
+static void arena_copy(uint8_t layer, uint8_t button, uint8_t slot,
+                       const uint8_t *data, uint16_t len) {
+  if (len > 0 && !macro_arena_set(layer, button, slot, data, len))
+    g_dropped++;
+}
+
+// skrypt z pola macro_entry_t.script, zapisany z NUL jak przy wysylaniu;
+// rowne skrypty kilku warstw arena trzyma raz
+static void migrate_script(uint8_t layer, uint8_t button, const char *script) {
+  static char text[MAX_SCRIPT_SIZE];
+  memcpy(text, script, MAX_SCRIPT_SIZE);
+  text[MAX_SCRIPT_SIZE - 1] = '\0';
+
+  size_t len = strlen(text);
+  if (script_is_packed(text))
+    len = SCRIPT_PACKED_HEADER + ((uint8_t)text[3] | (uint8_t)text[4] << 8);
+  if (len == 0 || len >= MAX_SCRIPT_SIZE || !script_check(text, len))
+    return;
+  text[len] = '\0';
+  arena_copy(layer, button, ARENA_SLOT_SCRIPT, (const uint8_t *)text,
+             (uint16_t)(len + 1));
+}
+
+// ==================== WERSJA 1 ====================
+// programy wersji 4 z wyrownaniem i najwyzej jedna sekwencja albo skrot
+// terminala na makro zawsze sie mieszcza; skrypty (do 2 KB na makro) nie
+_Static_assert(CONFIG_V4_ARENA_SIZE +
+                       CONFIG_V1_LAYERS * NUM_BUTTONS *
+                           (MACRO_ARENA_ALIGN - 1 +
+                            CONFIG_V1_SEQUENCE_STEPS * sizeof(key_step_t)) <=
+                   MACRO_ARENA_SIZE,
+               "older layouts must fit the arena");
+
+static void migrate_steps_v1(uint8_t layer, uint8_t button, uint8_t slot,
+                             const key_step_t *steps, uint8_t count) {
+  if (count > CONFIG_V1_SEQUENCE_STEPS)
+    count = CONFIG_V1_SEQUENCE_STEPS;
+  arena_copy(layer, button, slot, (const uint8_t *)steps,
+             count * sizeof(key_step_t));
+}
+
+static void migrate_macro_v1(uint8_t layer, uint8_t button,
+                             const macro_entry_v1_t *old) {
+  macro_entry_t *macro = config_get_macro(layer, button);
+  macro->type = old->type;
+  macro->value = old->value;
+  macro->move_x = old->move_x;
+  macro->move_y = old->move_y;
+  macro->repeat_count = old->repeat_count;
+  macro->repeat_interval = old->repeat_interval;
+  memcpy(macro->macro_string, old->macro_string, MACRO_STRING_LEN);
+  memcpy(macro->name, old->name, MAX_NAME_LEN);
+  macro->emoji_index = old->emoji_index;
+  macro->script_platform = old->script_platform;
+
+  // kroki i skrypt ida do areny, tylko te ktorych typ makra uzywa
+  if (old->type == MACRO_TYPE_KEY_SEQUENCE) {
+    migrate_steps_v1(layer, button, ARENA_SLOT_SEQUENCE, old->sequence,
+                     old->sequence_length);
+  } else if (old->type == MACRO_TYPE_SCRIPT) {
+    migrate_steps_v1(layer, button, ARENA_SLOT_SHORTCUT,
+                     old->terminal_shortcut, old->terminal_shortcut_length);
+    migrate_script(layer, button, old->script);
+  }
+}
+
+// warstwy i makra zapisane jako macro_entry_v1_t
+static void migrate_layers_v1(const char names[][MAX_NAME_LEN],
+                              const uint8_t *emojis,
+                              const macro_entry_v1_t macros[][NUM_BUTTONS]) {
+  config_set_layer_count(CONFIG_V1_LAYERS);
+  for (uint8_t l = 0; l < CONFIG_V1_LAYERS; l++) {
+    layer_t *layer = config_get_layer(l);
+    memcpy(layer->name, names[l], MAX_NAME_LEN);
+    layer->emoji = emojis[l];
+    for (uint8_t b = 0; b < NUM_BUTTONS; b++)
+      migrate_macro_v1(l, b, &macros[l][b]);
+  }
+}
+
+static bool migrate_v1(const uint8_t *flash) {
+  const config_v1_t *old = (const config_v1_t *)flash;
+  if (config_crc32(flash, offsetof(config_v1_t, crc32)) != old->crc32)
+    return false;
+
+  // pola dodane po wersji 1 (uklad klawiatury, czasy, arena) maja wartosci
+  // fabryczne
+  config_set_factory_defaults();
+  config_data_t *config = config_get();
+  config->global_text_platform = old->global_text_platform;
+  config->oled_timeout_s = old->oled_timeout_s;
+  migrate_layers_v1(old->layer_names, old->layer_emojis, old->macros);
+
+  printf("[CONFIG] Migrated version 1 layout\n");
+  return true;
+}
+
+// ==================== WERSJE 2+ ====================
+// CRC i wersja na poczatku, CRC obejmuje reszte struktury
+static bool image_valid(const uint8_t *flash, uint16_t version, size_t size) {
+  const config_v2_t *header = (const config_v2_t *)flash;
+  return header->version == version &&
+         config_crc32(flash + sizeof(header->crc32),
+                      size - sizeof(header->crc32)) == header->crc32;
+}
+
+static bool migrate_v2(const uint8_t *flash) {
+  const config_v2_t *old = (const config_v2_t *)flash;
+  if (!image_valid(flash, 2, sizeof(config_v2_t)))
+    return false;
+
+  config_set_factory_defaults();
+  config_data_t *config = config_get();
+  config->global_text_platform = old->global_text_platform;
+  config->oled_timeout_s = old->oled_timeout_s;
+  if (old->kb_layout < KB_LAYOUT_COUNT)
+    config->kb_layout = old->kb_layout;
+  migrate_layers_v1(old->layer_names, old->layer_emojis, old->macros);
+
+  printf("[CONFIG] Migrated version 2 layout\n");
+  return true;
+}
+
+static bool migrate_v3(const uint8_t *flash) {
+  const config_v3_t *old = (const config_v3_t *)flash;
+  if (!image_valid(flash, 3, sizeof(config_v3_t)))
+    return false;
+
+  // arena (programy) pusta
+  config_set_factory_defaults();
+  config_data_t *config = config_get();
+  config->global_text_platform = old->global_text_platform;
+  config->oled_timeout_s = old->oled_timeout_s;
+  if (old->kb_layout < KB_LAYOUT_COUNT)
+    config->kb_layout = old->kb_layout;
+  for (uint8_t p = 0; p < UNICODE_PLATFORMS; p++) {
+    if (old->unicode_timing[p].mode <= UNICODE_MODE_HEX_INPUT)
+      config->unicode_timing[p] = old->unicode_timing[p];
+  }
+  migrate_layers_v1(old->layer_names, old->layer_emojis, old->macros);
+
+  printf("[CONFIG] Migrated version 3 layout\n");
+  return true;
+}
+
+static bool migrate_v4(const uint8_t *flash) {
+  const config_v4_t *old = (const config_v4_t *)flash;
+  if (!image_valid(flash, 4, sizeof(config_v4_t)))
+    return false;
+
+  config_set_factory_defaults();
+  config_data_t *config = config_get();
+  config->global_text_platform = old->global_text_platform;
+  config->oled_timeout_s = old->oled_timeout_s;
+  if (old->kb_layout < KB_LAYOUT_COUNT)
+    config->kb_layout = old->kb_layout;
+  for (uint8_t p = 0; p < UNICODE_PLATFORMS; p++) {
+    if (old->unicode_timing[p].mode <= UNICODE_MODE_HEX_INPUT)
+      config->unicode_timing[p] = old->unicode_timing[p];
+  }
+  migrate_layers_v1(old->layer_names, old->layer_emojis, old->macros);
+
+  // programy z areny bez wyrownania
+  for (uint8_t l = 0; l < CONFIG_V1_LAYERS; l++) {
+    for (uint8_t b = 0; b < NUM_BUTTONS; b++) {
+      const arena_ref_t *ref = &old->arena.refs[l][b];
+      if (old->macros[l][b].type != MACRO_TYPE_PROGRAM || ref->len == 0 ||
+          (uint32_t)ref->offset + ref->len > CONFIG_V4_ARENA_SIZE)
+        continue;
+      arena_copy(l, b, ARENA_SLOT_PROGRAM, &old->arena.data[ref->offset],
+                 ref->len);
+    }
+  }
+
+  printf("[CONFIG] Migrated version 4 layout\n");
+  return true;
+}
+
+// ==================== WERSJE 5+ ====================
+// makra bez krokow, kroki i programy w wyrownanej arenie, skrypt w makrze
+static void migrate_layers_v5(const char names[][MAX_NAME_LEN],
+                              const uint8_t *emojis,
+                              const macro_entry_v5_t macros[][NUM_BUTTONS],
+                              const macro_arena_v5_t *arena) {
+  config_set_layer_count(CONFIG_V1_LAYERS);
+  for (uint8_t l = 0; l < CONFIG_V1_LAYERS; l++) {
+    layer_t *layer = config_get_layer(l);
+    memcpy(layer->name, names[l], MAX_NAME_LEN);
+    layer->emoji = emojis[l];
+    for (uint8_t b = 0; b < NUM_BUTTONS; b++) {
+      const macro_entry_v5_t *old = &macros[l][b];
+      macro_entry_t *macro = &layer->macros[b];
+      macro->type = old->type;
+      macro->value = old->value;
+      macro->move_x = old->move_x;
+      macro->move_y = old->move_y;
+      macro->repeat_count = old->repeat_count;
+      macro->repeat_interval = old->repeat_interval;
+      memcpy(macro->macro_string, old->macro_string, MACRO_STRING_LEN);
+      memcpy(macro->name, old->name, MAX_NAME_LEN);
+      macro->emoji_index = old->emoji_index;
+      macro->script_platform = old->script_platform;
+      if (old->type == MACRO_TYPE_SCRIPT)
+        migrate_script(l, b, old->script);
+
+      for (uint8_t slot = 0; slot < CONFIG_V5_ARENA_SLOTS; slot++) {
+        const arena_ref_t *ref = &arena->refs[l][b][slot];
+        if (ref->len == 0 ||
+            (uint32_t)ref->offset + ref->len > CONFIG_V5_ARENA_SIZE)
+          continue;
+        arena_copy(l, b, slot, &arena->data[ref->offset], ref->len);
+      }
+    }
+  }
+}
+
+static bool migrate_v5(const uint8_t *flash) {
+  const config_v5_t *old = (const config_v5_t *)flash;
+  if (!image_valid(flash, 5, sizeof(config_v5_t)))
+    return false;
+
+  // czasy sekwencji fabryczne
+  config_set_factory_defaults();
+  config_data_t *config = config_get();
+  config->global_text_platform = old->global_text_platform;
+  config->oled_timeout_s = old->oled_timeout_s;
+  if (old->kb_layout < KB_LAYOUT_COUNT)
+    config->kb_layout = old->kb_layout;
+  for (uint8_t p = 0; p < UNICODE_PLATFORMS; p++) {
+    if (old->unicode_timing[p].mode <= UNICODE_MODE_HEX_INPUT)
+      config->unicode_timing[p] = old->unicode_timing[p];
+  }
+  migrate_layers_v5(old->layer_names, old->layer_emojis, old->macros,
+                    &old->arena);
+
+  printf("[CONFIG] Migrated version 5 layout\n");
+  return true;
+}
+
+// wersja 7 ma ten sam uklad, skrypty moga byc spakowane LZSS
+static bool migrate_v6(const uint8_t *flash) {
+  const config_v6_t *old = (const config_v6_t *)flash;
+  if (!image_valid(flash, 6, sizeof(config_v6_t)) &&
+      !image_valid(flash, 7, sizeof(config_v6_t)))
+    return false;
+
+  config_set_factory_defaults();
+  config_data_t *config = config_get();
+  config->global_text_platform = old->global_text_platform;
+  config->oled_timeout_s = old->oled_timeout_s;
+  if (old->kb_layout < KB_LAYOUT_COUNT)
+    config->kb_layout = old->kb_layout;
+  for (uint8_t p = 0; p < UNICODE_PLATFORMS; p++) {
+    if (old->unicode_timing[p].mode <= UNICODE_MODE_HEX_INPUT)
+      config->unicode_timing[p] = old->unicode_timing[p];
+    if (old->seq_timing[p].reserved == 0)
+      config->seq_timing[p] = old->seq_timing[p];
+  }
+  migrate_layers_v5(old->layer_names, old->layer_emojis, old->macros,
+                    &old->arena);
+
+  printf("[CONFIG] Migrated version %d layout\n", old->version);
+  return true;
+}
+
+// ==================== WERSJA 8 ====================
+// cztery warstwy w tablicach konfiguracji, odwolania w arenie
+static bool migrate_v8(const uint8_t *flash) {
+  const config_v8_t *old = (const config_v8_t *)flash;
+  if (!image_valid(flash, 8, sizeof(config_v8_t)))
+    return false;
+
+  config_set_factory_defaults();
+  config_data_t *config = config_get();
+  config->global_text_platform = old->global_text_platform;
+  config->oled_timeout_s = old->oled_timeout_s;
+  if (old->kb_layout < KB_LAYOUT_COUNT)
+    config->kb_layout = old->kb_layout;
+  for (uint8_t p = 0; p < UNICODE_PLATFORMS; p++) {
+    if (old->unicode_timing[p].mode <= UNICODE_MODE_HEX_INPUT)
+      config->unicode_timing[p] = old->unicode_timing[p];
+    if (old->seq_timing[p].reserved == 0)
+      config->seq_timing[p] = old->seq_timing[p];
+  }
+
+  config_set_layer_count(CONFIG_V1_LAYERS);
+  for (uint8_t l = 0; l < CONFIG_V1_LAYERS; l++) {
+    layer_t *layer = config_get_layer(l);
+    memcpy(layer->name, old->layer_names[l], MAX_NAME_LEN);
+    layer->emoji = old->layer_emojis[l];
+    for (uint8_t b = 0; b < NUM_BUTTONS; b++) {
+      const macro_entry_v8_t *old_macro = &old->macros[l][b];
+      macro_entry_t *macro = &layer->macros[b];
+      macro->type = old_macro->type;
+      macro->value = old_macro->value;
+      macro->move_x = old_macro->move_x;
+      macro->move_y = old_macro->move_y;
+      macro->repeat_count = old_macro->repeat_count;
+      macro->repeat_interval = old_macro->repeat_interval;
+      memcpy(macro->macro_string, old_macro->macro_string, MACRO_STRING_LEN);
+      memcpy(macro->name, old_macro->name, MAX_NAME_LEN);
+      macro->emoji_index = old_macro->emoji_index;
+      macro->script_platform = old_macro->script_platform;
+
+      // ta sama arena, wspolne bloby znow zapisane raz
+      for (uint8_t slot = 0; slot < CONFIG_V8_ARENA_SLOTS; slot++) {
+        const arena_ref_t *ref = &old->arena.refs[l][b][slot];
+        if (ref->len == 0 ||
+            (uint32_t)ref->offset + ref->len > CONFIG_V8_ARENA_SIZE)
+          continue;
+        arena_copy(l, b, slot, &old->arena.data[ref->offset], ref->len);
+      }
+    }
+  }
+
+  printf("[CONFIG] Migrated version 8 layout\n");
+  return true;
+}
+
+// ==================== API ====================
+// kolejne wersje ukladu dodaja tu swoje kroki
+config_migrate_result_t config_migrate(const uint8_t *flash,
+                                       uint16_t *version) {
+  g_dropped = 0;
+  if (migrate_v1(flash))
+    *version = 1;
+  else if (migrate_v2(flash) || migrate_v3(flash) || migrate_v4(flash) ||
+           migrate_v5(flash) || migrate_v6(flash) || migrate_v8(flash))
+    *version = ((const config_v2_t *)flash)->version;
+  else
+    return CONFIG_MIGRATE_UNKNOWN;
+
+  if (g_dropped > 0) {
+    printf("[CONFIG] %u blobs of version %u do not fit the arena\n", g_dropped,
+           *version);
+    return CONFIG_MIGRATE_NO_SPACE;
+  }
+  return CONFIG_MIGRATE_OK;
+}
@@ -5,6 +5,7 @@
 #include "oled/screensaver/screensaver_utils.h"
 #include "pico/stdlib.h"
 #include "pin_definitions.h"
+#include "scheduler/scheduler.h"
 #include "tusb.h"
 #include <math.h>
 #include <stdio.h>
@@ -127,7 +128,7 @@ void run_game_breakout(void) {
     // check exit
     if (button_is_pressed(0)) {
       // debounce exit
-      sleep_ms(200);
+      sched_delay_ms(200);
       while (button_is_pressed(0))
         tight_loop_contents();
       return;
@@ -146,6 +147,6 @@ void run_game_breakout(void) {
     oled_wake_up();    // keep oled awake
     tud_task();        // keep usb alive
 
-    sleep_ms(16); // ~60fps
+    sched_delay_ms(16); // ~60fps
   }
 }
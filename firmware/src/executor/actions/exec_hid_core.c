@@ -4,6 +4,7 @@
 #include "hardware/watchdog.h"
 #include "pico/stdlib.h"
 #include "pin_definitions.h"
+#include "scheduler/scheduler.h"
 #include "tusb.h"
 
 bool check_cancel(uint8_t btn_index, bool *wait_for_release) {
@@ -31,13 +32,13 @@ void send_key_with_modifiers(uint8_t modifiers, uint8_t keycode,
 
   uint8_t report[6] = {keycode, 0, 0, 0, 0, 0};
   tud_hid_keyboard_report(1, modifiers, report);
-  sleep_ms(press_ms);
+  sched_delay_ms(press_ms);
 
   while (!tud_hid_ready())
     tud_task();
 
   tud_hid_keyboard_report(1, modifiers, NULL); // release key, keep modifiers
-  sleep_ms(20);
+  sched_delay_ms(20);
 }
 
 void press_sequence(uint8_t modifiers, uint8_t keycode) {
@@ -48,14 +49,14 @@ void press_sequence(uint8_t modifiers, uint8_t keycode) {
   uint8_t report[6] = {keycode, 0, 0, 0, 0, 0};
   tud_hid_keyboard_report(1, modifiers, report);
 
-  sleep_ms(60); // registering shortcut in os
+  sched_delay_ms(60); // registering shortcut in os
 
   // 2. release key, keep modifiers
   if (keycode != 0) {
     while (!tud_hid_ready())
       tud_task();
     tud_hid_keyboard_report(1, modifiers, NULL);
-    sleep_ms(20);
+    sched_delay_ms(20);
   }
 
   // 3. ANTI-SPOTLIGHT
@@ -69,7 +70,7 @@ void press_sequence(uint8_t modifiers, uint8_t keycode) {
       tud_task();
 
     tud_hid_keyboard_report(1, safe_mods, NULL);
-    sleep_ms(20);
+    sched_delay_ms(20);
   }
 
   // 4. release all
@@ -77,7 +78,7 @@ void press_sequence(uint8_t modifiers, uint8_t keycode) {
     tud_task();
 
   tud_hid_keyboard_report(1, 0, NULL);
-  sleep_ms(50);
+  sched_delay_ms(50);
 }
 
 void exec_key_repeat(uint8_t keycode, uint16_t count, uint16_t interval) {
@@ -88,7 +89,7 @@ void exec_key_repeat(uint8_t keycode, uint16_t count, uint16_t interval) {
     press_sequence(0, keycode);
 
     if (i < count - 1) {
-      sleep_ms(interval > 0 ? interval : 20);
+      sched_delay_ms(interval > 0 ? interval : 20);
     }
     tud_task(); // keep alive
   }
@@ -110,7 +111,7 @@ void exec_key_repeat_fast(uint8_t keycode, uint16_t count, uint16_t interval) {
 
     uint8_t report[6] = {keycode, 0, 0, 0, 0, 0};
     tud_hid_keyboard_report(1, 0, report);
-    sleep_ms(hold_time);
+    sched_delay_ms(hold_time);
 
     // release
     while (!tud_hid_ready())
@@ -120,19 +121,83 @@ void exec_key_repeat_fast(uint8_t keycode, uint16_t count, uint16_t interval) {
 
     // delay
     if (i < count - 1) {
-      sleep_ms(wait_time);
+      sched_delay_ms(wait_time);
     }
     tud_task(); // keep USB alive
   }
 }
 
-void exec_key_sequence(const key_step_t *sequence, uint8_t len) {
-  for (int i = 0; i < len; i++) {
+// ==================== SEQUENCE ENGINE ====================
+
+static void seq_report(uint8_t modifiers, uint8_t keycode, uint8_t wait_ms) {
+  while (!tud_hid_ready())
+    tud_task();
+
+  uint8_t report[6] = {keycode, 0, 0, 0, 0, 0};
+  tud_hid_keyboard_report(1, modifiers, keycode ? report : NULL);
+  if (wait_ms)
+    sched_delay_ms(wait_ms);
+}
+
+static void seq_release_modifiers(uint8_t held, bool gui_alone,
+                                  const seq_timing_t *t) {
+  // ANTI-SPOTLIGHT, only for a GUI tap without a key under it (the
+  // Meta+Ctrl chord does not open the menu on Linux)
+  if (gui_alone)
+    seq_report(held | MODIFIER_LEFT_CTRL, 0, t->mod_ms);
+
+  seq_report(0, 0, t->mod_ms);
+}
+
+void exec_key_sequence(const key_step_t *sequence, uint16_t len) {
+  const seq_timing_t *t =
+      &config_get()->seq_timing[detect_platform() % UNICODE_PLATFORMS];
+  uint8_t held = 0;       // modifiers down, shared by merged steps
+  bool gui_alone = false; // GUI down and no key pressed under it yet
+
+  for (uint16_t i = 0; i < len; i++) {
+    const key_step_t *step = &sequence[i];
     watchdog_update();
-    press_sequence(sequence[i].modifiers, sequence[i].keycode);
 
-    if (sequence[i].duration > 0) {
-      sleep_ms(sequence[i].duration);
+    // 1. modifiers down (already down when merged with the previous step)
+    if (step->modifiers != held) {
+      seq_report(step->modifiers, 0, t->mod_ms);
+      held = step->modifiers;
+      gui_alone = (held & (MODIFIER_LEFT_GUI | MODIFIER_RIGHT_GUI)) != 0;
     }
+
+    // 2. key down + up, a modifier only step just holds them
+    if (step->keycode != 0) {
+      seq_report(held, step->keycode, t->hold_ms);
+      seq_report(held, 0, t->gap_ms);
+      gui_alone = false;
+    } else if (t->hold_ms) {
+      sched_delay_ms(t->hold_ms);
+    }
+
+    // 3. modifiers up, unless the next key is pressed with the same ones
+    bool merge = i + 1 < len && sequence[i + 1].keycode != 0 &&
+                 sequence[i + 1].modifiers == held;
+    if (held && !merge) {
+      seq_release_modifiers(held, gui_alone, t);
+      held = 0;
+    }
+
+    if (step->duration > 0)
+      sched_delay_ms(step->duration);
   }
 }
+
+// ==================== HOST LEDS ====================
+
+static uint8_t host_leds;
+static uint32_t host_led_changes;
+
+void hid_host_leds_set(uint8_t leds) {
+  if (leds == host_leds)
+    return;
+  host_leds = leds;
+  host_led_changes++;
+}
+
+uint32_t hid_host_led_changes(void) { return host_led_changes; }
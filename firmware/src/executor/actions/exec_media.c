@@ -0,0 +1,40 @@
+#include "executor/actions/exec_media.h"
+
+#include "cdc/cdc_transport.h"
+#include "scheduler/scheduler.h"
+#include "tusb.h"
+#include <stdint.h>
+
+// one report per host poll, press and release of the same key
+static void send_report(uint8_t report_id, const void *report, uint16_t len) {
+  while (!tud_hid_ready())
+    tud_task();
+  tud_hid_report(report_id, report, len);
+}
+
+void exec_consumer_key(uint16_t usage, uint16_t count, uint16_t interval) {
+  const uint16_t release = 0;
+
+  if (count == 0)
+    count = 1;
+
+  for (uint16_t i = 0; i < count; i++) {
+    send_report(4, &usage, sizeof(usage));
+    send_report(4, &release, sizeof(release));
+
+    if (i < count - 1 && interval > 0)
+      sched_delay_ms(interval);
+  }
+  cdc_log("[MEDIA] Consumer 0x%04X x%d\n", usage, count);
+}
+
+void exec_system_key(uint8_t code) {
+  const uint8_t release = 0;
+
+  if (code < SYSTEM_KEY_POWER_DOWN || code > SYSTEM_KEY_WAKE_UP)
+    return;
+
+  send_report(5, &code, sizeof(code));
+  send_report(5, &release, sizeof(release));
+  cdc_log("[MEDIA] System %d\n", code);
+}
@@ -1,10 +1,14 @@
 #include "executor/actions/exec_midi_core.h"
 
 #include "cdc/cdc_transport.h"
+#include "executor/midi_cc.h"
+#include "executor/midi_voice.h"
+#include "midi/midi_tx.h"
 #include "pico/stdlib.h"
-#include "tusb.h"
+#include "scheduler/scheduler.h"
 
-void exec_midi_note(uint8_t note, uint8_t velocity, uint8_t channel) {
+void exec_midi_note(uint8_t note, uint8_t velocity, uint8_t channel,
+                    uint16_t gate_ms, uint8_t button) {
   // channel conversion from 1-16 to 0-15 (midi protocol)
   // channel = 0 (default), assign to 0 (channel 1)
   uint8_t midi_channel = (channel > 0) ? channel - 1 : 0;
@@ -17,29 +21,10 @@ void exec_midi_note(uint8_t note, uint8_t velocity, uint8_t channel) {
   if (midi_channel > 15)
     midi_channel = 0; // fallback to ch 1
 
-  uint8_t msg[3];
-
-  // --- Note ON ---
-  msg[0] = 0x90 | midi_channel; // 0x90 = Note On status for channel
-  msg[1] = note;
-  msg[2] = velocity;
-
-  if (tud_midi_mounted()) {
-    tud_midi_stream_write(0, msg, 3);
-    cdc_log("[MIDI] Note ON: %d Vel: %d Ch: %d\n", note, velocity,
-            midi_channel + 1);
-  }
-
-  sleep_ms(100);
-
-  // --- Note OFF ---
-  msg[0] = 0x80 | midi_channel; // 0x80 = Note Off status
-  msg[2] = 0;                   // velocity 0
-
-  if (tud_midi_mounted()) {
-    tud_midi_stream_write(0, msg, 3);
-    cdc_log("[MIDI] Note OFF\n");
-  }
+  // Note On right away, Note Off from the voice scheduler
+  midi_voice_note_on(button, note, velocity, midi_channel, gate_ms);
+  cdc_log("[MIDI] Note ON: %d Vel: %d Ch: %d Gate: %d\n", note, velocity,
+          midi_channel + 1, gate_ms);
 }
 
 void exec_midi_cc(uint8_t controller, uint8_t value, uint8_t channel) {
@@ -53,15 +38,50 @@ void exec_midi_cc(uint8_t controller, uint8_t value, uint8_t channel) {
   if (midi_channel > 15)
     midi_channel = 0;
 
-  uint8_t msg[3];
   // status byte 0xB0 = Control Change
-  msg[0] = 0xB0 | midi_channel;
-  msg[1] = controller;
-  msg[2] = value;
-
-  if (tud_midi_mounted()) {
-    tud_midi_stream_write(0, msg, 3);
+  if (midi_tx_message(0xB0 | midi_channel, controller, value)) {
     cdc_log("[MIDI] CC: %d Val: %d Ch: %d\n", controller, value,
             midi_channel + 1);
   }
 }
+
+bool exec_midi_controller(uint16_t mode, uint16_t value, uint8_t channel,
+                          uint16_t param, uint16_t ramp_ms, uint8_t button) {
+  uint8_t controller = mode & MIDI_CC_CONTROLLER_MASK;
+  uint8_t resolution = (mode >> MIDI_CC_RES_SHIFT) & 0x03;
+  uint8_t curve = (mode >> MIDI_CC_CURVE_SHIFT) & 0x03;
+
+  // plain 7-bit value, the original single message
+  if (resolution == MIDI_CC_RES_7BIT && !(mode & MIDI_CC_RAMP)) {
+    exec_midi_cc(controller, (uint8_t)(value > 127 ? 127 : value), channel);
+    return false;
+  }
+
+  midi_cc_dest_t dest = {
+      .channel = (channel > 0 && channel <= 16) ? channel - 1 : 0,
+      .resolution = resolution > MIDI_CC_RES_NRPN ? MIDI_CC_RES_7BIT
+                                                  : resolution,
+      .controller = controller,
+      .param = param & 0x3FFF,
+  };
+  // 14-bit pairs are controllers 0-31 with their LSB at +32
+  if (dest.resolution == MIDI_CC_RES_14BIT && dest.controller > 31)
+    dest.controller = 31;
+  else if (dest.controller > 119)
+    dest.controller = 119;
+
+  if (!(mode & MIDI_CC_RAMP)) {
+    midi_cc_set(&dest, value);
+    cdc_log("[MIDI] CC%s: %d Val: %d Ch: %d\n",
+            dest.resolution == MIDI_CC_RES_NRPN ? " NRPN" : " 14-bit",
+            dest.resolution == MIDI_CC_RES_NRPN ? dest.param : controller,
+            value, dest.channel + 1);
+    return false;
+  }
+
+  midi_cc_ramp(button, &dest, value, curve, ramp_ms);
+  cdc_log("[MIDI] CC ramp: %d -> %d Ch: %d\n",
+          dest.resolution == MIDI_CC_RES_NRPN ? dest.param : controller, value,
+          dest.channel + 1);
+  return true;
+}
@@ -2,7 +2,9 @@
 
 #include "cdc/cdc_transport.h"
 #include "executor/actions/exec_hid_core.h"
+#include "executor/mouse_motion.h"
 #include "hardware/watchdog.h"
+#include "scheduler/scheduler.h"
 #include "tusb.h"
 #include <stdbool.h>
 #include <stdint.h>
@@ -24,10 +26,10 @@ void exec_mouse_click(uint8_t buttons, uint16_t count, uint16_t interval,
         break;
 
       tud_task();
-      sleep_ms(1);
+      sched_delay_ms(1);
     }
 
-    sleep_ms(50);
+    sched_delay_ms(50);
 
     retry = 50;
     while (retry-- > 0) {
@@ -35,10 +37,10 @@ void exec_mouse_click(uint8_t buttons, uint16_t count, uint16_t interval,
         break;
 
       tud_task();
-      sleep_ms(1);
+      sched_delay_ms(1);
     }
 
-    sleep_ms(50);
+    sched_delay_ms(50);
   }
 
   for (uint16_t i = 0; i < count; i++) {
@@ -60,13 +62,13 @@ void exec_mouse_click(uint8_t buttons, uint16_t count, uint16_t interval,
       }
 
       tud_task();
-      sleep_ms(1);
+      sched_delay_ms(1);
     }
 
     if (!sent)
       cdc_log("[MOUSE] Drop Press\n");
 
-    sleep_ms(hold_time);
+    sched_delay_ms(hold_time);
 
     // release
     retry = 50;
@@ -79,7 +81,7 @@ void exec_mouse_click(uint8_t buttons, uint16_t count, uint16_t interval,
       }
 
       tud_task();
-      sleep_ms(1);
+      sched_delay_ms(1);
     }
 
     if (!sent)
@@ -88,7 +90,7 @@ void exec_mouse_click(uint8_t buttons, uint16_t count, uint16_t interval,
     cdc_log("[MOUSE] Click %d/%d done\n", i + 1, count);
 
     if (i < count - 1) {
-      sleep_ms(wait_time);
+      sched_delay_ms(wait_time);
     }
 
     tud_task();
@@ -96,14 +98,12 @@ void exec_mouse_click(uint8_t buttons, uint16_t count, uint16_t interval,
 }
 
 void exec_mouse_move(int16_t total_x, int16_t total_y, uint16_t count,
-                     uint16_t interval, uint8_t trigger_btn) {
+                     uint16_t interval, uint16_t motion_value,
+                     uint8_t trigger_btn) {
   bool wait_for_release = true;
   bool infinite = (count == 0);
   uint32_t i = 0;
-
-  // parametry wygladzania
-  const int8_t MAX_STEP = 5;    // max 5 pikseli na raport (dla plynnosci)
-  const uint8_t STEP_DELAY = 8; // 8ms miedzy krokami (ok 125Hz)
+  mouse_motion_t motion;
 
   while (infinite || i < count) {
     watchdog_update();
@@ -111,34 +111,29 @@ void exec_mouse_move(int16_t total_x, int16_t total_y, uint16_t count,
     if (check_cancel(trigger_btn, &wait_for_release))
       break;
 
-    int16_t x = total_x;
-    int16_t y = total_y;
-
-    // petla interpolacji ruchu
-    while (x != 0 || y != 0) {
-      // uzytkownik anuluje w trakcie dlugiego przejazdu
-      if (check_cancel(trigger_btn, &wait_for_release))
-        goto end_move;
-
-      int8_t dx = (x > MAX_STEP) ? MAX_STEP : (x < -MAX_STEP) ? -MAX_STEP : x;
-      int8_t dy = (y > MAX_STEP) ? MAX_STEP : (y < -MAX_STEP) ? -MAX_STEP : y;
-
-      x -= dx;
-      y -= dy;
+    // one report per host poll, the engine spreads the path over them
+    mouse_motion_init(&motion, total_x, total_y, motion_value);
+    int8_t dx, dy;
+    while (mouse_motion_next(&motion, &dx, &dy)) {
+      while (!tud_hid_ready()) {
+        // uzytkownik anuluje w trakcie dlugiego przejazdu
+        if (check_cancel(trigger_btn, &wait_for_release))
+          goto end_move;
+        tud_task();
+      }
 
-      if (tud_hid_ready()) {
+      if (dx != 0 || dy != 0)
         tud_hid_mouse_report(2, 0, dx, dy, 0, 0);
-      }
-      sleep_ms(STEP_DELAY);
-      tud_task();
+      else
+        sched_delay_ms(HID_POLL_INTERVAL_MS); // slow part of the curve
     }
 
     uint32_t delay = interval;
     if (infinite && delay < 50)
       delay = 500;
 
-    if (infinite || i < count - 1)
-      sleep_ms(delay > 0 ? delay : 20);
+    if (infinite || i + 1 < count)
+      sched_delay_ms(delay > 0 ? delay : 20);
 
     if (!infinite)
       i++;
@@ -146,6 +141,27 @@ void exec_mouse_move(int16_t total_x, int16_t total_y, uint16_t count,
 end_move:;
 }
 
+static void send_abs_report(uint8_t buttons, int16_t x, int16_t y) {
+  while (!tud_hid_ready())
+    tud_task();
+  tud_hid_abs_mouse_report(3, buttons, x, y, 0, 0);
+}
+
+void exec_mouse_move_abs(int16_t x, int16_t y, uint8_t buttons) {
+  if (x < 0)
+    x = 0;
+  if (y < 0)
+    y = 0;
+
+  // one report jumps there, the click reuses the same position
+  send_abs_report(0, x, y);
+  if (buttons) {
+    send_abs_report(buttons, x, y);
+    send_abs_report(0, x, y);
+  }
+  cdc_log("[MOUSE] Abs %d,%d buttons %d\n", x, y, buttons);
+}
+
 void exec_mouse_wheel(int8_t wheel_value) {
   if (tud_hid_ready()) {
     tud_hid_mouse_report(2, 0, 0, 0, wheel_value, 0);
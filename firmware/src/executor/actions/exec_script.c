@@ -4,98 +4,336 @@
 #include "executor/actions/exec_hid_core.h"
 #include "executor/actions/exec_text.h"
 #include "hardware/watchdog.h"
+#include "pin_definitions.h"
+#include "scheduler/scheduler.h"
+#include "script_codec.h"
 #include "tusb.h"
 #include <stdint.h>
+#include <stdio.h>
+#include <string.h>
 
-void exec_script(const char *script, uint8_t platform,
-                 const key_step_t *shortcut, uint8_t shortcut_len) {
-  cdc_log("[SCRIPT] Executing script (platform=%d)\n", platform);
+// serial port of the device as seen from the host shell
+#define UNIX_PORT_LINUX "$(ls /dev/serial/by-id/*Talos*|head -n1)"
+#define UNIX_PORT_MAC "$(ls /dev/cu.usbmodem*|head -n1)"
+// PowerShell: COM port of our VID/PID (printf arguments USB_VID, USB_PID)
+#define WIN_PORT                                                               \
+  "((Get-CimInstance Win32_PnPEntity|?{$_.PNPDeviceID -like "                  \
+  "'USB\\VID_%04X&PID_%04X*' -and $_.Name -match 'COM\\d+'}|select -f 1)"      \
+  ".Name -replace '.*\\((COM\\d+)\\).*','$1')"
 
-  if (platform == 0) { // LINUX
+// text decoded per pass, a packed script is never expanded in full
+#define SCRIPT_CHUNK 256
+
+static script_reader_t reader;
+static char chunk[SCRIPT_CHUNK + 4]; // + a split UTF-8 sequence
+
+// ==================== HOST SIGNALS ====================
+
+// a line from the host, read directly (the CDC task does not run while a
+// macro plays), or a keyboard LED change since led_base (NULL = lines only)
+static bool wait_for_signal(const char *line, uint32_t timeout_ms,
+                            const uint32_t *led_base) {
+  const size_t line_len = strlen(line);
+  size_t matched = 0;
+  bool other = false;
+  absolute_time_t end = make_timeout_time_ms(timeout_ms);
+
+  while (!time_reached(end)) {
+    while (tud_cdc_available()) {
+      char c = (char)tud_cdc_read_char();
+      if (c == '\n' || c == '\r') {
+        if (!other && matched == line_len)
+          return true;
+        matched = 0;
+        other = false;
+      } else if (!other && matched < line_len && c == line[matched]) {
+        matched++;
+      } else {
+        other = true;
+      }
+    }
+    if (led_base != NULL && hid_host_led_changes() != *led_base)
+      return true;
+
+    watchdog_update();
+    sched_delay_ms(1);
+  }
+  return false;
+}
+
+// ==================== TERMINAL ====================
+
+// a leading space keeps the probe out of the shell history
+static void type_probe(uint8_t platform) {
+  char line[384];
+
+  if (platform == 1) { // WINDOWS: Num Lock twice if the port is busy
+    snprintf(line, sizeof(line),
+             " try{$p=New-Object IO.Ports.SerialPort " WIN_PORT ";$p.Open();"
+             "$p.WriteLine('" SCRIPT_READY_SENTINEL "');$p.Close()}catch{"
+             "$w=New-Object -ComObject WScript.Shell;$w.SendKeys('{NUMLOCK}');"
+             "$w.SendKeys('{NUMLOCK}')}\n",
+             USB_VID, USB_PID);
+  } else if (platform == 2) { // MACOS
+    snprintf(line, sizeof(line),
+             " echo " SCRIPT_READY_SENTINEL " >" UNIX_PORT_MAC "\n");
+  } else { // LINUX: no access to the port -> Num Lock twice (X11)
+    snprintf(line, sizeof(line),
+             " echo " SCRIPT_READY_SENTINEL " >" UNIX_PORT_LINUX
+             " || xdotool key Num_Lock Num_Lock\n");
+  }
+
+  type_text_content(line, platform);
+}
+
+// instead of a fixed wait the shell answers a typed probe, a probe typed
+// before the window had focus is cancelled and typed again
+static void wait_terminal_ready(uint8_t platform) {
+  sched_delay_ms(SCRIPT_READY_SETTLE_MS);
+
+  cdc_set_binary_mode(true);
+  uint32_t led_base = hid_host_led_changes();
+  absolute_time_t end = make_timeout_time_ms(SCRIPT_READY_TIMEOUT_MS);
+  bool ready = false;
+
+  for (int probe = 0; !ready && !time_reached(end); probe++) {
+    if (probe > 0) {
+      press_sequence(0x01, 6); // Ctrl + C, drop the partial line
+      sched_delay_ms(100);
+    }
+    type_probe(platform);
+    ready = wait_for_signal(SCRIPT_READY_SENTINEL, SCRIPT_READY_PROBE_MS,
+                            &led_base);
+  }
+  cdc_set_binary_mode(false);
 
-    // 1. terminal shortcut
+  cdc_log("[SCRIPT] Terminal %s\n", ready ? "ready" : "did not answer");
+}
+
+static void open_terminal(uint8_t platform, const key_step_t *shortcut,
+                          uint16_t shortcut_len) {
+  if (platform == 0) { // LINUX
     if (shortcut_len > 0) {
       for (int i = 0; i < shortcut_len; i++) {
+        watchdog_update();
         press_sequence(shortcut[i].modifiers, shortcut[i].keycode);
 
         // minimal delay between keys
         if (i < shortcut_len - 1)
-          sleep_ms(100);
+          sched_delay_ms(100);
       }
     } else {
       // fallback: ctrl+alt+t
       press_sequence(0x05, 23);
     }
 
+  } else if (platform == 1) { // WINDOWS
+    press_sequence(0x08, 21); // Win + R
+    sched_delay_ms(500);
+
+    // open PowerShell
+    type_text_content("powershell -NoProfile -ExecutionPolicy Bypass\n",
+                      platform);
+
+  } else if (platform == 2) { // MACOS
+    press_sequence(0x08, 44); // Cmd + Space
+    sched_delay_ms(300);
+
+    type_text_content("Terminal", platform);
+    sched_delay_ms(100);
+
+    press_sequence(0, 40);
+  }
+
+  watchdog_update();
+  wait_terminal_ready(platform);
+}
+
+// ==================== TYPED DELIVERY ====================
+
+// length of the complete UTF-8 characters at the start of buf
+static size_t utf8_complete(const char *buf, size_t len) {
+  size_t i = len;
+  while (i > 0 && len - i < 4 && ((uint8_t)buf[i - 1] & 0xC0) == 0x80)
+    i--;
+  if (i == 0)
+    return len;
+
+  uint8_t lead = (uint8_t)buf[i - 1];
+  size_t need = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 1;
+  return len - (i - 1) >= need ? len : i - 1;
+}
+
+static void type_stored_text(const char *script, uint8_t platform) {
+  size_t kept = 0;
+
+  script_reader_open(&reader, script);
+  for (;;) {
+    size_t n = kept + script_reader_read(&reader, chunk + kept, SCRIPT_CHUNK);
+    if (n == kept) {
+      // end (a broken sequence at the very end is typed as it is)
+      chunk[n] = '\0';
+      if (n > 0)
+        type_text_content(chunk, platform);
+      return;
+    }
+
+    size_t whole = utf8_complete(chunk, n);
+    char tail[4];
+    kept = n - whole;
+    memcpy(tail, chunk + whole, kept);
+    chunk[whole] = '\0';
+    type_text_content(chunk, platform);
+    memcpy(chunk, tail, kept);
     watchdog_update();
-    sleep_ms(1500); // waiting for gui response
+  }
+}
 
-    // 2. temporary file
+static void type_script(const char *script, uint8_t platform) {
+  if (platform == 0) { // LINUX
+    // temporary file
     type_text_content("cat << 'EOF' > /tmp/m.sh\n", platform);
-    sleep_ms(200);
+    sched_delay_ms(200);
 
-    // 3. type content
-    type_text_content(script, platform);
+    // type content
+    type_stored_text(script, platform);
 
-    // 4. close file (enter -> eof -> enter)
+    // close file (enter -> eof -> enter)
     press_sequence(0, 40); // enter
     type_text_content("EOF\n", platform);
-    sleep_ms(200);
+    sched_delay_ms(200);
 
-    // 5. run and cleanup
+    // run and cleanup
     type_text_content("chmod +x /tmp/m.sh && /tmp/m.sh && rm /tmp/m.sh\n",
                       platform);
 
   } else if (platform == 1) { // WINDOWS
-    press_sequence(0x08, 21); // Win + R
-    sleep_ms(500);
-
-    // open PowerShell
-    type_text_content("powershell -NoProfile -ExecutionPolicy Bypass\n",
-                      platform);
-    watchdog_update();
-    sleep_ms(1500);
-
     // define temp file path
     type_text_content("$f=\"$env:TEMP\\m.ps1\"\n", platform);
-    sleep_ms(100);
+    sched_delay_ms(100);
 
     // start here-String
     type_text_content("$c=@'\n", platform);
 
     // type script content
-    type_text_content(script, platform);
+    type_stored_text(script, platform);
 
     // end here-String
     type_text_content("\n'@\n", platform);
-    sleep_ms(200);
+    sched_delay_ms(200);
 
     // save to file
     type_text_content("Set-Content -Path $f -Value $c -Encoding UTF8\n",
                       platform);
-    sleep_ms(200);
+    sched_delay_ms(200);
 
     // execute and Remove
     type_text_content("& $f; Remove-Item $f\n", platform);
     press_sequence(0, 40);
-  } else if (platform == 2) { // MACOS
-    press_sequence(0x08, 44); // Cmd + Space
-    sleep_ms(300);
-
-    type_text_content("Terminal", platform);
-    sleep_ms(100);
-
-    press_sequence(0, 40);
-    watchdog_update();
-    sleep_ms(1000);
 
+  } else if (platform == 2) { // MACOS
     type_text_content("cat << 'EOF' > /tmp/m.sh\n", platform);
-    type_text_content(script, platform);
+    type_stored_text(script, platform);
 
     press_sequence(0, 40);
     type_text_content("EOF\n", platform);
-    sleep_ms(100);
+    sched_delay_ms(100);
 
     type_text_content("sh /tmp/m.sh && rm /tmp/m.sh\n", platform);
   }
 }
+
+// ==================== CDC DELIVERY ====================
+
+// the bootstrap opens the CDC port, asks for the body and saves everything
+// up to the end marker, so only the one-liner is typed
+static void type_bootstrap(uint8_t platform) {
+  char line[512];
+
+  if (platform == 1) { // WINDOWS: COM port of our VID/PID
+    snprintf(line, sizeof(line),
+             "$p=New-Object IO.Ports.SerialPort " WIN_PORT ";"
+             "$p.DtrEnable=1;$p.Open();"
+             "$p.WriteLine('" SCRIPT_PULL_REQUEST "');$c='';"
+             "while(($l=$p.ReadLine()) -ne '" SCRIPT_PULL_END "')"
+             "{$c+=$l+\"`n\"};$p.Close();$f=\"$env:TEMP\\m.ps1\";"
+             "Set-Content -Path $f -Value $c -Encoding UTF8;& $f;"
+             "Remove-Item $f\n",
+             USB_VID, USB_PID);
+  } else {
+    bool mac = platform == 2;
+    snprintf(line, sizeof(line),
+             "exec 3<>%s;stty raw -echo <&3;"
+             "echo " SCRIPT_PULL_REQUEST " >&3;"
+             "sed '/^" SCRIPT_PULL_END "/q' <&3|sed '$d' >/tmp/m.sh;"
+             "exec 3<&-;%s\n",
+             mac ? UNIX_PORT_MAC : UNIX_PORT_LINUX,
+             mac ? "sh /tmp/m.sh && rm /tmp/m.sh"
+                 : "chmod +x /tmp/m.sh && /tmp/m.sh && rm /tmp/m.sh");
+  }
+
+  type_text_content(line, platform);
+}
+
+static bool cdc_write_all(const char *data, size_t len) {
+  absolute_time_t end = make_timeout_time_ms(SCRIPT_PULL_TIMEOUT_MS);
+
+  while (len > 0) {
+    if (time_reached(end))
+      return false;
+
+    uint32_t n = tud_cdc_write(data, (uint32_t)len);
+    data += n;
+    len -= n;
+    tud_cdc_write_flush();
+    tud_task();
+    watchdog_update();
+  }
+  return true;
+}
+
+static bool pull_script(const char *script, uint8_t platform) {
+  cdc_set_binary_mode(true);
+  type_bootstrap(platform);
+
+  bool served = false;
+  if (wait_for_signal(SCRIPT_PULL_REQUEST, SCRIPT_PULL_TIMEOUT_MS, NULL)) {
+    char last = '\n';
+    size_t n;
+    served = true;
+    script_reader_open(&reader, script);
+    while (served && (n = script_reader_read(&reader, chunk, SCRIPT_CHUNK))) {
+      served = cdc_write_all(chunk, n);
+      last = chunk[n - 1];
+    }
+    // the end marker needs a line of its own
+    if (served && last != '\n')
+      served = cdc_write_all("\n", 1);
+    if (served)
+      served = cdc_write_all(SCRIPT_PULL_END "\n",
+                             sizeof(SCRIPT_PULL_END "\n") - 1);
+  }
+
+  cdc_set_binary_mode(false);
+  return served;
+}
+
+void exec_script(const char *script, uint8_t platform,
+                 const key_step_t *shortcut, uint16_t shortcut_len) {
+  uint8_t os = platform & SCRIPT_PLATFORM_MASK;
+  cdc_log("[SCRIPT] Executing script (platform=%d)\n", platform);
+
+  open_terminal(os, shortcut, shortcut_len);
+
+  if (platform & SCRIPT_DELIVERY_CDC) {
+    if (pull_script(script, os))
+      return;
+
+    // no request (port busy or not found): stop the bootstrap, type instead
+    cdc_log("[SCRIPT] No CDC request, typing the script\n");
+    press_sequence(0x01, 6); // Ctrl + C
+    sched_delay_ms(200);
+  }
+
+  type_script(script, os);
+}
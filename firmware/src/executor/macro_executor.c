@@ -3,44 +3,71 @@
 #include "cdc/cdc_transport.h"
 #include "easter_egg.h"
 #include "executor/actions/exec_hid_core.h"
+#include "executor/actions/exec_media.h"
 #include "executor/actions/exec_midi_core.h"
 #include "executor/actions/exec_mouse.h"
 #include "executor/actions/exec_script.h"
 #include "executor/actions/exec_text.h"
+#include "executor/macro_recorder.h"
+#include "executor/macro_vm.h"
+#include "executor/text_stream.h"
 #include "hardware_interface.h"
+#include "hid/keyboard_layout.h"
+#include "macro_arena.h"
 #include "macro_config.h"
+#include "midi/midi_clock.h"
+#include "midi/midi_tx.h"
 #include "oled/oled_display.h"
 #include "pico/stdlib.h"
 #include "pin_definitions.h"
+#include "scheduler/scheduler.h"
 #include "tusb.h"
 #include <stdio.h>
 #include <string.h>
 
 void execute_macro(uint8_t layer, uint8_t button) {
-  config_data_t *config = config_get();
-  macro_entry_t *macro = &config->macros[layer][button];
+  macro_entry_t *macro = config_get_macro(layer, button);
+  if (!macro)
+    return; // layer removed (SET_LAYER_COUNT)
 
   cdc_log("[EXECUTOR] Executing macro: L%d B%d '%s'\n", layer, button,
           macro->name);
 
   oled_trigger_preview(layer, button);
 
+  // MIDI_INTERVAL_TICKS: the interval follows the tempo of the MIDI clock
+  uint16_t interval = midi_clock_interval_ms(macro->repeat_interval);
+
   switch (macro->type) {
   case MACRO_TYPE_KEY_PRESS: {
-    exec_key_repeat_fast((uint8_t)macro->value, macro->repeat_count,
-                         macro->repeat_interval);
+    exec_key_repeat_fast((uint8_t)macro->value, macro->repeat_count, interval);
     break;
   }
 
   case MACRO_TYPE_MOUSE_BUTTON: {
-    exec_mouse_click((uint8_t)macro->value, macro->repeat_count,
-                     macro->repeat_interval, button);
+    exec_mouse_click((uint8_t)macro->value, macro->repeat_count, interval,
+                     button);
     break;
   }
 
   case MACRO_TYPE_MOUSE_MOVE: {
     exec_mouse_move(macro->move_x, macro->move_y, macro->repeat_count,
-                    macro->repeat_interval, button);
+                    interval, macro->value, button);
+    break;
+  }
+
+  case MACRO_TYPE_MOUSE_MOVE_ABS: {
+    exec_mouse_move_abs(macro->move_x, macro->move_y, (uint8_t)macro->value);
+    break;
+  }
+
+  case MACRO_TYPE_MEDIA_KEY: {
+    exec_consumer_key(macro->value, macro->repeat_count, interval);
+    break;
+  }
+
+  case MACRO_TYPE_SYSTEM_KEY: {
+    exec_system_key((uint8_t)macro->value);
     break;
   }
 
@@ -50,12 +77,30 @@ void execute_macro(uint8_t layer, uint8_t button) {
   }
 
   case MACRO_TYPE_TEXT_STRING: {
+    // precompiled report stream, typed live only if it did not fit the cache
+    if (text_stream_cache_play(layer, button, detect_platform()))
+      break;
+
+    kb_layout_set_override(kb_layout_from_macro_value(macro->value));
     exec_type_text_auto(macro->macro_string);
+    kb_layout_set_override(KB_LAYOUT_DEVICE);
     break;
   }
 
   case MACRO_TYPE_LAYER_TOGGLE: {
-    config_cycle_layer();
+    uint8_t target = (uint8_t)(macro->value & LAYER_SWITCH_TARGET_MASK);
+
+    switch (macro->value & LAYER_SWITCH_MODE_MASK) {
+    case LAYER_SWITCH_JUMP:
+      config_set_current_layer(target);
+      break;
+    case LAYER_SWITCH_MOMENTARY:
+      config_layer_push(target, button); // until the button is released
+      break;
+    default:
+      config_cycle_layer();
+      break;
+    }
     uint8_t new_layer = config_get_current_layer();
 
     printf("[LAYER] Switched to layer %d\n", new_layer);
@@ -66,13 +111,21 @@ void execute_macro(uint8_t layer, uint8_t button) {
   }
 
   case MACRO_TYPE_SCRIPT: {
-    exec_script(macro->script, macro->script_platform, macro->terminal_shortcut,
-                macro->terminal_shortcut_length);
+    uint16_t shortcut_len = 0;
+    const key_step_t *shortcut =
+        macro_arena_steps(layer, button, ARENA_SLOT_SHORTCUT, &shortcut_len);
+    const char *script =
+        (const char *)macro_arena_get(layer, button, ARENA_SLOT_SCRIPT, NULL);
+    if (script)
+      exec_script(script, macro->script_platform, shortcut, shortcut_len);
     break;
   }
 
   case MACRO_TYPE_KEY_SEQUENCE: {
-    exec_key_sequence(macro->sequence, macro->sequence_length);
+    uint16_t len = 0;
+    const key_step_t *steps =
+        macro_arena_steps(layer, button, ARENA_SLOT_SEQUENCE, &len);
+    exec_key_sequence(steps, len);
     break;
   }
 
@@ -80,20 +133,54 @@ void execute_macro(uint8_t layer, uint8_t button) {
     // value  -> Note
     // move_x -> Velocity (default is 127)
     // move_y -> Channel (default is 1)
+    // repeat_interval -> Gate ms or ticks (0 = while the key is held)
 
     uint8_t note = (uint8_t)macro->value;
     uint8_t velocity = (macro->move_x > 0) ? (uint8_t)macro->move_x : 127;
     uint8_t channel = (macro->move_y > 0) ? (uint8_t)macro->move_y : 1;
 
-    exec_midi_note(note, velocity, channel);
-    break;
+    // the LED follows the note, no blink or HID release that would delay
+    // the next key
+    exec_midi_note(note, velocity, channel, interval, button);
+    midi_tx_flush(); // a retrigger's Note Off and the Note On in one write
+    return;
   }
   case MACRO_TYPE_MIDI_CC: {
-    uint8_t cc_num = (uint8_t)macro->value;
-    uint8_t cc_val = (macro->move_x >= 0) ? (uint8_t)macro->move_x : 127;
+    // value  -> Controller + MIDI_CC_* mode bits (midi_cc.h)
+    // move_x -> Value or ramp target (default is 127)
+    // move_y -> Channel (default is 1)
+    // repeat_count -> NRPN parameter number
+    // repeat_interval -> ramp time of the whole range
+
+    uint16_t cc_val = (macro->move_x >= 0) ? (uint16_t)macro->move_x : 127;
     uint8_t channel = (macro->move_y > 0) ? (uint8_t)macro->move_y : 1;
 
-    exec_midi_cc(cc_num, cc_val, channel);
+    // a ramp runs until the key is released, its LED shows it moving
+    bool ramp = exec_midi_controller(macro->value, cc_val, channel,
+                                     macro->repeat_count, interval, button);
+    midi_tx_flush(); // MSB/LSB or the NRPN sequence in one write
+    if (ramp)
+      return;
+    break;
+  }
+
+  case MACRO_TYPE_PROGRAM: {
+    // runs in the macro_vm task, the button press only starts (or stops) it
+    macro_vm_start(layer, button);
+    break;
+  }
+
+  case MACRO_TYPE_RECORD: {
+    // first press arms the recorder, the companion then streams REC_KEY
+    if (!recorder_active()) {
+      if (recorder_start(layer, (uint8_t)macro->value))
+        cdc_send_response_fmt("REC_START|%d|%d", layer, macro->value);
+    } else {
+      uint16_t len = 0;
+      bool stored = recorder_stop(&len);
+      cdc_send_response_fmt("REC_DONE|%d|%d|%u", layer, macro->value,
+                            stored ? len : 0);
+    }
     break;
   }
 
@@ -107,11 +194,15 @@ void execute_macro(uint8_t layer, uint8_t button) {
   }
 
   led_toggle(button);
-  sleep_ms(10);
+  sched_delay_ms(10);
   led_toggle(button);
 
-  if (tud_hid_ready()) {
-    tud_hid_keyboard_report(1, 0, NULL);
-    tud_hid_mouse_report(2, 0, 0, 0, 0, 0);
-  }
+  // one endpoint for both reports, the mouse one waits for the next poll
+  while (!tud_hid_ready())
+    tud_task();
+  tud_hid_keyboard_report(1, 0, NULL);
+
+  while (!tud_hid_ready())
+    tud_task();
+  tud_hid_mouse_report(2, 0, 0, 0, 0, 0);
 }
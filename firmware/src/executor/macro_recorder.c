@@ -0,0 +1,195 @@
+#include "executor/macro_recorder.h"
+
+#include "cdc/cdc_transport.h"
+#include "executor/macro_vm.h"
+#include "macro_arena.h"
+#include "macro_config.h"
+#include <string.h>
+
+typedef struct {
+  uint16_t pre_ms; // delay before the press
+  uint8_t key;
+  uint8_t mods;
+  uint16_t hold_ms;
+} rec_tap_t;
+
+typedef struct {
+  bool active;
+  bool full;
+  uint8_t layer;
+  uint8_t button;
+  uint8_t code[REC_MAX_PROGRAM];
+  uint16_t len;
+
+  // press not written yet, the next event may make it a tap
+  bool down_pending;
+  uint8_t down_key;
+  uint8_t down_mods;
+  uint16_t down_delay;
+
+  // identical taps in a row, written as one loop
+  uint16_t run;
+  rec_tap_t tap;
+} recorder_t;
+
+static recorder_t rec;
+
+// ==================== EMIT ====================
+
+static void emit(const uint8_t *bytes, uint16_t n) {
+  if (rec.full || rec.len + n > REC_MAX_PROGRAM) {
+    rec.full = true;
+    return;
+  }
+  memcpy(&rec.code[rec.len], bytes, n);
+  rec.len += n;
+}
+
+static void emit_key(uint8_t op, uint8_t key, uint8_t mods) {
+  uint8_t bytes[3] = {op, key, mods};
+  emit(bytes, 3);
+}
+
+static void emit_delay(uint16_t ms) {
+  if (ms == 0)
+    return;
+  uint8_t bytes[3] = {VM_OP_DELAY, (uint8_t)ms, (uint8_t)(ms >> 8)};
+  emit(bytes, 3);
+}
+
+static void emit_tap(const rec_tap_t *tap) {
+  emit_delay(tap->pre_ms);
+  emit_key(VM_OP_KEY_DOWN, tap->key, tap->mods);
+  emit_delay(tap->hold_ms);
+  emit_key(VM_OP_KEY_UP, tap->key, tap->mods);
+}
+
+static void flush_run(void) {
+  if (rec.run == 1) {
+    emit_tap(&rec.tap);
+  } else if (rec.run > 1) {
+    uint8_t loop[3] = {VM_OP_LOOP, (uint8_t)rec.run, (uint8_t)(rec.run >> 8)};
+    uint8_t end_loop = VM_OP_END_LOOP;
+    emit(loop, 3);
+    emit_tap(&rec.tap);
+    emit(&end_loop, 1);
+  }
+  rec.run = 0;
+}
+
+static void flush_down(void) {
+  if (!rec.down_pending)
+    return;
+  emit_delay(rec.down_delay);
+  emit_key(VM_OP_KEY_DOWN, rec.down_key, rec.down_mods);
+  rec.down_pending = false;
+}
+
+// ==================== RECORDING ====================
+
+static bool same_tap(const rec_tap_t *a, const rec_tap_t *b) {
+  return a->pre_ms == b->pre_ms && a->key == b->key && a->mods == b->mods &&
+         a->hold_ms == b->hold_ms;
+}
+
+static uint16_t quantize(uint32_t ms) {
+  ms = (ms + REC_QUANTUM_MS / 2) / REC_QUANTUM_MS * REC_QUANTUM_MS;
+  return ms > UINT16_MAX ? UINT16_MAX : (uint16_t)ms;
+}
+
+bool recorder_active(void) { return rec.active; }
+
+bool recorder_start(uint8_t layer, uint8_t button) {
+  if (rec.active || layer >= config_layer_count() || button >= NUM_BUTTONS)
+    return false;
+
+  memset(&rec, 0, sizeof(rec));
+  rec.active = true;
+  rec.layer = layer;
+  rec.button = button;
+  cdc_log("[REC] Recording L%d B%d\n", layer, button);
+  return true;
+}
+
+bool recorder_feed(bool down, uint8_t keycode, uint32_t delta_ms) {
+  if (!rec.active || rec.full)
+    return false;
+
+  // modifier keys go into the modifier byte of the report
+  uint8_t key = keycode;
+  uint8_t mods = 0;
+  if (keycode >= 0xE0 && keycode <= 0xE7) {
+    key = 0;
+    mods = (uint8_t)(1 << (keycode - 0xE0));
+  }
+  uint16_t delay = quantize(delta_ms);
+
+  // release right after its press -> tap, identical ones make a run
+  if (!down && rec.down_pending && rec.down_key == key &&
+      rec.down_mods == mods) {
+    rec_tap_t tap = {rec.down_delay, key, mods, delay};
+    rec.down_pending = false;
+
+    if (rec.run > 0 && rec.run < UINT16_MAX && same_tap(&tap, &rec.tap)) {
+      rec.run++;
+    } else {
+      flush_run();
+      rec.tap = tap;
+      rec.run = 1;
+    }
+    return !rec.full;
+  }
+
+  // a lone press may still become the next tap of the run
+  if (!down || rec.down_pending) {
+    flush_run();
+    flush_down();
+  }
+
+  if (down) {
+    rec.down_pending = true;
+    rec.down_key = key;
+    rec.down_mods = mods;
+    rec.down_delay = delay;
+  } else {
+    emit_delay(delay);
+    emit_key(VM_OP_KEY_UP, key, mods);
+  }
+  return !rec.full;
+}
+
+bool recorder_stop(uint16_t *len) {
+  if (!rec.active)
+    return false;
+
+  flush_run();
+  flush_down(); // keys still held go up when the program ends
+  rec.active = false;
+
+  if (len)
+    *len = rec.len;
+  if (rec.len == 0 || rec.full) {
+    cdc_log("[REC] Nothing stored (%s)\n", rec.full ? "full" : "empty");
+    return false;
+  }
+
+  // the program must not change under the running VM
+  macro_vm_stop();
+  if (!macro_arena_set(rec.layer, rec.button, ARENA_SLOT_PROGRAM, rec.code,
+                       rec.len))
+    return false;
+
+  macro_arena_clear(rec.layer, rec.button, ARENA_SLOT_SEQUENCE);
+  macro_arena_clear(rec.layer, rec.button, ARENA_SLOT_SHORTCUT);
+  macro_arena_clear(rec.layer, rec.button, ARENA_SLOT_SCRIPT);
+  config_get_macro(rec.layer, rec.button)->type = MACRO_TYPE_PROGRAM;
+
+  cdc_log("[REC] L%d B%d: %u bytes\n", rec.layer, rec.button, rec.len);
+  return config_save();
+}
+
+void recorder_cancel(void) {
+  if (rec.active)
+    cdc_log("[REC] Cancelled\n");
+  rec.active = false;
+}
@@ -0,0 +1,569 @@
+#include "executor/macro_vm.h"
+
+#include "cdc/cdc_transport.h"
+#include "executor/text_stream.h"
+#include "hardware_interface.h"
+#include "hid/keyboard_layout.h"
+#include "macro_arena.h"
+#include "macro_config.h"
+#include "midi/midi_clock.h"
+#include "midi/midi_tx.h"
+#include "oled/oled_display.h"
+#include "pico/stdlib.h"
+#include "power/power_idle.h"
+#include "tusb.h"
+#include <string.h>
+
+typedef struct {
+  uint16_t start; // first instruction of the body
+  uint16_t remaining;
+  bool forever;
+} vm_loop_t;
+
+typedef struct {
+  bool running;
+  bool releasing; // program ended, held keys / buttons still going up
+  uint8_t layer;
+  uint8_t button;
+  uint16_t pc;
+
+  bool waiting;
+  uint32_t wake_ms;
+  bool syncing; // VM_OP_SYNC, waits for a clock position
+  int32_t sync_target;
+
+  // what the program holds down
+  uint8_t mods;
+  uint8_t keys[6];
+  uint8_t mouse_buttons;
+
+  // second half of VM_OP_TAP, goes out on the next poll
+  bool tap_pending;
+  uint8_t tap_key;
+  uint8_t tap_mods;
+
+  vm_loop_t loops[VM_MAX_LOOP_DEPTH];
+  uint8_t depth;
+
+  // VM_OP_TEXT in progress
+  bool in_text;
+  bool text_finished; // input session closed, last stream playing
+  uint16_t text_pos;
+  uint16_t text_end;
+  text_stream_t stream;
+  text_stream_player_t player;
+  uint8_t stream_buf[TEXT_STREAM_CODEPOINT_MAX];
+} macro_vm_t;
+
+static macro_vm_t vm;
+
+// ==================== DECODING ====================
+
+static uint16_t read16(const uint8_t *p) {
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+// instruction size, 0 for an unknown opcode or one cut by the end
+static uint16_t op_size(const uint8_t *code, uint16_t len, uint16_t pc) {
+  static const uint8_t SIZES[] = {
+      [VM_OP_END] = 1,          [VM_OP_KEY_DOWN] = 3,
+      [VM_OP_KEY_UP] = 3,       [VM_OP_TAP] = 3,
+      [VM_OP_TEXT] = 2,         [VM_OP_MOUSE_BUTTON] = 2,
+      [VM_OP_MOUSE_MOVE] = 3,   [VM_OP_MOUSE_WHEEL] = 2,
+      [VM_OP_MIDI] = 4,         [VM_OP_DELAY] = 3,
+      [VM_OP_LOOP] = 3,         [VM_OP_END_LOOP] = 1,
+      [VM_OP_LAYER] = 2,        [VM_OP_WAIT_RELEASE] = 1,
+      [VM_OP_IF_HELD] = 3,      [VM_OP_IF_PLATFORM] = 4,
+      [VM_OP_JUMP] = 3,         [VM_OP_SYNC] = 3,
+  };
+
+  uint8_t op = code[pc];
+  if (op >= sizeof(SIZES))
+    return 0;
+
+  uint32_t size = SIZES[op];
+  if (pc + size > len)
+    return 0;
+  if (op == VM_OP_TEXT)
+    size += code[pc + 1];
+  return pc + size > len ? 0 : (uint16_t)size;
+}
+
+// forward skip of a jump / condition (0 for other opcodes)
+static uint16_t op_skip(const uint8_t *code, uint16_t pc) {
+  switch (code[pc]) {
+  case VM_OP_IF_HELD:
+  case VM_OP_JUMP:
+    return read16(&code[pc + 1]);
+  case VM_OP_IF_PLATFORM:
+    return read16(&code[pc + 2]);
+  default:
+    return 0;
+  }
+}
+
+// loop depth at an instruction boundary, -1 if target is not one
+static int depth_at(const uint8_t *code, uint16_t len, uint16_t target) {
+  uint16_t pc = 0;
+  int depth = 0;
+
+  while (pc < target) {
+    if (code[pc] == VM_OP_LOOP)
+      depth++;
+    else if (code[pc] == VM_OP_END_LOOP)
+      depth--;
+
+    uint16_t size = op_size(code, len, pc);
+    if (size == 0)
+      return -1;
+    pc += size;
+  }
+  return pc == target ? depth : -1;
+}
+
+int macro_vm_verify(const uint8_t *code, uint16_t len) {
+  uint16_t pc = 0;
+  int depth = 0;
+
+  while (pc < len) {
+    uint16_t size = op_size(code, len, pc);
+    if (size == 0)
+      return pc;
+
+    uint8_t op = code[pc];
+    if (op == VM_OP_LOOP && ++depth > VM_MAX_LOOP_DEPTH)
+      return pc;
+    if (op == VM_OP_END_LOOP && --depth < 0)
+      return pc;
+
+    // forward only, onto an instruction at the same loop depth
+    uint16_t skip = op_skip(code, pc);
+    if (skip) {
+      uint32_t target = (uint32_t)pc + size + skip;
+      int here = depth_at(code, len, pc);
+      if (target > len ||
+          (target < len && depth_at(code, len, target) != here) ||
+          (target == len && here != 0))
+        return pc;
+    }
+
+    pc += size;
+  }
+
+  return depth == 0 ? -1 : (int)len;
+}
+
+// ==================== HID ====================
+
+static void send_keyboard(void) {
+  tud_hid_keyboard_report(1, vm.mods, vm.keys);
+}
+
+static void key_down(uint8_t key) {
+  for (int i = 0; i < 6; i++) {
+    if (vm.keys[i] == key)
+      return;
+  }
+  for (int i = 0; i < 6; i++) {
+    if (vm.keys[i] == 0) {
+      vm.keys[i] = key;
+      return;
+    }
+  }
+}
+
+static void key_up(uint8_t key) {
+  for (int i = 0; i < 6; i++) {
+    if (vm.keys[i] == key)
+      vm.keys[i] = 0;
+  }
+}
+
+static bool keyboard_held(void) {
+  if (vm.mods)
+    return true;
+  for (int i = 0; i < 6; i++) {
+    if (vm.keys[i])
+      return true;
+  }
+  return false;
+}
+
+// ==================== CONTROL ====================
+
+static uint32_t now_ms(void) { return to_ms_since_boot(get_absolute_time()); }
+
+static void wait_ms(uint32_t ms) {
+  vm.waiting = true;
+  vm.wake_ms = now_ms() + ms;
+  power_idle_request_wakeup(vm.wake_ms);
+}
+
+// endpoint busy -> try again on the next poll
+static void wait_endpoint(void) { power_idle_request_wakeup(now_ms() + 1); }
+
+static void finish(void) {
+  vm.in_text = false;
+  vm.releasing = true;
+  power_idle_notify_event(); // release on the next pass, not after a sleep
+}
+
+bool macro_vm_running(void) { return vm.running; }
+
+bool macro_vm_start(uint8_t layer, uint8_t button) {
+  uint16_t len = 0;
+  const uint8_t *code =
+      macro_arena_get(layer, button, ARENA_SLOT_PROGRAM, &len);
+
+  // second press of the running program's button cancels it
+  if (vm.running && vm.layer == layer && vm.button == button) {
+    cdc_log("[VM] Program L%d B%d cancelled\n", layer, button);
+    macro_vm_stop();
+    return true;
+  }
+
+  if (code == NULL) {
+    cdc_log("[VM] L%d B%d has no program\n", layer, button);
+    return false;
+  }
+
+  int bad = macro_vm_verify(code, len);
+  if (bad >= 0) {
+    cdc_log("[VM] Invalid program L%d B%d at %d\n", layer, button, bad);
+    return false;
+  }
+
+  macro_vm_stop();
+  memset(&vm, 0, sizeof(vm));
+  vm.running = true;
+  vm.layer = layer;
+  vm.button = button;
+
+  cdc_log("[VM] Program L%d B%d started (%u bytes)\n", layer, button, len);
+  power_idle_notify_event();
+  return true;
+}
+
+void macro_vm_stop(void) {
+  if (!vm.running)
+    return;
+
+  // one endpoint for both reports, the mouse one waits for the next poll
+  if (keyboard_held() || vm.in_text) {
+    while (!tud_hid_ready())
+      tud_task();
+    tud_hid_keyboard_report(1, 0, NULL);
+  }
+
+  if (vm.mouse_buttons) {
+    while (!tud_hid_ready())
+      tud_task();
+    tud_hid_mouse_report(2, 0, 0, 0, 0, 0);
+  }
+
+  memset(&vm, 0, sizeof(vm));
+}
+
+// ==================== EXECUTION ====================
+
+// release after the end, false while something is still going up
+static bool release_step(void) {
+  if (keyboard_held()) {
+    if (!tud_hid_ready())
+      return false;
+    vm.mods = 0;
+    memset(vm.keys, 0, sizeof(vm.keys));
+    send_keyboard();
+  }
+
+  if (vm.mouse_buttons) {
+    if (!tud_hid_ready())
+      return false;
+    vm.mouse_buttons = 0;
+    tud_hid_mouse_report(2, 0, 0, 0, 0, 0);
+  }
+
+  return true;
+}
+
+// one step of VM_OP_TEXT, false when the tick has to end
+static bool text_step(const uint8_t *code, bool *sent) {
+  uint16_t delay_ms = 0;
+
+  switch (text_stream_step(&vm.player, &delay_ms)) {
+  case TS_STEP_SENT:
+    *sent = true;
+    return true;
+  case TS_STEP_BUSY:
+    wait_endpoint();
+    return false;
+  case TS_STEP_DELAY:
+    wait_ms(delay_ms);
+    return false;
+  case TS_STEP_DONE:
+    break;
+  }
+
+  uint8_t layout = kb_layout_active();
+  uint8_t platform = detect_platform();
+  vm.stream.len = 0;
+
+  if (vm.text_pos < vm.text_end) {
+    // one codepoint, the decoder needs a terminated string
+    char utf8[5] = {0};
+    uint16_t n = vm.text_end - vm.text_pos;
+    memcpy(utf8, &code[vm.text_pos], n < 4 ? n : 4);
+
+    const char *p = utf8;
+    uint32_t cp = utf8_to_codepoint(&p);
+    vm.text_pos += (p > utf8) ? (uint16_t)(p - utf8) : 1;
+    if (cp != 0)
+      text_stream_compile_codepoint(&vm.stream, cp, layout, platform);
+  } else if (!vm.text_finished) {
+    text_stream_finish(&vm.stream);
+    vm.text_finished = true;
+  } else {
+    vm.in_text = false;
+    vm.pc = vm.text_end;
+    return true;
+  }
+
+  text_stream_player_start(&vm.player, vm.stream_buf, vm.stream.len);
+  return true;
+}
+
+// executes one instruction, false when the tick has to end
+static bool exec_one(const uint8_t *code, uint16_t len) {
+  if (vm.tap_pending) {
+    if (!tud_hid_ready()) {
+      wait_endpoint();
+      return false;
+    }
+    vm.mods &= ~vm.tap_mods;
+    key_up(vm.tap_key);
+    send_keyboard();
+    vm.tap_pending = false;
+    return true;
+  }
+
+  if (vm.pc >= len) {
+    finish();
+    return false;
+  }
+
+  uint16_t pc = vm.pc;
+  uint8_t op = code[pc];
+  uint16_t size = op_size(code, len, pc);
+  if (size == 0) {
+    cdc_log("[VM] Bad instruction 0x%02x at %u\n", op, pc);
+    finish();
+    return false;
+  }
+
+  // every HID report waits for the endpoint, pc stays until it is free
+  bool hid = op == VM_OP_KEY_DOWN || op == VM_OP_KEY_UP || op == VM_OP_TAP ||
+             op == VM_OP_MOUSE_BUTTON || op == VM_OP_MOUSE_MOVE ||
+             op == VM_OP_MOUSE_WHEEL;
+  if (hid && !tud_hid_ready()) {
+    wait_endpoint();
+    return false;
+  }
+
+  uint16_t next = pc + size;
+
+  switch (op) {
+  case VM_OP_END:
+    finish();
+    return false;
+
+  case VM_OP_KEY_DOWN:
+    vm.mods |= code[pc + 2];
+    if (code[pc + 1])
+      key_down(code[pc + 1]);
+    send_keyboard();
+    break;
+
+  case VM_OP_KEY_UP:
+    vm.mods &= ~code[pc + 2];
+    if (code[pc + 1])
+      key_up(code[pc + 1]);
+    send_keyboard();
+    break;
+
+  case VM_OP_TAP:
+    vm.mods |= code[pc + 2];
+    key_down(code[pc + 1]);
+    send_keyboard();
+    vm.tap_pending = true;
+    vm.tap_key = code[pc + 1];
+    vm.tap_mods = code[pc + 2];
+    break;
+
+  case VM_OP_TEXT: {
+    if (!vm.in_text) {
+      // the text stream ends with all keys up
+      vm.mods = 0;
+      memset(vm.keys, 0, sizeof(vm.keys));
+      vm.in_text = true;
+      vm.text_finished = false;
+      vm.text_pos = pc + 2;
+      vm.text_end = next;
+      text_stream_init(&vm.stream, vm.stream_buf, sizeof(vm.stream_buf));
+      text_stream_player_start(&vm.player, vm.stream_buf, 0);
+    }
+    bool sent = false;
+    while (vm.in_text && !sent) {
+      if (!text_step(code, &sent))
+        return false;
+    }
+    return true;
+  }
+
+  case VM_OP_MOUSE_BUTTON:
+    vm.mouse_buttons = code[pc + 1];
+    tud_hid_mouse_report(2, vm.mouse_buttons, 0, 0, 0, 0);
+    break;
+
+  case VM_OP_MOUSE_MOVE:
+    tud_hid_mouse_report(2, vm.mouse_buttons, (int8_t)code[pc + 1],
+                         (int8_t)code[pc + 2], 0, 0);
+    break;
+
+  case VM_OP_MOUSE_WHEEL:
+    tud_hid_mouse_report(2, vm.mouse_buttons, 0, 0, (int8_t)code[pc + 1], 0);
+    break;
+
+  case VM_OP_MIDI:
+    midi_tx_message(code[pc + 1], code[pc + 2], code[pc + 3]);
+    break;
+
+  case VM_OP_DELAY:
+    vm.pc = next;
+    wait_ms(read16(&code[pc + 1]));
+    return false;
+
+  case VM_OP_SYNC: {
+    uint16_t grid = read16(&code[pc + 1]);
+    vm.pc = next;
+    if (!midi_clock_running()) {
+      wait_ms(midi_clock_interval_ms(MIDI_INTERVAL_TICKS | (grid & 0x7FFF)));
+      return false;
+    }
+    vm.syncing = true;
+    vm.sync_target = midi_clock_next_grid(grid);
+    return false;
+  }
+
+  case VM_OP_LOOP: {
+    if (vm.depth >= VM_MAX_LOOP_DEPTH) {
+      finish();
+      return false;
+    }
+
+    uint16_t count = read16(&code[pc + 1]);
+    vm_loop_t *loop = &vm.loops[vm.depth++];
+    loop->start = next;
+    loop->remaining = count;
+    loop->forever = (count == 0);
+    break;
+  }
+
+  case VM_OP_END_LOOP: {
+    if (vm.depth == 0)
+      break;
+
+    vm_loop_t *loop = &vm.loops[vm.depth - 1];
+    if (loop->forever || --loop->remaining > 0) {
+      vm.pc = loop->start;
+      return true;
+    }
+    vm.depth--;
+    break;
+  }
+
+  case VM_OP_LAYER: {
+    if (code[pc + 1] == VM_LAYER_NEXT)
+      config_cycle_layer();
+    else
+      config_set_current_layer(code[pc + 1]);
+
+    uint8_t layer = config_get_current_layer();
+    leds_update_for_layer(layer);
+    oled_display_layer_info(layer);
+    break;
+  }
+
+  case VM_OP_WAIT_RELEASE:
+    if (button_is_pressed(vm.button)) {
+      wait_ms(1);
+      return false;
+    }
+    break;
+
+  case VM_OP_IF_HELD:
+    if (!button_is_pressed(vm.button))
+      next += op_skip(code, pc);
+    break;
+
+  case VM_OP_IF_PLATFORM:
+    if (detect_platform() != code[pc + 1])
+      next += op_skip(code, pc);
+    break;
+
+  case VM_OP_JUMP:
+    next += op_skip(code, pc);
+    break;
+  }
+
+  vm.pc = next;
+  return true;
+}
+
+void macro_vm_task(void) {
+  if (!vm.running)
+    return;
+
+  if (vm.waiting) {
+    if ((int32_t)(now_ms() - vm.wake_ms) < 0) {
+      power_idle_request_wakeup(vm.wake_ms);
+      return;
+    }
+    vm.waiting = false;
+  }
+
+  // ticks wake the device as USB events, the timeout notices a lost clock
+  if (vm.syncing) {
+    if (midi_clock_running() && midi_clock_position() < vm.sync_target) {
+      power_idle_request_wakeup(now_ms() + MIDI_CLOCK_TIMEOUT_MS);
+      return;
+    }
+    vm.syncing = false;
+  }
+
+  if (vm.releasing) {
+    if (release_step()) {
+      cdc_log("[VM] Program L%d B%d done\n", vm.layer, vm.button);
+      memset(&vm, 0, sizeof(vm));
+    } else {
+      wait_endpoint();
+    }
+    return;
+  }
+
+  // re-read every pass, the arena moves blobs when it changes
+  uint16_t len = 0;
+  const uint8_t *code =
+      macro_arena_get(vm.layer, vm.button, ARENA_SLOT_PROGRAM, &len);
+  if (code == NULL) {
+    finish();
+    return;
+  }
+
+  for (int budget = VM_TICK_BUDGET; budget > 0; budget--) {
+    if (!exec_one(code, len))
+      return;
+  }
+
+  // budget used up, continue on the next pass without sleeping
+  power_idle_notify_event();
+}
@@ -0,0 +1,282 @@
+#include "executor/midi_cc.h"
+
+#include "hardware_interface.h"
+#include "midi/midi_tx.h"
+#include "pico/stdlib.h"
+#include "pin_definitions.h"
+#include "power/power_idle.h"
+#include "tusb.h"
+#include <string.h>
+
+// USB MIDI bytes per millisecond (4 per message), half of the TX FIFO so
+// Note On/Off of other keys still fit
+#define FRAME_BYTES (CFG_TUD_MIDI_TX_BUFSIZE / 2)
+#define CURVE_ONE 1024 // curve fixed point 1.0
+
+typedef struct {
+  bool used;
+  midi_cc_dest_t dest;
+  uint16_t value; // last value sent
+  uint32_t age;   // last use, the oldest entry is reused
+} cc_state_t;
+
+typedef struct {
+  bool active;
+  bool stopping; // key released, send the current value and stop
+  uint8_t state; // cc_states index
+  uint8_t curve;
+  uint16_t from;
+  uint16_t to;
+  uint32_t start_ms;
+  uint32_t duration_ms;
+} cc_ramp_t;
+
+static cc_state_t states[MIDI_CC_MAX_STATES];
+static cc_ramp_t ramps[NUM_BUTTONS];
+static uint32_t age_counter;
+static uint32_t frame_ms; // budget window
+static uint16_t frame_bytes;
+static uint8_t first_ramp; // a ramp that ran out of budget goes first next
+
+static uint32_t now_ms(void) { return to_ms_since_boot(get_absolute_time()); }
+
+// ==================== OUTPUT ====================
+
+static uint8_t message_bytes(uint8_t resolution) {
+  switch (resolution) {
+  case MIDI_CC_RES_14BIT:
+    return 8;
+  case MIDI_CC_RES_NRPN:
+    return 16;
+  default:
+    return 4;
+  }
+}
+
+// budget of the current millisecond, false when the message must wait
+static bool take_budget(uint8_t bytes) {
+  uint32_t now = now_ms();
+  if (now != frame_ms) {
+    frame_ms = now;
+    frame_bytes = 0;
+  }
+  if (frame_bytes + bytes > FRAME_BYTES)
+    return false;
+  frame_bytes += bytes;
+  return true;
+}
+
+static void send_cc(uint8_t channel, uint8_t controller, uint8_t value) {
+  midi_tx_message(0xB0 | channel, controller, value);
+}
+
+static void send(const midi_cc_dest_t *dest, uint16_t value) {
+  if (!tud_midi_mounted())
+    return;
+
+  switch (dest->resolution) {
+  case MIDI_CC_RES_14BIT:
+    // receivers apply the pair on the LSB
+    send_cc(dest->channel, dest->controller, value >> 7);
+    send_cc(dest->channel, dest->controller + 32, value & 0x7F);
+    break;
+  case MIDI_CC_RES_NRPN:
+    send_cc(dest->channel, 99, dest->param >> 7);
+    send_cc(dest->channel, 98, dest->param & 0x7F);
+    send_cc(dest->channel, 6, value >> 7);
+    send_cc(dest->channel, 38, value & 0x7F);
+    break;
+  default:
+    send_cc(dest->channel, dest->controller, (uint8_t)value);
+    break;
+  }
+}
+
+// ==================== STATE ====================
+
+static bool same_dest(const midi_cc_dest_t *a, const midi_cc_dest_t *b) {
+  if (a->channel != b->channel || a->resolution != b->resolution)
+    return false;
+  if (a->resolution == MIDI_CC_RES_NRPN)
+    return a->param == b->param;
+  return a->controller == b->controller;
+}
+
+static int find_state(const midi_cc_dest_t *dest) {
+  for (int i = 0; i < MIDI_CC_MAX_STATES; i++) {
+    if (states[i].used && same_dest(&states[i].dest, dest))
+      return i;
+  }
+  return -1;
+}
+
+static bool state_in_ramp(uint8_t s) {
+  for (uint8_t b = 0; b < NUM_BUTTONS; b++) {
+    if (ramps[b].active && ramps[b].state == s)
+      return true;
+  }
+  return false;
+}
+
+// existing entry or a new one (free, else the oldest one not ramping)
+static uint8_t get_state(const midi_cc_dest_t *dest) {
+  int found = find_state(dest);
+  if (found >= 0) {
+    states[found].age = age_counter++;
+    return (uint8_t)found;
+  }
+
+  uint8_t pick = 0;
+  bool have = false;
+  for (uint8_t i = 0; i < MIDI_CC_MAX_STATES; i++) {
+    if (!states[i].used) {
+      pick = i;
+      break;
+    }
+    if (!state_in_ramp(i) && (!have || states[i].age < states[pick].age)) {
+      pick = i;
+      have = true;
+    }
+  }
+
+  states[pick].used = true;
+  states[pick].dest = *dest;
+  states[pick].value = 0;
+  states[pick].age = age_counter++;
+  return pick;
+}
+
+uint16_t midi_cc_max(uint8_t resolution) {
+  return resolution == MIDI_CC_RES_7BIT ? 127 : 16383;
+}
+
+uint16_t midi_cc_value(const midi_cc_dest_t *dest) {
+  int i = find_state(dest);
+  return i >= 0 ? states[i].value : 0;
+}
+
+void midi_cc_set(const midi_cc_dest_t *dest, uint16_t value) {
+  uint16_t max = midi_cc_max(dest->resolution);
+  if (value > max)
+    value = max;
+
+  uint8_t s = get_state(dest);
+  states[s].value = value;
+  // a single press is never dropped, only ramps are budgeted
+  take_budget(message_bytes(dest->resolution));
+  send(dest, value);
+}
+
+// ==================== RAMPS ====================
+
+static uint32_t curve_apply(uint8_t curve, uint32_t p) {
+  switch (curve) {
+  case MIDI_CC_CURVE_EXP:
+    return p * p / CURVE_ONE;
+  case MIDI_CC_CURVE_LOG:
+    return CURVE_ONE - (CURVE_ONE - p) * (CURVE_ONE - p) / CURVE_ONE;
+  default:
+    return p;
+  }
+}
+
+static uint16_t ramp_value(const cc_ramp_t *ramp, uint32_t now) {
+  uint32_t elapsed = now - ramp->start_ms;
+  if (elapsed >= ramp->duration_ms)
+    return ramp->to;
+
+  uint32_t p = elapsed * CURVE_ONE / ramp->duration_ms;
+  int32_t span = (int32_t)ramp->to - (int32_t)ramp->from;
+  int32_t step = span * (int32_t)curve_apply(ramp->curve, p) / CURVE_ONE;
+  return (uint16_t)((int32_t)ramp->from + step);
+}
+
+static void ramp_end(uint8_t button) {
+  ramps[button].active = false;
+  led_toggle(button);
+}
+
+void midi_cc_ramp(uint8_t button, const midi_cc_dest_t *dest, uint16_t target,
+                  uint8_t curve, uint16_t full_ms) {
+  if (button >= NUM_BUTTONS)
+    return;
+  if (ramps[button].active)
+    ramp_end(button);
+
+  uint16_t max = midi_cc_max(dest->resolution);
+  if (target > max)
+    target = max;
+  if (full_ms == 0)
+    full_ms = MIDI_CC_DEFAULT_RAMP_MS;
+
+  cc_ramp_t *ramp = &ramps[button];
+  ramp->state = get_state(dest);
+  ramp->from = states[ramp->state].value;
+  ramp->to = target;
+  ramp->curve = curve;
+  ramp->start_ms = now_ms();
+  // the whole range takes full_ms, a shorter distance less
+  uint32_t distance = target > ramp->from ? target - ramp->from
+                                          : ramp->from - target;
+  ramp->duration_ms = distance * full_ms / max;
+  if (ramp->duration_ms == 0)
+    ramp->duration_ms = 1;
+  ramp->stopping = false;
+  ramp->active = true;
+  led_toggle(button);
+
+  power_idle_request_wakeup(ramp->start_ms + 1);
+}
+
+void midi_cc_release(uint8_t button) {
+  if (button < NUM_BUTTONS && ramps[button].active)
+    ramps[button].stopping = true;
+}
+
+void midi_cc_init(void) {
+  memset(states, 0, sizeof(states));
+  memset(ramps, 0, sizeof(ramps));
+  age_counter = 0;
+  frame_bytes = 0;
+  first_ramp = 0;
+}
+
+void midi_cc_task(void) {
+  uint32_t now = now_ms();
+  bool moving = false;
+
+  bool starved = false;
+  uint8_t first = first_ramp;
+
+  for (uint8_t i = 0; i < NUM_BUTTONS; i++) {
+    uint8_t b = (first + i) % NUM_BUTTONS;
+    cc_ramp_t *ramp = &ramps[b];
+    if (!ramp->active)
+      continue;
+
+    cc_state_t *state = &states[ramp->state];
+    uint16_t value = ramp_value(ramp, now);
+    bool done = ramp->stopping || value == ramp->to;
+
+    if (value != state->value) {
+      if (!take_budget(message_bytes(state->dest.resolution))) {
+        // newest value goes out in the next millisecond
+        if (!starved)
+          first_ramp = b;
+        starved = true;
+        moving = true;
+        continue;
+      }
+      state->value = value;
+      send(&state->dest, value);
+    }
+
+    if (done)
+      ramp_end(b);
+    else
+      moving = true;
+  }
+
+  if (moving)
+    power_idle_request_wakeup(now + 1);
+}
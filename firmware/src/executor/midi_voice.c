@@ -0,0 +1,173 @@
+#include "executor/midi_voice.h"
+
+#include "cdc/cdc_transport.h"
+#include "hardware_interface.h"
+#include "midi/midi_tx.h"
+#include "pico/stdlib.h"
+#include "power/power_idle.h"
+#include <string.h>
+
+typedef struct {
+  bool used;
+  bool timed; // in the wheel, otherwise held until the key is released
+  uint8_t button;
+  uint8_t note;
+  uint8_t channel;
+  uint8_t next; // next voice in the same wheel slot (index + 1, 0 = end)
+  uint32_t off_at_ms;
+  uint32_t age; // start order, the oldest voice is stolen first
+} voice_t;
+
+static voice_t voices[MIDI_MAX_VOICES];
+static uint8_t wheel[MIDI_WHEEL_SLOTS]; // first voice of a slot (index + 1)
+static uint32_t wheel_ms;               // next wheel slot to expire
+static uint8_t timed_count;
+static uint32_t age_counter;
+
+static uint32_t now_ms(void) { return to_ms_since_boot(get_absolute_time()); }
+
+static void send(uint8_t status, uint8_t note, uint8_t velocity) {
+  midi_tx_message(status, note, velocity);
+}
+
+// ==================== TIMER WHEEL ====================
+
+static void wheel_insert(uint8_t v) {
+  uint8_t slot = voices[v].off_at_ms % MIDI_WHEEL_SLOTS;
+  if (timed_count == 0)
+    wheel_ms = now_ms();
+  voices[v].next = wheel[slot];
+  wheel[slot] = v + 1;
+  timed_count++;
+}
+
+static void wheel_remove(uint8_t v) {
+  uint8_t *link = &wheel[voices[v].off_at_ms % MIDI_WHEEL_SLOTS];
+  while (*link != 0 && *link != v + 1)
+    link = &voices[*link - 1].next;
+  if (*link == 0)
+    return;
+  *link = voices[v].next;
+  timed_count--;
+}
+
+// ==================== VOICES ====================
+
+static void voice_off(uint8_t v) {
+  voice_t *voice = &voices[v];
+  if (voice->timed)
+    wheel_remove(v);
+
+  send(0x80 | voice->channel, voice->note, 0);
+  if (voice->button != MIDI_VOICE_NO_BUTTON)
+    led_toggle(voice->button);
+  voice->used = false;
+}
+
+static uint8_t voice_alloc(uint8_t note, uint8_t channel) {
+  uint8_t free_v = MIDI_MAX_VOICES;
+  uint8_t oldest = 0;
+
+  for (uint8_t v = 0; v < MIDI_MAX_VOICES; v++) {
+    if (!voices[v].used) {
+      if (free_v == MIDI_MAX_VOICES)
+        free_v = v;
+      continue;
+    }
+    // the same note again -> retrigger
+    if (voices[v].note == note && voices[v].channel == channel) {
+      voice_off(v);
+      return v;
+    }
+    if (voices[v].age < voices[oldest].age)
+      oldest = v;
+  }
+
+  if (free_v < MIDI_MAX_VOICES)
+    return free_v;
+
+  voice_off(oldest);
+  return oldest;
+}
+
+void midi_voice_note_on(uint8_t button, uint8_t note, uint8_t velocity,
+                        uint8_t channel, uint16_t gate_ms) {
+  uint8_t v = voice_alloc(note, channel);
+  voice_t *voice = &voices[v];
+
+  voice->used = true;
+  voice->button = button;
+  voice->note = note;
+  voice->channel = channel;
+  voice->age = age_counter++;
+  voice->timed = gate_ms > 0;
+
+  send(0x90 | channel, note, velocity);
+  if (button != MIDI_VOICE_NO_BUTTON)
+    led_toggle(button);
+
+  if (voice->timed) {
+    voice->off_at_ms = now_ms() + gate_ms;
+    wheel_insert(v);
+    power_idle_request_wakeup(voice->off_at_ms);
+  }
+}
+
+void midi_voice_release(uint8_t button) {
+  for (uint8_t v = 0; v < MIDI_MAX_VOICES; v++) {
+    if (voices[v].used && !voices[v].timed && voices[v].button == button)
+      voice_off(v);
+  }
+}
+
+void midi_voice_all_off(void) {
+  for (uint8_t v = 0; v < MIDI_MAX_VOICES; v++) {
+    if (voices[v].used)
+      voice_off(v);
+  }
+}
+
+uint8_t midi_voice_active(void) {
+  uint8_t n = 0;
+  for (uint8_t v = 0; v < MIDI_MAX_VOICES; v++)
+    n += voices[v].used;
+  return n;
+}
+
+void midi_voice_init(void) {
+  memset(voices, 0, sizeof(voices));
+  memset(wheel, 0, sizeof(wheel));
+  timed_count = 0;
+  age_counter = 0;
+}
+
+void midi_voice_task(void) {
+  if (timed_count == 0)
+    return;
+
+  // every slot passed since the last run, one lap at most
+  uint32_t now = now_ms();
+  uint32_t laps = now - wheel_ms + 1;
+  if (laps > MIDI_WHEEL_SLOTS)
+    laps = MIDI_WHEEL_SLOTS;
+
+  for (uint32_t i = 0; i < laps; i++) {
+    uint8_t link = wheel[(wheel_ms + i) % MIDI_WHEEL_SLOTS];
+    while (link != 0) {
+      uint8_t v = link - 1;
+      link = voices[v].next;
+      // later laps of a long gate stay in the slot
+      if ((int32_t)(now - voices[v].off_at_ms) >= 0)
+        voice_off(v);
+    }
+  }
+  wheel_ms = now + 1;
+
+  uint32_t next = UINT32_MAX;
+  for (uint8_t v = 0; v < MIDI_MAX_VOICES; v++) {
+    if (voices[v].used && voices[v].timed && voices[v].off_at_ms < next)
+      next = voices[v].off_at_ms;
+  }
+  if (next != UINT32_MAX)
+    power_idle_request_wakeup(next);
+}
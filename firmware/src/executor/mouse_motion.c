@@ -0,0 +1,112 @@
+#include "executor/mouse_motion.h"
+
+#include <stdlib.h>
+
+#define ONE_Q16 65536
+
+// ==================== CURVES ====================
+
+// smoothstep 3t^2 - 2t^3, peak speed 1.5x the average
+static int32_t ease_in_out(int32_t t) {
+  int64_t t2 = ((int64_t)t * t) >> 16;
+  return (int32_t)((t2 * (3 * ONE_Q16 - 2 * (int64_t)t)) >> 16);
+}
+
+// cubic Bezier from 0 to end, s in Q16
+static int32_t bezier(int32_t s, int32_t p1, int32_t p2, int32_t end) {
+  int64_t u = ONE_Q16 - s;
+  int64_t uu = (u * u) >> 16;
+  int64_t ss = ((int64_t)s * s) >> 16;
+  int64_t b1 = (3 * uu * s) >> 16;
+  int64_t b2 = (3 * u * ss) >> 16;
+  int64_t b3 = (ss * s) >> 16;
+  return (int32_t)((b1 * p1 + b2 * p2 + b3 * end) >> 16);
+}
+
+// 24.8 -> nearest whole pixel (also for negative positions)
+static int32_t round_px(int32_t pos) {
+  return pos >= 0 ? (pos + 128) / 256 : -((-pos + 128) / 256);
+}
+
+static int8_t clamp_report(int32_t delta) {
+  return delta > 127 ? 127 : delta < -127 ? -127 : (int8_t)delta;
+}
+
+// ==================== PLANNING ====================
+
+void mouse_motion_init(mouse_motion_t *motion, int16_t dx, int16_t dy,
+                       uint16_t value) {
+  int8_t bend = MOTION_BEND(value);
+  uint32_t speed = MOTION_SPEED(value);
+  if (speed == 0)
+    speed = MOTION_DEFAULT_SPEED;
+
+  motion->curve = MOTION_CURVE(value);
+  if (motion->curve > MOTION_CURVE_BEZIER)
+    motion->curve = MOTION_CURVE_LINEAR;
+
+  motion->end_x = (int32_t)dx * 256;
+  motion->end_y = (int32_t)dy * 256;
+  motion->sent_x = 0;
+  motion->sent_y = 0;
+  motion->step = 0;
+
+  // control points at 1/3 and 2/3 of the line, pushed sideways by bend %
+  int32_t side_x = -(int32_t)dy * 256 * bend / 100;
+  int32_t side_y = (int32_t)dx * 256 * bend / 100;
+  motion->p1_x = motion->end_x / 3 + side_x;
+  motion->p1_y = motion->end_y / 3 + side_y;
+  motion->p2_x = motion->end_x * 2 / 3 + side_x;
+  motion->p2_y = motion->end_y * 2 / 3 + side_y;
+
+  // the longer axis sets the report count (line rasterization)
+  uint32_t len = (uint32_t)abs(dx) > (uint32_t)abs(dy) ? (uint32_t)abs(dx)
+                                                       : (uint32_t)abs(dy);
+  if (motion->curve == MOTION_CURVE_BEZIER)
+    len += len * (uint32_t)abs(bend) / 50;
+  if (motion->curve != MOTION_CURVE_LINEAR)
+    len = len * 3 / 2; // the fastest part stays at the given speed
+
+  uint32_t steps = (len + speed - 1) / speed;
+  if (steps == 0)
+    steps = 1;
+  if (steps > MOTION_MAX_STEPS)
+    steps = MOTION_MAX_STEPS;
+  motion->steps = (uint16_t)steps;
+}
+
+bool mouse_motion_next(mouse_motion_t *motion, int8_t *dx, int8_t *dy) {
+  int32_t x = round_px(motion->end_x);
+  int32_t y = round_px(motion->end_y);
+
+  if (motion->step < motion->steps) {
+    motion->step++;
+    int32_t t = (int32_t)(((int64_t)motion->step << 16) / motion->steps);
+
+    switch (motion->curve) {
+    case MOTION_CURVE_EASE_IN_OUT:
+      t = ease_in_out(t);
+      x = round_px((int32_t)(((int64_t)motion->end_x * t) >> 16));
+      y = round_px((int32_t)(((int64_t)motion->end_y * t) >> 16));
+      break;
+    case MOTION_CURVE_BEZIER:
+      t = ease_in_out(t);
+      x = round_px(bezier(t, motion->p1_x, motion->p2_x, motion->end_x));
+      y = round_px(bezier(t, motion->p1_y, motion->p2_y, motion->end_y));
+      break;
+    default:
+      x = round_px((int32_t)(((int64_t)motion->end_x * t) >> 16));
+      y = round_px((int32_t)(((int64_t)motion->end_y * t) >> 16));
+      break;
+    }
+  } else if (x == motion->sent_x && y == motion->sent_y) {
+    return false;
+  }
+
+  // a clamped report leaves the rest for the next one (or extra reports)
+  *dx = clamp_report(x - motion->sent_x);
+  *dy = clamp_report(y - motion->sent_y);
+  motion->sent_x += *dx;
+  motion->sent_y += *dy;
+  return true;
+}
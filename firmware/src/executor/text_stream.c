@@ -0,0 +1,453 @@
+#include "executor/text_stream.h"
+
+#include "cdc/cdc_transport.h"
+#include "hardware/watchdog.h"
+#include "hardware_interface.h"
+#include "hid/keyboard_layout.h"
+#include "macro_config.h"
+#include "scheduler/scheduler.h"
+#include "tusb.h"
+#include <string.h>
+
+#define KEY_SPACE 44
+
+typedef struct {
+  uint32_t source; // hash of text + layout the stream was compiled from
+  uint16_t offset;
+  uint16_t len;
+  bool cached;
+} ts_slot_t;
+
+static uint8_t pool[TEXT_STREAM_POOL_SIZE];
+static uint16_t pool_used = 0;
+static ts_slot_t slots[MAX_LAYERS][NUM_BUTTONS][TEXT_STREAM_PLATFORMS];
+
+// ==================== EMIT ====================
+
+void text_stream_init(text_stream_t *stream, uint8_t *buf, uint16_t cap) {
+  stream->buf = buf;
+  stream->cap = cap;
+  stream->len = 0;
+  stream->overflow = false;
+  stream->used_unicode = false;
+  stream->in_unicode = false;
+  stream->hex_session = false;
+}
+
+static void emit3(text_stream_t *s, uint8_t op, uint8_t a, uint8_t b) {
+  if (s->len + 3 > s->cap) {
+    s->overflow = true;
+    return;
+  }
+  s->buf[s->len++] = op;
+  s->buf[s->len++] = a;
+  s->buf[s->len++] = b;
+}
+
+static void emit_report(text_stream_t *s, uint8_t modifiers, uint8_t keycode) {
+  emit3(s, TS_OP_REPORT, modifiers, keycode);
+}
+
+static void emit_delay(text_stream_t *s, uint8_t ms) {
+  if (ms == 0)
+    return; // USB pace only
+
+  if (s->len + 2 > s->cap) {
+    s->overflow = true;
+    return;
+  }
+  s->buf[s->len++] = TS_OP_DELAY;
+  s->buf[s->len++] = ms;
+}
+
+static void emit_roll(text_stream_t *s, uint8_t modifiers, uint8_t held,
+                      uint8_t keycode) {
+  if (s->len + 4 > s->cap) {
+    s->overflow = true;
+    return;
+  }
+  s->buf[s->len++] = TS_OP_ROLL;
+  s->buf[s->len++] = modifiers;
+  s->buf[s->len++] = held;
+  s->buf[s->len++] = keycode;
+}
+
+// key of a plain character (hex digit, u, x) on the layout
+static void layout_key(uint8_t layout, char c, uint8_t *keycode,
+                       uint8_t *modifiers) {
+  if (!kb_layout_map(layout, (uint8_t)c, keycode, modifiers)) {
+    *keycode = 0;
+    *modifiers = 0;
+  }
+}
+
+// ==================== UNICODE ====================
+
+// lowercase hex, at least min_digits (leading zeros), most significant first
+static int hex_digits(uint32_t value, int min_digits, char *out) {
+  char rev[8];
+  int n = 0;
+  do {
+    uint8_t nibble = value & 0xF;
+    rev[n++] = nibble < 10 ? '0' + nibble : 'a' + nibble - 10;
+    value >>= 4;
+  } while ((value || n < min_digits) && n < (int)sizeof(rev));
+
+  for (int i = 0; i < n; i++)
+    out[i] = rev[n - 1 - i];
+  return n;
+}
+
+// Types keys with rollover: the next key goes down in the same report that
+// still holds the previous one, so n keys take n + 1 reports instead of 2n.
+// Exactly one key is new in every report, the host sees them in order.
+// Repeated keys and keys needing other modifiers release first.
+static void emit_rolled(text_stream_t *s, uint8_t layout, const char *keys,
+                        int count, uint8_t base_mods, uint8_t key_ms) {
+  uint8_t held = 0, held_mods = 0;
+
+  for (int i = 0; i < count; i++) {
+    uint8_t key, mods;
+    layout_key(layout, keys[i], &key, &mods);
+    mods |= base_mods;
+
+    if (held && (key == held || mods != held_mods)) {
+      emit_report(s, base_mods, 0);
+      emit_delay(s, key_ms);
+      held = 0;
+    }
+
+    if (held)
+      emit_roll(s, mods, held, key);
+    else
+      emit_report(s, mods, key);
+    emit_delay(s, key_ms);
+
+    held = key;
+    held_mods = mods;
+  }
+
+  emit_report(s, base_mods, 0);
+}
+
+// macOS Unicode Hex Input ends when Option goes up
+static void close_hex_session(text_stream_t *s) {
+  if (!s->hex_session)
+    return;
+
+  const unicode_timing_t *t = &config_get()->unicode_timing[2];
+  emit_report(s, 0, 0);
+  emit_delay(s, t->commit_ms);
+  s->hex_session = false;
+}
+
+bool text_stream_compile_unicode(text_stream_t *s, uint32_t codepoint,
+                                 uint8_t layout, uint8_t platform) {
+  if (platform >= UNICODE_PLATFORMS)
+    return !s->overflow;
+
+  const unicode_timing_t *t = &config_get()->unicode_timing[platform];
+  char keys[12];
+  int n;
+  uint8_t key, mods;
+
+  if (platform == 0) { // Linux (GTK / IBus): Ctrl+Shift+U, hex, space
+    layout_key(layout, 'u', &key, &mods);
+
+    if (!s->in_unicode) {
+      emit_report(s, 0x03, 0); // registering modifiers
+      emit_delay(s, t->key_ms);
+    }
+    emit_report(s, 0x03, key);
+    emit_delay(s, t->key_ms);
+    emit_report(s, 0, 0);
+    // the input method is already awake after the previous codepoint
+    emit_delay(s, s->in_unicode ? t->key_ms : t->settle_ms);
+
+    n = hex_digits(codepoint, 1, keys);
+    keys[n++] = ' '; // confirm input, rolls in after the last digit
+    emit_rolled(s, layout, keys, n, 0, t->key_ms);
+    emit_delay(s, t->commit_ms);
+
+  } else if (platform == 1) { // Windows: hex digits + Alt+X
+    n = hex_digits(codepoint, 1, keys);
+    emit_rolled(s, layout, keys, n, 0, t->key_ms);
+    emit_delay(s, t->settle_ms);
+
+    layout_key(layout, 'x', &key, &mods);
+    emit_report(s, 0x04, key);
+    emit_delay(s, t->key_ms);
+    emit_report(s, 0, 0);
+    emit_delay(s, t->commit_ms);
+
+  } else if (t->mode == UNICODE_MODE_HEX_INPUT) {
+    // Mac Unicode Hex Input: Option held, 4 digits per UTF-16 unit,
+    // consecutive codepoints stay in the same Option session
+    if (!s->hex_session) {
+      emit_report(s, 0x04, 0);
+      emit_delay(s, t->settle_ms);
+      s->hex_session = true;
+    }
+
+    if (codepoint > 0xFFFF) { // surrogate pair
+      uint32_t v = codepoint - 0x10000;
+      n = hex_digits(0xD800 + (v >> 10), 4, keys);
+      n += hex_digits(0xDC00 + (v & 0x3FF), 4, keys + n);
+    } else {
+      n = hex_digits(codepoint, 4, keys);
+    }
+    emit_rolled(s, layout, keys, n, 0x04, t->key_ms);
+    emit_delay(s, t->key_ms);
+
+  } else { // Mac: Ctrl+Cmd+Space + hex + space
+    emit_report(s, 0x11, KEY_SPACE);
+    emit_delay(s, t->key_ms);
+    emit_report(s, 0, 0);
+    emit_delay(s, t->settle_ms);
+
+    n = hex_digits(codepoint, 1, keys);
+    keys[n++] = ' ';
+    emit_rolled(s, layout, keys, n, 0, t->key_ms);
+    emit_delay(s, t->commit_ms);
+  }
+
+  s->in_unicode = true;
+  s->used_unicode = true;
+  return !s->overflow;
+}
+
+bool text_stream_compile_codepoint(text_stream_t *s, uint32_t codepoint,
+                                   uint8_t layout, uint8_t platform) {
+  uint8_t keycode, modifiers;
+
+  // key on the host layout (ascii and e.g. ą on PL, ß on DE)
+  if (kb_layout_map(layout, codepoint, &keycode, &modifiers)) {
+    close_hex_session(s);
+    s->in_unicode = false;
+    emit3(s, TS_OP_TAP, modifiers, keycode);
+  } else if (codepoint >= 0x20 && codepoint != 0x7F) {
+    // unicode (also dead key characters like ^ on DE)
+    text_stream_compile_unicode(s, codepoint, layout, platform);
+  }
+
+  return !s->overflow;
+}
+
+bool text_stream_compile(text_stream_t *s, const char *text, uint8_t layout,
+                         uint8_t platform) {
+  const char *p = text;
+  while (*p && !s->overflow) {
+    uint32_t code = utf8_to_codepoint(&p);
+    if (code != 0)
+      text_stream_compile_codepoint(s, code, layout, platform);
+  }
+  return text_stream_finish(s);
+}
+
+bool text_stream_finish(text_stream_t *s) {
+  close_hex_session(s);
+  s->in_unicode = false;
+  return !s->overflow;
+}
+
+// ==================== PLAY ====================
+
+static void send_keys(uint8_t modifiers, uint8_t key0, uint8_t key1) {
+  uint8_t report[6] = {key0, key1, 0, 0, 0, 0};
+  tud_hid_keyboard_report(1, modifiers, key0 ? report : NULL);
+}
+
+void text_stream_player_start(text_stream_player_t *player,
+                              const uint8_t *code, uint16_t len) {
+  player->code = code;
+  player->len = len;
+  player->pc = 0;
+  player->release_pending = false;
+}
+
+ts_step_t text_stream_step(text_stream_player_t *player, uint16_t *delay_ms) {
+  const uint8_t *code = player->code;
+  uint16_t pc = player->pc;
+
+  if (player->release_pending) {
+    if (!tud_hid_ready())
+      return TS_STEP_BUSY;
+    send_keys(0, 0, 0);
+    player->release_pending = false;
+    return TS_STEP_SENT;
+  }
+
+  if (pc >= player->len)
+    return TS_STEP_DONE;
+
+  // every report waits for the endpoint (USB pace)
+  if (code[pc] != TS_OP_DELAY && !tud_hid_ready())
+    return TS_STEP_BUSY;
+
+  switch (code[pc]) {
+  case TS_OP_TAP:
+    // release goes out on the next poll after the host took the press
+    send_keys(code[pc + 1], code[pc + 2], 0);
+    player->release_pending = true;
+    player->pc += 3;
+    return TS_STEP_SENT;
+
+  case TS_OP_REPORT:
+    send_keys(code[pc + 1], code[pc + 2], 0);
+    player->pc += 3;
+    return TS_STEP_SENT;
+
+  case TS_OP_ROLL:
+    send_keys(code[pc + 1], code[pc + 2], code[pc + 3]);
+    player->pc += 4;
+    return TS_STEP_SENT;
+
+  case TS_OP_DELAY:
+    *delay_ms = code[pc + 1];
+    player->pc += 2;
+    return TS_STEP_DELAY;
+
+  default:
+    cdc_log("[TEXT] Bad opcode 0x%02x at %u\n", code[pc], pc);
+    player->pc = player->len;
+    return TS_STEP_DONE;
+  }
+}
+
+void text_stream_play(const uint8_t *code, uint16_t len) {
+  text_stream_player_t player;
+  uint16_t delay_ms = 0;
+  text_stream_player_start(&player, code, len);
+
+  for (;;) {
+    watchdog_update();
+
+    switch (text_stream_step(&player, &delay_ms)) {
+    case TS_STEP_DONE:
+      return;
+    case TS_STEP_BUSY:
+      tud_task();
+      break;
+    case TS_STEP_DELAY:
+      sched_delay_ms(delay_ms);
+      break;
+    case TS_STEP_SENT:
+      break;
+    }
+  }
+}
+
+// ==================== MACRO CACHE ====================
+
+static uint8_t macro_layout(const macro_entry_t *macro) {
+  uint8_t layout = kb_layout_from_macro_value(macro->value);
+  return layout != KB_LAYOUT_DEVICE ? layout : kb_layout_active();
+}
+
+// FNV-1a of the text and the layout, detects edits made without a rebuild
+static uint32_t macro_source(const macro_entry_t *macro, uint8_t layout) {
+  uint32_t hash = 2166136261u ^ layout;
+  for (int i = 0; i < MACRO_STRING_LEN && macro->macro_string[i]; i++) {
+    hash ^= (uint8_t)macro->macro_string[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+static bool compile_slot(ts_slot_t *slot, const char *text, uint8_t layout,
+                         uint8_t platform, bool *used_unicode) {
+  text_stream_t s;
+  text_stream_init(&s, &pool[pool_used], TEXT_STREAM_POOL_SIZE - pool_used);
+
+  if (!text_stream_compile(&s, text, layout, platform))
+    return false;
+
+  slot->offset = pool_used;
+  slot->len = s.len;
+  slot->cached = true;
+  pool_used += s.len;
+  *used_unicode = s.used_unicode;
+  return true;
+}
+
+static void compile_macro(uint8_t layer, uint8_t button) {
+  macro_entry_t *macro = config_get_macro(layer, button);
+  ts_slot_t *slot = slots[layer][button];
+  uint8_t layout = macro_layout(macro);
+  uint32_t source = macro_source(macro, layout);
+
+  for (int p = 0; p < TEXT_STREAM_PLATFORMS; p++) {
+    slot[p].cached = false;
+    slot[p].source = source;
+  }
+
+  bool used_unicode = false;
+  if (!compile_slot(&slot[0], macro->macro_string, layout, 0, &used_unicode))
+    return;
+
+  // keys only -> the same stream on every platform
+  for (int p = 1; p < TEXT_STREAM_PLATFORMS; p++) {
+    if (!used_unicode) {
+      slot[p] = slot[0];
+    } else if (!compile_slot(&slot[p], macro->macro_string, layout, p,
+                             &used_unicode)) {
+      return;
+    }
+  }
+}
+
+void text_stream_cache_rebuild(void) {
+  config_data_t *config = config_get();
+
+  memset(slots, 0, sizeof(slots));
+  pool_used = 0;
+
+  for (uint8_t layer = 0; layer < config_layer_count(); layer++) {
+    for (uint8_t btn = 0; btn < NUM_BUTTONS; btn++) {
+      if (config->layers[layer].macros[btn].type == MACRO_TYPE_TEXT_STRING)
+        compile_macro(layer, btn);
+    }
+  }
+
+  cdc_log("[TEXT] Report streams: %u/%u bytes\n", pool_used,
+          TEXT_STREAM_POOL_SIZE);
+}
+
+bool text_stream_cache_play(uint8_t layer, uint8_t button, uint8_t platform) {
+  if (layer >= config_layer_count() || button >= NUM_BUTTONS ||
+      platform >= TEXT_STREAM_PLATFORMS)
+    return false;
+
+  const macro_entry_t *macro = config_get_macro(layer, button);
+  if (macro->type != MACRO_TYPE_TEXT_STRING)
+    return false;
+
+  ts_slot_t *slot = &slots[layer][button][platform];
+  uint8_t layout = macro_layout(macro);
+
+  // stale (edited directly or layout changed) -> recompile everything
+  if (slot->source != macro_source(macro, layout))
+    text_stream_cache_rebuild();
+
+  if (!slot->cached)
+    return false; // did not fit the pool
+
+  text_stream_play(&pool[slot->offset], slot->len);
+  return true;
+}
+
+void text_stream_cache_stats(uint16_t *used_bytes, uint8_t *cached_macros) {
+  if (used_bytes)
+    *used_bytes = pool_used;
+
+  if (cached_macros) {
+    uint8_t count = 0;
+    for (uint8_t layer = 0; layer < config_layer_count(); layer++) {
+      for (uint8_t btn = 0; btn < NUM_BUTTONS; btn++) {
+        if (slots[layer][btn][0].cached)
+          count++;
+      }
+    }
+    *cached_macros = count;
+  }
+}
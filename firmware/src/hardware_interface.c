@@ -2,10 +2,12 @@
 
 #include "cdc/cdc_transport.h"
 #include "hardware/timer.h"
+#include "hid/keyboard_layout.h"
 #include "macro_config.h"
 #include "oled/oled_display.h"
 #include "pico/stdlib.h"
 #include "pin_definitions.h"
+#include "power/power_idle.h"
 #include <stdio.h>
 #include <string.h>
 
@@ -18,10 +20,14 @@ static bool led_states[NUM_BUTTONS] = {false};
 
 // Timer structure
 static struct repeating_timer buttons_timer;
+static volatile bool buttons_scanning = false;
+static uint8_t buttons_idle_scans = 0;
 
-// BUTTON SCANNING CALLBACK (ISR)
-static bool buttons_timer_callback(struct repeating_timer *t) {
-  (void)t;
+// scans with nothing pressed before the timer stops and GPIO IRQs take over
+#define BUTTONS_IDLE_SCANS_TO_STOP 4
+
+static bool buttons_scan(void) {
+  bool any_pressed = false;
 
   for (int i = 0; i < NUM_BUTTONS; i++) {
     button_prev_states[i] = button_states[i];
@@ -29,11 +35,47 @@ static bool buttons_timer_callback(struct repeating_timer *t) {
     bool raw_state = !gpio_get(BUTTON_PINS[i]);
 
     button_states[i] = raw_state;
+    any_pressed |= raw_state;
+  }
+
+  any_pressed |= !gpio_get(BTN_OS_TOGGLE_PIN);
+  return any_pressed;
+}
+
+// BUTTON SCANNING CALLBACK (ISR)
+static bool buttons_timer_callback(struct repeating_timer *t) {
+  (void)t;
+
+  if (buttons_scan()) {
+    buttons_idle_scans = 0;
+  } else if (++buttons_idle_scans >= BUTTONS_IDLE_SCANS_TO_STOP) {
+    // all released and stable -> stop polling, next edge restarts it
+    buttons_scanning = false;
+    power_idle_notify_event();
+    return false;
   }
 
+  power_idle_notify_event();
   return true;
 }
 
+// BUTTON EDGE CALLBACK (ISR)
+static void buttons_gpio_callback(uint gpio, uint32_t events) {
+  (void)gpio;
+  (void)events;
+
+  // sample right away so the press is visible without waiting for the timer
+  buttons_scan();
+  buttons_idle_scans = 0;
+
+  if (!buttons_scanning) {
+    buttons_scanning = true;
+    add_repeating_timer_ms(5, buttons_timer_callback, NULL, &buttons_timer);
+  }
+
+  power_idle_notify_event();
+}
+
 const char *get_key_name(uint8_t keycode) {
   static const char *key_names[] = {
       "A",     "B",   "C",         "D",   "E",     "F",   "G",   "H",   "I",
@@ -72,7 +114,7 @@ const char *get_key_name(uint8_t keycode) {
   return "Key";
 }
 
-const char *format_sequence_short(key_step_t *sequence, uint8_t len) {
+const char *format_sequence_short(const key_step_t *sequence, uint16_t len) {
   static char buf[32];
   buf[0] = '\0';
   if (len == 0)
@@ -117,7 +159,18 @@ void buttons_init(void) {
   gpio_set_dir(BTN_OS_TOGGLE_PIN, GPIO_IN);
   gpio_pull_up(BTN_OS_TOGGLE_PIN);
 
-  add_repeating_timer_ms(5, buttons_timer_callback, NULL, &buttons_timer);
+  // edges wake the core and start the 5ms scan timer only while keys are used
+  const uint32_t edges = GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE;
+  gpio_set_irq_enabled_with_callback(BUTTON_PINS[0], edges, true,
+                                     buttons_gpio_callback);
+  for (int i = 1; i < NUM_BUTTONS; i++) {
+    gpio_set_irq_enabled(BUTTON_PINS[i], edges, true);
+  }
+  gpio_set_irq_enabled(BTN_OS_TOGGLE_PIN, edges, true);
+
+  buttons_scanning = false;
+  buttons_idle_scans = 0;
+  buttons_scan();
 
   cdc_log("[BUTTONS] Initialized (%d buttons)\n", NUM_BUTTONS);
 }
@@ -204,113 +257,7 @@ void led_rgb_update_os(uint8_t platform) {
 }
 
 bool map_char_to_hid(char c, uint8_t *keycode, uint8_t *modifiers) {
-  *modifiers = 0;
-  if (c >= 'a' && c <= 'z') {
-    *keycode = c - 'a' + 4;
-  } else if (c >= 'A' && c <= 'Z') {
-    *keycode = c - 'A' + 4;
-    *modifiers = 0x02; // SHIFT
-  } else if (c >= '1' && c <= '9') {
-    *keycode = c - '1' + 30;
-  } else if (c == '0') {
-    *keycode = 39;
-  } else if (c == ' ') {
-    *keycode = 44;
-  } else if (c == '\n' || c == '\r') {
-    *keycode = 40; // Enter
-  } else if (c == '!') {
-    *keycode = 30; // 1
-    *modifiers = 0x02;
-  } else if (c == '@') {
-    *keycode = 31; // 2
-    *modifiers = 0x02;
-  } else if (c == '#') {
-    *keycode = 32; // 3
-    *modifiers = 0x02;
-  } else if (c == '$') {
-    *keycode = 33; // 4
-    *modifiers = 0x02;
-  } else if (c == '%') {
-    *keycode = 34; // 5
-    *modifiers = 0x02;
-  } else if (c == '^') {
-    *keycode = 35; // 6
-    *modifiers = 0x02;
-  } else if (c == '&') {
-    *keycode = 36; // 7
-    *modifiers = 0x02;
-  } else if (c == '*') {
-    *keycode = 37; // 8
-    *modifiers = 0x02;
-  } else if (c == '(') {
-    *keycode = 38; // 9
-    *modifiers = 0x02;
-  } else if (c == ')') {
-    *keycode = 39; // 0
-    *modifiers = 0x02;
-  } else if (c == '_') {
-    *keycode = 45; // -
-    *modifiers = 0x02;
-  } else if (c == '+') {
-    *keycode = 46; // =
-    *modifiers = 0x02;
-  } else if (c == '{') {
-    *keycode = 47; // [
-    *modifiers = 0x02;
-  } else if (c == '}') {
-    *keycode = 48; // ]
-    *modifiers = 0x02;
-  } else if (c == '|') {
-    *keycode = 49; // \
-    *modifiers = 0x02;
-  } else if (c == ':') {
-    *keycode = 51; // ;
-    *modifiers = 0x02;
-  } else if (c == '"') {
-    *keycode = 52; // '
-    *modifiers = 0x02;
-  } else if (c == '~') {
-    *keycode = 53; // `
-    *modifiers = 0x02;
-  } else if (c == '<') {
-    *keycode = 54; // ,
-    *modifiers = 0x02;
-  } else if (c == '>') {
-    *keycode = 55; // .
-    *modifiers = 0x02;
-  } else if (c == '?') {
-    *keycode = 56; // /
-    *modifiers = 0x02;
-  } else if (c == '\t') {
-    *keycode = 43; // Tab
-  } else if (c == '\b') {
-    *keycode = 42; // Backspace
-  } else if (c == '.') {
-    *keycode = 55;
-  } else if (c == ',') {
-    *keycode = 54;
-  } else if (c == '-') {
-    *keycode = 45;
-  } else if (c == '=') {
-    *keycode = 46;
-  } else if (c == '[') {
-    *keycode = 47;
-  } else if (c == ']') {
-    *keycode = 48;
-  } else if (c == '\\') {
-    *keycode = 49;
-  } else if (c == ';') {
-    *keycode = 51;
-  } else if (c == '\'') {
-    *keycode = 52;
-  } else if (c == '`') {
-    *keycode = 53;
-  } else if (c == '/') {
-    *keycode = 56;
-  } else {
-    return false; // Nieobsługiwany znak
-  }
-  return true;
+  return kb_layout_map(kb_layout_active(), (uint8_t)c, keycode, modifiers);
 }
 
 uint32_t utf8_to_codepoint(const char **str) {
@@ -0,0 +1,420 @@
+#include "hid/keyboard_layout.h"
+
+#include "macro_config.h"
+#include <stddef.h>
+#include <stdlib.h>
+#include <strings.h>
+
+typedef struct {
+  uint8_t keycode; // 0 = not typeable on this layout
+  uint8_t modifiers;
+} kb_key_t;
+
+typedef struct {
+  uint16_t codepoint;
+  kb_key_t key;
+} kb_extra_t;
+
+typedef struct {
+  const char *name;
+  const kb_key_t *ascii; // 128 entries
+  const kb_extra_t *extras;
+  uint8_t extra_count;
+} kb_layout_desc_t;
+
+// ==================== KEY HELPERS ====================
+
+// HID usage of the key labelled ch / digit d on a US keyboard
+#define KC(ch) (0x04 + (ch) - 'a')
+#define KN(d) ((d) == 0 ? 0x27 : 0x1D + (d))
+
+#define KC_ENTER 0x28
+#define KC_BACKSPACE 0x2A
+#define KC_TAB 0x2B
+#define KC_SPACE 0x2C
+#define KC_MINUS 0x2D
+#define KC_EQUAL 0x2E
+#define KC_LBRACKET 0x2F
+#define KC_RBRACKET 0x30
+#define KC_BACKSLASH 0x31
+#define KC_NONUS_HASH 0x32 // ISO key next to Enter
+#define KC_SEMICOLON 0x33
+#define KC_QUOTE 0x34
+#define KC_GRAVE 0x35
+#define KC_COMMA 0x36
+#define KC_PERIOD 0x37
+#define KC_SLASH 0x38
+#define KC_NONUS_BSLASH 0x64 // ISO key next to left shift
+
+#define K(kc) {(kc), 0}
+#define S(kc) {(kc), MODIFIER_LEFT_SHIFT}
+#define G(kc) {(kc), MODIFIER_RIGHT_ALT} // AltGr
+#define GS(kc) {(kc), MODIFIER_RIGHT_ALT | MODIFIER_LEFT_SHIFT}
+
+// lowercase on the key, uppercase with shift
+#define LETTER(ch, kc) [ch] = K(kc), [(ch) - 'a' + 'A'] = S(kc)
+
+// ==================== SHARED BLOCKS ====================
+
+#define CONTROL_KEYS                                                           \
+  ['\b'] = K(KC_BACKSPACE), ['\t'] = K(KC_TAB), ['\n'] = K(KC_ENTER),          \
+  ['\r'] = K(KC_ENTER), [' '] = K(KC_SPACE)
+
+// letters on the same key in QWERTY, QWERTZ and AZERTY
+#define LETTERS_COMMON                                                         \
+  LETTER('b', KC('b')), LETTER('c', KC('c')), LETTER('d', KC('d')),            \
+      LETTER('e', KC('e')), LETTER('f', KC('f')), LETTER('g', KC('g')),        \
+      LETTER('h', KC('h')), LETTER('i', KC('i')), LETTER('j', KC('j')),        \
+      LETTER('k', KC('k')), LETTER('l', KC('l')), LETTER('n', KC('n')),        \
+      LETTER('o', KC('o')), LETTER('p', KC('p')), LETTER('r', KC('r')),        \
+      LETTER('s', KC('s')), LETTER('t', KC('t')), LETTER('u', KC('u')),        \
+      LETTER('v', KC('v')), LETTER('x', KC('x'))
+
+#define LETTERS_QWERTY                                                         \
+  LETTERS_COMMON, LETTER('a', KC('a')), LETTER('m', KC('m')),                  \
+      LETTER('q', KC('q')), LETTER('w', KC('w')), LETTER('y', KC('y')),        \
+      LETTER('z', KC('z'))
+
+#define DIGITS                                                                 \
+  ['1'] = K(KN(1)), ['2'] = K(KN(2)), ['3'] = K(KN(3)), ['4'] = K(KN(4)),      \
+  ['5'] = K(KN(5)), ['6'] = K(KN(6)), ['7'] = K(KN(7)), ['8'] = K(KN(8)),      \
+  ['9'] = K(KN(9)), ['0'] = K(KN(0))
+
+// US shifted number row (without 2 and 3, those differ on UK)
+#define US_SHIFTED_DIGITS                                                      \
+  ['!'] = S(KN(1)), ['$'] = S(KN(4)), ['%'] = S(KN(5)), ['^'] = S(KN(6)),      \
+  ['&'] = S(KN(7)), ['*'] = S(KN(8)), ['('] = S(KN(9)), [')'] = S(KN(0))
+
+// punctuation shared by US and UK
+#define US_PUNCTUATION                                                         \
+  ['-'] = K(KC_MINUS), ['_'] = S(KC_MINUS), ['='] = K(KC_EQUAL),               \
+  ['+'] = S(KC_EQUAL), ['['] = K(KC_LBRACKET), ['{'] = S(KC_LBRACKET),         \
+  [']'] = K(KC_RBRACKET), ['}'] = S(KC_RBRACKET), [';'] = K(KC_SEMICOLON),     \
+  [':'] = S(KC_SEMICOLON), ['\''] = K(KC_QUOTE), ['`'] = K(KC_GRAVE),          \
+  [','] = K(KC_COMMA), ['<'] = S(KC_COMMA), ['.'] = K(KC_PERIOD),              \
+  ['>'] = S(KC_PERIOD), ['/'] = K(KC_SLASH), ['?'] = S(KC_SLASH)
+
+// ==================== ASCII TABLES ====================
+// built by the preprocessor, unset entries are {0, 0} = not typeable
+// (dead keys are left out, those characters go through send_unicode)
+
+static const kb_key_t ASCII_US[128] = {
+    CONTROL_KEYS,
+    LETTERS_QWERTY,
+    DIGITS,
+    US_SHIFTED_DIGITS,
+    US_PUNCTUATION,
+    ['@'] = S(KN(2)),
+    ['#'] = S(KN(3)),
+    ['\\'] = K(KC_BACKSLASH),
+    ['|'] = S(KC_BACKSLASH),
+    ['"'] = S(KC_QUOTE),
+    ['~'] = S(KC_GRAVE),
+};
+
+static const kb_key_t ASCII_UK[128] = {
+    CONTROL_KEYS,
+    LETTERS_QWERTY,
+    DIGITS,
+    US_SHIFTED_DIGITS,
+    US_PUNCTUATION,
+    ['"'] = S(KN(2)),
+    ['@'] = S(KC_QUOTE),
+    ['#'] = K(KC_NONUS_HASH),
+    ['~'] = S(KC_NONUS_HASH),
+    ['\\'] = K(KC_NONUS_BSLASH),
+    ['|'] = S(KC_NONUS_BSLASH),
+};
+
+static const kb_key_t ASCII_DE[128] = {
+    CONTROL_KEYS,
+    LETTERS_COMMON,
+    LETTER('a', KC('a')),
+    LETTER('m', KC('m')),
+    LETTER('q', KC('q')),
+    LETTER('w', KC('w')),
+    LETTER('y', KC('z')),
+    LETTER('z', KC('y')),
+    DIGITS,
+    ['!'] = S(KN(1)),
+    ['"'] = S(KN(2)),
+    ['$'] = S(KN(4)),
+    ['%'] = S(KN(5)),
+    ['&'] = S(KN(6)),
+    ['/'] = S(KN(7)),
+    ['('] = S(KN(8)),
+    [')'] = S(KN(9)),
+    ['='] = S(KN(0)),
+    ['?'] = S(KC_MINUS),
+    ['\\'] = G(KC_MINUS),
+    ['+'] = K(KC_RBRACKET),
+    ['*'] = S(KC_RBRACKET),
+    ['~'] = G(KC_RBRACKET),
+    ['#'] = K(KC_NONUS_HASH),
+    ['\''] = S(KC_NONUS_HASH),
+    [','] = K(KC_COMMA),
+    [';'] = S(KC_COMMA),
+    ['.'] = K(KC_PERIOD),
+    [':'] = S(KC_PERIOD),
+    ['-'] = K(KC_SLASH),
+    ['_'] = S(KC_SLASH),
+    ['<'] = K(KC_NONUS_BSLASH),
+    ['>'] = S(KC_NONUS_BSLASH),
+    ['|'] = G(KC_NONUS_BSLASH),
+    ['@'] = G(KC('q')),
+    ['{'] = G(KN(7)),
+    ['['] = G(KN(8)),
+    [']'] = G(KN(9)),
+    ['}'] = G(KN(0)),
+};
+
+static const kb_key_t ASCII_FR[128] = {
+    CONTROL_KEYS,
+    LETTERS_COMMON,
+    LETTER('a', KC('q')),
+    LETTER('q', KC('a')),
+    LETTER('w', KC('z')),
+    LETTER('z', KC('w')),
+    LETTER('y', KC('y')),
+    LETTER('m', KC_SEMICOLON),
+    // digits are shifted on AZERTY
+    ['1'] = S(KN(1)),
+    ['2'] = S(KN(2)),
+    ['3'] = S(KN(3)),
+    ['4'] = S(KN(4)),
+    ['5'] = S(KN(5)),
+    ['6'] = S(KN(6)),
+    ['7'] = S(KN(7)),
+    ['8'] = S(KN(8)),
+    ['9'] = S(KN(9)),
+    ['0'] = S(KN(0)),
+    ['&'] = K(KN(1)),
+    ['"'] = K(KN(3)),
+    ['\''] = K(KN(4)),
+    ['('] = K(KN(5)),
+    ['-'] = K(KN(6)),
+    ['_'] = K(KN(8)),
+    ['#'] = G(KN(3)),
+    ['{'] = G(KN(4)),
+    ['['] = G(KN(5)),
+    ['|'] = G(KN(6)),
+    ['\\'] = G(KN(8)),
+    ['@'] = G(KN(0)),
+    [')'] = K(KC_MINUS),
+    [']'] = G(KC_MINUS),
+    ['='] = K(KC_EQUAL),
+    ['+'] = S(KC_EQUAL),
+    ['}'] = G(KC_EQUAL),
+    ['$'] = K(KC_RBRACKET),
+    ['%'] = S(KC_QUOTE),
+    ['*'] = K(KC_NONUS_HASH),
+    [','] = K(KC('m')),
+    ['?'] = S(KC('m')),
+    [';'] = K(KC_COMMA),
+    ['.'] = S(KC_COMMA),
+    [':'] = K(KC_PERIOD),
+    ['/'] = S(KC_PERIOD),
+    ['!'] = K(KC_SLASH),
+    ['<'] = K(KC_NONUS_BSLASH),
+    ['>'] = S(KC_NONUS_BSLASH),
+};
+
+static const kb_key_t ASCII_DVORAK[128] = {
+    CONTROL_KEYS,
+    LETTER('a', KC('a')),
+    LETTER('b', KC('n')),
+    LETTER('c', KC('i')),
+    LETTER('d', KC('h')),
+    LETTER('e', KC('d')),
+    LETTER('f', KC('y')),
+    LETTER('g', KC('u')),
+    LETTER('h', KC('j')),
+    LETTER('i', KC('g')),
+    LETTER('j', KC('c')),
+    LETTER('k', KC('v')),
+    LETTER('l', KC('p')),
+    LETTER('m', KC('m')),
+    LETTER('n', KC('l')),
+    LETTER('o', KC('s')),
+    LETTER('p', KC('r')),
+    LETTER('q', KC('x')),
+    LETTER('r', KC('o')),
+    LETTER('s', KC_SEMICOLON),
+    LETTER('t', KC('k')),
+    LETTER('u', KC('f')),
+    LETTER('v', KC_PERIOD),
+    LETTER('w', KC_COMMA),
+    LETTER('x', KC('b')),
+    LETTER('y', KC('t')),
+    LETTER('z', KC_SLASH),
+    DIGITS,
+    US_SHIFTED_DIGITS,
+    ['@'] = S(KN(2)),
+    ['#'] = S(KN(3)),
+    ['\''] = K(KC('q')),
+    ['"'] = S(KC('q')),
+    [','] = K(KC('w')),
+    ['<'] = S(KC('w')),
+    ['.'] = K(KC('e')),
+    ['>'] = S(KC('e')),
+    [';'] = K(KC('z')),
+    [':'] = S(KC('z')),
+    ['['] = K(KC_MINUS),
+    ['{'] = S(KC_MINUS),
+    [']'] = K(KC_EQUAL),
+    ['}'] = S(KC_EQUAL),
+    ['/'] = K(KC_LBRACKET),
+    ['?'] = S(KC_LBRACKET),
+    ['='] = K(KC_RBRACKET),
+    ['+'] = S(KC_RBRACKET),
+    ['-'] = K(KC_QUOTE),
+    ['_'] = S(KC_QUOTE),
+    ['\\'] = K(KC_BACKSLASH),
+    ['|'] = S(KC_BACKSLASH),
+    ['`'] = K(KC_GRAVE),
+    ['~'] = S(KC_GRAVE),
+};
+
+// ==================== NON ASCII EXTRAS ====================
+
+static const kb_extra_t EXTRAS_PL[] = {
+    {0x00D3, GS(KC('o'))}, // Ó
+    {0x00F3, G(KC('o'))},  // ó
+    {0x0104, GS(KC('a'))}, // Ą
+    {0x0105, G(KC('a'))},  // ą
+    {0x0106, GS(KC('c'))}, // Ć
+    {0x0107, G(KC('c'))},  // ć
+    {0x0118, GS(KC('e'))}, // Ę
+    {0x0119, G(KC('e'))},  // ę
+    {0x0141, GS(KC('l'))}, // Ł
+    {0x0142, G(KC('l'))},  // ł
+    {0x0143, GS(KC('n'))}, // Ń
+    {0x0144, G(KC('n'))},  // ń
+    {0x015A, GS(KC('s'))}, // Ś
+    {0x015B, G(KC('s'))},  // ś
+    {0x0179, GS(KC('x'))}, // Ź
+    {0x017A, G(KC('x'))},  // ź
+    {0x017B, GS(KC('z'))}, // Ż
+    {0x017C, G(KC('z'))},  // ż
+    {0x20AC, G(KC('u'))},  // €
+};
+
+static const kb_extra_t EXTRAS_DE[] = {
+    {0x00A7, S(KN(3))},        // §
+    {0x00B0, S(KC_GRAVE)},     // °
+    {0x00B2, G(KN(2))},        // ²
+    {0x00B3, G(KN(3))},        // ³
+    {0x00B5, G(KC('m'))},      // µ
+    {0x00C4, S(KC_QUOTE)},     // Ä
+    {0x00D6, S(KC_SEMICOLON)}, // Ö
+    {0x00DC, S(KC_LBRACKET)},  // Ü
+    {0x00DF, K(KC_MINUS)},     // ß
+    {0x00E4, K(KC_QUOTE)},     // ä
+    {0x00F6, K(KC_SEMICOLON)}, // ö
+    {0x00FC, K(KC_LBRACKET)},  // ü
+    {0x20AC, G(KC('e'))},      // €
+};
+
+static const kb_extra_t EXTRAS_FR[] = {
+    {0x00A3, S(KC_RBRACKET)},   // £
+    {0x00A7, S(KC_SLASH)},      // §
+    {0x00B0, S(KC_MINUS)},      // °
+    {0x00B2, K(KC_GRAVE)},      // ²
+    {0x00B5, S(KC_NONUS_HASH)}, // µ
+    {0x00E0, K(KN(0))},         // à
+    {0x00E7, K(KN(9))},         // ç
+    {0x00E8, K(KN(7))},         // è
+    {0x00E9, K(KN(2))},         // é
+    {0x00F9, K(KC_QUOTE)},      // ù
+    {0x20AC, G(KC('e'))},       // €
+};
+
+static const kb_extra_t EXTRAS_UK[] = {
+    {0x00A3, S(KN(3))},    // £
+    {0x00AC, S(KC_GRAVE)}, // ¬
+    {0x20AC, G(KN(4))},    // €
+};
+
+#define EXTRAS(table) (table), (sizeof(table) / sizeof((table)[0]))
+
+static const kb_layout_desc_t LAYOUTS[KB_LAYOUT_COUNT] = {
+    [KB_LAYOUT_US] = {"US", ASCII_US, NULL, 0},
+    [KB_LAYOUT_DE] = {"DE", ASCII_DE, EXTRAS(EXTRAS_DE)},
+    [KB_LAYOUT_PL] = {"PL", ASCII_US, EXTRAS(EXTRAS_PL)}, // ASCII as US
+    [KB_LAYOUT_FR] = {"FR", ASCII_FR, EXTRAS(EXTRAS_FR)},
+    [KB_LAYOUT_UK] = {"UK", ASCII_UK, EXTRAS(EXTRAS_UK)},
+    [KB_LAYOUT_DVORAK] = {"DVORAK", ASCII_DVORAK, NULL, 0},
+};
+
+static uint8_t override_layout = KB_LAYOUT_DEVICE;
+
+// ==================== LOOKUP ====================
+
+bool kb_layout_map(uint8_t layout, uint32_t codepoint, uint8_t *keycode,
+                   uint8_t *modifiers) {
+  if (layout >= KB_LAYOUT_COUNT)
+    layout = KB_LAYOUT_US;
+
+  const kb_layout_desc_t *desc = &LAYOUTS[layout];
+  const kb_key_t *key = NULL;
+
+  if (codepoint < 128) {
+    key = &desc->ascii[codepoint];
+  } else {
+    // extras are sorted and short (< 20), linear scan is enough
+    for (uint8_t i = 0; i < desc->extra_count; i++) {
+      if (desc->extras[i].codepoint == codepoint) {
+        key = &desc->extras[i].key;
+        break;
+      }
+    }
+  }
+
+  if (key == NULL || key->keycode == 0)
+    return false;
+
+  *keycode = key->keycode;
+  *modifiers = key->modifiers;
+  return true;
+}
+
+uint8_t kb_layout_active(void) {
+  if (override_layout < KB_LAYOUT_COUNT)
+    return override_layout;
+
+  uint8_t layout = config_get()->kb_layout;
+  return layout < KB_LAYOUT_COUNT ? layout : KB_LAYOUT_US;
+}
+
+void kb_layout_set_override(uint8_t layout) {
+  override_layout = layout < KB_LAYOUT_COUNT ? layout : KB_LAYOUT_DEVICE;
+}
+
+uint8_t kb_layout_from_macro_value(uint16_t value) {
+  if ((value & 0xFF00) != KB_LAYOUT_MACRO_FLAG)
+    return KB_LAYOUT_DEVICE;
+
+  uint8_t layout = value & 0xFF;
+  return layout < KB_LAYOUT_COUNT ? layout : KB_LAYOUT_DEVICE;
+}
+
+const char *kb_layout_name(uint8_t layout) {
+  return layout < KB_LAYOUT_COUNT ? LAYOUTS[layout].name : "?";
+}
+
+int kb_layout_parse(const char *text) {
+  if (text == NULL || *text == '\0')
+    return -1;
+
+  if (*text >= '0' && *text <= '9') {
+    char *end;
+    long index = strtol(text, &end, 10);
+    return (*end == '\0' && index < KB_LAYOUT_COUNT) ? (int)index : -1;
+  }
+
+  for (int i = 0; i < KB_LAYOUT_COUNT; i++) {
+    if (strcasecmp(text, LAYOUTS[i].name) == 0)
+      return i;
+  }
+  return -1;
+}
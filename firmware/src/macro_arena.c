@@ -0,0 +1,264 @@
+#include "macro_arena.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+// key_step_t blobs are read in place, their offsets have to stay aligned
+_Static_assert(offsetof(macro_arena_t, data) % MACRO_ARENA_ALIGN == 0,
+               "arena data must be aligned");
+
+static macro_arena_t *arena(void) { return &config_get()->arena; }
+
+// space a blob takes in the arena, padded so the next one stays aligned
+static uint16_t stored_len(uint16_t len) {
+  return (uint16_t)((len + MACRO_ARENA_ALIGN - 1) & ~(MACRO_ARENA_ALIGN - 1));
+}
+
+static arena_ref_t *ref_of(uint8_t layer, uint8_t button, uint8_t slot) {
+  if (layer >= config_layer_count() || button >= NUM_BUTTONS ||
+      slot >= ARENA_SLOT_COUNT)
+    return NULL;
+  return &config_get()->layers[layer].refs[button][slot];
+}
+
+// moves every blob starting at or after 'from' by 'delta' bytes
+static void shift_refs(uint16_t from, int delta) {
+  layer_t *layers = config_get()->layers;
+  for (int l = 0; l < config_layer_count(); l++) {
+    for (int b = 0; b < NUM_BUTTONS; b++) {
+      for (int s = 0; s < ARENA_SLOT_COUNT; s++) {
+        arena_ref_t *r = &layers[l].refs[b][s];
+        if (r->len > 0 && r->offset >= from)
+          r->offset = (uint16_t)(r->offset + delta);
+      }
+    }
+  }
+}
+
+// refs using the blob at offset, equal blobs are stored once (interned)
+static int blob_users(uint16_t offset) {
+  layer_t *layers = config_get()->layers;
+  int users = 0;
+  for (int l = 0; l < config_layer_count(); l++) {
+    for (int b = 0; b < NUM_BUTTONS; b++) {
+      for (int s = 0; s < ARENA_SLOT_COUNT; s++) {
+        const arena_ref_t *r = &layers[l].refs[b][s];
+        if (r->len > 0 && r->offset == offset)
+          users++;
+      }
+    }
+  }
+  return users;
+}
+
+// another ref whose blob has the same content (the length filters almost
+// every candidate before any bytes are compared)
+static arena_ref_t *find_equal(const uint8_t *data, uint16_t len,
+                               const arena_ref_t *skip) {
+  macro_arena_t *a = arena();
+  layer_t *layers = config_get()->layers;
+  for (int l = 0; l < config_layer_count(); l++) {
+    for (int b = 0; b < NUM_BUTTONS; b++) {
+      for (int s = 0; s < ARENA_SLOT_COUNT; s++) {
+        arena_ref_t *r = &layers[l].refs[b][s];
+        if (r != skip && r->len == len &&
+            memcmp(&a->data[r->offset], data, len) == 0)
+          return r;
+      }
+    }
+  }
+  return NULL;
+}
+
+// bytes a set frees: the old blob goes away only with its last user
+static uint16_t freed_by_set(const arena_ref_t *ref) {
+  if (ref->len == 0 || blob_users(ref->offset) > 1)
+    return 0;
+  return stored_len(ref->len);
+}
+
+static void remove_blob(arena_ref_t *ref) {
+  macro_arena_t *a = arena();
+  if (ref->len == 0)
+    return;
+
+  // still used by another macro: drop only the reference
+  if (blob_users(ref->offset) > 1) {
+    ref->len = 0;
+    ref->offset = 0;
+    return;
+  }
+
+  uint16_t size = stored_len(ref->len);
+  uint16_t end = ref->offset + size;
+  memmove(&a->data[ref->offset], &a->data[end], a->used - end);
+  a->used -= size;
+
+  ref->len = 0;
+  ref->offset = 0;
+  shift_refs(end, -(int)size);
+}
+
+const uint8_t *macro_arena_get(uint8_t layer, uint8_t button, uint8_t slot,
+                               uint16_t *len) {
+  arena_ref_t *ref = ref_of(layer, button, slot);
+  uint16_t blob_len = ref ? ref->len : 0;
+
+  if (len)
+    *len = blob_len;
+  return blob_len ? &arena()->data[ref->offset] : NULL;
+}
+
+bool macro_arena_set(uint8_t layer, uint8_t button, uint8_t slot,
+                     const uint8_t *data, uint16_t len) {
+  arena_ref_t *ref = ref_of(layer, button, slot);
+  if (!ref)
+    return false;
+
+  macro_arena_t *a = arena();
+  if (data == NULL)
+    len = 0;
+  if (len > 0 && ref->len == len &&
+      memcmp(&a->data[ref->offset], data, len) == 0)
+    return true;
+
+  // interning: the same content stored for another macro is shared
+  arena_ref_t *same = len > 0 ? find_equal(data, len, ref) : NULL;
+  if (!same &&
+      stored_len(len) > macro_arena_free_bytes() + freed_by_set(ref))
+    return false;
+
+  remove_blob(ref);
+  if (len == 0)
+    return true;
+
+  if (same) {
+    ref->offset = same->offset; // fixed by remove_blob if it moved
+    ref->len = len;
+    return true;
+  }
+
+  memcpy(&a->data[a->used], data, len);
+  ref->offset = a->used;
+  ref->len = len;
+  a->used += stored_len(len);
+  return true;
+}
+
+bool macro_arena_append(uint8_t layer, uint8_t button, uint8_t slot,
+                        const uint8_t *data, uint16_t len) {
+  arena_ref_t *ref = ref_of(layer, button, slot);
+  if (!ref)
+    return false;
+
+  if (ref->len == 0)
+    return macro_arena_set(layer, button, slot, data, len);
+
+  // the padding of the blob is reused, only the rest needs a gap
+  macro_arena_t *a = arena();
+  uint16_t old_size = stored_len(ref->len);
+  uint16_t grow = stored_len(ref->len + len) - old_size;
+  bool shared = blob_users(ref->offset) > 1;
+  if (grow + (shared ? old_size : 0) > macro_arena_free_bytes())
+    return false;
+
+  // a shared blob is copied first, the other macros keep the old content
+  if (shared) {
+    memcpy(&a->data[a->used], &a->data[ref->offset], ref->len);
+    ref->offset = a->used;
+    a->used += old_size;
+  }
+
+  // open the gap right behind the blob
+  uint16_t end = ref->offset + old_size;
+  memmove(&a->data[end + grow], &a->data[end], a->used - end);
+  shift_refs(end, grow);
+
+  memcpy(&a->data[ref->offset + ref->len], data, len);
+  ref->len += len;
+  a->used += grow;
+
+  // the grown blob may now equal one that is already stored
+  arena_ref_t *same = find_equal(&a->data[ref->offset], ref->len, ref);
+  if (same && same->offset != ref->offset) {
+    uint16_t full = ref->len;
+    remove_blob(ref);
+    ref->offset = same->offset;
+    ref->len = full;
+  }
+  return true;
+}
+
+const key_step_t *macro_arena_steps(uint8_t layer, uint8_t button,
+                                    uint8_t slot, uint16_t *count) {
+  uint16_t len = 0;
+  const uint8_t *blob = macro_arena_get(layer, button, slot, &len);
+
+  if (count)
+    *count = len / sizeof(key_step_t);
+  return (const key_step_t *)blob;
+}
+
+void macro_arena_clear(uint8_t layer, uint8_t button, uint8_t slot) {
+  arena_ref_t *ref = ref_of(layer, button, slot);
+  if (ref)
+    remove_blob(ref);
+}
+
+uint16_t macro_arena_free_bytes(void) {
+  return MACRO_ARENA_SIZE - arena()->used;
+}
+
+static const arena_ref_t *first_user(uint16_t offset) {
+  layer_t *layers = config_get()->layers;
+  for (int l = 0; l < config_layer_count(); l++) {
+    for (int b = 0; b < NUM_BUTTONS; b++) {
+      for (int s = 0; s < ARENA_SLOT_COUNT; s++) {
+        const arena_ref_t *r = &layers[l].refs[b][s];
+        if (r->len > 0 && r->offset == offset)
+          return r;
+      }
+    }
+  }
+  return NULL;
+}
+
+void macro_arena_validate(void) {
+  macro_arena_t *a = arena();
+  layer_t *layers = config_get()->layers;
+  bool valid = a->used <= MACRO_ARENA_SIZE;
+  uint32_t total = 0;
+
+  for (int l = 0; l < config_layer_count() && valid; l++) {
+    for (int b = 0; b < NUM_BUTTONS && valid; b++) {
+      for (int s = 0; s < ARENA_SLOT_COUNT; s++) {
+        arena_ref_t *r = &layers[l].refs[b][s];
+        if (r->len == 0)
+          continue;
+        if ((uint32_t)r->offset + r->len > a->used ||
+            r->offset % MACRO_ARENA_ALIGN != 0) {
+          valid = false;
+          break;
+        }
+        // a shared blob counts once, all its users see the same length
+        const arena_ref_t *first = first_user(r->offset);
+        if (first->len != r->len) {
+          valid = false;
+          break;
+        }
+        if (first == r)
+          total += stored_len(r->len);
+      }
+    }
+  }
+
+  // packed without gaps -> the blobs add up to the used size
+  if (valid && total == a->used)
+    return;
+
+  printf("[ARENA] Invalid arena in flash, clearing\n");
+  memset(a, 0, sizeof(*a));
+  for (int l = 0; l < config_layer_count(); l++)
+    memset(layers[l].refs, 0, sizeof(layers[l].refs));
+}
@@ -1,7 +1,10 @@
 #include "macro_config.h"
+#include "config_migrate.h"
 #include "hardware/flash.h"
 #include "hardware/sync.h"
 #include "hardware/watchdog.h"
+#include "hid/keyboard_layout.h"
+#include "macro_arena.h"
 #include "pico/stdlib.h"
 #include "tusb.h"
 #include <stdio.h>
@@ -11,13 +14,40 @@
 // ==================== PRYWATNE ZMIENNE ====================
 static config_data_t g_config;
 static bool g_config_loaded = false;
-static uint8_t g_current_layer = 0;
+// wersja ukladu, ktora zostala we flash, bo nie zmiescila sie w arenie
+static uint16_t g_unmigrated_version = 0;
+static uint8_t g_current_layer = 0; // warstwa bazowa
+
+// warstwy chwilowe, ostatnio wcisniety przycisk na szczycie
+typedef struct {
+  uint8_t layer;
+  uint8_t button;
+} held_layer_t;
+static held_layer_t g_held[NUM_BUTTONS];
+static uint8_t g_held_count = 0;
 
 // ==================== DOMYŚLNE EMOTKI ====================
-static const uint8_t DEFAULT_LAYER_EMOJIS[MAX_LAYERS] = {0, 1, 2,
-                                                         7}; // 🎮, 💼, 🏠, 🎵
+// kolejne warstwy powtarzaja cykl
+static const uint8_t DEFAULT_LAYER_EMOJIS[DEFAULT_LAYER_COUNT] = {
+    0, 1, 2, 7}; // 🎮, 💼, 🏠, 🎵
 static const uint8_t DEFAULT_LAYER_SWITCH_EMOJI = 4;         // ⚡
 
+// ==================== DOMYŚLNE CZASY UNICODE ====================
+// {mode, settle_ms, key_ms, commit_ms}: Linux, Windows, macOS
+static const unicode_timing_t DEFAULT_UNICODE_TIMING[UNICODE_PLATFORMS] = {
+    {UNICODE_MODE_DEFAULT, 15, 2, 2},
+    {UNICODE_MODE_DEFAULT, 10, 2, 50},
+    {UNICODE_MODE_DEFAULT, 100, 100, 50},
+};
+
+// ==================== DOMYŚLNE CZASY SEKWENCJI ====================
+// {hold_ms, gap_ms, mod_ms}: Linux, Windows, macOS
+static const seq_timing_t DEFAULT_SEQ_TIMING[UNICODE_PLATFORMS] = {
+    {10, 5, 5, 0},
+    {10, 5, 5, 0},
+    {20, 10, 10, 0},
+};
+
 // ==================== CRC32 IMPLEMENTATION ====================
 static const uint32_t crc32_table[256] = {
     0x00000000, 0x77073096, 0xEE0E612C, 0x990951BA, 0x076DC419, 0x706AF48F,
@@ -64,10 +94,17 @@ static const uint32_t crc32_table[256] = {
     0x54DE5729, 0x23D967BF, 0xB3667A2E, 0xC4614AB8, 0x5D681B02, 0x2A6F2B94,
     0xB40BBE37, 0xC30C8EA1, 0x5A05DF1B, 0x2D02EF8D};
 
-uint32_t config_calculate_crc(const config_data_t *config) {
+// zapisywana czesc: ustawienia, arena i istniejace warstwy
+static uint32_t stored_size_for(uint8_t layer_count) {
+  return offsetof(config_data_t, layers) + layer_count * sizeof(layer_t);
+}
+
+uint32_t config_stored_size(void) {
+  return stored_size_for(g_config.layer_count);
+}
+
+uint32_t config_crc32(const uint8_t *data, size_t len) {
   uint32_t crc = 0xFFFFFFFF;
-  const uint8_t *data = (const uint8_t *)config;
-  size_t len = offsetof(config_data_t, crc32);
 
   for (size_t i = 0; i < len; i++) {
     crc = crc32_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
@@ -76,149 +113,257 @@ uint32_t config_calculate_crc(const config_data_t *config) {
   return ~crc;
 }
 
-uint8_t config_get_current_layer(void) { return g_current_layer; }
+uint32_t config_calculate_crc(const config_data_t *config) {
+  uint8_t layers =
+      config->layer_count <= MAX_LAYERS ? config->layer_count : MAX_LAYERS;
+  size_t len = stored_size_for(layers);
 
-void config_cycle_layer(void) {
-  g_current_layer = (g_current_layer + 1) % MAX_LAYERS;
-  printf("[CONFIG] Switched to layer %d\n", g_current_layer);
+  return config_crc32((const uint8_t *)config + sizeof(config->crc32),
+                      len - sizeof(config->crc32));
 }
 
-// ==================== FABRYCZNA KONFIGURACJA ====================
-void config_set_factory_defaults(void) {
-  memset(&g_config, 0, sizeof(config_data_t));
+// ==================== WARSTWY ====================
+uint8_t config_layer_count(void) { return g_config.layer_count; }
+
+layer_t *config_get_layer(uint8_t layer) {
+  if (layer >= g_config.layer_count)
+    return NULL;
+  return &g_config.layers[layer];
+}
 
-  // dla wszystkich mark sequence_length = 0
-  for (int layer = 0; layer < MAX_LAYERS; layer++) {
-    for (int btn = 0; btn < NUM_BUTTONS; btn++) {
-      g_config.macros[layer][btn].sequence_length = 0;
+macro_entry_t *config_get_macro(uint8_t layer, uint8_t button) {
+  if (layer >= g_config.layer_count || button >= NUM_BUTTONS)
+    return NULL;
+  return &g_config.layers[layer].macros[button];
+}
+
+// pusta warstwa, BTN7 przelacza warstwy
+static void layer_set_defaults(uint8_t index) {
+  layer_t *layer = &g_config.layers[index];
+  memset(layer, 0, sizeof(layer_t)); // bez blobow w arenie
+  layer->emoji = DEFAULT_LAYER_EMOJIS[index % DEFAULT_LAYER_COUNT];
+
+  for (int btn = 0; btn < NUM_BUTTONS; btn++) {
+    macro_entry_t *macro = &layer->macros[btn];
+    macro->type = MACRO_TYPE_KEY_PRESS;
+    macro->value = 0;
+    snprintf(macro->name, MAX_NAME_LEN, "Empty");
+    macro->emoji_index = 0; // domyslny
+
+    // defaultowe emoji dla przyciskow
+    if (btn == 0)
+      macro->emoji_index = 0; // 🎮
+    else if (btn == 1)
+      macro->emoji_index = 1; // 💼
+    else if (btn == 2)
+      macro->emoji_index = 2; // 🏠
+    else if (btn == 3)
+      macro->emoji_index = 17; // Ghost
+    else if (btn == 4)
+      macro->emoji_index = 7; // 🎵
+    else if (btn == 5)
+      macro->emoji_index = 9; // Mail
+
+    // BTN7 na kazdej warstwie = Layer Switch
+    if (btn == 6) {
+      macro->type = MACRO_TYPE_LAYER_TOGGLE;
+      macro->value = LAYER_SWITCH_CYCLE; // cykliczne przejscie
+      snprintf(macro->name, MAX_NAME_LEN, "LayerSwitch");
+      macro->emoji_index = DEFAULT_LAYER_SWITCH_EMOJI; // ⚡
     }
   }
+}
 
-  // nazwy i emotki warstw
-  for (int i = 0; i < MAX_LAYERS; i++) {
-    g_config.layer_emojis[i] = DEFAULT_LAYER_EMOJIS[i];
+// warstwy chwilowe musza istniec
+static void drop_missing_layers(void) {
+  uint8_t kept = 0;
+  for (uint8_t i = 0; i < g_held_count; i++) {
+    if (g_held[i].layer < g_config.layer_count)
+      g_held[kept++] = g_held[i];
   }
+  g_held_count = kept;
 
-  // Layer 0: F1-F7
-  for (int i = 0; i < NUM_BUTTONS; i++) {
-    g_config.macros[0][i].type = MACRO_TYPE_KEY_PRESS;
-    g_config.macros[0][i].value = 0x3A + i; // HID F1-F7 keycodes
-    snprintf(g_config.macros[0][i].name, MAX_NAME_LEN, "F%d", i + 1);
-    g_config.macros[0][i].emoji_index = 0; // domyslny
-  }
+  if (g_current_layer >= g_config.layer_count)
+    g_current_layer = 0;
+}
+
+bool config_set_layer_count(uint8_t count) {
+  if (count == 0 || count > MAX_LAYERS)
+    return false;
 
-  // BTN7 (ostatni przycisk) = Layer Switch
-  g_config.macros[0][6].type = MACRO_TYPE_LAYER_TOGGLE;
-  g_config.macros[0][6].value = 0; // cykliczne przejscie (1->2->3->4->1)
-  snprintf(g_config.macros[0][6].name, MAX_NAME_LEN, "LayerSwitch");
-  g_config.macros[0][6].emoji_index = DEFAULT_LAYER_SWITCH_EMOJI; // ⚡
-
-  // Layer 1-3: puste
-  for (int layer = 0; layer < MAX_LAYERS; layer++) {
-    for (int btn = 0; btn < NUM_BUTTONS; btn++) {
-      g_config.macros[layer][btn].type = MACRO_TYPE_KEY_PRESS;
-      g_config.macros[layer][btn].value = 0;
-      g_config.macros[layer][btn].sequence_length = 0;
-      snprintf(g_config.macros[layer][btn].name, MAX_NAME_LEN, "Empty");
-      g_config.macros[layer][btn].emoji_index = 0; // domyslny
-
-      // defaultowe emoji dla przyciskow
-      if (btn == 0)
-        g_config.macros[layer][btn].emoji_index = 0; // 🎮
-      else if (btn == 1)
-        g_config.macros[layer][btn].emoji_index = 1; // 💼
-      else if (btn == 2)
-        g_config.macros[layer][btn].emoji_index = 2; // 🏠
-      else if (btn == 3)
-        g_config.macros[layer][btn].emoji_index = 17; // Ghost
-      else if (btn == 4)
-        g_config.macros[layer][btn].emoji_index = 7; // 🎵
-      else if (btn == 5)
-        g_config.macros[layer][btn].emoji_index = 9; // Mail
-
-      // BTN7 na kazdej warstwie = Layer Switch
-      if (btn == 6) {
-        g_config.macros[layer][btn].type = MACRO_TYPE_LAYER_TOGGLE;
-        g_config.macros[layer][btn].value = 0; // cykliczne przejscie
-        snprintf(g_config.macros[layer][btn].name, MAX_NAME_LEN, "LayerSwitch");
-        g_config.macros[layer][btn].emoji_index =
-            DEFAULT_LAYER_SWITCH_EMOJI; // ⚡
-      }
+  // bloby usuwanych warstw wracaja do areny
+  for (uint8_t l = count; l < g_config.layer_count; l++) {
+    for (uint8_t b = 0; b < NUM_BUTTONS; b++) {
+      for (uint8_t s = 0; s < ARENA_SLOT_COUNT; s++)
+        macro_arena_clear(l, b, s);
     }
+    memset(&g_config.layers[l], 0, sizeof(layer_t));
   }
 
-  g_config.crc32 = config_calculate_crc(&g_config);
+  for (uint8_t l = g_config.layer_count; l < count; l++)
+    layer_set_defaults(l);
+
+  g_config.layer_count = count;
+  drop_missing_layers();
+  printf("[CONFIG] Layers: %d\n", count);
+  return true;
+}
+
+uint8_t config_get_current_layer(void) {
+  if (g_held_count > 0)
+    return g_held[g_held_count - 1].layer;
+  return g_current_layer;
+}
+
+void config_set_current_layer(uint8_t layer) {
+  if (layer >= g_config.layer_count)
+    return;
+  g_current_layer = layer;
+  g_held_count = 0; // skok konczy warstwy chwilowe
+  printf("[CONFIG] Switched to layer %d\n", g_current_layer);
+}
+
+void config_cycle_layer(void) {
+  g_current_layer = (config_get_current_layer() + 1) % g_config.layer_count;
+  g_held_count = 0;
+  printf("[CONFIG] Switched to layer %d\n", g_current_layer);
+}
+
+void config_layer_push(uint8_t layer, uint8_t button) {
+  if (layer >= g_config.layer_count || button >= NUM_BUTTONS)
+    return;
+
+  config_layer_release(button); // jeden wpis na przycisk
+  g_held[g_held_count].layer = layer;
+  g_held[g_held_count].button = button;
+  g_held_count++;
+  printf("[CONFIG] Holding layer %d\n", layer);
+}
+
+bool config_layer_release(uint8_t button) {
+  for (uint8_t i = 0; i < g_held_count; i++) {
+    if (g_held[i].button != button)
+      continue;
+
+    memmove(&g_held[i], &g_held[i + 1],
+            (g_held_count - i - 1) * sizeof(g_held[0]));
+    g_held_count--;
+    printf("[CONFIG] Released layer, now %d\n", config_get_current_layer());
+    return true;
+  }
+  return false;
+}
+
+// ==================== FABRYCZNA KONFIGURACJA ====================
+void config_set_factory_defaults(void) {
+  memset(&g_config, 0, sizeof(config_data_t)); // pusta arena, bez sekwencji
+
+  g_config.version = CONFIG_VERSION;
+  g_config.layer_count = DEFAULT_LAYER_COUNT;
+  for (int layer = 0; layer < DEFAULT_LAYER_COUNT; layer++)
+    layer_set_defaults(layer);
+  drop_missing_layers();
+
   g_config_loaded = true;
   g_config.global_text_platform = detect_platform();
   g_config.oled_timeout_s = 300; // 5 minut
+  g_config.kb_layout = KB_LAYOUT_US;
+  memcpy(g_config.unicode_timing, DEFAULT_UNICODE_TIMING,
+         sizeof(DEFAULT_UNICODE_TIMING));
+  memcpy(g_config.seq_timing, DEFAULT_SEQ_TIMING, sizeof(DEFAULT_SEQ_TIMING));
+  g_config.crc32 = config_calculate_crc(&g_config);
 }
 
 // ==================== ODCZYT Z FLASH ====================
 static bool config_load_from_flash(void) {
-  const uint8_t *flash_target =
-      (const uint8_t *)(XIP_BASE + FLASH_TARGET_OFFSET);
+  const config_data_t *flash_config =
+      (const config_data_t *)(XIP_BASE + FLASH_TARGET_OFFSET);
+
+  // inny uklad: config_migrate() albo konfiguracja fabryczna
+  if (flash_config->version != CONFIG_VERSION) {
+    printf("[CONFIG] Layout version %d, expected %d\n", flash_config->version,
+           CONFIG_VERSION);
+    return false;
+  }
 
-  config_data_t temp_config;
-  memcpy(&temp_config, flash_target, sizeof(config_data_t));
+  // CRC liczone wprost na flash (XIP), bez kopii na stosie
+  uint8_t layer_count = flash_config->layer_count;
+  if (layer_count == 0 || layer_count > MAX_LAYERS) {
+    printf("[CONFIG] Invalid layer count: %d\n", layer_count);
+    return false;
+  }
 
-  uint32_t calculated_crc = config_calculate_crc(&temp_config);
-  if (calculated_crc != temp_config.crc32) {
+  uint32_t calculated_crc = config_calculate_crc(flash_config);
+  if (calculated_crc != flash_config->crc32) {
     printf("[CONFIG] CRC mismatch! Calculated: 0x%08X, Stored: 0x%08X\n",
-           calculated_crc, temp_config.crc32);
+           calculated_crc, flash_config->crc32);
     return false;
   }
 
-  memcpy(&g_config, &temp_config, sizeof(config_data_t));
-  printf("[CONFIG] Loaded from flash successfully\n");
+  // tylko istniejace warstwy, reszta pusta
+  uint32_t size = stored_size_for(layer_count);
+  memcpy(&g_config, flash_config, size);
+  memset((uint8_t *)&g_config + size, 0, sizeof(config_data_t) - size);
+
+  // wartosci spoza zakresu (zapis innej wersji firmware)
+  if (g_config.kb_layout >= KB_LAYOUT_COUNT)
+    g_config.kb_layout = KB_LAYOUT_US;
+  for (int p = 0; p < UNICODE_PLATFORMS; p++) {
+    if (g_config.unicode_timing[p].mode > UNICODE_MODE_HEX_INPUT)
+      g_config.unicode_timing[p] = DEFAULT_UNICODE_TIMING[p];
+    if (g_config.seq_timing[p].reserved != 0)
+      g_config.seq_timing[p] = DEFAULT_SEQ_TIMING[p];
+  }
+  macro_arena_validate();
+  printf("[CONFIG] Loaded %d layers from flash successfully\n", layer_count);
   return true;
 }
 
 // ==================== ZAPIS DO FLASH ====================
+// jeden sektor naraz, bez bufora na cala konfiguracje
+static uint8_t g_sector_buffer[FLASH_SECTOR_SIZE];
+
 bool config_save(void) {
   watchdog_update();
 
   g_config.crc32 = config_calculate_crc(&g_config);
 
-  // wymagany rozmiar sektora (wielokrotnosc 4KB)
-  uint32_t sector_size = FLASH_SECTOR_SIZE_CALC;
-  uint32_t aligned_size =
-      (sizeof(config_data_t) + 255) & ~255; // wyrownanie do 256 bajtow
-
-  // wyrownany bufor
-  uint8_t *aligned_buffer = malloc(aligned_size);
-  if (!aligned_buffer) {
-    printf("[CONFIG] ERROR: Memory allocation failed\n");
-    return false;
-  }
-
-  memset(aligned_buffer, 0xFF, aligned_size);
-  memcpy(aligned_buffer, &g_config, sizeof(config_data_t));
+  const uint8_t *data = (const uint8_t *)&g_config;
+  uint32_t stored_size = config_stored_size(); // tylko istniejace warstwy
 
-  watchdog_update();
+  printf("[CONFIG] Writing to flash (%lu bytes)...\n",
+         (unsigned long)stored_size);
 
-  printf("[CONFIG] Writing to flash (%lu bytes)...\n", aligned_size);
+  for (uint32_t offset = 0; offset < stored_size;
+       offset += FLASH_SECTOR_SIZE) {
+    uint32_t len = stored_size - offset;
+    if (len > FLASH_SECTOR_SIZE)
+      len = FLASH_SECTOR_SIZE;
+    // programowane tylko zajete strony (wyrownanie do 256 bajtow)
+    uint32_t program_len = (len + FLASH_PAGE_SIZE - 1) & ~(FLASH_PAGE_SIZE - 1);
 
-  uint32_t ints = save_and_disable_interrupts();
-  flash_range_erase(FLASH_TARGET_OFFSET, sector_size);
-  flash_range_program(FLASH_TARGET_OFFSET, aligned_buffer, aligned_size);
-  restore_interrupts(ints);
+    memset(g_sector_buffer, 0xFF, program_len);
+    memcpy(g_sector_buffer, data + offset, len);
 
-  watchdog_update();
+    uint32_t ints = save_and_disable_interrupts();
+    flash_range_erase(FLASH_TARGET_OFFSET + offset, FLASH_SECTOR_SIZE);
+    flash_range_program(FLASH_TARGET_OFFSET + offset, g_sector_buffer,
+                        program_len);
+    restore_interrupts(ints);
 
-  free(aligned_buffer);
+    watchdog_update();
+  }
 
+  g_unmigrated_version = 0;
   printf("[CONFIG] Flash write complete, verifying...\n");
 
   sleep_ms(50);
   watchdog_update();
 
-  // weryfikacja
-  config_data_t temp_verify;
-  const uint8_t *flash_target =
-      (const uint8_t *)(XIP_BASE + FLASH_TARGET_OFFSET);
-  memcpy(&temp_verify, flash_target, sizeof(config_data_t));
-
-  uint32_t flash_crc = config_calculate_crc(&temp_verify);
+  // weryfikacja wprost na flash (XIP)
+  const config_data_t *flash_config =
+      (const config_data_t *)(XIP_BASE + FLASH_TARGET_OFFSET);
+  uint32_t flash_crc = config_calculate_crc(flash_config);
 
   watchdog_update();
 
@@ -234,18 +379,37 @@ bool config_save(void) {
 
 // ==================== INICJALIZACJA ====================
 void config_init(void) {
+  const uint8_t *flash = (const uint8_t *)(XIP_BASE + FLASH_TARGET_OFFSET);
+  uint16_t old_version = 0;
+  config_migrate_result_t migrated = CONFIG_MIGRATE_UNKNOWN;
   printf("[CONFIG] Initializing...\n");
 
   if (config_load_from_flash()) {
     g_config_loaded = true;
     printf("[CONFIG] Configuration loaded from flash\n");
+  } else if ((migrated = config_migrate(flash, &old_version)) ==
+             CONFIG_MIGRATE_OK) {
+    // od razu w nowym ukladzie, kolejny start czyta go wprost
+    printf("[CONFIG] Configuration migrated to version %d\n", CONFIG_VERSION);
+    config_save();
+  } else if (migrated == CONFIG_MIGRATE_NO_SPACE) {
+    // stary sektor zostaje, GET_CONF zglasza to, az uzytkownik zapisze sam
+    g_unmigrated_version = old_version;
+    printf("[CONFIG] Migration incomplete, version %u kept in flash\n",
+           old_version);
   } else {
     printf("[CONFIG] Flash empty or corrupted, loading factory defaults\n");
     config_set_factory_defaults();
     g_config.global_text_platform = detect_platform();
     config_save();
   }
+
+  // start (i RELOAD_CONFIG) od pierwszej warstwy
+  g_current_layer = 0;
+  g_held_count = 0;
 }
 
 // ==================== GETTERY ====================
 config_data_t *config_get(void) { return &g_config; }
+
+uint16_t config_unmigrated_version(void) { return g_unmigrated_version; }
@@ -0,0 +1,129 @@
+#include "midi/midi_clock.h"
+
+#include "pico/stdlib.h"
+
+#define DEFAULT_TICK_US (60000000u / (MIDI_CLOCK_DEFAULT_BPM * MIDI_CLOCK_PPQN))
+#define MIN_TICK_US (60000000u / (MIDI_CLOCK_MAX_BPM * MIDI_CLOCK_PPQN))
+
+static uint32_t tick_us = DEFAULT_TICK_US; // filtered period
+static uint32_t last_tick_us;
+static bool have_last_tick; // last_tick_us is valid for the next interval
+static bool seeded;         // tick_us measured, not the default tempo
+static uint8_t outliers;    // samples in a row far from tick_us
+static uint32_t outlier_us; // their average, they have to agree to relock
+static bool started;        // Start / Continue seen, no Stop yet
+static int32_t position = -1;
+
+static bool clock_lost(uint32_t now) {
+  return !have_last_tick ||
+         now - last_tick_us > MIDI_CLOCK_TIMEOUT_MS * 1000u;
+}
+
+static bool near(uint32_t sample, uint32_t period) {
+  uint32_t band = period / 4;
+  return sample + band >= period && sample <= period + band;
+}
+
+// one interval between two ticks into the period estimate
+static void filter_sample(uint32_t sample) {
+  // ticks read late in one go (the endpoint was not polled) carry no tempo
+  if (sample < MIN_TICK_US)
+    return;
+
+  if (!seeded) {
+    tick_us = sample;
+    seeded = true;
+    return;
+  }
+
+  // more than 25% off: a USB burst, or a real tempo change when the
+  // following samples agree on the new period
+  if (!near(sample, tick_us)) {
+    if (outliers == 0 || !near(sample, outlier_us)) {
+      outlier_us = sample;
+      outliers = 1;
+    } else {
+      outlier_us = (outlier_us * outliers + sample) / (outliers + 1);
+      outliers++;
+    }
+    if (outliers < MIDI_CLOCK_RELOCK_SAMPLES)
+      return;
+    tick_us = outlier_us;
+    outliers = 0;
+    return;
+  }
+
+  outliers = 0;
+  // exponential average, 1/8 of the error per tick
+  int32_t error = (int32_t)sample - (int32_t)tick_us;
+  tick_us = (uint32_t)((int32_t)tick_us + error / 8);
+}
+
+static void on_tick(void) {
+  uint32_t now = time_us_32();
+  if (!clock_lost(now))
+    filter_sample(now - last_tick_us);
+  last_tick_us = now;
+  have_last_tick = true;
+
+  if (started)
+    position++;
+}
+
+void midi_clock_realtime(uint8_t byte) {
+  switch (byte) {
+  case 0xF8: // Timing Clock
+    on_tick();
+    break;
+  case 0xFA: // Start, the next tick is the downbeat
+    started = true;
+    position = -1;
+    break;
+  case 0xFB: // Continue from the current position
+    started = true;
+    break;
+  case 0xFC: // Stop
+    started = false;
+    break;
+  default:
+    break;
+  }
+}
+
+void midi_clock_init(void) {
+  tick_us = DEFAULT_TICK_US;
+  have_last_tick = false;
+  seeded = false;
+  outliers = 0;
+  started = false;
+  position = -1;
+}
+
+bool midi_clock_running(void) {
+  return started && !clock_lost(time_us_32());
+}
+
+int32_t midi_clock_position(void) { return position; }
+
+uint32_t midi_clock_tick_us(void) { return tick_us; }
+
+uint16_t midi_clock_bpm_x10(void) {
+  return (uint16_t)((600000000u / MIDI_CLOCK_PPQN + tick_us / 2) / tick_us);
+}
+
+uint16_t midi_clock_interval_ms(uint16_t interval) {
+  if (!(interval & MIDI_INTERVAL_TICKS))
+    return interval;
+
+  uint64_t ticks = interval & ~MIDI_INTERVAL_TICKS;
+  uint64_t ms = (ticks * tick_us + 500) / 1000;
+  return ms > UINT16_MAX ? UINT16_MAX : (uint16_t)ms;
+}
+
+int32_t midi_clock_next_grid(uint16_t grid) {
+  if (grid == 0)
+    grid = 1;
+  if (position < 0)
+    return 0; // downbeat
+  return (position / grid + 1) * grid;
+}
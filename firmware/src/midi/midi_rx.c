@@ -0,0 +1,101 @@
+#include "midi/midi_rx.h"
+
+#include "hardware_interface.h"
+#include "midi/midi_clock.h"
+#include "oled/oled_display.h"
+#include "pin_definitions.h"
+#include "tusb.h"
+#include <stdbool.h>
+
+static uint8_t running_status; // 0 = none, data bytes are dropped
+static uint8_t data[2];
+static uint8_t data_count;
+static bool rgb[3];
+
+// Program Change and Channel Pressure carry one data byte
+static uint8_t data_length(uint8_t status) {
+  uint8_t type = status & 0xF0;
+  return (type == 0xC0 || type == 0xD0) ? 1 : 2;
+}
+
+// ==================== FEEDBACK ====================
+
+static void note_feedback(uint8_t note, bool on) {
+  if (note < MIDI_RX_LED_NOTE_BASE ||
+      note >= MIDI_RX_LED_NOTE_BASE + NUM_BUTTONS)
+    return;
+  led_set(note - MIDI_RX_LED_NOTE_BASE, on);
+}
+
+static void cc_feedback(uint8_t cc, uint8_t value) {
+  if (cc >= MIDI_RX_RGB_CC_BASE && cc < MIDI_RX_RGB_CC_BASE + 3) {
+    rgb[cc - MIDI_RX_RGB_CC_BASE] = value >= 64;
+    led_rgb_set(rgb[0], rgb[1], rgb[2]);
+  } else if (cc >= MIDI_RX_METER_CC_BASE &&
+             cc < MIDI_RX_METER_CC_BASE + OLED_METER_COUNT) {
+    // only stored here, oled_ui_task redraws at its own frame rate
+    oled_show_meter(cc - MIDI_RX_METER_CC_BASE, value);
+  }
+}
+
+static void dispatch(uint8_t status) {
+  switch (status & 0xF0) {
+  case 0x90: // Note On with velocity 0 is a Note Off
+    note_feedback(data[0], data[1] > 0);
+    break;
+  case 0x80:
+    note_feedback(data[0], false);
+    break;
+  case 0xB0:
+    cc_feedback(data[0], data[1]);
+    break;
+  default:
+    break;
+  }
+}
+
+// ==================== PARSER ====================
+
+void midi_rx_parse(uint8_t byte) {
+  if (byte >= 0xF8) { // real-time, does not touch running status
+    midi_clock_realtime(byte);
+    return;
+  }
+
+  if (byte & 0x80) {
+    // SysEx and system common cancel running status
+    running_status = (byte < 0xF0) ? byte : 0;
+    data_count = 0;
+    return;
+  }
+
+  if (running_status == 0)
+    return;
+
+  data[data_count++] = byte;
+  if (data_count == data_length(running_status)) {
+    dispatch(running_status);
+    data_count = 0;
+  }
+}
+
+void midi_rx_init(void) {
+  running_status = 0;
+  data_count = 0;
+  rgb[0] = rgb[1] = rgb[2] = false;
+}
+
+void midi_rx_task(void) {
+  if (!tud_midi_mounted())
+    return;
+
+  // drain the endpoint, the idle loop only wakes on new USB events
+  uint8_t buf[MIDI_RX_BUF_SIZE];
+  while (tud_midi_available() > 0) {
+    uint32_t n = tud_midi_stream_read(buf, sizeof(buf));
+    if (n == 0)
+      break;
+    for (uint32_t i = 0; i < n; i++)
+      midi_rx_parse(buf[i]);
+  }
+}
@@ -0,0 +1,116 @@
+#include "midi/midi_tx.h"
+
+#include "power/power_idle.h"
+#include "tusb.h"
+#include <string.h>
+
+typedef struct {
+  uint8_t len;
+  uint8_t bytes[3];
+} tx_event_t;
+
+static tx_event_t queue[MIDI_TX_MAX_EVENTS];
+static uint8_t queue_len;
+static midi_tx_stats_t stats;
+
+static uint8_t message_length(uint8_t status) {
+  switch (status & 0xF0) {
+  case 0xC0: // Program Change
+  case 0xD0: // Channel Pressure
+    return 2;
+  case 0xF0:
+    if (status == 0xF1 || status == 0xF3)
+      return 2;
+    return status == 0xF2 ? 3 : 1;
+  default:
+    return 3;
+  }
+}
+
+// Data Entry, RPN and NRPN select: a later message depends on the earlier
+static bool keeps_order(uint8_t controller) {
+  return controller == 6 || controller == 38 ||
+         (controller >= 96 && controller <= 101);
+}
+
+// queued CC of the same channel and controller, searched backwards up to
+// the last other message of the channel (a sustain change must not move
+// before a note)
+static tx_event_t *find_cc(uint8_t status, uint8_t controller) {
+  if ((status & 0xF0) != 0xB0 || keeps_order(controller))
+    return NULL;
+
+  for (int i = queue_len - 1; i >= 0; i--) {
+    const uint8_t *bytes = queue[i].bytes;
+    if ((bytes[0] & 0x0F) != (status & 0x0F) && bytes[0] < 0xF0)
+      continue; // another channel
+    if (bytes[0] != status || keeps_order(bytes[1]))
+      return NULL;
+    if (bytes[1] == controller)
+      return &queue[i];
+  }
+  return NULL;
+}
+
+bool midi_tx_message(uint8_t status, uint8_t data1, uint8_t data2) {
+  if (!tud_midi_mounted())
+    return false;
+
+  stats.events++;
+
+  tx_event_t *queued = find_cc(status, data1);
+  if (queued != NULL) {
+    queued->bytes[2] = data2;
+    stats.coalesced++;
+    return true;
+  }
+
+  if (queue_len == MIDI_TX_MAX_EVENTS) {
+    stats.overflows++;
+    midi_tx_flush();
+  }
+  if (queue_len == 0)
+    power_idle_notify_event(); // no idle sleep with a message waiting
+
+  tx_event_t *event = &queue[queue_len++];
+  event->len = message_length(status);
+  event->bytes[0] = status;
+  event->bytes[1] = data1;
+  event->bytes[2] = data2;
+  return true;
+}
+
+void midi_tx_flush(void) {
+  if (queue_len == 0)
+    return;
+
+  uint8_t buf[MIDI_TX_MAX_EVENTS * 3];
+  uint32_t len = 0;
+  for (uint8_t i = 0; i < queue_len; i++) {
+    memcpy(&buf[len], queue[i].bytes, queue[i].len);
+    len += queue[i].len;
+  }
+
+  uint32_t written = tud_midi_stream_write(0, buf, len);
+  stats.flushes++;
+
+  // messages past the written bytes never reached the FIFO
+  uint32_t end = 0;
+  for (uint8_t i = 0; i < queue_len; i++) {
+    end += queue[i].len;
+    if (end > written)
+      stats.dropped++;
+  }
+  queue_len = 0;
+}
+
+void midi_tx_task(void) { midi_tx_flush(); }
+
+void midi_tx_init(void) {
+  queue_len = 0;
+  memset(&stats, 0, sizeof(stats));
+}
+
+void midi_tx_get_stats(midi_tx_stats_t *out) { *out = stats; }
+
+void midi_tx_reset_stats(void) { memset(&stats, 0, sizeof(stats)); }
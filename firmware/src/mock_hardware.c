@@ -61,7 +61,8 @@ void mock_hardware_update(void) {
 
   // status
   if (mock_update_counter % 10000 == 0) {
-    printf("[MOCK] Status update (#%lu):\n", mock_update_counter / 10000);
+    printf("[MOCK] Status update (#%lu):\n",
+           (unsigned long)(mock_update_counter / 10000));
 
     // LED status
     printf("[MOCK]   LEDs: ");
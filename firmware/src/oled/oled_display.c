@@ -3,14 +3,17 @@
 #include "assets_graphics.h"
 #include "cdc/cdc_transport.h"
 #include "emoji.h"
+#include "executor/midi_cc.h"
 #include "font.h"
 #include "hardware/spi.h"
-#include "hardware/timer.h"
 #include "hardware_interface.h"
+#include "macro_arena.h"
 #include "macro_config.h"
 #include "oled/screensaver/screensaver_manager.h"
 #include "pico/stdlib.h"
 #include "pin_definitions.h"
+#include "power/power_idle.h"
+#include "profiler/profiler.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -24,17 +27,18 @@ static uint32_t preview_end_time = 0;
 static bool is_preview_active = false;
 #define PREVIEW_DURATION_MS 2000
 
+// MIDI feedback meters
+static uint8_t meter_values[OLED_METER_COUNT];
+static bool meter_dirty = false;
+static uint32_t meter_next_frame = 0;
+
 // matrix effect
 static RainColumn rain_cols[MATRIX_COLS];
 static bool matrix_initialized = false;
-static struct repeating_timer matrix_timer;
-static volatile bool matrix_tick_flag = false;
-static bool timer_running = false;
-
-static bool matrix_timer_callback(struct repeating_timer *t) {
-  matrix_tick_flag = true;
-  return true;
-}
+static int flush_prof_zone = -1;
+static bool screensaver_running = false;
+static uint32_t next_frame_time = 0;
+#define SCREENSAVER_FRAME_MS 50
 
 void oled_init(void) {
   // SPI init
@@ -67,6 +71,8 @@ void oled_init(void) {
 
   cdc_log("[OLED] SPI initialized\n");
 
+  flush_prof_zone = profiler_register("oled_flush");
+
   // init sequence
   oled_write_cmd(OLED_CMD_DISPLAY_OFF);
   oled_write_cmd(OLED_CMD_SET_DISPLAY_CLOCK_DIV);
@@ -113,6 +119,8 @@ void oled_init(void) {
 void oled_clear(void) { memset(oled_buffer, 0, sizeof(oled_buffer)); }
 
 void oled_update(void) {
+  PROF_BEGIN(stamp);
+
   oled_write_cmd(OLED_CMD_COLUMN_ADDR);
   oled_write_cmd(0);
   oled_write_cmd(OLED_WIDTH - 1);
@@ -126,6 +134,8 @@ void oled_update(void) {
         (i + 16 > sizeof(oled_buffer)) ? sizeof(oled_buffer) - i : 16;
     oled_write_data(&oled_buffer[i], chunk_size);
   }
+
+  PROF_END(flush_prof_zone, stamp);
 }
 
 void oled_write_cmd(uint8_t cmd) {
@@ -145,7 +155,7 @@ void oled_write_data(const uint8_t *data, size_t len) {
 void oled_display_layer_info(uint8_t layer) {
   oled_clear();
 
-  if (layer >= MAX_LAYERS) {
+  if (layer >= config_layer_count()) {
     oled_draw_string(0, 28, "Invalid layer!");
     oled_update();
     return;
@@ -166,10 +176,11 @@ void oled_display_layer_info(uint8_t layer) {
 
   // tytul
   char line1[32];
-  if (strlen(config->layer_names[layer]) > 0) {
-    snprintf(line1, sizeof(line1), "%s", config->layer_names[layer]);
+  if (strlen(config->layers[layer].name) > 0) {
+    snprintf(line1, sizeof(line1), "%s", config->layers[layer].name);
   } else {
-    snprintf(line1, sizeof(line1), "Layer %d/4", layer + 1);
+    snprintf(line1, sizeof(line1), "Layer %d/%d", layer + 1,
+             config_layer_count());
   }
 
   int title_len = strlen(line1);
@@ -178,7 +189,7 @@ void oled_display_layer_info(uint8_t layer) {
   title_x = (OLED_WIDTH - title_width) / 2;
   if (title_x < 0)
     title_x = 0;
-  oled_draw_emoji(title_x, 0, config->layer_emojis[layer]);
+  oled_draw_emoji(title_x, 0, config->layers[layer].emoji);
   oled_draw_string(title_x + 15, 0, line1);
 
   uint8_t icon_idx = 0;
@@ -209,38 +220,66 @@ void oled_display_layer_info(uint8_t layer) {
   // rzad 1: [1] [2] [3]
   oled_draw_string(grid_x_start, row1_y, "[1]");
   oled_draw_emoji(grid_x_start + 18, row1_y,
-                  config->macros[layer][0].emoji_index);
+                  config->layers[layer].macros[0].emoji_index);
   oled_draw_string(grid_x_start + button_width, row1_y, "[2]");
   oled_draw_emoji(grid_x_start + button_width + 18, row1_y,
-                  config->macros[layer][1].emoji_index);
+                  config->layers[layer].macros[1].emoji_index);
   oled_draw_string(grid_x_start + 2 * button_width, row1_y, "[3]");
   oled_draw_emoji(grid_x_start + 2 * button_width + 18, row1_y,
-                  config->macros[layer][2].emoji_index);
+                  config->layers[layer].macros[2].emoji_index);
 
   // rzad 2: [4] [5] [6]
   oled_draw_string(grid_x_start, row2_y, "[4]");
   oled_draw_emoji(grid_x_start + 18, row2_y,
-                  config->macros[layer][3].emoji_index);
+                  config->layers[layer].macros[3].emoji_index);
   oled_draw_string(grid_x_start + button_width, row2_y, "[5]");
   oled_draw_emoji(grid_x_start + button_width + 18, row2_y,
-                  config->macros[layer][4].emoji_index);
+                  config->layers[layer].macros[4].emoji_index);
   oled_draw_string(grid_x_start + 2 * button_width, row2_y, "[6]");
   oled_draw_emoji(grid_x_start + 2 * button_width + 18, row2_y,
-                  config->macros[layer][5].emoji_index);
+                  config->layers[layer].macros[5].emoji_index);
 
   // rzad 3: [7]
   int center_x = (OLED_WIDTH - 26) / 2; // 26px dla [7] bez gap
   oled_draw_string(center_x, row3_y, "[7]");
-  oled_draw_emoji(center_x + 18, row3_y, config->macros[layer][6].emoji_index);
+  oled_draw_emoji(center_x + 18, row3_y,
+                  config->layers[layer].macros[6].emoji_index);
 
   oled_update();
 }
 
+// nazwy najczestszych usage Consumer Control
+static const char *media_key_name(uint16_t usage) {
+  switch (usage) {
+  case 0x00CD:
+    return "Play / Pause";
+  case 0x00B5:
+    return "Next Track";
+  case 0x00B6:
+    return "Previous Track";
+  case 0x00B7:
+    return "Stop";
+  case 0x00E2:
+    return "Mute";
+  case 0x00E9:
+    return "Volume Up";
+  case 0x00EA:
+    return "Volume Down";
+  case 0x006F:
+    return "Brightness Up";
+  case 0x0070:
+    return "Brightness Down";
+  default:
+    return "Media Key";
+  }
+}
+
 void oled_display_button_preview(uint8_t layer, uint8_t button) {
   oled_clear();
 
-  config_data_t *config = config_get();
-  macro_entry_t *macro = &config->macros[layer][button];
+  macro_entry_t *macro = config_get_macro(layer, button);
+  if (!macro)
+    return;
 
   // emoji + nazwa przycisku
   char title[32];
@@ -319,17 +358,24 @@ void oled_display_button_preview(uint8_t layer, uint8_t button) {
     snprintf(details, sizeof(details), "Layer Toggle to Layer %d",
              macro->value + 1);
     break;
-  case MACRO_TYPE_SCRIPT:
-    snprintf(details, sizeof(details), "Script (%s)",
-             macro->script_platform == 0   ? "Linux"
-             : macro->script_platform == 1 ? "Windows"
-                                           : "macOS");
+  case MACRO_TYPE_SCRIPT: {
+    uint8_t os = macro->script_platform & SCRIPT_PLATFORM_MASK;
+    snprintf(details, sizeof(details), "Script (%s%s)",
+             os == 0   ? "Linux"
+             : os == 1 ? "Windows"
+                       : "macOS",
+             (macro->script_platform & SCRIPT_DELIVERY_CDC) ? ", USB" : "");
     break;
-  case MACRO_TYPE_KEY_SEQUENCE:
+  }
+  case MACRO_TYPE_KEY_SEQUENCE: {
     // skrocona wersja
+    uint16_t len = 0;
+    const key_step_t *steps =
+        macro_arena_steps(layer, button, ARENA_SLOT_SEQUENCE, &len);
     snprintf(details, sizeof(details), "Sequence: %s",
-             format_sequence_short(macro->sequence, macro->sequence_length));
+             format_sequence_short(steps, len));
     break;
+  }
   case MACRO_TYPE_MOUSE_BUTTON:
     snprintf(details, sizeof(details), "Mouse Button: %s",
              macro->value == 1   ? "Left"
@@ -342,6 +388,23 @@ void oled_display_button_preview(uint8_t layer, uint8_t button) {
              macro->move_y);
     break;
 
+  case MACRO_TYPE_MOUSE_MOVE_ABS:
+    snprintf(details, sizeof(details), "Go To: %d%% %d%%",
+             macro->move_x * 100 / ABS_MOUSE_MAX,
+             macro->move_y * 100 / ABS_MOUSE_MAX);
+    break;
+
+  case MACRO_TYPE_MEDIA_KEY:
+    snprintf(details, sizeof(details), "%s", media_key_name(macro->value));
+    break;
+
+  case MACRO_TYPE_SYSTEM_KEY:
+    snprintf(details, sizeof(details), "%s",
+             macro->value == 1   ? "System Power Down"
+             : macro->value == 2 ? "System Sleep"
+                                 : "System Wake Up");
+    break;
+
   case MACRO_TYPE_MOUSE_WHEEL:
     snprintf(details, sizeof(details), "Mouse Wheel (x%d)", macro->value);
     break;
@@ -352,11 +415,31 @@ void oled_display_button_preview(uint8_t layer, uint8_t button) {
              (macro->move_x > 0) ? (uint8_t)macro->move_x : 127,
              (macro->move_y > 0) ? (uint8_t)macro->move_y : 1);
     break;
-  case MACRO_TYPE_MIDI_CC:
-    snprintf(details, sizeof(details), "CC: %d Val: %d Ch: %d",
-             (uint8_t)macro->value,
-             (macro->move_x > 0) ? (uint8_t)macro->move_x : 127,
-             (macro->move_y > 0) ? (uint8_t)macro->move_y : 1);
+  case MACRO_TYPE_MIDI_CC: {
+    uint8_t res = (macro->value >> MIDI_CC_RES_SHIFT) & 0x03;
+    const char *kind = (macro->value & MIDI_CC_RAMP) ? "Ramp" : "CC";
+    if (res == MIDI_CC_RES_NRPN)
+      snprintf(details, sizeof(details), "NRPN %s: %d Ch: %d", kind,
+               macro->repeat_count & 0x3FFF,
+               (macro->move_y > 0) ? (uint8_t)macro->move_y : 1);
+    else
+      snprintf(details, sizeof(details), "%s%s: %d Val: %d Ch: %d", kind,
+               res == MIDI_CC_RES_14BIT ? "14" : "",
+               macro->value & MIDI_CC_CONTROLLER_MASK,
+               (macro->move_x > 0) ? macro->move_x : 127,
+               (macro->move_y > 0) ? (uint8_t)macro->move_y : 1);
+    break;
+  }
+
+  case MACRO_TYPE_PROGRAM: {
+    uint16_t len = 0;
+    macro_arena_get(layer, button, ARENA_SLOT_PROGRAM, &len);
+    snprintf(details, sizeof(details), "Program (%u B)", len);
+    break;
+  }
+
+  case MACRO_TYPE_RECORD:
+    snprintf(details, sizeof(details), "Record -> Btn %d", macro->value);
     break;
 
   default:
@@ -388,7 +471,7 @@ void oled_draw_char(uint8_t x, uint8_t y, char c) {
       int byte_idx = (y / 8) * OLED_WIDTH + x + i;
       int bit_idx = y % 8 + j;
 
-      if (bit_idx < 8 && byte_idx < sizeof(oled_buffer)) {
+      if (bit_idx < 8 && byte_idx < (int)sizeof(oled_buffer)) {
         if (glyph[i] & (1 << j)) {
           oled_buffer[byte_idx] |= (1 << bit_idx);
         } else {
@@ -413,7 +496,7 @@ void oled_draw_line(uint8_t y) {
   for (int x = 0; x < OLED_WIDTH; x++) {
     int byte_idx = (y / 8) * OLED_WIDTH + x;
     int bit_idx = y % 8;
-    if (byte_idx < sizeof(oled_buffer)) {
+    if (byte_idx < (int)sizeof(oled_buffer)) {
       oled_buffer[byte_idx] |= (1 << bit_idx);
     }
   }
@@ -487,26 +570,30 @@ void oled_power_save_task(void) {
 
   if (time_since_activity > timeout_ms &&
       time_since_activity < (timeout_ms + SCREENSAVER_DURATION_MS)) {
+    power_idle_request_wakeup(g_last_activity_time + timeout_ms +
+                              SCREENSAVER_DURATION_MS);
 
     if (!g_oled_active)
       oled_set_power(true);
 
-    if (!timer_running) {
-      add_repeating_timer_ms(50, matrix_timer_callback, NULL, &matrix_timer);
-      timer_running = true;
+    if (!screensaver_running) {
+      screensaver_running = true;
+      next_frame_time = now;
 
       screensaver_start_new_session();
     }
 
-    if (matrix_tick_flag) {
+    // frame deadline instead of a repeating timer irq
+    if ((int32_t)(now - next_frame_time) >= 0) {
       screensaver_update(); // Zamiast oled_effect_matrix_rain()
-      matrix_tick_flag = false;
+
+      next_frame_time += SCREENSAVER_FRAME_MS;
+      if ((int32_t)(now - next_frame_time) >= 0)
+        next_frame_time = now + SCREENSAVER_FRAME_MS; // dropped frames
     }
+    power_idle_request_wakeup(next_frame_time);
   } else if (time_since_activity >= (timeout_ms + SCREENSAVER_DURATION_MS)) {
-    if (timer_running) {
-      cancel_repeating_timer(&matrix_timer);
-      timer_running = false;
-    }
+    screensaver_running = false;
 
     if (g_oled_active) {
       oled_clear();
@@ -514,16 +601,16 @@ void oled_power_save_task(void) {
       oled_set_power(false);
     }
   } else {
-    if (timer_running) {
-      cancel_repeating_timer(&matrix_timer);
-      timer_running = false;
-    }
+    screensaver_running = false;
 
     if (!g_oled_active) {
       oled_set_power(true);
       uint8_t current_layer = config_get_current_layer();
       oled_display_layer_info(current_layer);
     }
+
+    // next state change: screensaver start
+    power_idle_request_wakeup(g_last_activity_time + timeout_ms + 1);
   }
 }
 
@@ -541,10 +628,7 @@ void oled_wake_up(void) {
   g_last_activity_time = to_ms_since_boot(get_absolute_time());
   matrix_initialized = false;
 
-  if (timer_running) {
-    cancel_repeating_timer(&matrix_timer);
-    timer_running = false;
-  }
+  screensaver_running = false;
 
   if (!g_oled_active) {
     oled_set_power(true);
@@ -572,10 +656,54 @@ void oled_trigger_preview(uint8_t layer, uint8_t button) {
   oled_wake_up();
 }
 
+void oled_show_meter(uint8_t index, uint8_t value) {
+  if (index >= OLED_METER_COUNT)
+    return;
+  meter_values[index] = value > 127 ? 127 : value;
+  meter_dirty = true;
+}
+
+static void draw_meters(void) {
+  oled_clear();
+  oled_draw_string((OLED_WIDTH - 7 * 6) / 2, 0, "MIDI IN");
+  oled_draw_line(16);
+
+  // jeden pasek 6px na strone (8px), etykieta 1-4 po lewej
+  for (uint8_t i = 0; i < OLED_METER_COUNT; i++) {
+    int y = 24 + i * 8;
+    int width = meter_values[i] * (OLED_WIDTH - 12) / 127;
+    char label[2] = {(char)('1' + i), '\0'};
+    oled_draw_string(0, y, label);
+    for (int x = 0; x < width; x++) {
+      for (int j = 0; j < 6; j++)
+        oled_draw_pixel(10 + x, y + j, 1);
+    }
+  }
+
+  oled_update();
+}
+
 void oled_ui_task(void) {
   if (config_mode == 1)
     return;
 
+  if (meter_dirty) {
+    uint32_t now = to_ms_since_boot(get_absolute_time());
+
+    // a burst of CC messages ends up in one frame
+    if ((int32_t)(now - meter_next_frame) >= 0) {
+      meter_dirty = false;
+      meter_next_frame = now + OLED_METER_FRAME_MS;
+      draw_meters();
+
+      preview_end_time = now + PREVIEW_DURATION_MS;
+      is_preview_active = true;
+      oled_wake_up();
+    } else {
+      power_idle_request_wakeup(meter_next_frame);
+    }
+  }
+
   if (is_preview_active) {
     uint32_t now = to_ms_since_boot(get_absolute_time());
 
@@ -584,6 +712,8 @@ void oled_ui_task(void) {
 
       uint8_t current = config_get_current_layer();
       oled_display_layer_info(current);
+    } else {
+      power_idle_request_wakeup(preview_end_time + 1);
     }
   }
 }
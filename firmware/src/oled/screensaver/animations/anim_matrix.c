@@ -4,9 +4,6 @@
 #include "oled/screensaver/screensaver_utils.h"
 #include <stdlib.h>
 
-#define MATRIX_COL_WIDTH 6
-#define MATRIX_COLS (128 / MATRIX_COL_WIDTH)
-
 typedef struct {
   int16_t y;
   bool active;
@@ -6,10 +6,16 @@
 #include "oled/screensaver/animations/anim_invaders.h"
 #include "oled/screensaver/animations/anim_matrix.h"
 #include "oled/screensaver/animations/anim_starfield.h"
+#include "profiler/profiler.h"
 
 static ScreensaverType config_mode = SCREENSAVER_CYCLE;
 static ScreensaverType current_running_mode = SCREENSAVER_MATRIX;
 
+static const char *const anim_prof_names[SCREENSAVER_COUNT] = {
+    "anim_matrix", "anim_bouncing_logo", "anim_starfield", "anim_breakout",
+    "anim_invaders"};
+static int anim_prof_zone = -1;
+
 void screensaver_init(void) {
   config_mode = SCREENSAVER_CYCLE;
   current_running_mode = SCREENSAVER_MATRIX;
@@ -53,9 +59,12 @@ void screensaver_start_new_session(void) {
     }
   }
   reset_animation_state(current_running_mode);
+  anim_prof_zone = profiler_register(anim_prof_names[current_running_mode]);
 }
 
 void screensaver_update(void) {
+  PROF_BEGIN(stamp);
+
   switch (current_running_mode) {
   case SCREENSAVER_MATRIX:
     anim_matrix_update();
@@ -76,5 +85,7 @@ void screensaver_update(void) {
     break;
   }
 
+  PROF_END(anim_prof_zone, stamp);
+
   oled_update();
 }
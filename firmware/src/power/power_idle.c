@@ -0,0 +1,52 @@
+#include "power/power_idle.h"
+
+#include "hardware/structs/scb.h"
+#include "hardware/sync.h"
+#include "pico/stdlib.h"
+#include "tusb.h"
+
+static uint32_t next_wakeup_ms = 0;
+static bool wakeup_requested = false;
+static volatile bool event_pending = false;
+
+void power_idle_init(void) {
+  // pending interrupts generate a WFE wake-up event, so an IRQ that lands
+  // between the last check and __wfe() cannot be missed
+  scb_hw->scr |= M0PLUS_SCR_SEVONPEND_BITS;
+
+  wakeup_requested = false;
+  event_pending = false;
+}
+
+void power_idle_request_wakeup(uint32_t at_ms) {
+  if (!wakeup_requested || (int32_t)(at_ms - next_wakeup_ms) < 0) {
+    next_wakeup_ms = at_ms;
+    wakeup_requested = true;
+  }
+}
+
+void power_idle_notify_event(void) {
+  event_pending = true;
+  __sev();
+}
+
+void power_idle_wait(void) {
+  uint32_t now = to_ms_since_boot(get_absolute_time());
+  uint32_t deadline = now + POWER_IDLE_MAX_SLEEP_MS;
+
+  if (wakeup_requested && (int32_t)(next_wakeup_ms - deadline) < 0) {
+    deadline = next_wakeup_ms;
+  }
+  wakeup_requested = false;
+
+  // work already queued or deadline passed -> next loop pass right away
+  if (event_pending || tud_task_event_ready() ||
+      (int32_t)(deadline - now) <= 0) {
+    event_pending = false;
+    return;
+  }
+
+  // single WFE: returns on any interrupt/event or on the deadline alarm
+  best_effort_wfe_or_timeout(make_timeout_time_ms(deadline - now));
+  event_pending = false;
+}
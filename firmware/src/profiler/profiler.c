@@ -0,0 +1,178 @@
+#include "profiler/profiler.h"
+
+#include "cdc/cdc_transport.h"
+#include "hardware/clocks.h"
+#include "hardware/structs/systick.h"
+#include "pico/stdlib.h"
+#include "scheduler/scheduler.h"
+#include <string.h>
+
+#define SYSTICK_MASK 0x00FFFFFFu
+
+static prof_zone_t zones[PROF_MAX_ZONES];
+static uint8_t zone_count = 0;
+static uint32_t cycles_per_us = 125;
+static int stream_task_id = -1;
+
+static void profiler_stream_task(void);
+
+void profiler_init(void) {
+  cycles_per_us = clock_get_hz(clk_sys) / 1000000;
+
+  // free running 24 bit down counter at clk_sys, no interrupt
+  systick_hw->csr = 0;
+  systick_hw->rvr = SYSTICK_MASK;
+  systick_hw->cvr = 0;
+  systick_hw->csr = M0PLUS_SYST_CSR_CLKSOURCE_BITS | M0PLUS_SYST_CSR_ENABLE_BITS;
+
+  stream_task_id = sched_register("prof_stream", profiler_stream_task,
+                                  SCHED_PRIO_LOW, 100, 0);
+  sched_set_enabled(stream_task_id, false);
+}
+
+static void zone_clear(prof_zone_t *zone) {
+  const char *name = zone->name;
+  memset(zone, 0, sizeof(*zone));
+  zone->name = name;
+  zone->min_cycles = UINT32_MAX;
+}
+
+int profiler_register(const char *name) {
+  for (uint8_t i = 0; i < zone_count; i++) {
+    if (strcmp(zones[i].name, name) == 0)
+      return i;
+  }
+
+  if (zone_count >= PROF_MAX_ZONES)
+    return -1;
+
+  zones[zone_count].name = name;
+  zone_clear(&zones[zone_count]);
+  return zone_count++;
+}
+
+prof_stamp_t profiler_start(void) {
+  prof_stamp_t stamp;
+  stamp.us = time_us_32();
+  stamp.tick = systick_hw->cvr;
+  return stamp;
+}
+
+static uint8_t hist_bucket(uint32_t v) {
+  if (v < (1u << PROF_HIST_SUB_BITS))
+    return v;
+
+  uint32_t msb = 31 - __builtin_clz(v);
+  uint32_t mant = (v >> (msb - PROF_HIST_SUB_BITS)) &
+                  ((1u << PROF_HIST_SUB_BITS) - 1);
+  return ((msb - PROF_HIST_SUB_BITS + 1) << PROF_HIST_SUB_BITS) | mant;
+}
+
+static uint32_t hist_bucket_upper(uint8_t b) {
+  if (b < (1u << PROF_HIST_SUB_BITS))
+    return b;
+
+  uint32_t msb = (b >> PROF_HIST_SUB_BITS) + PROF_HIST_SUB_BITS - 1;
+  uint32_t mant = b & ((1u << PROF_HIST_SUB_BITS) - 1);
+  uint32_t shift = msb - PROF_HIST_SUB_BITS;
+  uint32_t lower = ((1u << PROF_HIST_SUB_BITS) | mant) << shift;
+  return lower + ((1u << shift) - 1);
+}
+
+void profiler_stop(int zone_id, prof_stamp_t start) {
+  uint32_t tick = systick_hw->cvr;
+  uint32_t us = time_us_32();
+
+  if (zone_id < 0 || zone_id >= zone_count)
+    return;
+
+  uint32_t elapsed_us = us - start.us;
+  uint32_t cycles;
+  if (elapsed_us < PROF_SYSTICK_MAX_US) {
+    cycles = (start.tick - tick) & SYSTICK_MASK; // counts down
+  } else {
+    uint64_t c = (uint64_t)elapsed_us * cycles_per_us;
+    cycles = c > UINT32_MAX ? UINT32_MAX : (uint32_t)c;
+  }
+
+  prof_zone_t *zone = &zones[zone_id];
+  zone->count++;
+  zone->total_cycles += cycles;
+  if (cycles < zone->min_cycles)
+    zone->min_cycles = cycles;
+  if (cycles > zone->max_cycles)
+    zone->max_cycles = cycles;
+
+  uint16_t *bucket = &zone->hist[hist_bucket(cycles)];
+  if (*bucket == UINT16_MAX) {
+    // saturated -> halve the whole histogram, keeps the distribution shape
+    for (int i = 0; i < PROF_HIST_BUCKETS; i++)
+      zone->hist[i] >>= 1;
+  }
+  (*bucket)++;
+}
+
+static uint32_t zone_p99(const prof_zone_t *zone) {
+  uint32_t total = 0;
+  for (int i = 0; i < PROF_HIST_BUCKETS; i++)
+    total += zone->hist[i];
+  if (total == 0)
+    return 0;
+
+  uint32_t target = total - total / 100; // ceil(0.99 * total) for small n
+  uint32_t cumulative = 0;
+  for (int i = 0; i < PROF_HIST_BUCKETS; i++) {
+    cumulative += zone->hist[i];
+    if (cumulative >= target) {
+      uint32_t upper = hist_bucket_upper(i);
+      return upper > zone->max_cycles ? zone->max_cycles : upper;
+    }
+  }
+  return zone->max_cycles;
+}
+
+static void send_zone(const prof_zone_t *zone) {
+  uint32_t avg = zone->count ? (uint32_t)(zone->total_cycles / zone->count) : 0;
+  uint32_t min = zone->count ? zone->min_cycles : 0;
+
+  cdc_send_response_fmt("PROF|%s|%lu|%lu|%lu|%lu|%lu", zone->name,
+                        (unsigned long)zone->count, (unsigned long)min,
+                        (unsigned long)avg, (unsigned long)zone->max_cycles,
+                        (unsigned long)zone_p99(zone));
+}
+
+void profiler_dump(void) {
+  cdc_send_response_fmt("PROF_START|%lu",
+                        (unsigned long)(cycles_per_us * 1000000));
+  for (uint8_t i = 0; i < zone_count; i++) {
+    send_zone(&zones[i]);
+    zones[i].streamed_count = zones[i].count;
+  }
+  cdc_send_response("PROF_END");
+}
+
+void profiler_reset(void) {
+  for (uint8_t i = 0; i < zone_count; i++)
+    zone_clear(&zones[i]);
+}
+
+void profiler_set_stream(uint32_t interval_ms) {
+  if (stream_task_id < 0)
+    return;
+
+  sched_set_enabled(stream_task_id, false);
+  if (interval_ms > 0) {
+    sched_set_period(stream_task_id, interval_ms);
+    sched_set_enabled(stream_task_id, true);
+  }
+}
+
+static void profiler_stream_task(void) {
+  // only zones with new samples, keeps the line count (and cost) low
+  for (uint8_t i = 0; i < zone_count; i++) {
+    if (zones[i].count != zones[i].streamed_count) {
+      send_zone(&zones[i]);
+      zones[i].streamed_count = zones[i].count;
+    }
+  }
+}
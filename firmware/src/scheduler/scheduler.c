@@ -0,0 +1,203 @@
+#include "scheduler/scheduler.h"
+
+#include "hardware/watchdog.h"
+#include "pico/stdlib.h"
+#include "power/power_idle.h"
+#include "profiler/profiler.h"
+#include <string.h>
+
+static sched_task_t tasks[SCHED_MAX_TASKS];
+static uint8_t task_count = 0;
+static bool in_critical = false;
+
+static uint32_t loop_passes = 0;
+static uint64_t loop_busy_us = 0;
+static uint64_t loop_idle_us = 0;
+static int loop_prof_zone = -1;
+
+void sched_init(void) {
+  memset(tasks, 0, sizeof(tasks));
+  task_count = 0;
+  in_critical = false;
+
+  loop_passes = 0;
+  loop_busy_us = 0;
+  loop_idle_us = 0;
+}
+
+int sched_register(const char *name, sched_task_fn_t fn,
+                   sched_priority_t priority, uint32_t period_ms,
+                   uint32_t deadline_us) {
+  if (task_count >= SCHED_MAX_TASKS || fn == NULL ||
+      priority >= SCHED_PRIO_COUNT)
+    return -1;
+
+  sched_task_t *task = &tasks[task_count];
+  memset(task, 0, sizeof(*task));
+  task->name = name;
+  task->fn = fn;
+  task->priority = priority;
+  task->period_ms = period_ms;
+  task->deadline_us = deadline_us;
+  task->next_run_ms = to_ms_since_boot(get_absolute_time()) + period_ms;
+  task->enabled = true;
+  task->prof_zone = profiler_register(name);
+
+  if (loop_prof_zone < 0)
+    loop_prof_zone = profiler_register("loop");
+
+  return task_count++;
+}
+
+void sched_set_enabled(int id, bool enabled) {
+  if (id < 0 || id >= task_count)
+    return;
+
+  sched_task_t *task = &tasks[id];
+  if (enabled && !task->enabled) {
+    task->next_run_ms = to_ms_since_boot(get_absolute_time());
+  }
+  task->enabled = enabled;
+}
+
+void sched_set_period(int id, uint32_t period_ms) {
+  if (id < 0 || id >= task_count)
+    return;
+
+  tasks[id].period_ms = period_ms;
+  tasks[id].next_run_ms = to_ms_since_boot(get_absolute_time()) + period_ms;
+}
+
+static void run_task(sched_task_t *task) {
+  uint32_t start = time_us_32();
+  PROF_BEGIN(stamp);
+  task->fn();
+  PROF_END(task->prof_zone, stamp);
+  uint32_t elapsed = time_us_32() - start;
+
+  task->runs++;
+  task->total_us += elapsed;
+  if (elapsed > task->max_us)
+    task->max_us = elapsed;
+  if (task->deadline_us > 0 && elapsed > task->deadline_us)
+    task->overruns++;
+}
+
+void sched_service_critical(void) {
+  if (in_critical)
+    return;
+  in_critical = true;
+
+  for (uint8_t i = 0; i < task_count; i++) {
+    if (tasks[i].enabled && tasks[i].priority == SCHED_PRIO_CRITICAL)
+      run_task(&tasks[i]);
+  }
+
+  in_critical = false;
+}
+
+void sched_delay_ms(uint32_t ms) {
+  absolute_time_t end = make_timeout_time_ms(ms);
+
+  do {
+    sched_service_critical();
+  } while (!time_reached(end));
+}
+
+static bool task_is_due(sched_task_t *task, uint32_t now) {
+  if (task->period_ms == 0)
+    return true;
+  return (int32_t)(now - task->next_run_ms) >= 0;
+}
+
+static void advance_period(sched_task_t *task, uint32_t now) {
+  task->next_run_ms += task->period_ms;
+
+  // missed whole periods (blocked by a long macro) -> resync, no burst
+  if ((int32_t)(now - task->next_run_ms) >= 0) {
+    task->late_runs++;
+    task->next_run_ms = now + task->period_ms;
+  }
+}
+
+void sched_run_once(void) {
+  uint32_t pass_start = time_us_32();
+  PROF_BEGIN(pass_stamp);
+  watchdog_update();
+
+  for (uint8_t prio = SCHED_PRIO_CRITICAL; prio < SCHED_PRIO_COUNT; prio++) {
+    for (uint8_t i = 0; i < task_count; i++) {
+      sched_task_t *task = &tasks[i];
+
+      if (!task->enabled || task->priority != prio)
+        continue;
+
+      uint32_t now = to_ms_since_boot(get_absolute_time());
+      if (!task_is_due(task, now))
+        continue;
+
+      run_task(task);
+
+      // USB gets a turn after every non critical task
+      if (prio != SCHED_PRIO_CRITICAL)
+        sched_service_critical();
+
+      if (task->period_ms > 0)
+        advance_period(task, now);
+    }
+  }
+
+  // periodic releases are deadlines for the idle sleep
+  for (uint8_t i = 0; i < task_count; i++) {
+    if (tasks[i].enabled && tasks[i].period_ms > 0)
+      power_idle_request_wakeup(tasks[i].next_run_ms);
+  }
+
+  PROF_END(loop_prof_zone, pass_stamp);
+
+  uint32_t idle_start = time_us_32();
+  power_idle_wait();
+  uint32_t idle_end = time_us_32();
+
+  loop_passes++;
+  loop_busy_us += idle_start - pass_start;
+  loop_idle_us += idle_end - idle_start;
+}
+
+void sched_run(void) {
+  while (1) {
+    sched_run_once();
+  }
+}
+
+uint8_t sched_task_count(void) { return task_count; }
+
+const sched_task_t *sched_get_task(uint8_t id) {
+  if (id >= task_count)
+    return NULL;
+  return &tasks[id];
+}
+
+void sched_get_loop_stats(uint32_t *passes, uint64_t *busy_us,
+                          uint64_t *idle_us) {
+  if (passes)
+    *passes = loop_passes;
+  if (busy_us)
+    *busy_us = loop_busy_us;
+  if (idle_us)
+    *idle_us = loop_idle_us;
+}
+
+void sched_reset_stats(void) {
+  for (uint8_t i = 0; i < task_count; i++) {
+    tasks[i].runs = 0;
+    tasks[i].total_us = 0;
+    tasks[i].max_us = 0;
+    tasks[i].overruns = 0;
+    tasks[i].late_runs = 0;
+  }
+
+  loop_passes = 0;
+  loop_busy_us = 0;
+  loop_idle_us = 0;
+}
@@ -0,0 +1,140 @@
+#include "script_codec.h"
+
+#include <string.h>
+
+static uint16_t read_u16(const uint8_t *p) {
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+bool script_is_packed(const char *stored) {
+  return (uint8_t)stored[0] == SCRIPT_PACKED_MAGIC;
+}
+
+uint16_t script_text_len(const char *stored) {
+  if (script_is_packed(stored))
+    return read_u16((const uint8_t *)stored + 1);
+  return (uint16_t)strlen(stored);
+}
+
+bool script_check(const char *stored, size_t size) {
+  if (!script_is_packed(stored))
+    return true;
+  if (size < SCRIPT_PACKED_HEADER)
+    return false;
+
+  const uint8_t *p = (const uint8_t *)stored;
+  uint16_t text_len = read_u16(p + 1);
+  uint16_t src_len = read_u16(p + 3);
+  if (text_len == 0 || text_len > MAX_SCRIPT_TEXT ||
+      src_len != size - SCRIPT_PACKED_HEADER)
+    return false;
+
+  // a dry run: counts only, no window needed
+  const uint8_t *src = p + SCRIPT_PACKED_HEADER;
+  uint16_t pos = 0;
+  uint32_t produced = 0;
+  while (produced < text_len) {
+    if (pos >= src_len)
+      return false;
+    uint8_t flags = src[pos++];
+
+    for (int bit = 0; bit < 8 && produced < text_len; bit++) {
+      if (flags & (1 << bit)) {
+        if (pos >= src_len)
+          return false;
+        pos++;
+        produced++;
+        continue;
+      }
+
+      if (pos + 2 > src_len)
+        return false;
+      uint16_t dist = (uint16_t)((src[pos] | (src[pos + 1] >> 6 << 8)) + 1);
+      uint8_t len = (uint8_t)((src[pos + 1] & 0x3F) + SCRIPT_LZ_MIN_MATCH);
+      pos += 2;
+      if (dist > produced || produced + len > text_len)
+        return false;
+      produced += len;
+    }
+  }
+  return pos == src_len;
+}
+
+void script_reader_open(script_reader_t *r, const char *stored) {
+  r->packed = script_is_packed(stored);
+  r->src_pos = 0;
+  r->flag_bits = 0;
+  r->copy_len = 0;
+  r->head = 0;
+
+  if (r->packed) {
+    const uint8_t *p = (const uint8_t *)stored;
+    r->left = read_u16(p + 1);
+    r->src_len = read_u16(p + 3);
+    r->src = p + SCRIPT_PACKED_HEADER;
+  } else {
+    r->left = (uint16_t)strlen(stored);
+    r->src_len = r->left;
+    r->src = (const uint8_t *)stored;
+  }
+}
+
+static void emit(script_reader_t *r, char *out, size_t *n, uint8_t c) {
+  r->window[r->head] = c;
+  r->head = (r->head + 1) % SCRIPT_LZ_WINDOW;
+  out[(*n)++] = (char)c;
+  r->left--;
+}
+
+size_t script_reader_read(script_reader_t *r, char *out, size_t cap) {
+  size_t n = 0;
+
+  if (!r->packed) {
+    n = r->left < cap ? r->left : cap;
+    memcpy(out, r->src + r->src_pos, n);
+    r->src_pos += n;
+    r->left -= n;
+    return n;
+  }
+
+  while (n < cap && r->left > 0) {
+    // match in progress (may span several reads)
+    if (r->copy_len > 0) {
+      uint16_t from = (r->head + SCRIPT_LZ_WINDOW - r->copy_dist) %
+                      SCRIPT_LZ_WINDOW;
+      emit(r, out, &n, r->window[from]);
+      r->copy_len--;
+      continue;
+    }
+
+    if (r->flag_bits == 0) {
+      if (r->src_pos >= r->src_len)
+        break;
+      r->flags = r->src[r->src_pos++];
+      r->flag_bits = 8;
+    }
+
+    bool literal = r->flags & 1;
+    r->flags >>= 1;
+    r->flag_bits--;
+
+    if (literal) {
+      if (r->src_pos >= r->src_len)
+        break;
+      emit(r, out, &n, r->src[r->src_pos++]);
+    } else {
+      if (r->src_pos + 2 > r->src_len)
+        break;
+      uint8_t lo = r->src[r->src_pos];
+      uint8_t hi = r->src[r->src_pos + 1];
+      r->src_pos += 2;
+      r->copy_dist = (uint16_t)((lo | (hi >> 6 << 8)) + 1);
+      r->copy_len = (uint8_t)((hi & 0x3F) + SCRIPT_LZ_MIN_MATCH);
+    }
+  }
+
+  // a truncated stream ends the text early
+  if (n == 0)
+    r->left = 0;
+  return n;
+}
@@ -1,3 +1,4 @@
+#include "executor/actions/exec_hid_core.h"
 #include "pico/unique_id.h"
 #include "pin_definitions.h"
 #include "tusb.h"
@@ -51,7 +52,10 @@ uint8_t const *tud_descriptor_device_cb(void) {
 //--------------------------------------------------------------------+
 uint8_t const desc_hid_report[] = {
     TUD_HID_REPORT_DESC_KEYBOARD(HID_REPORT_ID(1)),
-    TUD_HID_REPORT_DESC_MOUSE(HID_REPORT_ID(2))};
+    TUD_HID_REPORT_DESC_MOUSE(HID_REPORT_ID(2)),
+    TUD_HID_REPORT_DESC_ABSMOUSE(HID_REPORT_ID(3)),
+    TUD_HID_REPORT_DESC_CONSUMER(HID_REPORT_ID(4)),
+    TUD_HID_REPORT_DESC_SYSTEM_CONTROL(HID_REPORT_ID(5))};
 
 uint8_t const *tud_hid_descriptor_report_cb(uint8_t instance) {
   (void)instance;
@@ -94,7 +98,7 @@ uint8_t const desc_configuration[] = {
     // interface number, string index, protocol, report descriptor len, EP
     TUD_HID_DESCRIPTOR(ITF_NUM_HID, 5, HID_ITF_PROTOCOL_NONE,
                        sizeof(desc_hid_report), EPNUM_HID,
-                       CFG_TUD_HID_EP_BUFSIZE, 10),
+                       CFG_TUD_HID_EP_BUFSIZE, HID_POLL_INTERVAL_MS),
 
     // MIDI IAD
     TUD_ASSOCIATION_DESCRIPTOR(ITF_NUM_MIDI, 2, 0x01, 0x01, 0x00, 0),
@@ -179,8 +183,8 @@ void tud_hid_set_report_cb(uint8_t instance, uint8_t report_id,
                            hid_report_type_t report_type, uint8_t const *buffer,
                            uint16_t bufsize) {
   (void)instance;
-  (void)report_id;
-  (void)report_type;
-  (void)buffer;
-  (void)bufsize;
+
+  // keyboard LEDs (Num/Caps Lock), a ready signal for exec_script
+  if (report_id == 1 && report_type == HID_REPORT_TYPE_OUTPUT && bufsize >= 1)
+    hid_host_leds_set(buffer[0]);
 }
@@ -0,0 +1,82 @@
+/*
+ * media key tests - Consumer Control and System Control reports
+ * (real firmware sources)
+ */
+
+#include "unity/unity.h"
+
+#include "executor/actions/exec_media.h"
+#include "executor/macro_executor.h"
+#include "macro_config.h"
+#include "sim/sim.h"
+#include <stdint.h>
+#include <stdio.h>
+
+#define USAGE_VOLUME_UP 0x00E9
+#define USAGE_PLAY_PAUSE 0x00CD
+
+static uint16_t usage_of(const sim_hid_report_t *r) {
+  return (uint16_t)(r->data[0] | (r->data[1] << 8));
+}
+
+void test_sim_media_key_single_reports(void) {
+  sim_boot();
+  macro_entry_t *macro = &config_get()->layers[0].macros[0];
+  macro->type = MACRO_TYPE_MEDIA_KEY;
+  macro->value = USAGE_VOLUME_UP;
+  macro->repeat_count = 3;
+  macro->repeat_interval = 0;
+
+  execute_macro(0, 0);
+
+  // press + release per tap on report ID 4, nothing typed
+  int presses = 0, releases = 0;
+  for (size_t i = 0; i < sim_hid_report_count(); i++) {
+    const sim_hid_report_t *r = sim_hid_report(i);
+    if (r->report_id == 1)
+      TEST_ASSERT_EQUAL(0, r->data[2]);
+    if (r->report_id != 4)
+      continue;
+    TEST_ASSERT_EQUAL(2, r->len);
+    if (usage_of(r) == USAGE_VOLUME_UP)
+      presses++;
+    else if (usage_of(r) == 0)
+      releases++;
+  }
+  TEST_ASSERT_EQUAL(3, presses);
+  TEST_ASSERT_EQUAL(3, releases);
+  TEST_ASSERT_EQUAL(0, sim_hid_dropped_reports());
+
+  // a tap takes two polls
+  sim_clear_records();
+  uint64_t start = sim_time_us();
+  exec_consumer_key(USAGE_PLAY_PAUSE, 1, 0);
+  TEST_ASSERT_EQUAL(2, (int)sim_hid_report_count());
+  TEST_ASSERT_TRUE(sim_time_us() - start <= 2 * SIM_HID_INTERVAL_US);
+}
+
+void test_sim_system_key(void) {
+  sim_boot();
+  macro_entry_t *macro = &config_get()->layers[0].macros[0];
+  macro->type = MACRO_TYPE_SYSTEM_KEY;
+  macro->value = SYSTEM_KEY_SLEEP;
+
+  execute_macro(0, 0);
+
+  TEST_ASSERT_EQUAL(5, sim_hid_report(0)->report_id);
+  TEST_ASSERT_EQUAL(SYSTEM_KEY_SLEEP, sim_hid_report(0)->data[0]);
+  TEST_ASSERT_EQUAL(5, sim_hid_report(1)->report_id);
+  TEST_ASSERT_EQUAL(0, sim_hid_report(1)->data[0]);
+
+  // unknown codes send nothing
+  sim_clear_records();
+  exec_system_key(9);
+  TEST_ASSERT_EQUAL(0, (int)sim_hid_report_count());
+}
+
+void run_exec_media_tests(void) {
+  printf("\n=== Media Key Tests ===\n");
+
+  RUN_TEST(test_sim_media_key_single_reports);
+  RUN_TEST(test_sim_system_key);
+}
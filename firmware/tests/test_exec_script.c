@@ -0,0 +1,194 @@
+/*
+ * Script macro tests - terminal ready handshake (CDC sentinel, keyboard LED
+ * fallback, probe retries), typed heredoc delivery, the CDC pull bootstrap
+ * that reads the script body from the serial port and the fallback to typing
+ * when no request comes (real firmware sources)
+ */
+
+#include "unity/unity.h"
+
+#include "executor/actions/exec_script.h"
+#include "executor/macro_executor.h"
+#include "macro_arena.h"
+#include "macro_config.h"
+#include "sim/sim.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+static char long_script[1024];
+
+static void set_script(const char *script, uint8_t platform) {
+  macro_entry_t *macro = &config_get()->layers[0].macros[0];
+  memset(macro, 0, sizeof(*macro));
+  macro->type = MACRO_TYPE_SCRIPT;
+  macro->script_platform = platform;
+  macro_arena_set(0, 0, ARENA_SLOT_SCRIPT, (const uint8_t *)script,
+                  (uint16_t)(strlen(script) + 1));
+}
+
+// the shell answers the first ready probe
+static void shell_ready(void) { sim_cdc_input(SCRIPT_READY_SENTINEL "\n"); }
+
+static void make_long_script(void) {
+  memset(long_script, 0, sizeof(long_script));
+  while (strlen(long_script) + 24 < sizeof(long_script))
+    strcat(long_script, "echo talos >> /tmp/log\n");
+}
+
+// keyboard reports with a key down
+static int key_downs(void) {
+  int n = 0;
+  for (size_t i = 0; i < sim_hid_report_count(); i++) {
+    const sim_hid_report_t *r = sim_hid_report(i);
+    if (r->report_id == 1 && r->data[2] != 0)
+      n++;
+  }
+  return n;
+}
+
+static int ctrl_c_count(void) {
+  int n = 0;
+  for (size_t i = 0; i < sim_hid_report_count(); i++) {
+    const sim_hid_report_t *r = sim_hid_report(i);
+    if (r->report_id == 1 && r->data[0] == 0x01 && r->data[2] == 6)
+      n++;
+  }
+  return n;
+}
+
+static bool ctrl_c_sent(void) { return ctrl_c_count() > 0; }
+
+// duration of a Linux script macro, the shell answers at ready_ms
+static uint64_t run_with_sentinel_at(uint32_t ready_ms) {
+  sim_boot();
+  set_script("ls\n", 0);
+  uint64_t start = sim_time_us();
+  sim_script_cdc_input(start + ready_ms * 1000ULL,
+                       SCRIPT_READY_SENTINEL "\n");
+  execute_macro(0, 0);
+  return sim_time_us() - start;
+}
+
+void test_sim_script_ready_sentinel_starts_typing(void) {
+  uint64_t early = run_with_sentinel_at(600);
+  TEST_ASSERT_FALSE(ctrl_c_sent());
+  uint64_t late = run_with_sentinel_at(1100);
+  TEST_ASSERT_FALSE(ctrl_c_sent());
+
+  // typing follows the answer, not a fixed wait
+  TEST_ASSERT_GREATER_THAN(480000, late - early);
+  TEST_ASSERT_LESS_THAN(520000, late - early);
+}
+
+void test_sim_script_ready_led_fallback(void) {
+  uint64_t by_sentinel = run_with_sentinel_at(600);
+
+  // port not accessible: the probe toggles Num Lock twice instead
+  sim_boot();
+  set_script("ls\n", 0);
+  uint64_t start = sim_time_us();
+  sim_script_hid_leds(start + 600000, 0x01);
+  sim_script_hid_leds(start + 610000, 0x00);
+  execute_macro(0, 0);
+  uint64_t by_leds = sim_time_us() - start;
+
+  TEST_ASSERT_FALSE(ctrl_c_sent());
+  TEST_ASSERT_LESS_THAN(by_sentinel + 5000, by_leds);
+  TEST_ASSERT_GREATER_THAN(by_sentinel - 5000, by_leds);
+}
+
+void test_sim_script_ready_probe_retried(void) {
+  // the first probe went nowhere, the second one is answered
+  run_with_sentinel_at(SCRIPT_READY_SETTLE_MS + SCRIPT_READY_PROBE_MS + 700);
+  TEST_ASSERT_EQUAL(1, ctrl_c_count());
+
+  // a late answer of an extra probe is not an unknown command
+  sim_cdc_clear_output();
+  shell_ready();
+  sim_run_for_ms(20);
+  TEST_ASSERT_NULL(strstr(sim_cdc_output(), "ERROR"));
+
+  // nobody answers: typed anyway after the timeout
+  sim_boot();
+  set_script("ls\n", 0);
+  uint64_t start = sim_time_us();
+  execute_macro(0, 0);
+  TEST_ASSERT_GREATER_THAN(SCRIPT_READY_TIMEOUT_MS * 1000ULL,
+                           sim_time_us() - start);
+  TEST_ASSERT_GREATER_THAN(1, ctrl_c_count());
+}
+
+void test_sim_script_cdc_pull_types_only_bootstrap(void) {
+  make_long_script();
+
+  sim_boot();
+  set_script(long_script, 0);
+  shell_ready();
+  uint64_t start = sim_time_us();
+  execute_macro(0, 0);
+  uint64_t typed_us = sim_time_us() - start;
+  int typed_keys = key_downs();
+
+  // the bootstrap asks for the body as soon as it runs
+  sim_boot();
+  set_script(long_script, 0 | SCRIPT_DELIVERY_CDC);
+  sim_cdc_input(SCRIPT_READY_SENTINEL "\n" SCRIPT_PULL_REQUEST "\n");
+  start = sim_time_us();
+  execute_macro(0, 0);
+  uint64_t pulled_us = sim_time_us() - start;
+
+  TEST_ASSERT_LESS_THAN(typed_keys / 3, key_downs());
+  TEST_ASSERT_LESS_THAN(typed_us / 2, pulled_us);
+  TEST_ASSERT_FALSE(ctrl_c_sent());
+
+  // body, then the end marker on a line of its own
+  const char *out = strstr(sim_cdc_output(), long_script);
+  TEST_ASSERT_NOT_NULL(out);
+  TEST_ASSERT_EQUAL_STRING(SCRIPT_PULL_END "\n", out + strlen(long_script));
+}
+
+void test_sim_script_cdc_pull_ignores_other_lines(void) {
+  sim_boot();
+
+  // no trailing newline in the script, Windows bootstrap
+  set_script("Write-Host talos", 1 | SCRIPT_DELIVERY_CDC);
+  shell_ready();
+  sim_cdc_input("GET_SCRIPTS\nGET_CONF\n" SCRIPT_PULL_REQUEST "\r\n");
+  execute_macro(0, 0);
+
+  TEST_ASSERT_EQUAL_STRING("Write-Host talos\n" SCRIPT_PULL_END "\n",
+                           sim_cdc_output());
+  TEST_ASSERT_FALSE(ctrl_c_sent());
+}
+
+void test_sim_script_cdc_pull_falls_back_to_typing(void) {
+  sim_boot();
+  set_script("ls -la\n", 2 | SCRIPT_DELIVERY_CDC);
+  shell_ready();
+  uint64_t start = sim_time_us();
+  execute_macro(0, 0);
+
+  // waited for the request, stopped the bootstrap and typed the heredoc
+  TEST_ASSERT_GREATER_THAN(SCRIPT_PULL_TIMEOUT_MS * 1000ULL,
+                           sim_time_us() - start);
+  TEST_ASSERT_TRUE(ctrl_c_sent());
+  TEST_ASSERT_NULL(strstr(sim_cdc_output(), SCRIPT_PULL_END));
+  int with_fallback = key_downs();
+
+  sim_boot();
+  set_script("ls -la\n", 2);
+  shell_ready();
+  execute_macro(0, 0);
+  TEST_ASSERT_GREATER_THAN(key_downs(), with_fallback);
+}
+
+void run_exec_script_tests(void) {
+  printf("\n=== Script Delivery Tests ===\n");
+  RUN_TEST(test_sim_script_ready_sentinel_starts_typing);
+  RUN_TEST(test_sim_script_ready_led_fallback);
+  RUN_TEST(test_sim_script_ready_probe_retried);
+  RUN_TEST(test_sim_script_cdc_pull_types_only_bootstrap);
+  RUN_TEST(test_sim_script_cdc_pull_ignores_other_lines);
+  RUN_TEST(test_sim_script_cdc_pull_falls_back_to_typing);
+}
@@ -0,0 +1,106 @@
+/*
+ * key sequence engine tests - minimal report sequences, merged chords,
+ * anti-Spotlight Ctrl tap, SET_SEQ_TIMING profiles (real firmware sources)
+ */
+
+#include "unity/unity.h"
+
+#include "executor/actions/exec_hid_core.h"
+#include "macro_config.h"
+#include "sim/sim.h"
+#include <string.h>
+
+#define KEY_C 0x06
+#define KEY_V 0x19
+#define KEY_T 0x17
+
+extern volatile uint8_t g_detected_platform;
+
+static void expect_report(size_t i, uint8_t mods, uint8_t key) {
+  TEST_ASSERT_TRUE(i < sim_hid_report_count());
+  const sim_hid_report_t *r = sim_hid_report(i);
+  TEST_ASSERT_EQUAL(1, r->report_id);
+  TEST_ASSERT_EQUAL(mods, r->data[0]);
+  TEST_ASSERT_EQUAL(key, r->data[2]);
+}
+
+void test_sim_sequence_merges_shared_modifiers(void) {
+  sim_boot();
+  g_detected_platform = 0; // Linux profile
+  const key_step_t steps[] = {{KEY_C, MODIFIER_LEFT_CTRL, 0},
+                              {KEY_V, MODIFIER_LEFT_CTRL, 0}};
+
+  exec_key_sequence(steps, 2);
+
+  // Ctrl goes down once and up once around both keys
+  TEST_ASSERT_EQUAL(6, (int)sim_hid_report_count());
+  expect_report(0, MODIFIER_LEFT_CTRL, 0);
+  expect_report(1, MODIFIER_LEFT_CTRL, KEY_C);
+  expect_report(2, MODIFIER_LEFT_CTRL, 0);
+  expect_report(3, MODIFIER_LEFT_CTRL, KEY_V);
+  expect_report(4, MODIFIER_LEFT_CTRL, 0);
+  expect_report(5, 0, 0);
+  TEST_ASSERT_EQUAL(0, sim_hid_dropped_reports());
+}
+
+void test_sim_sequence_ctrl_tap_only_for_lone_gui(void) {
+  sim_boot();
+  g_detected_platform = 0;
+
+  // Meta alone -> Ctrl tap before the release
+  const key_step_t lone[] = {{0, MODIFIER_LEFT_GUI, 0}};
+  exec_key_sequence(lone, 1);
+  TEST_ASSERT_EQUAL(3, (int)sim_hid_report_count());
+  expect_report(1, MODIFIER_LEFT_GUI | MODIFIER_LEFT_CTRL, 0);
+
+  // Meta held, then Meta+T -> a real chord, no Ctrl
+  sim_clear_records();
+  const key_step_t chord[] = {{0, MODIFIER_LEFT_GUI, 0},
+                              {KEY_T, MODIFIER_LEFT_GUI, 0}};
+  exec_key_sequence(chord, 2);
+  TEST_ASSERT_EQUAL(4, (int)sim_hid_report_count());
+  for (size_t i = 0; i < sim_hid_report_count(); i++)
+    TEST_ASSERT_FALSE(sim_hid_report(i)->data[0] & MODIFIER_LEFT_CTRL);
+}
+
+void test_sim_sequence_timing_profile(void) {
+  sim_boot();
+  g_detected_platform = 0;
+  const key_step_t steps[] = {
+      {KEY_C, MODIFIER_LEFT_CTRL, 0}, {KEY_V, 0, 0}, {KEY_T, 0, 0},
+      {KEY_C, 0, 0},                  {KEY_V, 0, 0},
+  };
+
+  // default profile: well under the old 130 ms per step
+  uint64_t start = sim_time_us();
+  exec_key_sequence(steps, 5);
+  uint64_t normal = sim_time_us() - start;
+  TEST_ASSERT_TRUE(normal < 5 * 130000);
+
+  // a fast host runs at USB pace only
+  sim_cdc_input("SET_SEQ_TIMING|0|0|0|0\n");
+  sim_run_for_ms(20);
+  TEST_ASSERT_NOT_NULL(strstr(sim_cdc_output(), "OK"));
+
+  sim_clear_records();
+  start = sim_time_us();
+  exec_key_sequence(steps, 5);
+  uint64_t fast = sim_time_us() - start;
+  TEST_ASSERT_TRUE(fast < normal);
+  TEST_ASSERT_TRUE(fast <= (sim_hid_report_count() + 1) * SIM_HID_INTERVAL_US);
+  TEST_ASSERT_EQUAL(0, sim_hid_dropped_reports());
+
+  sim_cdc_clear_output();
+  sim_cdc_input("GET_CONF\n");
+  sim_run_for_ms(50);
+  TEST_ASSERT_NOT_NULL(strstr(sim_cdc_output(), "SEQ_TIMING|0|0|0|0"));
+  TEST_ASSERT_NOT_NULL(strstr(sim_cdc_output(), "SEQ_TIMING|2|20|10|10"));
+}
+
+void run_key_sequence_tests(void) {
+  printf("\n=== Key Sequence Tests ===\n");
+
+  RUN_TEST(test_sim_sequence_merges_shared_modifiers);
+  RUN_TEST(test_sim_sequence_ctrl_tap_only_for_lone_gui);
+  RUN_TEST(test_sim_sequence_timing_profile);
+}
@@ -0,0 +1,169 @@
+/*
+ * keyboard layout tests - ASCII/extra tables, per macro override,
+ * SET_KB_LAYOUT (real firmware sources in the simulator)
+ */
+
+#include "unity/unity.h"
+
+#include "executor/macro_executor.h"
+#include "hid/keyboard_layout.h"
+#include "macro_config.h"
+#include "sim/sim.h"
+#include <string.h>
+
+#define SHIFT MODIFIER_LEFT_SHIFT
+#define ALTGR MODIFIER_RIGHT_ALT
+
+static void assert_key(uint8_t layout, uint32_t cp, uint8_t keycode,
+                       uint8_t modifiers) {
+  uint8_t kc = 0, mods = 0;
+  TEST_ASSERT_TRUE(kb_layout_map(layout, cp, &kc, &mods));
+  TEST_ASSERT_EQUAL(keycode, kc);
+  TEST_ASSERT_EQUAL(modifiers, mods);
+}
+
+static void run_text_macro(const char *text, uint16_t value) {
+  macro_entry_t *macro = &config_get()->layers[0].macros[0];
+  memset(macro, 0, sizeof(*macro));
+  macro->type = MACRO_TYPE_TEXT_STRING;
+  macro->value = value;
+  strcpy(macro->macro_string, text);
+
+  sim_clear_records();
+  execute_macro(0, 0);
+}
+
+// ==================== TABLES ====================
+
+void test_layout_us_matches_legacy_mapping(void) {
+  assert_key(KB_LAYOUT_US, 'a', 0x04, 0);
+  assert_key(KB_LAYOUT_US, 'Z', 0x1D, SHIFT);
+  assert_key(KB_LAYOUT_US, '1', 30, 0);
+  assert_key(KB_LAYOUT_US, '0', 39, 0);
+  assert_key(KB_LAYOUT_US, ' ', 44, 0);
+  assert_key(KB_LAYOUT_US, '\n', 40, 0);
+  assert_key(KB_LAYOUT_US, '@', 31, SHIFT);
+  assert_key(KB_LAYOUT_US, '?', 56, SHIFT);
+  assert_key(KB_LAYOUT_US, '\\', 49, 0);
+
+  uint8_t kc, mods;
+  TEST_ASSERT_FALSE(kb_layout_map(KB_LAYOUT_US, 0x7F, &kc, &mods));
+  TEST_ASSERT_FALSE(kb_layout_map(KB_LAYOUT_US, 0x0105, &kc, &mods)); // ą
+}
+
+void test_layout_every_printable_ascii_on_us_and_dvorak(void) {
+  uint8_t kc, mods;
+  for (uint32_t c = 0x20; c < 0x7F; c++) {
+    TEST_ASSERT_TRUE(kb_layout_map(KB_LAYOUT_US, c, &kc, &mods));
+    TEST_ASSERT_TRUE(kb_layout_map(KB_LAYOUT_DVORAK, c, &kc, &mods));
+  }
+}
+
+void test_layout_de_qwertz(void) {
+  assert_key(KB_LAYOUT_DE, 'z', 0x1C, 0); // on the US 'y' key
+  assert_key(KB_LAYOUT_DE, 'Y', 0x1D, SHIFT);
+  assert_key(KB_LAYOUT_DE, '-', 0x38, 0);
+  assert_key(KB_LAYOUT_DE, '@', 0x14, ALTGR);
+  assert_key(KB_LAYOUT_DE, 0x00DF, 0x2D, 0); // ß
+
+  // ^ is a dead key -> not in the table (typed as unicode)
+  uint8_t kc, mods;
+  TEST_ASSERT_FALSE(kb_layout_map(KB_LAYOUT_DE, '^', &kc, &mods));
+}
+
+void test_layout_fr_azerty(void) {
+  assert_key(KB_LAYOUT_FR, 'a', 0x14, 0);
+  assert_key(KB_LAYOUT_FR, 'm', 0x33, 0);
+  assert_key(KB_LAYOUT_FR, '1', 0x1E, SHIFT); // digits need shift
+  assert_key(KB_LAYOUT_FR, 0x00E9, 0x1F, 0);  // é
+}
+
+void test_layout_pl_extras(void) {
+  assert_key(KB_LAYOUT_PL, 'q', 0x14, 0);
+  assert_key(KB_LAYOUT_PL, 0x0105, 0x04, ALTGR);         // ą
+  assert_key(KB_LAYOUT_PL, 0x017B, 0x1D, ALTGR | SHIFT); // Ż
+  assert_key(KB_LAYOUT_PL, 0x017A, 0x1B, ALTGR);         // ź
+}
+
+void test_layout_parse_and_macro_value(void) {
+  TEST_ASSERT_EQUAL(KB_LAYOUT_DE, kb_layout_parse("de"));
+  TEST_ASSERT_EQUAL(KB_LAYOUT_DVORAK, kb_layout_parse("DVORAK"));
+  TEST_ASSERT_EQUAL(KB_LAYOUT_FR, kb_layout_parse("3"));
+  TEST_ASSERT_EQUAL(-1, kb_layout_parse("9"));
+  TEST_ASSERT_EQUAL(-1, kb_layout_parse("XX"));
+
+  TEST_ASSERT_EQUAL(KB_LAYOUT_DEVICE, kb_layout_from_macro_value(0));
+  TEST_ASSERT_EQUAL(KB_LAYOUT_DEVICE, kb_layout_from_macro_value(0x04));
+  TEST_ASSERT_EQUAL(KB_LAYOUT_PL,
+                    kb_layout_from_macro_value(KB_LAYOUT_MACRO_FLAG | 2));
+}
+
+// ==================== TYPING ====================
+
+void test_sim_text_pl_types_without_unicode_input(void) {
+  sim_boot();
+  config_get()->kb_layout = KB_LAYOUT_PL;
+
+  run_text_macro("ąŻ", 0);
+
+  // one key press per character, no Ctrl+Shift+U unicode entry
+  int presses = 0;
+  for (size_t i = 0; i < sim_hid_report_count(); i++) {
+    if (sim_hid_report(i)->data[2] != 0)
+      presses++;
+    TEST_ASSERT_NOT_EQUAL(0x03, sim_hid_report(i)->data[0]);
+  }
+  TEST_ASSERT_EQUAL(2, presses);
+  TEST_ASSERT_EQUAL(ALTGR, sim_hid_report(0)->data[0]);
+  TEST_ASSERT_EQUAL(0x04, sim_hid_report(0)->data[2]);
+  TEST_ASSERT_EQUAL(ALTGR | SHIFT, sim_hid_report(2)->data[0]);
+  TEST_ASSERT_EQUAL(0x1D, sim_hid_report(2)->data[2]);
+}
+
+void test_sim_text_macro_layout_override(void) {
+  sim_boot();
+  TEST_ASSERT_EQUAL(KB_LAYOUT_US, config_get()->kb_layout);
+
+  run_text_macro("z", KB_LAYOUT_MACRO_FLAG | KB_LAYOUT_DE);
+  TEST_ASSERT_EQUAL(0x1C, sim_hid_report(0)->data[2]);
+
+  // override ends with the macro
+  TEST_ASSERT_EQUAL(KB_LAYOUT_US, kb_layout_active());
+  run_text_macro("z", 0);
+  TEST_ASSERT_EQUAL(0x1D, sim_hid_report(0)->data[2]);
+}
+
+// ==================== CDC ====================
+
+void test_sim_cdc_set_kb_layout(void) {
+  sim_boot();
+
+  sim_cdc_input("SET_KB_LAYOUT|FR\n");
+  sim_run_for_ms(20);
+  TEST_ASSERT_NOT_NULL(strstr(sim_cdc_output(), "OK"));
+  TEST_ASSERT_EQUAL(KB_LAYOUT_FR, config_get()->kb_layout);
+
+  sim_cdc_clear_output();
+  sim_cdc_input("SET_KB_LAYOUT|XX\n");
+  sim_run_for_ms(20);
+  TEST_ASSERT_NOT_NULL(strstr(sim_cdc_output(), "ERROR|Unknown layout"));
+  TEST_ASSERT_EQUAL(KB_LAYOUT_FR, config_get()->kb_layout);
+}
+
+// ==================== RUNNER ====================
+
+void run_keyboard_layout_tests(void) {
+  printf("\n=== Keyboard Layout Tests ===\n");
+
+  RUN_TEST(test_layout_us_matches_legacy_mapping);
+  RUN_TEST(test_layout_every_printable_ascii_on_us_and_dvorak);
+  RUN_TEST(test_layout_de_qwertz);
+  RUN_TEST(test_layout_fr_azerty);
+  RUN_TEST(test_layout_pl_extras);
+  RUN_TEST(test_layout_parse_and_macro_value);
+
+  RUN_TEST(test_sim_text_pl_types_without_unicode_input);
+  RUN_TEST(test_sim_text_macro_layout_override);
+
+  RUN_TEST(test_sim_cdc_set_kb_layout);
+}
@@ -0,0 +1,162 @@
+/*
+ * Layer tests - layer count set over CDC (flash holds only existing layers,
+ * arena data of dropped layers is freed), direct jumps, cycling over the
+ * configured count and momentary layers held by buttons (real firmware
+ * sources)
+ */
+
+#include "unity/unity.h"
+
+#include "cdc/cdc_dispatcher.h"
+#include "executor/macro_executor.h"
+#include "macro_arena.h"
+#include "macro_config.h"
+#include "sim/sim.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define KEY_A 0x04
+#define KEY_B 0x05
+#define KEY_C 0x06
+
+static void set_key(uint8_t layer, uint8_t button, uint8_t keycode) {
+  macro_entry_t *macro = config_get_macro(layer, button);
+  macro->type = MACRO_TYPE_KEY_PRESS;
+  macro->value = keycode;
+}
+
+static void set_layer_key(uint8_t layer, uint8_t button, uint16_t value) {
+  macro_entry_t *macro = config_get_macro(layer, button);
+  macro->type = MACRO_TYPE_LAYER_TOGGLE;
+  macro->value = value;
+}
+
+static int key_presses(uint8_t keycode) {
+  int n = 0;
+  for (size_t i = 0; i < sim_hid_report_count(); i++) {
+    const sim_hid_report_t *r = sim_hid_report(i);
+    if (r->report_id == 1 && r->data[2] == keycode)
+      n++;
+  }
+  return n;
+}
+
+void test_sim_layer_count_sizes_flash(void) {
+  sim_boot();
+  TEST_ASSERT_EQUAL(DEFAULT_LAYER_COUNT, config_layer_count());
+  uint32_t four_layers = config_stored_size();
+
+  // new layers are empty with the layer switch on BTN7
+  process_command("SET_LAYER_COUNT|24");
+  TEST_ASSERT_NOT_NULL(strstr(sim_cdc_output(), "OK"));
+  TEST_ASSERT_EQUAL(24, config_layer_count());
+  TEST_ASSERT_EQUAL_STRING("Empty", config_get_macro(23, 0)->name);
+  TEST_ASSERT_EQUAL(MACRO_TYPE_LAYER_TOGGLE, config_get_macro(23, 6)->type);
+  TEST_ASSERT_EQUAL(four_layers + 20 * sizeof(layer_t), config_stored_size());
+  TEST_ASSERT_LESS_THAN(sizeof(config_data_t), config_stored_size());
+
+  // saved and loaded with the count, the erase covers the stored part only
+  strcpy(config_get_layer(20)->name, "Lights");
+  process_command("SAVE_FLASH");
+  TEST_ASSERT_EQUAL(FLASH_SECTOR_SIZE_CALC / 4096,
+                    sim_flash_stats()->sectors_erased);
+  config_init();
+  TEST_ASSERT_EQUAL(24, config_layer_count());
+  TEST_ASSERT_EQUAL_STRING("Lights", config_get_layer(20)->name);
+
+  // out of range counts are refused
+  sim_cdc_clear_output();
+  process_command("SET_LAYER_COUNT|0");
+  process_command("SET_LAYER_COUNT|200");
+  TEST_ASSERT_NULL(strstr(sim_cdc_output(), "OK"));
+  TEST_ASSERT_EQUAL(24, config_layer_count());
+}
+
+void test_sim_layer_shrink_frees_layers(void) {
+  sim_boot();
+  process_command("SET_LAYER_COUNT|6");
+  uint16_t before = macro_arena_free_bytes();
+  process_command("SET_MACRO_SEQ|5|0|Seq|0|3|4,0,0,5,0,0,6,0,0");
+  TEST_ASSERT_LESS_THAN(before, macro_arena_free_bytes());
+
+  // the active layer is dropped too: back to the first one
+  config_set_current_layer(5);
+  sim_cdc_clear_output();
+  process_command("SET_LAYER_COUNT|2");
+  TEST_ASSERT_EQUAL(2, config_layer_count());
+  TEST_ASSERT_EQUAL(0, config_get_current_layer());
+  TEST_ASSERT_EQUAL(before, macro_arena_free_bytes());
+  TEST_ASSERT_NULL(config_get_macro(5, 0));
+  TEST_ASSERT_NULL(config_get_layer(2));
+
+  // the configurator reads the count before the layers
+  sim_cdc_clear_output();
+  process_command("GET_CONF");
+  TEST_ASSERT_NOT_NULL(strstr(sim_cdc_output(), "LAYERS|2|"));
+  TEST_ASSERT_NOT_NULL(strstr(sim_cdc_output(), "LAYER_NAME|1|"));
+  TEST_ASSERT_NULL(strstr(sim_cdc_output(), "LAYER_NAME|2|"));
+  TEST_ASSERT_NULL(strstr(sim_cdc_output(), "MACRO|2|"));
+}
+
+void test_sim_layer_jump_and_cycle(void) {
+  sim_boot();
+  config_set_layer_count(6);
+
+  // jump straight to the last layer
+  set_layer_key(0, 0, LAYER_SWITCH_JUMP | 5);
+  execute_macro(0, 0);
+  TEST_ASSERT_EQUAL(5, config_get_current_layer());
+
+  // cycling wraps at the configured count
+  execute_macro(5, 6);
+  TEST_ASSERT_EQUAL(0, config_get_current_layer());
+  execute_macro(0, 6);
+  TEST_ASSERT_EQUAL(1, config_get_current_layer());
+
+  // a jump to a layer that does not exist is ignored
+  set_layer_key(1, 0, LAYER_SWITCH_JUMP | 9);
+  execute_macro(1, 0);
+  TEST_ASSERT_EQUAL(1, config_get_current_layer());
+}
+
+void test_sim_layer_momentary_stack(void) {
+  sim_boot();
+  config_set_layer_count(4);
+  set_layer_key(0, 0, LAYER_SWITCH_MOMENTARY | 2);
+  set_layer_key(2, 2, LAYER_SWITCH_MOMENTARY | 3);
+  set_key(0, 1, KEY_A);
+  set_key(2, 1, KEY_B);
+  set_key(3, 1, KEY_C);
+
+  // BTN1 holds layer 2, BTN3 on it holds layer 3, released out of order
+  uint64_t t = sim_time_us() + 10000;
+  sim_script_button(0, t, 400);
+  sim_script_button(1, t + 100000, 30);
+  sim_script_button(2, t + 150000, 500);
+  sim_script_button(1, t + 250000, 30);
+  sim_script_button(1, t + 500000, 30); // BTN1 up, BTN3 still down
+  sim_script_button(1, t + 750000, 30); // both up
+  sim_run_for_ms(900);
+
+  TEST_ASSERT_EQUAL(1, key_presses(KEY_B));
+  TEST_ASSERT_EQUAL(2, key_presses(KEY_C));
+  TEST_ASSERT_EQUAL(1, key_presses(KEY_A));
+  TEST_ASSERT_EQUAL(0, config_get_current_layer());
+
+  // a jump while a layer is held replaces it
+  set_layer_key(2, 3, LAYER_SWITCH_JUMP | 1);
+  config_layer_push(2, 0);
+  execute_macro(2, 3);
+  TEST_ASSERT_EQUAL(1, config_get_current_layer());
+  TEST_ASSERT_FALSE(config_layer_release(0));
+  TEST_ASSERT_EQUAL(1, config_get_current_layer());
+}
+
+void run_layer_tests(void) {
+  printf("\n=== Layer Tests ===\n");
+  RUN_TEST(test_sim_layer_count_sizes_flash);
+  RUN_TEST(test_sim_layer_shrink_frees_layers);
+  RUN_TEST(test_sim_layer_jump_and_cycle);
+  RUN_TEST(test_sim_layer_momentary_stack);
+}
@@ -0,0 +1,162 @@
+/*
+ * macro recorder tests - CDC-fed key events compressed into VM programs
+ * (quantized delays, loops for repeated taps, modifiers), REC_* commands,
+ * MACRO_TYPE_RECORD trigger (real firmware sources)
+ */
+
+#include "unity/unity.h"
+
+#include "executor/macro_executor.h"
+#include "executor/macro_recorder.h"
+#include "executor/macro_vm.h"
+#include "macro_arena.h"
+#include "macro_config.h"
+#include "sim/sim.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define KEY_A 0x04
+#define KEY_B 0x05
+#define KEY_LCTRL 0xE0
+
+static int count_presses(uint8_t keycode) {
+  int n = 0;
+  for (size_t i = 0; i < sim_hid_report_count(); i++) {
+    if (sim_hid_report(i)->data[2] == keycode)
+      n++;
+  }
+  return n;
+}
+
+static void cdc_command(const char *cmd) {
+  sim_cdc_clear_output();
+  sim_cdc_input(cmd);
+  sim_run_for_ms(20);
+}
+
+void test_recorder_compresses_repeated_taps(void) {
+  sim_boot();
+  TEST_ASSERT_TRUE(recorder_start(0, 1));
+
+  // A tapped 4 times at a human pace (jitter within the quantum), then B
+  const uint32_t pre[4] = {0, 101, 99, 102};
+  const uint32_t hold[4] = {41, 39, 40, 42};
+  for (int i = 0; i < 4; i++) {
+    TEST_ASSERT_TRUE(recorder_feed(true, KEY_A, pre[i]));
+    TEST_ASSERT_TRUE(recorder_feed(false, KEY_A, hold[i]));
+  }
+  TEST_ASSERT_TRUE(recorder_feed(true, KEY_B, 200));
+  TEST_ASSERT_TRUE(recorder_feed(false, KEY_B, 30));
+
+  uint16_t len = 0;
+  TEST_ASSERT_TRUE(recorder_stop(&len));
+  TEST_ASSERT_FALSE(recorder_active());
+
+  // first tap, then LOOP 3 {DELAY 100, DOWN, DELAY 40, UP}, then B
+  const uint8_t expected[] = {
+      VM_OP_KEY_DOWN, KEY_A, 0, VM_OP_DELAY, 40, 0, VM_OP_KEY_UP, KEY_A, 0,
+      VM_OP_LOOP, 3, 0, VM_OP_DELAY, 100, 0, VM_OP_KEY_DOWN, KEY_A, 0,
+      VM_OP_DELAY, 40, 0, VM_OP_KEY_UP, KEY_A, 0, VM_OP_END_LOOP,
+      VM_OP_DELAY, 200, 0, VM_OP_KEY_DOWN, KEY_B, 0, VM_OP_DELAY, 30, 0,
+      VM_OP_KEY_UP, KEY_B, 0};
+  TEST_ASSERT_EQUAL((int)sizeof(expected), len);
+
+  uint16_t stored = 0;
+  const uint8_t *code = macro_arena_get(0, 1, ARENA_SLOT_PROGRAM, &stored);
+  TEST_ASSERT_NOT_NULL(code);
+  TEST_ASSERT_EQUAL(len, stored);
+  TEST_ASSERT_EQUAL(0, memcmp(expected, code, sizeof(expected)));
+  TEST_ASSERT_EQUAL(-1, macro_vm_verify(code, stored));
+  TEST_ASSERT_EQUAL(MACRO_TYPE_PROGRAM, config_get()->layers[0].macros[1].type);
+
+  // played back: the same keys come out
+  execute_macro(0, 1);
+  sim_run_for_ms(1000);
+  TEST_ASSERT_FALSE(macro_vm_running());
+  TEST_ASSERT_EQUAL(4, count_presses(KEY_A));
+  TEST_ASSERT_EQUAL(1, count_presses(KEY_B));
+}
+
+void test_recorder_modifiers_and_held_keys(void) {
+  sim_boot();
+  TEST_ASSERT_TRUE(recorder_start(1, 0));
+
+  // Ctrl held over a B tap -> modifier byte, not keycode 0xE0
+  TEST_ASSERT_TRUE(recorder_feed(true, KEY_LCTRL, 0));
+  TEST_ASSERT_TRUE(recorder_feed(true, KEY_B, 52));
+  TEST_ASSERT_TRUE(recorder_feed(false, KEY_B, 20));
+  TEST_ASSERT_TRUE(recorder_feed(false, KEY_LCTRL, 10));
+
+  uint16_t len = 0;
+  TEST_ASSERT_TRUE(recorder_stop(&len));
+  const uint8_t expected[] = {
+      VM_OP_KEY_DOWN, 0, MODIFIER_LEFT_CTRL, VM_OP_DELAY, 50, 0,
+      VM_OP_KEY_DOWN, KEY_B, 0, VM_OP_DELAY, 20, 0, VM_OP_KEY_UP, KEY_B, 0,
+      VM_OP_DELAY, 10, 0, VM_OP_KEY_UP, 0, MODIFIER_LEFT_CTRL};
+  const uint8_t *code = macro_arena_get(1, 0, ARENA_SLOT_PROGRAM, &len);
+  TEST_ASSERT_EQUAL((int)sizeof(expected), len);
+  TEST_ASSERT_EQUAL(0, memcmp(expected, code, sizeof(expected)));
+
+  // nothing recorded -> nothing stored
+  TEST_ASSERT_TRUE(recorder_start(1, 1));
+  TEST_ASSERT_FALSE(recorder_start(1, 2));
+  TEST_ASSERT_FALSE(recorder_stop(&len));
+  TEST_ASSERT_NULL(macro_arena_get(1, 1, ARENA_SLOT_PROGRAM, NULL));
+  TEST_ASSERT_FALSE(recorder_feed(true, KEY_A, 0));
+}
+
+void test_sim_recorder_cdc_flow(void) {
+  sim_boot();
+  uint8_t old_type = config_get()->layers[0].macros[2].type;
+
+  // cancelled recording leaves the macro alone
+  cdc_command("REC_START|0|2\n");
+  TEST_ASSERT_NOT_NULL(strstr(sim_cdc_output(), "OK"));
+  cdc_command("REC_KEY|1|4|0\n");
+  cdc_command("REC_CANCEL\n");
+  TEST_ASSERT_FALSE(recorder_active());
+  TEST_ASSERT_EQUAL(old_type, config_get()->layers[0].macros[2].type);
+  cdc_command("REC_KEY|1|4|0\n");
+  TEST_ASSERT_NOT_NULL(strstr(sim_cdc_output(), "ERROR|Not recording"));
+
+  // a record button arms the recorder, the host streams the keys
+  config_get()->layers[0].macros[3].type = MACRO_TYPE_RECORD;
+  config_get()->layers[0].macros[3].value = 2;
+  sim_cdc_clear_output();
+  execute_macro(0, 3);
+  TEST_ASSERT_TRUE(recorder_active());
+  TEST_ASSERT_NOT_NULL(strstr(sim_cdc_output(), "REC_START|0|2"));
+
+  cdc_command("REC_KEY|1|4|0\n");
+  cdc_command("REC_KEY|0|4|30\n");
+  TEST_ASSERT_NOT_NULL(strstr(sim_cdc_output(), "OK"));
+
+  // the second press stores the program in flash
+  sim_cdc_clear_output();
+  execute_macro(0, 3);
+  TEST_ASSERT_FALSE(recorder_active());
+  TEST_ASSERT_NOT_NULL(strstr(sim_cdc_output(), "REC_DONE|0|2|9"));
+
+  config_init();
+  TEST_ASSERT_EQUAL(MACRO_TYPE_PROGRAM, config_get()->layers[0].macros[2].type);
+  uint16_t len = 0;
+  TEST_ASSERT_NOT_NULL(macro_arena_get(0, 2, ARENA_SLOT_PROGRAM, &len));
+  TEST_ASSERT_EQUAL(9, len);
+
+  // REC_STOP replies with the program size
+  cdc_command("REC_START|0|4\n");
+  cdc_command("REC_KEY|1|5|0\n");
+  cdc_command("REC_STOP\n");
+  TEST_ASSERT_NOT_NULL(strstr(sim_cdc_output(), "OK|3"));
+  cdc_command("REC_START|9|0\n");
+  TEST_ASSERT_NOT_NULL(strstr(sim_cdc_output(), "ERROR|Invalid parameters"));
+}
+
+void run_macro_recorder_tests(void) {
+  printf("\n=== Macro Recorder Tests ===\n");
+
+  RUN_TEST(test_recorder_compresses_repeated_taps);
+  RUN_TEST(test_recorder_modifiers_and_held_keys);
+  RUN_TEST(test_sim_recorder_cdc_flow);
+}
@@ -0,0 +1,388 @@
+/*
+ * macro VM tests - arena blobs (programs, key steps, interning), program
+ * verification, non-blocking execution, SET_MACRO_PROG / SET_MACRO_SEQ (real
+ * sources)
+ */
+
+#include "unity/unity.h"
+
+#include "cdc/cdc_transport.h"
+#include "executor/macro_executor.h"
+#include "executor/macro_vm.h"
+#include "macro_arena.h"
+#include "macro_config.h"
+#include "sim/sim.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define KEY_A 0x04
+#define KEY_B 0x05
+
+extern volatile uint8_t g_detected_platform;
+
+static void set_program(uint8_t button, const uint8_t *code, uint16_t len) {
+  TEST_ASSERT_TRUE(macro_arena_set(0, button, ARENA_SLOT_PROGRAM, code, len));
+  config_get()->layers[0].macros[button].type = MACRO_TYPE_PROGRAM;
+}
+
+static uint16_t blob_len(uint8_t layer, uint8_t button, uint8_t slot) {
+  uint16_t len = 0;
+  macro_arena_get(layer, button, slot, &len);
+  return len;
+}
+
+static int count_presses(uint8_t keycode) {
+  int n = 0;
+  for (size_t i = 0; i < sim_hid_report_count(); i++) {
+    if (sim_hid_report(i)->data[2] == keycode)
+      n++;
+  }
+  return n;
+}
+
+// ==================== ARENA ====================
+
+void test_arena_compacts_on_free_and_grow(void) {
+  sim_boot();
+  const uint8_t a[] = {1, 2, 3};
+  const uint8_t b[] = {4, 5};
+  const uint8_t more[] = {6, 7};
+
+  TEST_ASSERT_TRUE(macro_arena_set(0, 0, ARENA_SLOT_PROGRAM, a, 3));
+  TEST_ASSERT_TRUE(macro_arena_set(1, 2, ARENA_SLOT_PROGRAM, b, 2));
+
+  // growing the first blob moves the second one behind it
+  TEST_ASSERT_TRUE(macro_arena_append(0, 0, ARENA_SLOT_PROGRAM, more, 2));
+  uint16_t len = 0;
+  const uint8_t *p = macro_arena_get(1, 2, ARENA_SLOT_PROGRAM, &len);
+  TEST_ASSERT_EQUAL(2, len);
+  TEST_ASSERT_EQUAL(4, p[0]);
+  p = macro_arena_get(0, 0, ARENA_SLOT_PROGRAM, &len);
+  TEST_ASSERT_EQUAL(5, len);
+  TEST_ASSERT_EQUAL(7, p[4]);
+
+  // freeing it leaves no gap (blobs are padded to MACRO_ARENA_ALIGN)
+  macro_arena_clear(0, 0, ARENA_SLOT_PROGRAM);
+  TEST_ASSERT_NULL(macro_arena_get(0, 0, ARENA_SLOT_PROGRAM, NULL));
+  TEST_ASSERT_EQUAL(MACRO_ARENA_SIZE - 4, macro_arena_free_bytes());
+  p = macro_arena_get(1, 2, ARENA_SLOT_PROGRAM, &len);
+  TEST_ASSERT_EQUAL(5, p[1]);
+
+  // key steps behind an odd sized program are still aligned
+  key_step_t steps[2] = {{KEY_A, 0, 10}, {KEY_B, 0, 20}};
+  TEST_ASSERT_TRUE(macro_arena_set(2, 0, ARENA_SLOT_SEQUENCE,
+                                   (const uint8_t *)steps, sizeof(steps)));
+  uint16_t count = 0;
+  const key_step_t *s = macro_arena_steps(2, 0, ARENA_SLOT_SEQUENCE, &count);
+  TEST_ASSERT_EQUAL(2, count);
+  TEST_ASSERT_EQUAL(0, (int)((uintptr_t)s % MACRO_ARENA_ALIGN));
+  TEST_ASSERT_EQUAL(20, s[1].duration);
+
+  // too big -> refused, nothing changes
+  static uint8_t big[MACRO_ARENA_SIZE];
+  TEST_ASSERT_FALSE(
+      macro_arena_set(0, 0, ARENA_SLOT_PROGRAM, big, MACRO_ARENA_SIZE));
+  TEST_ASSERT_EQUAL(MACRO_ARENA_SIZE - 12, macro_arena_free_bytes());
+}
+
+void test_arena_interns_equal_blobs(void) {
+  sim_boot();
+  uint16_t empty = macro_arena_free_bytes();
+  const uint8_t other[] = {9, 9};
+  const uint8_t shortcut[] = {0x17, 0x05, 0, 0}; // Ctrl+Alt+T
+  const uint8_t more[] = {0x28, 0, 0, 0};
+
+  // the same shortcut on three layers is stored once
+  TEST_ASSERT_TRUE(macro_arena_set(3, 0, ARENA_SLOT_PROGRAM, other, 2));
+  for (uint8_t l = 0; l < 3; l++)
+    TEST_ASSERT_TRUE(macro_arena_set(l, 1, ARENA_SLOT_SHORTCUT, shortcut, 4));
+  TEST_ASSERT_EQUAL(empty - 8, macro_arena_free_bytes());
+
+  // freeing the blob in front moves all the shared refs together
+  macro_arena_clear(3, 0, ARENA_SLOT_PROGRAM);
+  TEST_ASSERT_EQUAL(empty - 4, macro_arena_free_bytes());
+  TEST_ASSERT_TRUE(macro_arena_get(0, 1, ARENA_SLOT_SHORTCUT, NULL) ==
+                   macro_arena_get(2, 1, ARENA_SLOT_SHORTCUT, NULL));
+  TEST_ASSERT_EQUAL(0x17, macro_arena_get(1, 1, ARENA_SLOT_SHORTCUT, NULL)[0]);
+  TEST_ASSERT_TRUE(macro_arena_set(0, 0, ARENA_SLOT_PROGRAM, more, 4));
+
+  // growing one user copies it, the others keep the old content
+  TEST_ASSERT_TRUE(macro_arena_append(1, 1, ARENA_SLOT_SHORTCUT, more, 4));
+  uint16_t len = 0;
+  const uint8_t *p = macro_arena_get(1, 1, ARENA_SLOT_SHORTCUT, &len);
+  TEST_ASSERT_EQUAL(8, len);
+  TEST_ASSERT_EQUAL(0x28, p[4]);
+  TEST_ASSERT_EQUAL(4, blob_len(0, 1, ARENA_SLOT_SHORTCUT));
+  TEST_ASSERT_EQUAL(4, blob_len(2, 1, ARENA_SLOT_SHORTCUT));
+
+  // freed with the last user only, shared blobs pass the flash check
+  macro_arena_clear(0, 1, ARENA_SLOT_SHORTCUT);
+  TEST_ASSERT_EQUAL(0x17, macro_arena_get(2, 1, ARENA_SLOT_SHORTCUT, NULL)[0]);
+  macro_arena_validate();
+  TEST_ASSERT_EQUAL(empty - 16, macro_arena_free_bytes());
+  macro_arena_clear(2, 1, ARENA_SLOT_SHORTCUT);
+  macro_arena_clear(1, 1, ARENA_SLOT_SHORTCUT);
+  TEST_ASSERT_EQUAL(empty - 4, macro_arena_free_bytes());
+
+  // the program equals the remaining blob: no space needed at all
+  TEST_ASSERT_TRUE(macro_arena_set(3, 6, ARENA_SLOT_PROGRAM, more, 4));
+  TEST_ASSERT_EQUAL(empty - 4, macro_arena_free_bytes());
+}
+
+// ==================== VERIFY ====================
+
+void test_vm_verify_rejects_bad_programs(void) {
+  const uint8_t ok[] = {VM_OP_LOOP, 3, 0, VM_OP_TAP, KEY_A, 0, VM_OP_END_LOOP};
+  TEST_ASSERT_EQUAL(-1, macro_vm_verify(ok, sizeof(ok)));
+
+  const uint8_t unknown[] = {VM_OP_TAP, KEY_A, 0, 0x7F};
+  TEST_ASSERT_EQUAL(3, macro_vm_verify(unknown, sizeof(unknown)));
+
+  const uint8_t cut[] = {VM_OP_DELAY, 10};
+  TEST_ASSERT_EQUAL(0, macro_vm_verify(cut, sizeof(cut)));
+
+  const uint8_t unbalanced[] = {VM_OP_LOOP, 2, 0, VM_OP_TAP, KEY_A, 0};
+  TEST_ASSERT_NOT_EQUAL(-1, macro_vm_verify(unbalanced, sizeof(unbalanced)));
+
+  // a jump out of the loop body would leave the loop stack behind
+  const uint8_t out_of_loop[] = {VM_OP_LOOP, 2, 0,         VM_OP_JUMP, 1,
+                                 0,          VM_OP_END_LOOP, VM_OP_END};
+  TEST_ASSERT_EQUAL(3, macro_vm_verify(out_of_loop, sizeof(out_of_loop)));
+
+  const uint8_t past_end[] = {VM_OP_JUMP, 5, 0, VM_OP_END};
+  TEST_ASSERT_EQUAL(0, macro_vm_verify(past_end, sizeof(past_end)));
+}
+
+// ==================== EXECUTION ====================
+
+void test_sim_vm_runs_in_background(void) {
+  sim_boot();
+  const uint8_t prog[] = {VM_OP_LOOP,  3,     0, VM_OP_TAP,     KEY_A,
+                          0,           VM_OP_DELAY, 50, 0, VM_OP_END_LOOP,
+                          VM_OP_END};
+  set_program(0, prog, sizeof(prog));
+
+  // the button press only starts the program
+  uint64_t start = sim_time_us();
+  execute_macro(0, 0);
+  TEST_ASSERT_LESS_THAN(50000, (int)(sim_time_us() - start));
+  TEST_ASSERT_TRUE(macro_vm_running());
+  TEST_ASSERT_EQUAL(0, count_presses(KEY_A));
+
+  sim_run_for_ms(400);
+  TEST_ASSERT_FALSE(macro_vm_running());
+  TEST_ASSERT_EQUAL(3, count_presses(KEY_A));
+  TEST_ASSERT_EQUAL(0, sim_hid_dropped_reports());
+
+  // the delays separate the taps
+  uint64_t first = 0, last = 0;
+  for (size_t i = 0; i < sim_hid_report_count(); i++) {
+    const sim_hid_report_t *r = sim_hid_report(i);
+    if (r->data[2] == KEY_A) {
+      if (!first)
+        first = r->time_us;
+      last = r->time_us;
+    }
+  }
+  TEST_ASSERT_TRUE(last - first >= 2 * 50000);
+
+  const sim_hid_report_t *end = sim_hid_report(sim_hid_report_count() - 1);
+  TEST_ASSERT_EQUAL(0, end->data[0]);
+  TEST_ASSERT_EQUAL(0, end->data[2]);
+}
+
+void test_sim_vm_held_keys_and_text(void) {
+  sim_boot();
+  const uint8_t prog[] = {VM_OP_KEY_DOWN, 0,   MODIFIER_LEFT_CTRL,
+                          VM_OP_TAP,      KEY_B, 0,
+                          VM_OP_KEY_UP,   0,   MODIFIER_LEFT_CTRL,
+                          VM_OP_TEXT,     2,   'h',
+                          'i'};
+  set_program(0, prog, sizeof(prog));
+
+  execute_macro(0, 0);
+  sim_run_for_ms(300);
+
+  // Ctrl held under the B tap
+  bool ctrl_b = false;
+  for (size_t i = 0; i < sim_hid_report_count(); i++) {
+    const sim_hid_report_t *r = sim_hid_report(i);
+    if (r->data[2] == KEY_B && r->data[0] == MODIFIER_LEFT_CTRL)
+      ctrl_b = true;
+  }
+  TEST_ASSERT_TRUE(ctrl_b);
+  TEST_ASSERT_EQUAL(1, count_presses(0x0B)); // h
+  TEST_ASSERT_EQUAL(1, count_presses(0x0C)); // i
+  TEST_ASSERT_FALSE(macro_vm_running());
+}
+
+void test_sim_vm_forever_loop_cancelled_by_button(void) {
+  sim_boot();
+  const uint8_t prog[] = {VM_OP_LOOP, 0, 0, VM_OP_TAP, KEY_A, 0,
+                          VM_OP_DELAY, 20, 0, VM_OP_END_LOOP};
+  set_program(0, prog, sizeof(prog));
+
+  sim_script_button(0, sim_time_us() + 1000, 30);
+  sim_run_for_ms(200);
+  TEST_ASSERT_TRUE(macro_vm_running());
+
+  sim_script_button(0, sim_time_us() + 1000, 30);
+  sim_run_for_ms(100);
+  TEST_ASSERT_FALSE(macro_vm_running());
+
+  int presses = count_presses(KEY_A);
+  sim_run_for_ms(200);
+  TEST_ASSERT_EQUAL(presses, count_presses(KEY_A));
+}
+
+void test_sim_vm_platform_condition(void) {
+  sim_boot();
+  // IF_PLATFORM 2 { tap A } else { tap B }
+  const uint8_t prog[] = {VM_OP_IF_PLATFORM, 2, 6, 0, VM_OP_TAP, KEY_A, 0,
+                          VM_OP_JUMP,        3, 0, VM_OP_TAP, KEY_B, 0};
+  TEST_ASSERT_EQUAL(-1, macro_vm_verify(prog, sizeof(prog)));
+  set_program(0, prog, sizeof(prog));
+
+  g_detected_platform = 0;
+  execute_macro(0, 0);
+  sim_run_for_ms(200);
+  TEST_ASSERT_EQUAL(0, count_presses(KEY_A));
+  TEST_ASSERT_EQUAL(1, count_presses(KEY_B));
+
+  sim_clear_records();
+  g_detected_platform = 2;
+  execute_macro(0, 0);
+  sim_run_for_ms(200);
+  TEST_ASSERT_EQUAL(1, count_presses(KEY_A));
+  TEST_ASSERT_EQUAL(0, count_presses(KEY_B));
+  g_detected_platform = 0;
+}
+
+// ==================== CDC ====================
+
+void test_sim_cdc_set_macro_prog_chunks_and_flash(void) {
+  sim_boot();
+
+  // TAP A, then TAP B in a second chunk
+  sim_cdc_input("SET_MACRO_PROG|1|3|0|030400\n");
+  sim_run_for_ms(20);
+  sim_cdc_input("SET_MACRO_PROG|1|3|3|030500\n");
+  sim_run_for_ms(20);
+  TEST_ASSERT_NOT_NULL(strstr(sim_cdc_output(), "OK"));
+  TEST_ASSERT_EQUAL(MACRO_TYPE_PROGRAM, config_get()->layers[1].macros[3].type);
+
+  sim_cdc_clear_output();
+  sim_cdc_input("SET_MACRO_PROG|1|3|9|00\n");
+  sim_run_for_ms(20);
+  TEST_ASSERT_NOT_NULL(strstr(sim_cdc_output(), "ERROR|Invalid offset"));
+
+  sim_cdc_clear_output();
+  sim_cdc_input("GET_CONF\n");
+  sim_run_for_ms(50);
+  TEST_ASSERT_NOT_NULL(strstr(sim_cdc_output(), "PROG_DATA|1|3|0|030400030500"));
+
+  // survives save + reload
+  TEST_ASSERT_TRUE(config_save());
+  macro_arena_clear(1, 3, ARENA_SLOT_PROGRAM);
+  config_init();
+  uint16_t len = 0;
+  const uint8_t *code = macro_arena_get(1, 3, ARENA_SLOT_PROGRAM, &len);
+  TEST_ASSERT_EQUAL(6, len);
+  TEST_ASSERT_EQUAL(KEY_B, code[4]);
+}
+
+void test_sim_cdc_long_sequence_in_chunks(void) {
+  sim_boot();
+  char line[CDC_MAX_COMMAND_LEN];
+
+  // 30 steps in three lines, A..J each time, 10 ms after every step
+  for (int chunk = 0; chunk < 3; chunk++) {
+    int n = snprintf(line, sizeof(line), "SET_MACRO_SEQ|0|1|Long|0|10|");
+    for (int i = 0; i < 10; i++)
+      n += snprintf(line + n, sizeof(line) - n, "%s%d,0,10", i ? "," : "",
+                    KEY_A + i);
+    snprintf(line + n, sizeof(line) - n, "|%d\n", chunk * 10);
+    sim_cdc_input(line);
+    sim_run_for_ms(20);
+  }
+
+  // a gap is refused
+  sim_cdc_clear_output();
+  sim_cdc_input("SET_MACRO_SEQ|0|1|Long|0|1|4,0,10|40\n");
+  sim_run_for_ms(20);
+  TEST_ASSERT_NOT_NULL(strstr(sim_cdc_output(), "ERROR|Invalid offset"));
+
+  sim_cdc_clear_output();
+  sim_cdc_input("GET_CONF\n");
+  sim_run_for_ms(50);
+  TEST_ASSERT_NOT_NULL(strstr(sim_cdc_output(), "MACRO_SEQ|0|1|Long|0|30"));
+  TEST_ASSERT_NOT_NULL(strstr(sim_cdc_output(), "SEQ_STEP|0|1|29|13|0|10"));
+
+  sim_clear_records();
+  execute_macro(0, 1);
+  TEST_ASSERT_EQUAL(3, count_presses(KEY_A));
+  TEST_ASSERT_EQUAL(3, count_presses(KEY_A + 9));
+
+  // every step takes as long at the end as at the start
+  uint64_t t[30];
+  int n = 0;
+  for (size_t i = 0; i < sim_hid_report_count() && n < 30; i++) {
+    if (sim_hid_report(i)->data[2] != 0)
+      t[n++] = sim_hid_report(i)->time_us;
+  }
+  TEST_ASSERT_EQUAL(30, n);
+  TEST_ASSERT_EQUAL((int)(t[1] - t[0]), (int)(t[29] - t[28]));
+}
+
+void test_sim_cdc_program_frees_sequence_steps(void) {
+  sim_boot();
+
+  sim_cdc_input("SET_MACRO_SEQ|0|2|Seq|0|2|4,0,10,5,0,10\n");
+  sim_run_for_ms(20);
+  uint16_t steps = 0;
+  macro_arena_steps(0, 2, ARENA_SLOT_SEQUENCE, &steps);
+  TEST_ASSERT_EQUAL(2, steps);
+
+  // the program replaces the sequence, its arena bytes are freed
+  sim_cdc_input("SET_MACRO_PROG|0|2|0|030400\n");
+  sim_run_for_ms(20);
+  TEST_ASSERT_EQUAL(MACRO_TYPE_PROGRAM, config_get()->layers[0].macros[2].type);
+  TEST_ASSERT_NULL(macro_arena_steps(0, 2, ARENA_SLOT_SEQUENCE, &steps));
+  TEST_ASSERT_EQUAL(MACRO_ARENA_SIZE - MACRO_ARENA_ALIGN,
+                    macro_arena_free_bytes());
+}
+
+void test_sim_cdc_program_frees_script(void) {
+  sim_boot();
+  config_get()->layers[1].macros[4].type = MACRO_TYPE_SCRIPT;
+  TEST_ASSERT_TRUE(macro_arena_set(1, 4, ARENA_SLOT_SCRIPT,
+                                   (const uint8_t *)"ls -la\n", 8));
+
+  // a script macro turned into a program drops its script blob
+  sim_cdc_input("SET_MACRO_PROG|1|4|0|030400\n");
+  sim_run_for_ms(20);
+  TEST_ASSERT_NULL(macro_arena_get(1, 4, ARENA_SLOT_SCRIPT, NULL));
+  TEST_ASSERT_EQUAL(MACRO_ARENA_SIZE - MACRO_ARENA_ALIGN,
+                    macro_arena_free_bytes());
+}
+
+// ==================== RUNNER ====================
+
+void run_macro_vm_tests(void) {
+  printf("\n=== Macro VM Tests ===\n");
+
+  RUN_TEST(test_arena_compacts_on_free_and_grow);
+  RUN_TEST(test_arena_interns_equal_blobs);
+  RUN_TEST(test_vm_verify_rejects_bad_programs);
+
+  RUN_TEST(test_sim_vm_runs_in_background);
+  RUN_TEST(test_sim_vm_held_keys_and_text);
+  RUN_TEST(test_sim_vm_forever_loop_cancelled_by_button);
+  RUN_TEST(test_sim_vm_platform_condition);
+
+  RUN_TEST(test_sim_cdc_set_macro_prog_chunks_and_flash);
+  RUN_TEST(test_sim_cdc_long_sequence_in_chunks);
+  RUN_TEST(test_sim_cdc_program_frees_sequence_steps);
+  RUN_TEST(test_sim_cdc_program_frees_script);
+}
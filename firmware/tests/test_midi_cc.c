@@ -0,0 +1,143 @@
+/*
+ * MIDI controller tests - 14-bit and NRPN messages, hold-to-ramp faders
+ * that continue from the last value, output budget of the MIDI TX FIFO
+ * (real firmware sources)
+ */
+
+#include "unity/unity.h"
+
+#include "executor/macro_executor.h"
+#include "executor/midi_cc.h"
+#include "macro_config.h"
+#include "sim/sim.h"
+#include "tusb.h"
+#include <stdint.h>
+#include <stdio.h>
+
+static void set_cc(uint8_t button, uint16_t mode, int16_t value,
+                   uint16_t param, uint16_t ramp_ms) {
+  macro_entry_t *macro = &config_get()->layers[0].macros[button];
+  macro->type = MACRO_TYPE_MIDI_CC;
+  macro->value = mode;
+  macro->move_x = value;
+  macro->move_y = 1;
+  macro->repeat_count = param;
+  macro->repeat_interval = ramp_ms;
+}
+
+// values of CC `controller` in the MIDI log, in order
+static int cc_values(uint8_t controller, int *out, int max) {
+  size_t len = 0;
+  const uint8_t *bytes = sim_midi_bytes(&len);
+  int n = 0;
+  for (size_t i = 0; i + 2 < len; i += 3) {
+    if (bytes[i] == 0xB0 && bytes[i + 1] == controller && n < max)
+      out[n++] = bytes[i + 2];
+  }
+  return n;
+}
+
+void test_sim_midi_cc_14bit_and_nrpn(void) {
+  sim_boot();
+
+  // volume (CC 7) at 8192 of 16383: MSB first, LSB on CC 39
+  set_cc(0, 7 | (MIDI_CC_RES_14BIT << MIDI_CC_RES_SHIFT), 8192, 0, 0);
+  execute_macro(0, 0);
+  const uint8_t pair[] = {0xB0, 7, 0x40, 0xB0, 39, 0x00};
+  size_t len = 0;
+  const uint8_t *bytes = sim_midi_bytes(&len);
+  TEST_ASSERT_EQUAL(sizeof(pair), len);
+  TEST_ASSERT_EQUAL_MEMORY(pair, bytes, sizeof(pair));
+
+  // NRPN 0x123 = 1000: parameter on CC 99/98, data entry on CC 6/38
+  sim_clear_records();
+  set_cc(1, MIDI_CC_RES_NRPN << MIDI_CC_RES_SHIFT, 1000, 0x123, 0);
+  execute_macro(0, 1);
+  const uint8_t nrpn[] = {0xB0, 99, 0x02, 0xB0, 98, 0x23,
+                          0xB0, 6,  0x07, 0xB0, 38, 0x68};
+  bytes = sim_midi_bytes(&len);
+  TEST_ASSERT_EQUAL(sizeof(nrpn), len);
+  TEST_ASSERT_EQUAL_MEMORY(nrpn, bytes, sizeof(nrpn));
+
+  // plain 7-bit macros still send one message
+  sim_clear_records();
+  set_cc(2, 1, 64, 0, 0);
+  execute_macro(0, 2);
+  sim_midi_bytes(&len);
+  TEST_ASSERT_EQUAL(3, len);
+}
+
+void test_sim_midi_cc_ramp_while_held(void) {
+  sim_boot();
+
+  // mod wheel up on key 1, down on key 2, 0-127 takes 500 ms
+  set_cc(0, 1 | MIDI_CC_RAMP, 127, 0, 500);
+  set_cc(1, 1 | MIDI_CC_RAMP, 0, 0, 500);
+
+  uint64_t t = sim_time_us() + 1000;
+  sim_script_button(0, t, 250);
+  sim_script_button(1, t + 400000, 100);
+  sim_run_for_ms(700);
+
+  int values[256];
+  int n = cc_values(1, values, 256);
+  TEST_ASSERT_GREATER_THAN(40, n);
+
+  // up to about half way, then down from there (no jump back to 0 or 127)
+  int top = 0;
+  int i = 0;
+  for (; i + 1 < n && values[i + 1] > values[i]; i++)
+    ;
+  top = values[i];
+  TEST_ASSERT_TRUE(top > 55 && top < 72);
+  for (; i + 1 < n; i++)
+    TEST_ASSERT_TRUE(values[i + 1] < values[i]);
+  TEST_ASSERT_TRUE(values[n - 1] > 30 && values[n - 1] < top - 15);
+
+  midi_cc_dest_t dest = {0, MIDI_CC_RES_7BIT, 1, 0};
+  TEST_ASSERT_EQUAL(values[n - 1], midi_cc_value(&dest));
+}
+
+void test_sim_midi_cc_output_budget(void) {
+  sim_boot();
+
+  // four NRPN ramps over the full 14-bit range in 50 ms: every one wants
+  // 16 bytes every millisecond, the FIFO budget is half of the TX buffer
+  for (uint8_t b = 0; b < 4; b++) {
+    set_cc(b, (MIDI_CC_RES_NRPN << MIDI_CC_RES_SHIFT) | MIDI_CC_RAMP, 16383,
+           b, 50);
+    execute_macro(0, b);
+  }
+
+  sim_clear_records();
+  uint64_t start = sim_time_us();
+  sim_run_for_ms(40);
+  uint32_t elapsed_ms = (uint32_t)((sim_time_us() - start) / 1000) + 1;
+
+  // 4 USB-MIDI bytes per 3 byte message
+  uint32_t per_ms = CFG_TUD_MIDI_TX_BUFSIZE / 2 / 4;
+  TEST_ASSERT_LESS_THAN(elapsed_ms * per_ms + 1, sim_midi_write_calls());
+
+  // every ramp keeps moving (round robin), data entry MSB values of each
+  size_t len = 0;
+  const uint8_t *bytes = sim_midi_bytes(&len);
+  int updates[4] = {0};
+  for (size_t i = 0; i + 11 < len; i += 3) {
+    if (bytes[i + 1] == 99 && bytes[i + 4] == 98 && bytes[i + 5] < 4)
+      updates[bytes[i + 5]]++;
+  }
+  for (int b = 0; b < 4; b++)
+    TEST_ASSERT_GREATER_THAN(10, updates[b]);
+
+  // all of them end on the target
+  sim_run_for_ms(100);
+  midi_cc_dest_t dest = {0, MIDI_CC_RES_NRPN, 0, 3};
+  TEST_ASSERT_EQUAL(16383, midi_cc_value(&dest));
+}
+
+void run_midi_cc_tests(void) {
+  printf("\n=== MIDI Controller Tests ===\n");
+  RUN_TEST(test_sim_midi_cc_14bit_and_nrpn);
+  RUN_TEST(test_sim_midi_cc_ramp_while_held);
+  RUN_TEST(test_sim_midi_cc_output_budget);
+}
@@ -0,0 +1,186 @@
+/*
+ * MIDI clock tests - tempo tracking with USB jitter, Start/Stop, tempo
+ * changes, VM_OP_SYNC phase lock and repeat intervals in ticks (real
+ * firmware sources)
+ */
+
+#include "unity/unity.h"
+
+#include "cdc/cdc_dispatcher.h"
+#include "executor/macro_executor.h"
+#include "executor/macro_vm.h"
+#include "macro_arena.h"
+#include "macro_config.h"
+#include "midi/midi_clock.h"
+#include "sim/sim.h"
+#include <stdint.h>
+#include <stdio.h>
+
+#define KEY_A 0x04
+
+static bool within(int64_t tolerance, int64_t expected, int64_t actual) {
+  int64_t diff = actual - expected;
+  return diff <= tolerance && diff >= -tolerance;
+}
+
+static void realtime(uint8_t byte) { sim_midi_input(&byte, 1); }
+
+// one Timing Clock, then the gap to the next one (on a whole millisecond,
+// the idle sleep of sim_run_for_ms() may end on the next one)
+static uint64_t tick(uint32_t gap_ms) {
+  uint64_t at = sim_time_us();
+  realtime(0xF8);
+  sim_run_until_us((at / 1000 + gap_ms) * 1000);
+  return at;
+}
+
+// time of the n-th key A press report
+static uint64_t press_time(int n) {
+  for (size_t i = 0; i < sim_hid_report_count(); i++) {
+    const sim_hid_report_t *r = sim_hid_report(i);
+    if (r->report_id == 1 && r->data[2] == KEY_A && n-- == 0)
+      return r->time_us;
+  }
+  return 0;
+}
+
+void test_sim_midi_clock_tempo_with_jitter(void) {
+  sim_boot();
+  TEST_ASSERT_EQUAL(1200, midi_clock_bpm_x10());
+
+  // 125 BPM = 20 ms per tick, delivered 18/22 ms apart and one late burst
+  realtime(0xFA);
+  sim_run_for_ms(5);
+  for (int i = 0; i < 48; i++)
+    tick(i == 30 ? 35 : (i % 2 ? 18 : 22));
+  TEST_ASSERT_TRUE(midi_clock_running());
+  TEST_ASSERT_EQUAL(47, midi_clock_position());
+  TEST_ASSERT_TRUE(within(20, 1250, midi_clock_bpm_x10()));
+
+  // a real tempo change locks again after a few ticks (100 BPM)
+  for (int i = 0; i < 24; i++)
+    tick(25);
+  TEST_ASSERT_TRUE(within(20, 1000, midi_clock_bpm_x10()));
+
+  realtime(0xFC);
+  sim_run_for_ms(2);
+  TEST_ASSERT_FALSE(midi_clock_running());
+
+  // Continue keeps the position, the tempo survives the pause
+  realtime(0xFB);
+  tick(25);
+  TEST_ASSERT_EQUAL(72, midi_clock_position());
+  TEST_ASSERT_TRUE(within(20, 1000, midi_clock_bpm_x10()));
+
+  // ticks stop coming -> clock lost
+  sim_run_for_ms(MIDI_CLOCK_TIMEOUT_MS + 10);
+  TEST_ASSERT_FALSE(midi_clock_running());
+}
+
+void test_sim_midi_clock_ignores_tick_bursts(void) {
+  sim_boot();
+  realtime(0xFA);
+  sim_run_for_ms(5);
+  for (int i = 0; i < 24; i++)
+    tick(20);
+  TEST_ASSERT_TRUE(within(20, 1250, midi_clock_bpm_x10()));
+
+  // eight ticks read in one go: counted, but no tempo from them
+  const uint8_t burst[8] = {0xF8, 0xF8, 0xF8, 0xF8, 0xF8, 0xF8, 0xF8, 0xF8};
+  sim_midi_input(burst, sizeof(burst));
+  sim_run_for_ms(20);
+  TEST_ASSERT_EQUAL(31, midi_clock_position());
+  TEST_ASSERT_TRUE(within(20, 1250, midi_clock_bpm_x10()));
+  TEST_ASSERT_EQUAL(240, midi_clock_interval_ms(MIDI_INTERVAL_TICKS | 12));
+
+  // outliers that disagree (a burst around a gap) do not relock either
+  tick(40);
+  tick(2);
+  tick(60);
+  tick(20);
+  TEST_ASSERT_TRUE(within(20, 1250, midi_clock_bpm_x10()));
+}
+
+void test_sim_midi_clock_during_blocking_macro(void) {
+  sim_boot();
+  realtime(0xFA);
+  sim_run_for_ms(5);
+  for (int i = 0; i < 24; i++)
+    tick(20);
+
+  // ticks keep coming while a 400 ms key sequence runs
+  static const uint8_t clock = 0xF8;
+  for (int i = 0; i < 19; i++)
+    sim_script_midi_input(sim_time_us() + 10000 + i * 20000, &clock, 1);
+  process_command("SET_MACRO_SEQ|0|1|Long|0|4|4,0,100,5,0,100,6,0,100,"
+                  "7,0,100");
+  execute_macro(0, 1);
+
+  // read as they came, not as a burst after the macro
+  TEST_ASSERT_EQUAL(23 + 19, midi_clock_position());
+  TEST_ASSERT_TRUE(within(20, 1250, midi_clock_bpm_x10()));
+}
+
+void test_sim_vm_sync_phase_locked(void) {
+  sim_boot();
+
+  // tap on every 16th note (6 ticks), three times
+  const uint8_t prog[] = {VM_OP_LOOP, 3, 0, VM_OP_TAP, KEY_A, 0,
+                          VM_OP_SYNC, 6, 0, VM_OP_END_LOOP, VM_OP_END};
+  TEST_ASSERT_EQUAL(-1, macro_vm_verify(prog, sizeof(prog)));
+  TEST_ASSERT_TRUE(macro_arena_set(0, 0, ARENA_SLOT_PROGRAM, prog,
+                                   sizeof(prog)));
+  config_get()->layers[0].macros[0].type = MACRO_TYPE_PROGRAM;
+
+  realtime(0xFA);
+  sim_run_for_ms(3);
+  uint64_t ticks[16];
+  for (int i = 0; i < 3; i++)
+    ticks[i] = tick(20);
+
+  // pressed between ticks 2 and 3: first tap now, then on ticks 6 and 12
+  sim_run_for_ms(7);
+  execute_macro(0, 0);
+  sim_run_for_ms(2);
+  for (int i = 3; i < 16; i++)
+    ticks[i] = tick(i == 3 ? 11 : 20);
+
+  TEST_ASSERT_NOT_EQUAL(0, press_time(0));
+  TEST_ASSERT_TRUE(press_time(0) < ticks[3]);
+  TEST_ASSERT_TRUE(within(3000, ticks[6] + 1500, press_time(1)));
+  TEST_ASSERT_TRUE(within(3000, ticks[12] + 1500, press_time(2)));
+  TEST_ASSERT_EQUAL(0, press_time(3));
+}
+
+void test_sim_repeat_interval_in_ticks(void) {
+  sim_boot();
+
+  // 125 BPM -> an 8th note (12 ticks) is 240 ms
+  realtime(0xFA);
+  for (int i = 0; i < 24; i++)
+    tick(20);
+  TEST_ASSERT_EQUAL(240, midi_clock_interval_ms(MIDI_INTERVAL_TICKS | 12));
+  TEST_ASSERT_EQUAL(240, midi_clock_interval_ms(240));
+
+  macro_entry_t *macro = &config_get()->layers[0].macros[1];
+  macro->type = MACRO_TYPE_KEY_PRESS;
+  macro->value = KEY_A;
+  macro->repeat_count = 2;
+  macro->repeat_interval = MIDI_INTERVAL_TICKS | 12;
+
+  sim_clear_records();
+  execute_macro(0, 1);
+
+  // hold (20 ms) + one 8th note between the presses
+  uint64_t gap = press_time(1) - press_time(0);
+  TEST_ASSERT_TRUE(within(5000, 260000, gap));
+}
+
+void run_midi_clock_tests(void) {
+  printf("\n=== MIDI Clock Tests ===\n");
+  RUN_TEST(test_sim_midi_clock_tempo_with_jitter);
+  RUN_TEST(test_sim_midi_clock_ignores_tick_bursts);
+  RUN_TEST(test_sim_midi_clock_during_blocking_macro);
+  RUN_TEST(test_sim_vm_sync_phase_locked);
+  RUN_TEST(test_sim_repeat_interval_in_ticks);
+}
@@ -0,0 +1,99 @@
+/*
+ * MIDI input tests - running status parser, host driven key/RGB LED
+ * feedback and the rate limited OLED meters (real firmware sources)
+ */
+
+#include "unity/unity.h"
+
+#include "midi/midi_rx.h"
+#include "oled/oled_display.h"
+#include "pin_definitions.h"
+#include "sim/sim.h"
+#include <stdint.h>
+#include <stdio.h>
+
+static void send(const uint8_t *bytes, size_t len) {
+  sim_midi_input(bytes, len);
+  sim_run_for_ms(2);
+}
+
+static bool led(uint8_t index) { return sim_gpio_get_output(LED_PINS[index]); }
+
+void test_sim_midi_rx_running_status(void) {
+  sim_boot();
+
+  // two Note On with running status, a clock byte between data bytes
+  const uint8_t notes[] = {0x90, 37, 100, 38, 0xF8, 100};
+  send(notes, sizeof(notes));
+  TEST_ASSERT_TRUE(led(1));
+  TEST_ASSERT_TRUE(led(2));
+
+  // velocity 0 under the same running status is a Note Off
+  const uint8_t off[] = {37, 0};
+  send(off, sizeof(off));
+  TEST_ASSERT_FALSE(led(1));
+  TEST_ASSERT_TRUE(led(2));
+
+  // SysEx cancels running status, its data never reaches the LEDs
+  const uint8_t sysex[] = {0xF0, 0x7E, 39, 0x7F, 0xF7, 39, 100};
+  send(sysex, sizeof(sysex));
+  TEST_ASSERT_FALSE(led(3));
+
+  // Note Off message, channel 10
+  const uint8_t note_off[] = {0x89, 38, 64};
+  send(note_off, sizeof(note_off));
+  TEST_ASSERT_FALSE(led(2));
+}
+
+void test_sim_midi_rx_rgb_feedback(void) {
+  sim_boot();
+
+  // red on, green off, blue on (active low pins)
+  const uint8_t cc[] = {0xB0, 80, 127, 81, 10, 82, 64};
+  send(cc, sizeof(cc));
+  TEST_ASSERT_FALSE(sim_gpio_get_output(PIN_RGB_R));
+  TEST_ASSERT_TRUE(sim_gpio_get_output(PIN_RGB_G));
+  TEST_ASSERT_FALSE(sim_gpio_get_output(PIN_RGB_B));
+
+  const uint8_t red_off[] = {0xB3, 80, 0};
+  send(red_off, sizeof(red_off));
+  TEST_ASSERT_TRUE(sim_gpio_get_output(PIN_RGB_R));
+  TEST_ASSERT_FALSE(sim_gpio_get_output(PIN_RGB_B));
+}
+
+void test_sim_midi_rx_meters_rate_limited(void) {
+  sim_boot();
+
+  // cost of one meter frame
+  const uint8_t one[] = {0xB0, 16, 100};
+  send(one, sizeof(one));
+  sim_run_for_ms(OLED_METER_FRAME_MS);
+  uint32_t frame_calls = sim_spi_write_calls();
+  TEST_ASSERT_GREATER_THAN(0, frame_calls);
+
+  // a 100 ms CC sweep, one message per millisecond on every meter
+  sim_clear_records();
+  uint64_t start = sim_time_us();
+  for (int ms = 0; ms < 100; ms++) {
+    uint8_t sweep[] = {0xB0, 16 + ms % OLED_METER_COUNT, (uint8_t)ms};
+    sim_midi_input(sweep, sizeof(sweep));
+    sim_run_for_ms(1);
+  }
+  sim_run_for_ms(OLED_METER_FRAME_MS);
+  uint32_t elapsed_ms = (uint32_t)((sim_time_us() - start) / 1000);
+  uint32_t frames = sim_spi_write_calls() / frame_calls;
+  TEST_ASSERT_LESS_THAN(elapsed_ms / OLED_METER_FRAME_MS + 2, frames);
+  TEST_ASSERT_GREATER_THAN(1, frames);
+
+  // no new values -> no redraw
+  sim_clear_records();
+  sim_run_for_ms(200);
+  TEST_ASSERT_EQUAL(0, sim_spi_write_calls());
+}
+
+void run_midi_rx_tests(void) {
+  printf("\n=== MIDI Input Tests ===\n");
+  RUN_TEST(test_sim_midi_rx_running_status);
+  RUN_TEST(test_sim_midi_rx_rgb_feedback);
+  RUN_TEST(test_sim_midi_rx_meters_rate_limited);
+}
@@ -0,0 +1,107 @@
+/*
+ * MIDI output batcher tests - one stream write per scheduler pass, CC
+ * coalescing that keeps the order of notes and NRPN sequences, queue
+ * overflow and the GET_MIDI_STATS command (real firmware sources)
+ */
+
+#include "unity/unity.h"
+
+#include "executor/macro_executor.h"
+#include "executor/macro_vm.h"
+#include "macro_arena.h"
+#include "macro_config.h"
+#include "midi/midi_tx.h"
+#include "sim/sim.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+void test_sim_midi_tx_chord_in_one_write(void) {
+  sim_boot();
+
+  // C major chord and a volume change from one program step sequence
+  const uint8_t prog[] = {VM_OP_MIDI, 0x90, 60, 100, VM_OP_MIDI, 0x90, 64,
+                          100,        VM_OP_MIDI, 0x90, 67, 100, VM_OP_MIDI,
+                          0xB0,       7,    90,   VM_OP_END};
+  TEST_ASSERT_EQUAL(-1, macro_vm_verify(prog, sizeof(prog)));
+  TEST_ASSERT_TRUE(macro_arena_set(0, 0, ARENA_SLOT_PROGRAM, prog,
+                                   sizeof(prog)));
+  config_get()->layers[0].macros[0].type = MACRO_TYPE_PROGRAM;
+
+  execute_macro(0, 0);
+  sim_clear_records();
+  sim_run_for_ms(5);
+
+  size_t len = 0;
+  const uint8_t *bytes = sim_midi_bytes(&len);
+  const uint8_t expected[] = {0x90, 60, 100, 0x90, 64, 100,
+                              0x90, 67, 100, 0xB0, 7,  90};
+  TEST_ASSERT_EQUAL(1, sim_midi_write_calls());
+  TEST_ASSERT_EQUAL(sizeof(expected), len);
+  TEST_ASSERT_EQUAL_MEMORY(expected, bytes, sizeof(expected));
+}
+
+void test_sim_midi_tx_cc_coalescing(void) {
+  sim_boot();
+
+  // volume sweep on channel 1, pan on channel 2 between the updates
+  midi_tx_message(0xB0, 7, 10);
+  midi_tx_message(0xB1, 10, 64);
+  midi_tx_message(0xB0, 7, 20);
+  midi_tx_message(0xB0, 7, 30);
+  // a note on the channel: the next volume change must stay after it
+  midi_tx_message(0x90, 60, 100);
+  midi_tx_message(0xB0, 7, 40);
+  // NRPN select and data entry twice, nothing merged
+  for (int i = 0; i < 2; i++) {
+    midi_tx_message(0xB0, 99, 0);
+    midi_tx_message(0xB0, 98, 5);
+    midi_tx_message(0xB0, 6, 64 + i);
+  }
+  midi_tx_flush();
+
+  size_t len = 0;
+  const uint8_t *bytes = sim_midi_bytes(&len);
+  const uint8_t expected[] = {0xB0, 7,  30, 0xB1, 10, 64, 0x90, 60, 100,
+                              0xB0, 7,  40, 0xB0, 99, 0,  0xB0, 98, 5,
+                              0xB0, 6,  64, 0xB0, 99, 0,  0xB0, 98, 5,
+                              0xB0, 6,  65};
+  TEST_ASSERT_EQUAL(sizeof(expected), len);
+  TEST_ASSERT_EQUAL_MEMORY(expected, bytes, sizeof(expected));
+
+  midi_tx_stats_t stats;
+  midi_tx_get_stats(&stats);
+  TEST_ASSERT_EQUAL(12, stats.events);
+  TEST_ASSERT_EQUAL(2, stats.coalesced);
+  TEST_ASSERT_EQUAL(1, stats.flushes);
+}
+
+void test_sim_midi_tx_overflow_and_stats(void) {
+  sim_boot();
+
+  // more notes than the queue holds: one early write, the rest at the end
+  for (uint8_t n = 0; n < 20; n++)
+    midi_tx_message(0x90, 40 + n, 100);
+  sim_run_for_ms(2);
+
+  size_t len = 0;
+  sim_midi_bytes(&len);
+  TEST_ASSERT_EQUAL(2, sim_midi_write_calls());
+  TEST_ASSERT_EQUAL(20 * 3, len);
+
+  sim_cdc_input("GET_MIDI_STATS|RESET\n");
+  sim_run_for_ms(20);
+  TEST_ASSERT_NOT_NULL(strstr(sim_cdc_output(), "MIDI_STATS|20|0|2|1|0"));
+
+  sim_cdc_clear_output();
+  sim_cdc_input("GET_MIDI_STATS\n");
+  sim_run_for_ms(20);
+  TEST_ASSERT_NOT_NULL(strstr(sim_cdc_output(), "MIDI_STATS|0|0|0|0|0"));
+}
+
+void run_midi_tx_tests(void) {
+  printf("\n=== MIDI Output Tests ===\n");
+  RUN_TEST(test_sim_midi_tx_chord_in_one_write);
+  RUN_TEST(test_sim_midi_tx_cc_coalescing);
+  RUN_TEST(test_sim_midi_tx_overflow_and_stats);
+}
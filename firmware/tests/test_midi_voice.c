@@ -0,0 +1,161 @@
+/*
+ * MIDI voice scheduler tests - non-blocking Note On, timer wheel Note Off,
+ * held notes ending on key release, polyphony, retrigger and voice stealing
+ * (real firmware sources)
+ */
+
+#include "unity/unity.h"
+
+#include "cdc/cdc_dispatcher.h"
+#include "executor/macro_executor.h"
+#include "executor/midi_voice.h"
+#include "macro_config.h"
+#include "midi/midi_tx.h"
+#include "sim/sim.h"
+#include <stdint.h>
+#include <stdio.h>
+
+static void set_note(uint8_t button, uint8_t note, uint16_t gate_ms) {
+  macro_entry_t *macro = &config_get()->layers[0].macros[button];
+  macro->type = MACRO_TYPE_MIDI_NOTE;
+  macro->value = note;
+  macro->move_x = 100;
+  macro->move_y = 1;
+  macro->repeat_interval = gate_ms;
+}
+
+// number of 3 byte messages with the given status and note, queued ones
+// included (they leave at the end of the scheduler pass)
+static int count_msgs(uint8_t status, uint8_t note) {
+  midi_tx_flush();
+  size_t len = 0;
+  const uint8_t *bytes = sim_midi_bytes(&len);
+  int n = 0;
+  for (size_t i = 0; i + 2 < len; i += 3) {
+    if (bytes[i] == status && bytes[i + 1] == note)
+      n++;
+  }
+  return n;
+}
+
+void test_sim_midi_gate_from_timer_wheel(void) {
+  sim_boot();
+  set_note(0, 60, 50);
+
+  // Note On without waiting for the gate
+  uint64_t start = sim_time_us();
+  execute_macro(0, 0);
+  TEST_ASSERT_LESS_THAN(2000, (int)(sim_time_us() - start));
+  TEST_ASSERT_EQUAL(1, count_msgs(0x90, 60));
+  TEST_ASSERT_EQUAL(0, count_msgs(0x80, 60));
+
+  sim_run_for_ms(40);
+  TEST_ASSERT_EQUAL(0, count_msgs(0x80, 60));
+  sim_run_for_ms(20);
+  TEST_ASSERT_EQUAL(1, count_msgs(0x80, 60));
+  TEST_ASSERT_EQUAL(0, midi_voice_active());
+}
+
+// time of the first message with the given status and note
+static uint64_t msg_time(uint8_t status, uint8_t note) {
+  midi_tx_flush();
+  size_t len = 0;
+  const uint8_t *bytes = sim_midi_bytes(&len);
+  for (size_t i = 0; i + 2 < len; i += 3) {
+    if (bytes[i] == status && bytes[i + 1] == note)
+      return sim_midi_byte_time_us(i);
+  }
+  return UINT64_MAX;
+}
+
+// gate of a note played from BTN1, with BTN2 pressed 5 ms later
+static uint64_t gate_next_to(bool long_macro) {
+  sim_boot();
+  set_note(0, 60, 50);
+  if (long_macro)
+    process_command("SET_MACRO_SEQ|0|1|Long|0|4|4,0,100,5,0,100,6,0,100,"
+                    "7,0,100");
+
+  uint64_t t = sim_time_us() + 1000;
+  sim_script_button(0, t, 30);
+  sim_script_button(1, t + 5000, 30);
+  sim_run_for_ms(600);
+  return msg_time(0x80, 60) - msg_time(0x90, 60);
+}
+
+void test_sim_midi_gate_during_blocking_macro(void) {
+  uint64_t alone = gate_next_to(false);
+  TEST_ASSERT_TRUE(alone > 48000 && alone < 52000);
+
+  // a key sequence of 400 ms on another key does not hold the note
+  uint64_t with_sequence = gate_next_to(true);
+  TEST_ASSERT_TRUE(with_sequence < alone + 1000);
+  TEST_ASSERT_TRUE(with_sequence + 1000 > alone);
+}
+
+void test_sim_midi_held_notes_overlap(void) {
+  sim_boot();
+  set_note(0, 60, 0);
+  set_note(1, 64, 0);
+  set_note(2, 67, 0);
+
+  // a chord: three keys within a few ms, held for different times
+  uint64_t t = sim_time_us() + 1000;
+  sim_script_button(0, t, 200);
+  sim_script_button(1, t + 2000, 60);
+  sim_script_button(2, t + 4000, 120);
+
+  sim_run_for_ms(8);
+  TEST_ASSERT_EQUAL(1, count_msgs(0x90, 60));
+  TEST_ASSERT_EQUAL(1, count_msgs(0x90, 64));
+  TEST_ASSERT_EQUAL(1, count_msgs(0x90, 67));
+  TEST_ASSERT_EQUAL(3, midi_voice_active());
+
+  // each note ends with its own key
+  sim_run_for_ms(90);
+  TEST_ASSERT_EQUAL(1, count_msgs(0x80, 64));
+  TEST_ASSERT_EQUAL(0, count_msgs(0x80, 60));
+  TEST_ASSERT_EQUAL(0, count_msgs(0x80, 67));
+
+  sim_run_for_ms(200);
+  TEST_ASSERT_EQUAL(1, count_msgs(0x80, 60));
+  TEST_ASSERT_EQUAL(1, count_msgs(0x80, 67));
+  TEST_ASSERT_EQUAL(0, midi_voice_active());
+}
+
+void test_midi_voice_retrigger_and_stealing(void) {
+  sim_boot();
+
+  // the same note again -> Note Off first, one voice
+  midi_voice_note_on(MIDI_VOICE_NO_BUTTON, 40, 100, 0, 0);
+  midi_voice_note_on(MIDI_VOICE_NO_BUTTON, 40, 100, 0, 0);
+  TEST_ASSERT_EQUAL(1, midi_voice_active());
+  TEST_ASSERT_EQUAL(2, count_msgs(0x90, 40));
+  TEST_ASSERT_EQUAL(1, count_msgs(0x80, 40));
+
+  // one note more than voices -> the oldest one stops
+  for (uint8_t n = 0; n < MIDI_MAX_VOICES; n++)
+    midi_voice_note_on(MIDI_VOICE_NO_BUTTON, 50 + n, 100, 0, 0);
+  TEST_ASSERT_EQUAL(MIDI_MAX_VOICES, midi_voice_active());
+  TEST_ASSERT_EQUAL(2, count_msgs(0x80, 40));
+  TEST_ASSERT_EQUAL(0, count_msgs(0x80, 50));
+
+  // long gates wait more than one lap of the wheel
+  midi_voice_all_off();
+  TEST_ASSERT_EQUAL(0, midi_voice_active());
+  sim_clear_records();
+  midi_voice_note_on(MIDI_VOICE_NO_BUTTON, 70, 100, 2, 3 * MIDI_WHEEL_SLOTS);
+  sim_run_for_ms(2 * MIDI_WHEEL_SLOTS);
+  TEST_ASSERT_EQUAL(0, count_msgs(0x82, 70));
+  sim_run_for_ms(2 * MIDI_WHEEL_SLOTS);
+  TEST_ASSERT_EQUAL(1, count_msgs(0x82, 70));
+}
+
+void run_midi_voice_tests(void) {
+  printf("\n=== MIDI Voice Tests ===\n");
+
+  RUN_TEST(test_sim_midi_gate_from_timer_wheel);
+  RUN_TEST(test_sim_midi_gate_during_blocking_macro);
+  RUN_TEST(test_sim_midi_held_notes_overlap);
+  RUN_TEST(test_midi_voice_retrigger_and_stealing);
+}
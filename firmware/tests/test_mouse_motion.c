@@ -0,0 +1,160 @@
+/*
+ * mouse motion engine tests - exact sub-pixel paths, proportional axes,
+ * curves, full poll rate moves, absolute digitizer reports (real firmware
+ * sources)
+ */
+
+#include "unity/unity.h"
+
+#include "executor/macro_executor.h"
+#include "executor/mouse_motion.h"
+#include "macro_config.h"
+#include "sim/sim.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static uint16_t motion_value(uint8_t curve, uint8_t speed, int8_t bend) {
+  return (uint16_t)(curve | (speed << 3) | ((uint8_t)bend << 8));
+}
+
+void test_motion_linear_keeps_axes_proportional(void) {
+  mouse_motion_t m;
+  mouse_motion_init(&m, 1000, -333, 0);
+
+  int32_t x = 0, y = 0;
+  int reports = 0;
+  int8_t dx, dy;
+  while (mouse_motion_next(&m, &dx, &dy)) {
+    x += dx;
+    y += dy;
+    reports++;
+
+    // on the line within half a pixel (no drift from rounding)
+    int32_t expect_y = -(x * 333 + 500) / 1000;
+    TEST_ASSERT_LESS_THAN(2, abs(y - expect_y));
+    TEST_ASSERT_TRUE(dx <= MOTION_DEFAULT_SPEED);
+  }
+
+  TEST_ASSERT_EQUAL(1000, x);
+  TEST_ASSERT_EQUAL(-333, y);
+  TEST_ASSERT_EQUAL(1000 / MOTION_DEFAULT_SPEED, reports);
+}
+
+void test_motion_curves_end_exactly(void) {
+  mouse_motion_t m;
+  int8_t dx, dy;
+  int32_t x = 0, y = 0;
+
+  // ease-in-out: slow start, fast middle
+  mouse_motion_init(&m, 600, 0, motion_value(MOTION_CURVE_EASE_IN_OUT, 8, 0));
+  int first = 0, peak = 0;
+  while (mouse_motion_next(&m, &dx, &dy)) {
+    if (m.step == 1)
+      first = dx;
+    if (dx > peak)
+      peak = dx;
+    x += dx;
+  }
+  TEST_ASSERT_EQUAL(600, x);
+  TEST_ASSERT_LESS_THAN(2, first);
+  TEST_ASSERT_TRUE(peak >= 8);
+
+  // Bezier arc: leaves the straight line, lands on the target
+  x = 0;
+  int32_t max_side = 0;
+  mouse_motion_init(&m, 400, 0, motion_value(MOTION_CURVE_BEZIER, 0, 25));
+  while (mouse_motion_next(&m, &dx, &dy)) {
+    x += dx;
+    y += dy;
+    if (abs(y) > max_side)
+      max_side = abs(y);
+  }
+  TEST_ASSERT_EQUAL(400, x);
+  TEST_ASSERT_EQUAL(0, y);
+  TEST_ASSERT_TRUE(max_side > 50);
+
+  // speeds above a report are split, nothing is lost
+  x = 0;
+  y = 0;
+  mouse_motion_init(&m, -32000, 32000, motion_value(0, 31, 0));
+  while (mouse_motion_next(&m, &dx, &dy)) {
+    x += dx;
+    y += dy;
+  }
+  TEST_ASSERT_EQUAL(-32000, x);
+  TEST_ASSERT_EQUAL(32000, y);
+}
+
+void test_sim_mouse_move_at_poll_rate(void) {
+  sim_boot();
+  macro_entry_t *macro = &config_get()->layers[0].macros[0];
+  macro->type = MACRO_TYPE_MOUSE_MOVE;
+  macro->value = 0;
+  macro->move_x = 1000;
+  macro->move_y = 500;
+  macro->repeat_count = 1;
+
+  uint64_t start = sim_time_us();
+  execute_macro(0, 0);
+  uint64_t elapsed = sim_time_us() - start;
+
+  int32_t x = 0, y = 0;
+  size_t reports = 0;
+  for (size_t i = 0; i < sim_hid_report_count(); i++) {
+    const sim_hid_report_t *r = sim_hid_report(i);
+    if (r->report_id != 2 || (r->data[1] == 0 && r->data[2] == 0))
+      continue; // the release report at the end
+    x += (int8_t)r->data[1];
+    y += (int8_t)r->data[2];
+    reports++;
+  }
+
+  TEST_ASSERT_EQUAL(1000, x);
+  TEST_ASSERT_EQUAL(500, y);
+  TEST_ASSERT_EQUAL(1000 / MOTION_DEFAULT_SPEED, (int)reports);
+  TEST_ASSERT_EQUAL(0, sim_hid_dropped_reports());
+  // was 1.6 s with 5 px steps every 8 ms
+  TEST_ASSERT_TRUE(elapsed < 400000);
+}
+
+void test_sim_mouse_move_abs_single_report(void) {
+  sim_boot();
+  macro_entry_t *macro = &config_get()->layers[0].macros[0];
+  macro->type = MACRO_TYPE_MOUSE_MOVE_ABS;
+  macro->value = 1; // left click there
+  macro->move_x = ABS_MOUSE_MAX / 2;
+  macro->move_y = ABS_MOUSE_MAX;
+
+  uint64_t start = sim_time_us();
+  execute_macro(0, 0);
+
+  // jump, press, release - all on the digitizer report
+  int abs_reports = 0;
+  for (size_t i = 0; i < sim_hid_report_count(); i++) {
+    const sim_hid_report_t *r = sim_hid_report(i);
+    if (r->report_id != 3)
+      continue;
+    TEST_ASSERT_EQUAL(ABS_MOUSE_MAX / 2, r->data[1] | (r->data[2] << 8));
+    TEST_ASSERT_EQUAL(ABS_MOUSE_MAX, r->data[3] | (r->data[4] << 8));
+    TEST_ASSERT_EQUAL(abs_reports == 1 ? 1 : 0, r->data[0]);
+    abs_reports++;
+  }
+  TEST_ASSERT_EQUAL(3, abs_reports);
+  TEST_ASSERT_EQUAL(0, sim_hid_dropped_reports());
+
+  // the first report already places the cursor
+  const sim_hid_report_t *first = sim_hid_report(0);
+  TEST_ASSERT_EQUAL(3, first->report_id);
+  TEST_ASSERT_LESS_THAN(2 * SIM_HID_INTERVAL_US,
+                        (int)(first->time_us - start));
+}
+
+void run_mouse_motion_tests(void) {
+  printf("\n=== Mouse Motion Tests ===\n");
+
+  RUN_TEST(test_motion_linear_keeps_axes_proportional);
+  RUN_TEST(test_motion_curves_end_exactly);
+  RUN_TEST(test_sim_mouse_move_at_poll_rate);
+  RUN_TEST(test_sim_mouse_move_abs_single_report);
+}
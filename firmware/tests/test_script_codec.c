@@ -0,0 +1,241 @@
+/*
+ * Packed script tests - LZSS stream decoded in parts of any size, checks of
+ * received streams, upload of a packed script larger than the script field,
+ * GET_CONF sending the text, one copy of a script used on every layer and the
+ * CDC pull of a packed script (real firmware sources, the encoder mirrors
+ * lib/utils/script-codec.ts)
+ */
+
+#include "unity/unity.h"
+
+#include "cdc/cdc_dispatcher.h"
+#include "executor/actions/exec_script.h"
+#include "executor/macro_executor.h"
+#include "macro_arena.h"
+#include "macro_config.h"
+#include "script_codec.h"
+#include "sim/sim.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+static char text[MAX_SCRIPT_TEXT];
+static uint8_t packed[MAX_SCRIPT_TEXT];
+static char decoded[MAX_SCRIPT_TEXT + 1];
+
+// greedy LZSS, same stream as the configurator
+static size_t pack(const char *src, uint8_t *out) {
+  size_t len = strlen(src), pos = 0, o = SCRIPT_PACKED_HEADER;
+
+  while (pos < len) {
+    size_t flags_at = o++;
+    uint8_t flags = 0;
+
+    for (int bit = 0; bit < 8 && pos < len; bit++) {
+      size_t best = 0, best_dist = 0;
+      for (size_t d = 1; d <= SCRIPT_LZ_WINDOW && d <= pos; d++) {
+        size_t l = 0;
+        while (l < SCRIPT_LZ_MAX_MATCH && pos + l < len &&
+               src[pos + l - d] == src[pos + l])
+          l++;
+        if (l > best) {
+          best = l;
+          best_dist = d;
+        }
+      }
+
+      if (best >= SCRIPT_LZ_MIN_MATCH) {
+        out[o++] = (uint8_t)((best_dist - 1) & 0xFF);
+        out[o++] = (uint8_t)(((best_dist - 1) >> 8) << 6 |
+                             (best - SCRIPT_LZ_MIN_MATCH));
+        pos += best;
+      } else {
+        flags |= (uint8_t)(1 << bit);
+        out[o++] = (uint8_t)src[pos++];
+      }
+    }
+    out[flags_at] = flags;
+  }
+
+  out[0] = SCRIPT_PACKED_MAGIC;
+  out[1] = (uint8_t)(len & 0xFF);
+  out[2] = (uint8_t)(len >> 8);
+  out[3] = (uint8_t)((o - SCRIPT_PACKED_HEADER) & 0xFF);
+  out[4] = (uint8_t)((o - SCRIPT_PACKED_HEADER) >> 8);
+  return o;
+}
+
+// a shell script of about 6 KB with some UTF-8, 2-4x smaller packed
+static void make_text(void) {
+  memset(text, 0, sizeof(text));
+  for (int i = 0; strlen(text) + 80 < 6000; i++) {
+    char line[80];
+    snprintf(line, sizeof(line),
+             "echo \"krok %d: zażółć gęślą jaźń\" >> /tmp/talos.log\n", i);
+    strcat(text, line);
+  }
+}
+
+static size_t read_all(const char *stored, size_t part) {
+  static script_reader_t reader;
+  size_t total = 0, n;
+
+  script_reader_open(&reader, stored);
+  while ((n = script_reader_read(&reader, decoded + total, part)) > 0)
+    total += n;
+  decoded[total] = '\0';
+  return total;
+}
+
+// the text as SCRIPT_DATA sends it
+static const char *escaped_text(void) {
+  static char out[MAX_SCRIPT_TEXT * 2];
+  size_t o = 0;
+  for (const char *p = text; *p; p++) {
+    if (*p == '\n' || *p == '|' || *p == '\\')
+      out[o++] = '\\';
+    out[o++] = *p == '\n' ? 'n' : *p;
+  }
+  out[o] = '\0';
+  return out;
+}
+
+static int count_ok(void) {
+  int n = 0;
+  for (const char *p = sim_cdc_output(); (p = strstr(p, "\nOK")); p++)
+    n++;
+  return n;
+}
+
+static void store_packed(uint8_t platform) {
+  size_t size = pack(text, packed);
+  macro_entry_t *macro = &config_get()->layers[0].macros[0];
+  memset(macro, 0, sizeof(*macro));
+  macro->type = MACRO_TYPE_SCRIPT;
+  macro->script_platform = platform;
+  macro_arena_set(0, 0, ARENA_SLOT_SCRIPT, packed, (uint16_t)size);
+}
+
+void test_script_codec_roundtrip(void) {
+  make_text();
+  size_t size = pack(text, packed);
+
+  TEST_ASSERT_LESS_THAN(MAX_SCRIPT_SIZE, size);
+  TEST_ASSERT_LESS_THAN(strlen(text) / 2, size);
+  TEST_ASSERT_TRUE(script_check((const char *)packed, size));
+  TEST_ASSERT_EQUAL(strlen(text), script_text_len((const char *)packed));
+
+  // any part size, matches span reads
+  const size_t parts[] = {1, 7, 64, MAX_SCRIPT_TEXT};
+  for (size_t i = 0; i < sizeof(parts) / sizeof(parts[0]); i++) {
+    TEST_ASSERT_EQUAL(strlen(text), read_all((const char *)packed, parts[i]));
+    TEST_ASSERT_EQUAL_STRING(text, decoded);
+  }
+
+  // plain text is read as it is
+  TEST_ASSERT_FALSE(script_is_packed("ls -la\n"));
+  TEST_ASSERT_TRUE(script_check("ls -la\n", 7));
+  TEST_ASSERT_EQUAL(7, read_all("ls -la\n", 3));
+  TEST_ASSERT_EQUAL_STRING("ls -la\n", decoded);
+}
+
+void test_script_codec_rejects_broken_streams(void) {
+  strcpy(text, "abcabcabcabc\n");
+  size_t size = pack(text, packed);
+  TEST_ASSERT_TRUE(script_check((const char *)packed, size));
+
+  // truncated upload
+  TEST_ASSERT_FALSE(script_check((const char *)packed, size - 1));
+  TEST_ASSERT_FALSE(script_check((const char *)packed, 3));
+
+  // a match before the start of the text
+  uint8_t bad[] = {SCRIPT_PACKED_MAGIC, 6, 0, 4, 0, 0xFE, 'a', 4, 0};
+  TEST_ASSERT_FALSE(script_check((const char *)bad, sizeof(bad)));
+
+  // text length beyond the limit
+  packed[1] = 0xFF;
+  packed[2] = 0xFF;
+  TEST_ASSERT_FALSE(script_check((const char *)packed, size));
+}
+
+void test_sim_script_packed_upload(void) {
+  sim_boot();
+  make_text();
+  size_t size = pack(text, packed);
+
+  // the body follows READY (the command handler drops earlier input)
+  char cmd[96];
+  snprintf(cmd, sizeof(cmd), "SET_MACRO_SCRIPT|0|1|0|%u|Big|0|0|",
+           (unsigned)size);
+  sim_script_cdc_bytes(sim_time_us() + 100000, packed, size);
+  process_command(cmd);
+  TEST_ASSERT_NOT_NULL(strstr(sim_cdc_output(), "READY"));
+  TEST_ASSERT_NOT_NULL(strstr(sim_cdc_output(), "OK"));
+  const char *stored =
+      (const char *)macro_arena_get(0, 1, ARENA_SLOT_SCRIPT, NULL);
+  TEST_ASSERT_NOT_NULL(stored);
+  TEST_ASSERT_EQUAL(strlen(text), script_text_len(stored));
+
+  // the configurator gets the text back
+  sim_cdc_clear_output();
+  process_command("GET_CONF");
+  const char *data = strstr(sim_cdc_output(), "SCRIPT_DATA|0|1|0|");
+  TEST_ASSERT_NOT_NULL(data);
+  const char *expected = escaped_text();
+  TEST_ASSERT_EQUAL(0, strncmp(data + 18, expected, strlen(expected)));
+
+  // a broken stream is not stored
+  sim_boot();
+  packed[3]++; // longer than what is sent
+  sim_script_cdc_bytes(sim_time_us() + 100000, packed, size);
+  process_command(cmd);
+  TEST_ASSERT_NOT_NULL(strstr(sim_cdc_output(), "ERROR"));
+  TEST_ASSERT_NULL(macro_arena_get(0, 1, ARENA_SLOT_SCRIPT, NULL));
+}
+
+void test_sim_script_shared_across_layers(void) {
+  sim_boot();
+  make_text();
+  size_t size = pack(text, packed);
+  char cmd[96];
+
+  // the same script on all layers takes its space once
+  uint16_t before = macro_arena_free_bytes();
+  for (int layer = 0; layer < config_layer_count(); layer++) {
+    snprintf(cmd, sizeof(cmd), "SET_MACRO_SCRIPT|%d|2|1|%u|Setup|0|0|", layer,
+             (unsigned)size);
+    sim_script_cdc_bytes(sim_time_us() + 100000, packed, size);
+    process_command(cmd);
+  }
+  TEST_ASSERT_EQUAL(config_layer_count(), count_ok());
+  uint16_t used = before - macro_arena_free_bytes();
+  TEST_ASSERT_LESS_THAN(size + 1 + MACRO_ARENA_ALIGN, used);
+
+  // another macro type on one layer keeps the script of the rest
+  process_command("SET_MACRO|0|2|0|4||Key|0");
+  TEST_ASSERT_NULL(macro_arena_get(0, 2, ARENA_SLOT_SCRIPT, NULL));
+  TEST_ASSERT_EQUAL(before - used, macro_arena_free_bytes());
+  TEST_ASSERT_NOT_NULL(macro_arena_get(3, 2, ARENA_SLOT_SCRIPT, NULL));
+}
+
+void test_sim_script_packed_cdc_pull(void) {
+  sim_boot();
+  make_text();
+  store_packed(0 | SCRIPT_DELIVERY_CDC);
+  sim_cdc_input(SCRIPT_READY_SENTINEL "\n" SCRIPT_PULL_REQUEST "\n");
+  execute_macro(0, 0);
+
+  // the whole text, decoded in parts, then the end marker
+  const char *out = strstr(sim_cdc_output(), text);
+  TEST_ASSERT_NOT_NULL(out);
+  TEST_ASSERT_EQUAL_STRING(SCRIPT_PULL_END "\n", out + strlen(text));
+}
+
+void run_script_codec_tests(void) {
+  printf("\n=== Packed Script Tests ===\n");
+  RUN_TEST(test_script_codec_roundtrip);
+  RUN_TEST(test_script_codec_rejects_broken_streams);
+  RUN_TEST(test_sim_script_packed_upload);
+  RUN_TEST(test_sim_script_shared_across_layers);
+  RUN_TEST(test_sim_script_packed_cdc_pull);
+}
@@ -0,0 +1,495 @@
+/*
+ * simulator tests - real firmware sources on the host (see ../sim)
+ *
+ * tests: boot, button to HID report, CDC commands, flash save/load,
+ * migration of an older flash layout, OLED bytes per frame, idle loop
+ * sleeping
+ */
+
+#include "unity/unity.h"
+
+#include "app.h"
+#include "config_migrate.h"
+#include "hardware/flash.h"
+#include "hid/keyboard_layout.h"
+#include "macro_arena.h"
+#include "macro_config.h"
+#include "oled/oled_display.h"
+#include "scheduler/scheduler.h"
+#include "sim/sim.h"
+#include <stddef.h>
+#include <string.h>
+
+#define KEY_A 0x04
+#define KEY_B 0x05
+
+static const sim_hid_report_t *find_key_report(uint8_t keycode) {
+  for (size_t i = 0; i < sim_hid_report_count(); i++) {
+    const sim_hid_report_t *r = sim_hid_report(i);
+    if (r->report_id == 1 && r->data[2] == keycode)
+      return r;
+  }
+  return NULL;
+}
+
+// ==================== BOOT ====================
+
+void test_sim_boot_writes_factory_defaults(void) {
+  sim_reset();
+  app_init();
+
+  // empty flash -> defaults saved once
+  TEST_ASSERT_EQUAL(FLASH_SECTOR_SIZE_CALC / 4096,
+                    sim_flash_stats()->sectors_erased);
+  TEST_ASSERT_EQUAL(0, sim_flash_stats()->misaligned_ops);
+  TEST_ASSERT_EQUAL(MACRO_TYPE_LAYER_TOGGLE, config_get_macro(0, 6)->type);
+}
+
+// ==================== BUTTONS ====================
+
+void test_sim_button_press_sends_key(void) {
+  sim_boot();
+  config_get()->layers[0].macros[0].value = KEY_A;
+
+  uint64_t press_at = sim_time_us() + 10000;
+  sim_script_button(0, press_at, 50);
+  sim_run_for_ms(300);
+
+  const sim_hid_report_t *r = find_key_report(KEY_A);
+  TEST_ASSERT_NOT_NULL(r);
+  TEST_ASSERT_TRUE(r->time_us >= press_at);
+  TEST_ASSERT_LESS_THAN(10000, (int)(r->time_us - press_at)); // < 10ms
+
+  // last report releases the key
+  const sim_hid_report_t *last = sim_hid_report(sim_hid_report_count() - 1);
+  TEST_ASSERT_EQUAL(0, last->data[2]);
+}
+
+void test_sim_held_button_runs_macro_once(void) {
+  sim_boot();
+  config_get()->layers[0].macros[0].value = KEY_A;
+
+  sim_script_button(0, sim_time_us() + 1000, 500);
+  sim_run_for_ms(800);
+
+  int presses = 0;
+  for (size_t i = 0; i < sim_hid_report_count(); i++) {
+    if (sim_hid_report(i)->data[2] == KEY_A)
+      presses++;
+  }
+  TEST_ASSERT_EQUAL(1, presses);
+}
+
+// ==================== CDC ====================
+
+void test_sim_cdc_get_sched(void) {
+  sim_boot();
+  sim_cdc_input("GET_SCHED\n");
+  sim_run_for_ms(20);
+
+  TEST_ASSERT_NOT_NULL(strstr(sim_cdc_output(), "SCHED_START"));
+  TEST_ASSERT_NOT_NULL(strstr(sim_cdc_output(), "SCHED_TASK|usb|"));
+  TEST_ASSERT_NOT_NULL(strstr(sim_cdc_output(), "SCHED_TASK|oled_ui|"));
+  TEST_ASSERT_NOT_NULL(strstr(sim_cdc_output(), "SCHED_END"));
+
+  // all app tasks registered, room left for the profiler stream task
+  TEST_ASSERT_LESS_THAN(SCHED_MAX_TASKS, sched_task_count());
+}
+
+void test_sim_cdc_unknown_command(void) {
+  sim_boot();
+  sim_cdc_input("NOT_A_COMMAND\n");
+  sim_run_for_ms(20);
+
+  TEST_ASSERT_NOT_NULL(strstr(sim_cdc_output(), "ERROR|Unknown command"));
+}
+
+// ==================== FLASH ====================
+
+void test_sim_save_flash_roundtrip(void) {
+  sim_boot();
+  strcpy(config_get()->layers[1].name, "Studio");
+
+  sim_cdc_input("SAVE_FLASH\n");
+  sim_run_for_ms(50);
+  TEST_ASSERT_NOT_NULL(strstr(sim_cdc_output(), "OK"));
+  TEST_ASSERT_EQUAL(FLASH_SECTOR_SIZE_CALC / 4096,
+                    sim_flash_stats()->sectors_erased);
+
+  // reload from flash drops the unsaved change
+  strcpy(config_get()->layers[1].name, "Changed");
+  config_init();
+  TEST_ASSERT_EQUAL_STRING("Studio", config_get()->layers[1].name);
+}
+
+// layout 1 image (no version field) as the older firmware saved it
+static void flash_v1_image(void) {
+  static config_v1_t old;
+  memset(&old, 0, sizeof(old));
+  strcpy(old.layer_names[2], "Work");
+  old.layer_emojis[2] = 5;
+  old.global_text_platform = 2;
+  old.oled_timeout_s = 60;
+
+  macro_entry_v1_t *text = &old.macros[0][0];
+  text->type = MACRO_TYPE_TEXT_STRING;
+  strcpy(text->macro_string, "hello");
+  strcpy(text->name, "Hi");
+
+  macro_entry_v1_t *seq = &old.macros[1][3];
+  seq->type = MACRO_TYPE_KEY_SEQUENCE;
+  seq->sequence[0] = (key_step_t){KEY_A, MODIFIER_LEFT_CTRL, 10};
+  seq->sequence[1] = (key_step_t){KEY_B, 0, 0};
+  seq->sequence_length = 2;
+
+  macro_entry_v1_t *script = &old.macros[2][4];
+  script->type = MACRO_TYPE_SCRIPT;
+  strcpy(script->script, "ls -la\n");
+  script->script_platform = 1;
+  script->terminal_shortcut[0] = (key_step_t){KEY_A, MODIFIER_LEFT_GUI, 0};
+  script->terminal_shortcut_length = 1;
+
+  old.crc32 = config_crc32((const uint8_t *)&old, offsetof(config_v1_t, crc32));
+  memcpy(sim_flash_memory + FLASH_TARGET_OFFSET, &old, sizeof(old));
+}
+
+void test_sim_flash_migrates_v1_layout(void) {
+  sim_reset();
+  flash_v1_image();
+  app_init();
+
+  // layers, macros and their sequences and scripts are kept
+  config_data_t *config = config_get();
+  TEST_ASSERT_EQUAL_STRING("Work", config->layers[2].name);
+  TEST_ASSERT_EQUAL(5, config->layers[2].emoji);
+  TEST_ASSERT_EQUAL_STRING("hello", config->layers[0].macros[0].macro_string);
+  TEST_ASSERT_EQUAL(2, config->global_text_platform);
+  TEST_ASSERT_EQUAL(60, config->oled_timeout_s);
+  uint16_t steps = 0;
+  const key_step_t *seq =
+      macro_arena_steps(1, 3, ARENA_SLOT_SEQUENCE, &steps);
+  TEST_ASSERT_EQUAL(2, steps);
+  TEST_ASSERT_EQUAL(KEY_B, seq[1].keycode);
+  TEST_ASSERT_EQUAL_STRING(
+      "ls -la\n",
+      (const char *)macro_arena_get(2, 4, ARENA_SLOT_SCRIPT, NULL));
+  macro_arena_steps(2, 4, ARENA_SLOT_SHORTCUT, &steps);
+  TEST_ASSERT_EQUAL(1, steps);
+
+  // fields the old layout did not have start from the defaults
+  TEST_ASSERT_EQUAL(KB_LAYOUT_US, config->kb_layout);
+
+  // saved in the new layout at once, the next boot reads it directly
+  const config_data_t *flash =
+      (const config_data_t *)(XIP_BASE + FLASH_TARGET_OFFSET);
+  TEST_ASSERT_EQUAL(CONFIG_VERSION, flash->version);
+  config_init();
+  TEST_ASSERT_EQUAL_STRING("Work", config->layers[2].name);
+  TEST_ASSERT_EQUAL(1, config->layers[2].macros[4].script_platform);
+}
+
+// image of a versioned layout: CRC over everything after the crc32 field
+static void flash_image(void *image, size_t size) {
+  uint8_t *bytes = image;
+  *(uint32_t *)bytes = config_crc32(bytes + sizeof(uint32_t),
+                                    size - sizeof(uint32_t));
+  memcpy(sim_flash_memory + FLASH_TARGET_OFFSET, bytes, size);
+}
+
+void test_sim_flash_migrates_v2_layout(void) {
+  static config_v2_t old;
+  memset(&old, 0, sizeof(old));
+  old.version = 2;
+  strcpy(old.layer_names[1], "Code");
+  old.kb_layout = KB_LAYOUT_DE;
+  old.macros[1][2].type = MACRO_TYPE_TEXT_STRING;
+  strcpy(old.macros[1][2].macro_string, "hallo");
+
+  sim_reset();
+  flash_image(&old, sizeof(old));
+  app_init();
+
+  config_data_t *config = config_get();
+  TEST_ASSERT_EQUAL_STRING("Code", config->layers[1].name);
+  TEST_ASSERT_EQUAL(KB_LAYOUT_DE, config->kb_layout);
+  TEST_ASSERT_EQUAL_STRING("hallo", config->layers[1].macros[2].macro_string);
+  // unicode timings are new in version 3
+  TEST_ASSERT_EQUAL(100, config->unicode_timing[2].settle_ms);
+}
+
+void test_sim_flash_migrates_v3_layout(void) {
+  static config_v3_t old;
+  memset(&old, 0, sizeof(old));
+  old.version = 3;
+  strcpy(old.layer_names[3], "Mac");
+  old.unicode_timing[2] = (unicode_timing_t){UNICODE_MODE_HEX_INPUT, 40, 3, 7};
+
+  sim_reset();
+  flash_image(&old, sizeof(old));
+  app_init();
+
+  config_data_t *config = config_get();
+  TEST_ASSERT_EQUAL_STRING("Mac", config->layers[3].name);
+  TEST_ASSERT_EQUAL(UNICODE_MODE_HEX_INPUT, config->unicode_timing[2].mode);
+  TEST_ASSERT_EQUAL(40, config->unicode_timing[2].settle_ms);
+  // the program arena is new in version 4
+  TEST_ASSERT_EQUAL(0, config->arena.used);
+  TEST_ASSERT_EQUAL(MACRO_ARENA_SIZE, macro_arena_free_bytes());
+}
+
+void test_sim_flash_migrates_full_v4_arena(void) {
+  // worst case: the old arena is full and every other macro has 5 steps
+  static config_v4_t old;
+  memset(&old, 0, sizeof(old));
+  old.version = 4;
+  for (uint8_t l = 0; l < CONFIG_V1_LAYERS; l++) {
+    for (uint8_t b = 0; b < NUM_BUTTONS; b++) {
+      macro_entry_v1_t *macro = &old.macros[l][b];
+      if (b < 3) {
+        // odd lengths, every program gets padded when it moves
+        uint16_t len = l == 3 && b == 2 ? CONFIG_V4_ARENA_SIZE - old.arena.used
+                                        : 341;
+        macro->type = MACRO_TYPE_PROGRAM;
+        old.arena.refs[l][b] = (arena_ref_t){old.arena.used, len};
+        memset(&old.arena.data[old.arena.used], l * NUM_BUTTONS + b, len);
+        old.arena.used += len;
+      } else {
+        macro->type = b == 6 ? MACRO_TYPE_SCRIPT : MACRO_TYPE_KEY_SEQUENCE;
+        for (int i = 0; i < CONFIG_V1_SEQUENCE_STEPS; i++)
+          macro->sequence[i] = macro->terminal_shortcut[i] =
+              (key_step_t){KEY_A + i, 0, 10};
+        macro->sequence_length = macro->terminal_shortcut_length =
+            CONFIG_V1_SEQUENCE_STEPS;
+      }
+    }
+  }
+  TEST_ASSERT_EQUAL(CONFIG_V4_ARENA_SIZE, old.arena.used);
+
+  sim_reset();
+  flash_image(&old, sizeof(old));
+  app_init();
+
+  // nothing is dropped
+  uint16_t len = 0;
+  const uint8_t *code = macro_arena_get(3, 2, ARENA_SLOT_PROGRAM, &len);
+  TEST_ASSERT_EQUAL(CONFIG_V4_ARENA_SIZE - 11 * 341, len);
+  TEST_ASSERT_EQUAL(3 * NUM_BUTTONS + 2, code[len - 1]);
+  code = macro_arena_get(1, 0, ARENA_SLOT_PROGRAM, &len);
+  TEST_ASSERT_EQUAL(341, len);
+  TEST_ASSERT_EQUAL(NUM_BUTTONS, code[0]);
+  macro_arena_steps(3, 5, ARENA_SLOT_SEQUENCE, &len);
+  TEST_ASSERT_EQUAL(CONFIG_V1_SEQUENCE_STEPS, len);
+  macro_arena_steps(3, 6, ARENA_SLOT_SHORTCUT, &len);
+  TEST_ASSERT_EQUAL(CONFIG_V1_SEQUENCE_STEPS, len);
+  TEST_ASSERT_EQUAL(CONFIG_VERSION,
+                    ((config_data_t *)(XIP_BASE + FLASH_TARGET_OFFSET))
+                        ->version);
+}
+
+void test_sim_flash_migrates_v5_layout(void) {
+  static config_v5_t old;
+  memset(&old, 0, sizeof(old));
+  old.version = 5;
+  old.macros[0][1].type = MACRO_TYPE_KEY_SEQUENCE;
+  const key_step_t steps[] = {{KEY_A, 0, 10}, {KEY_B, 0, 10}};
+  memcpy(old.arena.data, steps, sizeof(steps));
+  old.arena.refs[0][1][ARENA_SLOT_SEQUENCE] = (arena_ref_t){0, sizeof(steps)};
+  old.macros[2][0].type = MACRO_TYPE_PROGRAM;
+  memcpy(&old.arena.data[8], "\x03\x04\x00", 3);
+  old.arena.refs[2][0][ARENA_SLOT_PROGRAM] = (arena_ref_t){8, 3};
+  old.arena.used = 12;
+
+  sim_reset();
+  flash_image(&old, sizeof(old));
+  app_init();
+
+  uint16_t len = 0;
+  const key_step_t *seq = macro_arena_steps(0, 1, ARENA_SLOT_SEQUENCE, &len);
+  TEST_ASSERT_EQUAL(2, len);
+  TEST_ASSERT_EQUAL(KEY_B, seq[1].keycode);
+  const uint8_t *code = macro_arena_get(2, 0, ARENA_SLOT_PROGRAM, &len);
+  TEST_ASSERT_EQUAL(3, len);
+  TEST_ASSERT_EQUAL(KEY_A, code[1]);
+  // sequence timings are new in version 6
+  TEST_ASSERT_EQUAL(20, config_get()->seq_timing[2].hold_ms);
+}
+
+void test_sim_flash_migrates_v6_layout(void) {
+  static config_v6_t old;
+  memset(&old, 0, sizeof(old));
+  old.version = 6;
+  old.macros[1][1].type = MACRO_TYPE_SCRIPT;
+  strcpy(old.macros[1][1].script, "echo hi\n");
+  old.seq_timing[1] = (seq_timing_t){30, 15, 5, 0};
+
+  sim_reset();
+  flash_image(&old, sizeof(old));
+  app_init();
+
+  // plain text scripts stay readable, the timing profile is kept
+  config_data_t *config = config_get();
+  TEST_ASSERT_EQUAL_STRING(
+      "echo hi\n", (const char *)macro_arena_get(1, 1, ARENA_SLOT_SCRIPT, NULL));
+  TEST_ASSERT_EQUAL(30, config->seq_timing[1].hold_ms);
+  TEST_ASSERT_EQUAL(15, config->seq_timing[1].gap_ms);
+  TEST_ASSERT_EQUAL(CONFIG_VERSION,
+                    ((config_data_t *)(XIP_BASE + FLASH_TARGET_OFFSET))
+                        ->version);
+}
+
+void test_sim_flash_migrates_v8_layout(void) {
+  static config_v8_t old;
+  memset(&old, 0, sizeof(old));
+  old.version = 8;
+  strcpy(old.layer_names[3], "Edit");
+  old.macros[0][5].type = MACRO_TYPE_SCRIPT;
+  old.macros[3][5].type = MACRO_TYPE_SCRIPT;
+  memcpy(old.arena.data, "make\n", 6);
+  old.arena.refs[0][5][ARENA_SLOT_SCRIPT] = (arena_ref_t){0, 6};
+  old.arena.refs[3][5][ARENA_SLOT_SCRIPT] = (arena_ref_t){0, 6};
+  old.arena.used = 8;
+
+  sim_reset();
+  flash_image(&old, sizeof(old));
+  app_init();
+
+  // four layers from the fixed tables, the shared script still stored once
+  TEST_ASSERT_EQUAL(4, config_layer_count());
+  TEST_ASSERT_EQUAL_STRING("Edit", config_get_layer(3)->name);
+  TEST_ASSERT_TRUE(macro_arena_get(0, 5, ARENA_SLOT_SCRIPT, NULL) ==
+                   macro_arena_get(3, 5, ARENA_SLOT_SCRIPT, NULL));
+  TEST_ASSERT_EQUAL_STRING(
+      "make\n", (const char *)macro_arena_get(3, 5, ARENA_SLOT_SCRIPT, NULL));
+  TEST_ASSERT_EQUAL(CONFIG_VERSION,
+                    ((config_data_t *)(XIP_BASE + FLASH_TARGET_OFFSET))
+                        ->version);
+}
+
+// every macro a script of nearly MAX_SCRIPT_SIZE, distinct unless shared
+static void flash_v7_scripts(config_v6_t *old, bool shared) {
+  memset(old, 0, sizeof(*old));
+  old->version = 7;
+  for (int l = 0; l < CONFIG_V1_LAYERS; l++) {
+    for (int b = 0; b < NUM_BUTTONS; b++) {
+      macro_entry_v5_t *macro = &old->macros[l][b];
+      macro->type = MACRO_TYPE_SCRIPT;
+      memset(macro->script, '#', MAX_SCRIPT_SIZE - 1);
+      macro->script[0] = shared ? 'A' : (char)('A' + l * NUM_BUTTONS + b);
+    }
+  }
+  sim_reset();
+  flash_image(old, sizeof(*old));
+}
+
+void test_sim_flash_migration_keeps_old_layout_on_overflow(void) {
+  static config_v6_t old;
+  flash_v7_scripts(&old, false);
+  app_init();
+
+  // 28 distinct scripts do not fit: the old sector stays and is reported
+  TEST_ASSERT_EQUAL(0, sim_flash_stats()->sectors_erased);
+  TEST_ASSERT_EQUAL_MEMORY(&old, sim_flash_memory + FLASH_TARGET_OFFSET,
+                           sizeof(old));
+  TEST_ASSERT_EQUAL(7, config_unmigrated_version());
+  sim_cdc_input("GET_CONF\n");
+  sim_run_for_ms(50);
+  TEST_ASSERT_NOT_NULL(strstr(sim_cdc_output(), "MIGRATION_FAILED|7"));
+
+  // what fit is usable, a save by the user replaces the old layout
+  TEST_ASSERT_EQUAL_STRING(
+      old.macros[0][0].script,
+      (const char *)macro_arena_get(0, 0, ARENA_SLOT_SCRIPT, NULL));
+  TEST_ASSERT_TRUE(config_save());
+  TEST_ASSERT_EQUAL(0, config_unmigrated_version());
+}
+
+void test_sim_flash_migration_interns_shared_scripts(void) {
+  static config_v6_t old;
+  flash_v7_scripts(&old, true);
+  app_init();
+
+  // the same script on every button is stored once and fits
+  TEST_ASSERT_EQUAL(0, config_unmigrated_version());
+  TEST_ASSERT_EQUAL(CONFIG_VERSION,
+                    ((config_data_t *)(XIP_BASE + FLASH_TARGET_OFFSET))
+                        ->version);
+  TEST_ASSERT_EQUAL_STRING(
+      old.macros[3][6].script,
+      (const char *)macro_arena_get(3, 6, ARENA_SLOT_SCRIPT, NULL));
+}
+
+void test_sim_flash_unknown_layout_resets(void) {
+  // a broken old image is not taken over
+  sim_reset();
+  flash_v1_image();
+  sim_flash_memory[FLASH_TARGET_OFFSET] ^= 0x01;
+  app_init();
+  TEST_ASSERT_EQUAL_STRING("", config_get()->layers[2].name);
+
+  // neither is a layout of a newer firmware
+  strcpy(config_get()->layers[2].name, "Work");
+  config_save();
+  ((config_data_t *)(XIP_BASE + FLASH_TARGET_OFFSET))->version++;
+  config_init();
+  TEST_ASSERT_EQUAL_STRING("", config_get()->layers[2].name);
+  TEST_ASSERT_EQUAL(CONFIG_VERSION,
+                    ((config_data_t *)(XIP_BASE + FLASH_TARGET_OFFSET))
+                        ->version);
+}
+
+// ==================== OLED ====================
+
+void test_sim_oled_frame_bytes(void) {
+  sim_boot();
+
+  oled_update();
+
+  // 6 addressing commands + full 128x64 framebuffer
+  TEST_ASSERT_EQUAL(6 + OLED_WIDTH * OLED_HEIGHT / 8, (int)sim_spi_bytes());
+}
+
+// ==================== IDLE ====================
+
+void test_sim_idle_loop_sleeps(void) {
+  sim_boot();
+  sim_run_for_ms(100); // settle after boot
+  sched_reset_stats();
+
+  sim_run_for_ms(10000);
+
+  uint32_t passes = 0;
+  sched_get_loop_stats(&passes, NULL, NULL);
+  TEST_ASSERT_GREATER_THAN(0, (int)passes);
+  TEST_ASSERT_LESS_THAN(100, (int)passes); // woken ~once per second
+  TEST_ASSERT_GREATER_THAN(0, (int)sim_watchdog_updates());
+}
+
+// ==================== RUNNER ====================
+
+void run_sim_app_tests(void) {
+  printf("\n=== Simulator App Tests ===\n");
+
+  RUN_TEST(test_sim_boot_writes_factory_defaults);
+
+  RUN_TEST(test_sim_button_press_sends_key);
+  RUN_TEST(test_sim_held_button_runs_macro_once);
+
+  RUN_TEST(test_sim_cdc_get_sched);
+  RUN_TEST(test_sim_cdc_unknown_command);
+
+  RUN_TEST(test_sim_save_flash_roundtrip);
+  RUN_TEST(test_sim_flash_migrates_v1_layout);
+  RUN_TEST(test_sim_flash_migrates_v2_layout);
+  RUN_TEST(test_sim_flash_migrates_v3_layout);
+  RUN_TEST(test_sim_flash_migrates_full_v4_arena);
+  RUN_TEST(test_sim_flash_migrates_v5_layout);
+  RUN_TEST(test_sim_flash_migrates_v6_layout);
+  RUN_TEST(test_sim_flash_migrates_v8_layout);
+  RUN_TEST(test_sim_flash_migration_keeps_old_layout_on_overflow);
+  RUN_TEST(test_sim_flash_migration_interns_shared_scripts);
+  RUN_TEST(test_sim_flash_unknown_layout_resets);
+
+  RUN_TEST(test_sim_oled_frame_bytes);
+
+  RUN_TEST(test_sim_idle_loop_sleeps);
+}
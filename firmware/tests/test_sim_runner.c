@@ -0,0 +1,53 @@
+/*
+ * simulator test runner - real firmware sources linked against ../sim
+ *
+ * cd build && cmake .. && make
+ * ./run_sim_tests
+ */
+
+#include "unity/unity.h"
+#include <stdio.h>
+
+extern void run_sim_app_tests(void);
+extern void run_keyboard_layout_tests(void);
+extern void run_text_stream_tests(void);
+extern void run_macro_vm_tests(void);
+extern void run_key_sequence_tests(void);
+extern void run_macro_recorder_tests(void);
+extern void run_mouse_motion_tests(void);
+extern void run_exec_media_tests(void);
+extern void run_midi_voice_tests(void);
+extern void run_midi_rx_tests(void);
+extern void run_midi_clock_tests(void);
+extern void run_midi_cc_tests(void);
+extern void run_midi_tx_tests(void);
+extern void run_exec_script_tests(void);
+extern void run_script_codec_tests(void);
+extern void run_layer_tests(void);
+
+int main(void) {
+  printf("================================================\n");
+  printf("       TALOS 7 FIRMWARE SIMULATOR TESTS\n");
+  printf("================================================\n");
+
+  UNITY_BEGIN();
+
+  run_sim_app_tests();
+  run_keyboard_layout_tests();
+  run_text_stream_tests();
+  run_macro_vm_tests();
+  run_key_sequence_tests();
+  run_macro_recorder_tests();
+  run_mouse_motion_tests();
+  run_exec_media_tests();
+  run_midi_voice_tests();
+  run_midi_rx_tests();
+  run_midi_clock_tests();
+  run_midi_cc_tests();
+  run_midi_tx_tests();
+  run_exec_script_tests();
+  run_script_codec_tests();
+  run_layer_tests();
+
+  return UNITY_END();
+}
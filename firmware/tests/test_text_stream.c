@@ -0,0 +1,236 @@
+/*
+ * text stream tests - precompiled HID report streams of text macros,
+ * cache rebuild on SET_MACRO, replay vs live typing, unicode input
+ */
+
+#include "unity/unity.h"
+
+#include "executor/actions/exec_text.h"
+#include "executor/macro_executor.h"
+#include "executor/text_stream.h"
+#include "hid/keyboard_layout.h"
+#include "macro_config.h"
+#include "sim/sim.h"
+#include <string.h>
+
+static void set_text_macro(uint8_t layer, uint8_t button, const char *text) {
+  macro_entry_t *macro = &config_get()->layers[layer].macros[button];
+  memset(macro, 0, sizeof(*macro));
+  macro->type = MACRO_TYPE_TEXT_STRING;
+  strcpy(macro->macro_string, text);
+}
+
+// ==================== COMPILER ====================
+
+void test_text_stream_ascii_compiles_to_taps(void) {
+  uint8_t buf[32];
+  text_stream_t s;
+  text_stream_init(&s, buf, sizeof(buf));
+
+  TEST_ASSERT_TRUE(text_stream_compile(&s, "aB", KB_LAYOUT_US, 0));
+  TEST_ASSERT_FALSE(s.used_unicode);
+  TEST_ASSERT_EQUAL(6, s.len);
+  TEST_ASSERT_EQUAL(TS_OP_TAP, buf[0]);
+  TEST_ASSERT_EQUAL(0, buf[1]);
+  TEST_ASSERT_EQUAL(0x04, buf[2]);
+  TEST_ASSERT_EQUAL(TS_OP_TAP, buf[3]);
+  TEST_ASSERT_EQUAL(MODIFIER_LEFT_SHIFT, buf[4]);
+  TEST_ASSERT_EQUAL(0x05, buf[5]);
+}
+
+void test_text_stream_overflow_is_reported(void) {
+  uint8_t buf[4];
+  text_stream_t s;
+  text_stream_init(&s, buf, sizeof(buf));
+
+  TEST_ASSERT_FALSE(text_stream_compile(&s, "abc", KB_LAYOUT_US, 0));
+  TEST_ASSERT_TRUE(s.overflow);
+  TEST_ASSERT_EQUAL(3, s.len);
+
+  // worst case codepoint fits the per codepoint buffer on every platform
+  uint8_t big[TEXT_STREAM_CODEPOINT_MAX];
+  for (uint8_t p = 0; p < TEXT_STREAM_PLATFORMS; p++) {
+    text_stream_init(&s, big, sizeof(big));
+    TEST_ASSERT_TRUE(text_stream_compile_codepoint(&s, 0x10FFFF,
+                                                   KB_LAYOUT_US, p));
+  }
+}
+
+// ==================== CACHE ====================
+
+void test_sim_text_stream_cached_on_set_macro(void) {
+  sim_boot();
+
+  sim_cdc_input("SET_MACRO|0|1|1|0|hello|Hi|0\n");
+  sim_run_for_ms(20);
+  TEST_ASSERT_NOT_NULL(strstr(sim_cdc_output(), "OK"));
+
+  uint16_t used = 0;
+  uint8_t cached = 0;
+  text_stream_cache_stats(&used, &cached);
+  TEST_ASSERT_TRUE(cached >= 1);
+  TEST_ASSERT_TRUE(used >= 5 * 3);
+}
+
+void test_sim_text_stream_ascii_shared_across_platforms(void) {
+  sim_boot();
+  for (uint8_t layer = 0; layer < config_layer_count(); layer++)
+    for (uint8_t btn = 0; btn < NUM_BUTTONS; btn++)
+      config_get()->layers[layer].macros[btn].type = MACRO_TYPE_KEY_PRESS;
+
+  set_text_macro(0, 0, "abc");
+  text_stream_cache_rebuild();
+
+  // one stream for all three platforms
+  uint16_t used = 0;
+  text_stream_cache_stats(&used, NULL);
+  TEST_ASSERT_EQUAL(3 * 3, used);
+
+  // unicode needs one stream per platform
+  set_text_macro(0, 0, "€");
+  text_stream_cache_rebuild();
+  uint16_t unicode_used = 0;
+  text_stream_cache_stats(&unicode_used, NULL);
+  TEST_ASSERT_TRUE(unicode_used > 3 * 9);
+}
+
+void test_sim_text_stream_replay_matches_live_typing(void) {
+  sim_boot();
+  set_text_macro(0, 0, "Hi!");
+  text_stream_cache_rebuild();
+
+  sim_clear_records();
+  TEST_ASSERT_TRUE(text_stream_cache_play(0, 0, 0));
+  size_t cached_count = sim_hid_report_count();
+  uint8_t cached_keys[16];
+  for (size_t i = 0; i < cached_count && i < sizeof(cached_keys); i++)
+    cached_keys[i] = sim_hid_report(i)->data[2];
+
+  sim_clear_records();
+  exec_type_text_auto("Hi!");
+
+  // live typing adds one trailing release
+  TEST_ASSERT_EQUAL(cached_count + 1, sim_hid_report_count());
+  for (size_t i = 0; i < cached_count; i++)
+    TEST_ASSERT_EQUAL(cached_keys[i], sim_hid_report(i)->data[2]);
+  TEST_ASSERT_EQUAL(0, sim_hid_dropped_reports());
+}
+
+void test_sim_text_stream_stale_edit_rebuilds(void) {
+  sim_boot();
+  set_text_macro(0, 0, "a");
+  text_stream_cache_rebuild();
+
+  // edited without a rebuild -> replay recompiles first
+  strcpy(config_get()->layers[0].macros[0].macro_string, "z");
+  config_get()->kb_layout = KB_LAYOUT_DE;
+
+  sim_clear_records();
+  execute_macro(0, 0);
+  TEST_ASSERT_EQUAL(0x1C, sim_hid_report(0)->data[2]);
+}
+
+// ==================== UNICODE ====================
+
+static void play_text(const char *text, uint8_t platform) {
+  static uint8_t buf[1024];
+  text_stream_t s;
+  text_stream_init(&s, buf, sizeof(buf));
+  TEST_ASSERT_TRUE(text_stream_compile(&s, text, KB_LAYOUT_US, platform));
+
+  sim_clear_records();
+  text_stream_play(buf, s.len);
+}
+
+// every report with keys presses exactly one new key
+static int new_keys(void) {
+  int n = 0;
+  for (size_t i = 0; i < sim_hid_report_count(); i++) {
+    if (sim_hid_report(i)->data[2] != 0)
+      n++;
+  }
+  return n;
+}
+
+void test_sim_unicode_linux_hex_rolls(void) {
+  sim_boot();
+  play_text("€", 0); // U+20ac
+
+  // Ctrl+Shift, +U, up, then 2-0-a-c-space rolling and one release
+  TEST_ASSERT_EQUAL(9, sim_hid_report_count());
+  const sim_hid_report_t *r = sim_hid_report(4);
+  TEST_ASSERT_EQUAL(0x1F, r->data[2]); // '2' still held
+  TEST_ASSERT_EQUAL(0x27, r->data[3]); // '0' goes down
+  TEST_ASSERT_EQUAL(0, sim_hid_report(8)->data[2]);
+  TEST_ASSERT_EQUAL(0, sim_hid_dropped_reports());
+}
+
+void test_sim_unicode_linux_session_reuse(void) {
+  sim_boot();
+  play_text("€€", 0);
+
+  // modifier warm-up only before the first codepoint
+  int warmups = 0;
+  for (size_t i = 0; i < sim_hid_report_count(); i++) {
+    const sim_hid_report_t *r = sim_hid_report(i);
+    if (r->data[0] == 0x03 && r->data[2] == 0)
+      warmups++;
+  }
+  TEST_ASSERT_EQUAL(1, warmups);
+}
+
+void test_sim_unicode_mac_hex_input_session(void) {
+  sim_boot();
+  config_get()->unicode_timing[2].mode = UNICODE_MODE_HEX_INPUT;
+  play_text("€\xF0\x9D\x84\x9E", 2); // U+20AC, U+1D11E (D834 DD1E)
+
+  size_t count = sim_hid_report_count();
+  TEST_ASSERT_EQUAL(4 + 8, new_keys());
+
+  // Option held from the first report until the single release at the end
+  for (size_t i = 0; i + 1 < count; i++)
+    TEST_ASSERT_EQUAL(MODIFIER_LEFT_ALT, sim_hid_report(i)->data[0]);
+  TEST_ASSERT_EQUAL(0, sim_hid_report(count - 1)->data[0]);
+  TEST_ASSERT_EQUAL(0, sim_hid_report(count - 1)->data[2]);
+}
+
+void test_sim_cdc_set_unicode_timing(void) {
+  sim_boot();
+
+  sim_cdc_input("SET_UNICODE_TIMING|2|1|5|0|5\n");
+  sim_run_for_ms(20);
+  TEST_ASSERT_NOT_NULL(strstr(sim_cdc_output(), "OK"));
+  const unicode_timing_t *t = &config_get()->unicode_timing[2];
+  TEST_ASSERT_EQUAL(UNICODE_MODE_HEX_INPUT, t->mode);
+  TEST_ASSERT_EQUAL(5, t->settle_ms);
+  TEST_ASSERT_EQUAL(0, t->key_ms);
+
+  sim_cdc_clear_output();
+  sim_cdc_input("GET_CONF\n");
+  sim_run_for_ms(50);
+  TEST_ASSERT_NOT_NULL(strstr(sim_cdc_output(), "UNICODE_TIMING|2|1|5|0|5"));
+
+  sim_cdc_clear_output();
+  sim_cdc_input("SET_UNICODE_TIMING|3|0|1|1|1\n");
+  sim_run_for_ms(20);
+  TEST_ASSERT_NOT_NULL(strstr(sim_cdc_output(), "ERROR"));
+}
+
+// ==================== RUNNER ====================
+
+void run_text_stream_tests(void) {
+  printf("\n=== Text Stream Tests ===\n");
+
+  RUN_TEST(test_text_stream_ascii_compiles_to_taps);
+  RUN_TEST(test_text_stream_overflow_is_reported);
+
+  RUN_TEST(test_sim_text_stream_cached_on_set_macro);
+  RUN_TEST(test_sim_text_stream_ascii_shared_across_platforms);
+  RUN_TEST(test_sim_text_stream_replay_matches_live_typing);
+  RUN_TEST(test_sim_text_stream_stale_edit_rebuilds);
+
+  RUN_TEST(test_sim_unicode_linux_hex_rolls);
+  RUN_TEST(test_sim_unicode_linux_session_reuse);
+  RUN_TEST(test_sim_unicode_mac_hex_input_session);
+  RUN_TEST(test_sim_cdc_set_unicode_timing);
+}
@@ -7,7 +7,9 @@ import {
   ConnectionStatus,
   ConnectionError,
   MacroEntry,
-  MacroType, ScriptPlatform
+  MacroType, ScriptPlatform,
+  FIRMWARE_CONSTANTS,
+  createDefaultLayer
 } from '@/lib/types/config.types';
 import { ConnectionPanel } from '@/components/device/connection-panel';
 import { LayerTabs } from '@/components/layout/LayerTabs';
@@ -126,6 +128,25 @@ export function Configurator() {
     });
   };
 
+  // layers are added / dropped at the end, the device follows on save
+  const handleAddLayer = () => {
+    if (!config || config.layers.length >= FIRMWARE_CONSTANTS.MAX_LAYERS) return;
+    setConfig({
+      ...config,
+      layers: [...config.layers, createDefaultLayer(config.layers.length)],
+    });
+    setActiveLayer(config.layers.length);
+    setSelectedButton(null);
+  };
+
+  const handleRemoveLayer = () => {
+    if (!config || config.layers.length <= 1) return;
+    const layers = config.layers.slice(0, -1);
+    setConfig({ ...config, layers });
+    setActiveLayer(Math.min(activeLayer, layers.length - 1));
+    setSelectedButton(null);
+  };
+
   const handleMacroChange = async (buttonIndex: number, macro: MacroEntry) => {
     if (!config) return;
 
@@ -189,7 +210,10 @@ export function Configurator() {
         const change = changes[i];
 
         if (change.type === 'setting') {
-          if (change.settingName === 'oledTimeout') {
+          if (change.settingName === 'layerCount') {
+            console.log(`📤 Updating layer count: ${change.value}`);
+            await serialService.setLayerCount(change.value);
+          } else if (change.settingName === 'oledTimeout') {
             console.log(`📤 Updating OLED Timeout: ${change.value}s`);
             await serialService.setOledTimeout(change.value);
           }
@@ -232,6 +256,9 @@ export function Configurator() {
                 macro.moveX,
                 macro.moveY
               );
+              if (macro.type === MacroType.PROGRAM && macro.program) {
+                await serialService.setMacroProgram(change.layer, change.button, macro.program);
+              }
             }
           }
         }
@@ -306,6 +333,8 @@ export function Configurator() {
           setActiveLayer(idx);
           setSelectedButton(null);
         }}
+        onAddLayer={handleAddLayer}
+        onRemoveLayer={handleRemoveLayer}
       />
 
       <LayerSettingsCard
@@ -333,6 +362,7 @@ export function Configurator() {
         buttonIndex={selectedButton}
         macro={selectedButton !== null ? currentLayer.macros[selectedButton] : null}
         layerMacros={currentLayer.macros}
+        layerCount={config.layers.length}
         onClose={() => setSelectedButton(null)}
         onSave={handleMacroChange}
       />
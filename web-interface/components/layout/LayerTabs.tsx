@@ -1,24 +1,57 @@
 'use client';
 
 import { Tabs, TabsList, TabsTrigger } from '@/components/ui/tabs';
+import { Button } from '@/components/ui/button';
 import { FIRMWARE_CONSTANTS } from '@/lib/types/config.types';
 
 interface LayerTabsProps {
   activeLayer: number;
   layerNames: string[];
   onLayerChange: (layer: number) => void;
+  onAddLayer: () => void;
+  onRemoveLayer: () => void;
 }
 
-export function LayerTabs({ activeLayer, layerNames, onLayerChange }: LayerTabsProps) {
+export function LayerTabs({
+  activeLayer,
+  layerNames,
+  onLayerChange,
+  onAddLayer,
+  onRemoveLayer,
+}: LayerTabsProps) {
   return (
-    <Tabs value={activeLayer.toString()} onValueChange={(v) => onLayerChange(parseInt(v))}>
-      <TabsList className="grid w-full grid-cols-4">
-        {Array.from({ length: FIRMWARE_CONSTANTS.MAX_LAYERS }, (_, i) => (
-          <TabsTrigger key={i} value={i.toString()}>
-            {layerNames[i] || `Layer ${i + 1}`}
-          </TabsTrigger>
-        ))}
-      </TabsList>
-    </Tabs>
+    <div className="flex items-center gap-2">
+      <Tabs
+        value={activeLayer.toString()}
+        onValueChange={(v) => onLayerChange(parseInt(v))}
+        className="flex-1"
+      >
+        <TabsList className="flex h-auto w-full flex-wrap">
+          {layerNames.map((name, i) => (
+            <TabsTrigger key={i} value={i.toString()}>
+              {name || `Layer ${i + 1}`}
+            </TabsTrigger>
+          ))}
+        </TabsList>
+      </Tabs>
+      <Button
+        variant="outline"
+        size="sm"
+        onClick={onRemoveLayer}
+        disabled={layerNames.length <= 1}
+        title="Remove the last layer"
+      >
+        −
+      </Button>
+      <Button
+        variant="outline"
+        size="sm"
+        onClick={onAddLayer}
+        disabled={layerNames.length >= FIRMWARE_CONSTANTS.MAX_LAYERS}
+        title="Add a layer"
+      >
+        +
+      </Button>
+    </div>
   );
 }
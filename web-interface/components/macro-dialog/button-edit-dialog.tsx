@@ -19,11 +19,12 @@ import {
   SelectTrigger,
   SelectValue,
 } from '@/components/ui/select';
-import { MAX_SCRIPT_SIZE, ScriptPlatform } from '@/lib/types/config.types';
+import { LAYER_SWITCH, MAX_SCRIPT_TEXT, SCRIPT_DELIVERY_CDC, SCRIPT_PLATFORM_MASK, ScriptPlatform } from '@/lib/types/config.types';
 import { KeySequenceInput } from '@/components/macro-dialog/key-sequence-input';
 import { MacroFormMidi } from '@/components/macro-dialog/forms/macro-form-midi';
 import { MacroFormKeyPress } from '@/components/macro-dialog/forms/macro-form-key-press';
 import { MacroFormMouse } from '@/components/macro-dialog/forms/macro-form-mouse';
+import { MacroFormMedia } from '@/components/macro-dialog/forms/macro-form-media';
 import { MacroFormText } from '@/components/macro-dialog/forms/macro-form-text';
 import { MacroFormScript } from '@/components/macro-dialog/forms/macro-form-script';
 
@@ -32,6 +33,7 @@ interface ButtonEditDialogProps {
   buttonIndex: number | null;
   macro: MacroEntry | null;
   layerMacros: MacroEntry[]; // lista makr do walidacji
+  layerCount: number; // cele skoku / warstwy chwilowej
   onClose: () => void;
   onSave: (buttonIndex: number, macro: MacroEntry) => void;
 }
@@ -43,6 +45,7 @@ export function ButtonEditDialog({
   buttonIndex,
   macro,
   layerMacros,
+  layerCount,
   onClose,
   onSave,
 }: ButtonEditDialogProps) {
@@ -53,6 +56,7 @@ export function ButtonEditDialog({
   const [macroString, setMacroString] = useState('');
   const [scriptContent, setScriptContent] = useState('');
   const [scriptPlatform, setScriptPlatform] = useState<ScriptPlatform>(ScriptPlatform.LINUX);
+  const [scriptViaSerial, setScriptViaSerial] = useState(false);
   const [scriptFile, setScriptFile] = useState<File | null>(null);
   const [keySequence, setKeySequence] = useState<KeyPress[]>([]);
   const [terminalShortcut, setTerminalShortcut] = useState<KeyPress[]>([]);
@@ -86,7 +90,8 @@ export function ButtonEditDialog({
 
       if (macro.type === MacroType.SCRIPT) {
         setScriptContent(macro.script || '');
-        setScriptPlatform(macro.scriptPlatform || ScriptPlatform.LINUX);
+        setScriptPlatform((macro.scriptPlatform ?? 0) & SCRIPT_PLATFORM_MASK);
+        setScriptViaSerial(((macro.scriptPlatform ?? 0) & SCRIPT_DELIVERY_CDC) !== 0);
       }
 
       if (macro.type === MacroType.MIDI_NOTE) {
@@ -151,7 +156,7 @@ export function ButtonEditDialog({
 
     if (macroType === MacroType.SCRIPT) {
       savedMacro.script = scriptContent;
-      savedMacro.scriptPlatform = scriptPlatform;
+      savedMacro.scriptPlatform = scriptPlatform | (scriptViaSerial ? SCRIPT_DELIVERY_CDC : 0);
       savedMacro.terminalShortcut = terminalShortcut;
     }
 
@@ -165,8 +170,8 @@ export function ButtonEditDialog({
       const reader = new FileReader();
       reader.onload = (event) => {
         const content = event.target?.result as string;
-        if (content.length > MAX_SCRIPT_SIZE) {
-          alert(`Script too large! Max ${MAX_SCRIPT_SIZE} bytes`);
+        if (content.length > MAX_SCRIPT_TEXT) {
+          alert(`Script too large! Max ${MAX_SCRIPT_TEXT} bytes`);
           return;
         }
         setScriptContent(content);
@@ -218,7 +223,12 @@ export function ButtonEditDialog({
             <Label htmlFor="macro-type">Macro Type</Label>
             <Select
               value={macroType.toString()}
-              onValueChange={(v) => setMacroType(parseInt(v) as MacroType)}
+              onValueChange={(v) => {
+                const type = parseInt(v) as MacroType;
+                // a value of another type is not a layer switch mode
+                if (type === MacroType.LAYER_TOGGLE && type !== macroType) setMacroValue(LAYER_SWITCH.CYCLE);
+                setMacroType(type);
+              }}
             >
               <SelectTrigger id="macro-type">
                 <SelectValue />
@@ -233,7 +243,10 @@ export function ButtonEditDialog({
                 <SelectItem value="4">Key Sequence</SelectItem>
                 <SelectItem value="5">Mouse Button</SelectItem>
                 <SelectItem value="6">Mouse Move</SelectItem>
+                <SelectItem value="13">Mouse Go To (Absolute)</SelectItem>
                 <SelectItem value="7">Mouse Scroll</SelectItem>
+                <SelectItem value="14">Media Key</SelectItem>
+                <SelectItem value="15">System Key (Sleep / Power)</SelectItem>
                 <SelectItem value="8">MIDI Note</SelectItem>
                 <SelectItem value="9">MIDI Control Change (CC)</SelectItem>
                 <SelectItem value="10">Atari Breakout (Game)</SelectItem>
@@ -254,6 +267,12 @@ export function ButtonEditDialog({
               onChannelChange={setMidiChannel}
               onCCNumberChange={setMidiCCNumber}
               onCCValueChange={setMidiCCValue}
+              gateMs={macroRepeatInterval}
+              onGateChange={setMacroRepeatInterval}
+              nrpnParam={macroRepeatCount}
+              onNrpnParamChange={setMacroRepeatCount}
+              rampMs={macroRepeatInterval}
+              onRampMsChange={setMacroRepeatInterval}
             />
           )}
 
@@ -308,18 +327,39 @@ export function ButtonEditDialog({
           {macroType === MacroType.MOUSE_MOVE && (
             <MacroFormMouse
               type="MOVE"
-              value={0}
+              value={macroValue}
               moveX={moveX}
               moveY={moveY}
               repeatCount={macroRepeatCount}
               repeatInterval={macroRepeatInterval}
               onRepeatCountChange={setMacroRepeatCount}
               onRepeatIntervalChange={setMacroRepeatInterval}
-              onValueChange={() => { }}
+              onValueChange={setMacroValue}
+              onMoveChange={(x, y) => { setMoveX(x); setMoveY(y); }}
+            />
+          )}
+
+          {macroType === MacroType.MOUSE_MOVE_ABS && (
+            <MacroFormMouse
+              type="ABS"
+              value={macroValue}
+              moveX={moveX}
+              moveY={moveY}
+              onValueChange={setMacroValue}
               onMoveChange={(x, y) => { setMoveX(x); setMoveY(y); }}
             />
           )}
 
+          {(macroType === MacroType.MEDIA_KEY || macroType === MacroType.SYSTEM_KEY) && (
+            <MacroFormMedia
+              type={macroType === MacroType.MEDIA_KEY ? 'MEDIA' : 'SYSTEM'}
+              value={macroValue}
+              repeatCount={macroRepeatCount}
+              onValueChange={setMacroValue}
+              onRepeatCountChange={setMacroRepeatCount}
+            />
+          )}
+
           {macroType === MacroType.MOUSE_WHEEL && (
             <MacroFormMouse
               type="WHEEL"
@@ -343,10 +383,12 @@ export function ButtonEditDialog({
             <MacroFormScript
               content={scriptContent}
               platform={scriptPlatform}
+              viaSerial={scriptViaSerial}
               terminalShortcut={terminalShortcut}
               file={scriptFile}
               onContentChange={setScriptContent}
               onPlatformChange={setScriptPlatform}
+              onViaSerialChange={setScriptViaSerial}
               onShortcutChange={setTerminalShortcut}
               onFileUpload={handleFileUpload}
             />
@@ -354,14 +396,48 @@ export function ButtonEditDialog({
 
           {macroType === MacroType.LAYER_TOGGLE && (
             <div className="space-y-2">
-              <Label>Layer Cycling</Label>
-              <p className="text-sm text-muted-foreground">
-                This button will cycle through layers: 1 → 2 → 3 → 4 → 1
-              </p>
-              <div className="flex items-center gap-2 p-3 rounded-md bg-muted">
-                <span className="text-2xl">🔄</span>
-                <span className="text-sm">Automatic layer rotation enabled</span>
-              </div>
+              <Label>Layer Switch</Label>
+              <Select
+                value={(macroValue & LAYER_SWITCH.MODE_MASK).toString()}
+                onValueChange={v => setMacroValue(parseInt(v) | (macroValue & LAYER_SWITCH.TARGET_MASK))}
+              >
+                <SelectTrigger>
+                  <SelectValue />
+                </SelectTrigger>
+                <SelectContent>
+                  <SelectItem value={LAYER_SWITCH.CYCLE.toString()}>Cycle to the next layer</SelectItem>
+                  <SelectItem value={LAYER_SWITCH.JUMP.toString()}>Jump to a layer</SelectItem>
+                  <SelectItem value={LAYER_SWITCH.MOMENTARY.toString()}>Hold for a layer</SelectItem>
+                </SelectContent>
+              </Select>
+
+              {(macroValue & LAYER_SWITCH.MODE_MASK) === LAYER_SWITCH.CYCLE ? (
+                <p className="text-sm text-muted-foreground">
+                  This button will cycle through layers: 1 → … → {layerCount} → 1
+                </p>
+              ) : (
+                <>
+                  <Label>Target Layer</Label>
+                  <Select
+                    value={Math.min(macroValue & LAYER_SWITCH.TARGET_MASK, layerCount - 1).toString()}
+                    onValueChange={v => setMacroValue((macroValue & LAYER_SWITCH.MODE_MASK) | parseInt(v))}
+                  >
+                    <SelectTrigger>
+                      <SelectValue />
+                    </SelectTrigger>
+                    <SelectContent>
+                      {Array.from({ length: layerCount }, (_, i) => (
+                        <SelectItem key={i} value={i.toString()}>Layer {i + 1}</SelectItem>
+                      ))}
+                    </SelectContent>
+                  </Select>
+                  <p className="text-sm text-muted-foreground">
+                    {(macroValue & LAYER_SWITCH.MODE_MASK) === LAYER_SWITCH.JUMP
+                      ? 'The target layer stays active until another layer key is used.'
+                      : 'The target layer is active only while this button is held.'}
+                  </p>
+                </>
+              )}
             </div>
           )}
 
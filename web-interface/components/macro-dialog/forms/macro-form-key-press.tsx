@@ -1,6 +1,8 @@
 import { Input } from "@/components/ui/input";
 import { Label } from "@/components/ui/label";
+import { Select, SelectContent, SelectItem, SelectTrigger, SelectValue } from "@/components/ui/select";
 import { KeycodeDialog } from "@/components/macro-dialog/keycode-dialog";
+import { decodeInterval, encodeInterval } from "@/lib/types/config.types";
 
 interface MacroFormKeyPressProps {
   value: number;
@@ -15,6 +17,8 @@ export function MacroFormKeyPress({
   value, repeatCount, repeatInterval,
   onValueChange, onRepeatCountChange, onRepeatIntervalChange
 }: MacroFormKeyPressProps) {
+  const interval = decodeInterval(repeatInterval);
+
   return (
     <div className="space-y-4">
       <div className="grid grid-cols-2 gap-4 p-3 bg-muted/20 rounded-md border">
@@ -27,12 +31,28 @@ export function MacroFormKeyPress({
           <p className="text-[10px] text-muted-foreground">Count</p>
         </div>
         <div className="space-y-2">
-          <Label>Interval (ms)</Label>
-          <Input
-            type="number" min={0} max={5000} value={repeatInterval}
-            onChange={e => onRepeatIntervalChange(parseInt(e.target.value))}
-          />
-          <p className="text-[10px] text-muted-foreground">Delay</p>
+          <Label>Interval</Label>
+          <div className="flex gap-2">
+            <Input
+              type="number" min={0} max={interval.ticks ? 384 : 5000} value={interval.amount}
+              onChange={e => onRepeatIntervalChange(encodeInterval({ ...interval, amount: parseInt(e.target.value) || 0 }))}
+            />
+            <Select
+              onValueChange={v => onRepeatIntervalChange(encodeInterval({ ticks: v === "ticks", amount: v === "ticks" ? 6 : 100 }))}
+              value={interval.ticks ? "ticks" : "ms"}
+            >
+              <SelectTrigger className="w-24">
+                <SelectValue />
+              </SelectTrigger>
+              <SelectContent>
+                <SelectItem value="ms">ms</SelectItem>
+                <SelectItem value="ticks">ticks</SelectItem>
+              </SelectContent>
+            </Select>
+          </div>
+          <p className="text-[10px] text-muted-foreground">
+            {interval.ticks ? "MIDI clock, 24 = 1 beat" : "Delay"}
+          </p>
         </div>
       </div>
       <div className="space-y-2">
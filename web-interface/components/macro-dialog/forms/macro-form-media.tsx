@@ -0,0 +1,58 @@
+import { useEffect } from "react";
+import { Input } from "@/components/ui/input";
+import { Label } from "@/components/ui/label";
+import { Select, SelectContent, SelectItem, SelectTrigger, SelectValue } from "@/components/ui/select";
+import { MEDIA_KEY_LABELS, SYSTEM_KEY_LABELS } from "@/lib/types/config.types";
+
+interface MacroFormMediaProps {
+  type: 'MEDIA' | 'SYSTEM';
+  value: number;
+  repeatCount?: number;
+  onValueChange: (val: number) => void;
+  onRepeatCountChange?: (val: number) => void;
+}
+
+export function MacroFormMedia({
+  type, value, repeatCount, onValueChange, onRepeatCountChange
+}: MacroFormMediaProps) {
+  const labels = type === 'MEDIA' ? MEDIA_KEY_LABELS : SYSTEM_KEY_LABELS;
+  const fallback = type === 'MEDIA' ? 0x00cd : 2;
+  const selected = labels[value] ? value : fallback;
+
+  // value left over from another macro type -> store the shown key
+  useEffect(() => {
+    if (selected !== value) onValueChange(selected);
+  }, [selected, value, onValueChange]);
+
+  return (
+    <div className="space-y-4">
+      <div className="space-y-2">
+        <Label>{type === 'MEDIA' ? 'Media Key' : 'System Key'}</Label>
+        <Select onValueChange={v => onValueChange(parseInt(v))} value={selected.toString()}>
+          <SelectTrigger>
+            <SelectValue />
+          </SelectTrigger>
+          <SelectContent>
+            {Object.entries(labels).map(([usage, label]) => (
+              <SelectItem key={usage} value={usage}>{label}</SelectItem>
+            ))}
+          </SelectContent>
+        </Select>
+        <p className="text-xs text-muted-foreground">
+          Sent as a single HID report, works without scripts or a terminal
+        </p>
+      </div>
+
+      {type === 'MEDIA' && (
+        <div className="space-y-2">
+          <Label>Repetitions</Label>
+          <Input
+            type="number" min={1} max={100} value={repeatCount || 1}
+            onChange={e => onRepeatCountChange?.(parseInt(e.target.value) || 1)}
+          />
+          <p className="text-[10px] text-muted-foreground">e.g. Volume Up x5</p>
+        </div>
+      )}
+    </div>
+  );
+}
@@ -1,24 +1,44 @@
 import { Input } from "../../ui/input";
 import { Label } from "../../ui/label";
+import { Select, SelectContent, SelectItem, SelectTrigger, SelectValue } from "../../ui/select";
+import {
+  decodeInterval,
+  decodeMidiCCMode,
+  encodeInterval,
+  encodeMidiCCMode,
+  MidiCCCurve,
+  MidiCCResolution,
+} from "@/lib/types/config.types";
 
 interface MacroFormMidiProps {
   type: 'NOTE' | 'CC';
   note: number;
   velocity: number;
   channel: number;
-  ccNumber: number;
+  ccNumber: number; // controller + mode bits (encodeMidiCCMode)
   ccValue: number;
   onNoteChange: (v: number) => void;
   onVelocityChange: (v: number) => void;
   onChannelChange: (v: number) => void;
   onCCNumberChange: (v: number) => void;
   onCCValueChange: (v: number) => void;
+  gateMs?: number; // NOTE: 0 = sounds while the key is held, ms or ticks (encodeInterval)
+  onGateChange?: (v: number) => void;
+  nrpnParam?: number; // CC: NRPN parameter number (repeatCount)
+  onNrpnParamChange?: (v: number) => void;
+  rampMs?: number; // CC: ramp time of the whole range (repeatInterval)
+  onRampMsChange?: (v: number) => void;
 }
 
 export function MacroFormMidi({
   type, note, velocity, channel, ccNumber, ccValue,
-  onNoteChange, onVelocityChange, onChannelChange, onCCNumberChange, onCCValueChange
+  onNoteChange, onVelocityChange, onChannelChange, onCCNumberChange, onCCValueChange,
+  gateMs, onGateChange, nrpnParam, onNrpnParamChange, rampMs, onRampMsChange
 }: MacroFormMidiProps) {
+  const gate = decodeInterval(gateMs || 0);
+  const cc = decodeMidiCCMode(ccNumber);
+  const maxValue = type === 'CC' && cc.resolution !== MidiCCResolution.BIT7 ? 16383 : 127;
+
   return (
     <div className="grid grid-cols-2 gap-4 p-3 bg-muted/20 rounded-md border">
       <div className="col-span-2 space-y-2">
@@ -35,21 +55,89 @@ export function MacroFormMidi({
           </>
         ) : (
           <>
-            <Label>Controller Number (CC#)</Label>
-            <Input
-              type="number" min={0} max={119} value={ccNumber}
-              onChange={e => onCCNumberChange(parseInt(e.target.value))}
-              placeholder="e.g. 1 (Mod Wheel), 7 (Volume)"
-            />
+            <div className="grid grid-cols-2 gap-4">
+              <div className="space-y-2">
+                <Label>Resolution</Label>
+                <Select
+                  onValueChange={v => onCCNumberChange(encodeMidiCCMode({ ...cc, resolution: parseInt(v) }))}
+                  value={cc.resolution.toString()}
+                >
+                  <SelectTrigger>
+                    <SelectValue />
+                  </SelectTrigger>
+                  <SelectContent>
+                    <SelectItem value={MidiCCResolution.BIT7.toString()}>7-bit CC</SelectItem>
+                    <SelectItem value={MidiCCResolution.BIT14.toString()}>14-bit CC (MSB + LSB)</SelectItem>
+                    <SelectItem value={MidiCCResolution.NRPN.toString()}>NRPN</SelectItem>
+                  </SelectContent>
+                </Select>
+              </div>
+              <div className="space-y-2">
+                {cc.resolution === MidiCCResolution.NRPN ? (
+                  <>
+                    <Label>Parameter (0-16383)</Label>
+                    <Input
+                      type="number" min={0} max={16383} value={nrpnParam || 0}
+                      onChange={e => onNrpnParamChange?.(parseInt(e.target.value) || 0)}
+                    />
+                  </>
+                ) : (
+                  <>
+                    <Label>Controller Number (CC#)</Label>
+                    <Input
+                      type="number" min={0} max={cc.resolution === MidiCCResolution.BIT14 ? 31 : 119}
+                      value={cc.controller}
+                      onChange={e => onCCNumberChange(encodeMidiCCMode({ ...cc, controller: parseInt(e.target.value) || 0 }))}
+                      placeholder="e.g. 1 (Mod Wheel), 7 (Volume)"
+                    />
+                  </>
+                )}
+              </div>
+            </div>
             <p className="text-[10px] text-muted-foreground">Standard: 1=Mod, 7=Vol, 10=Pan, 11=Expr</p>
+            <div className="grid grid-cols-2 gap-4">
+              <div className="space-y-2">
+                <Label>Hold to Ramp</Label>
+                <Select
+                  onValueChange={v => onCCNumberChange(encodeMidiCCMode(
+                    v === "off" ? { ...cc, ramp: false } : { ...cc, ramp: true, curve: parseInt(v) }
+                  ))}
+                  value={cc.ramp ? cc.curve.toString() : "off"}
+                >
+                  <SelectTrigger>
+                    <SelectValue />
+                  </SelectTrigger>
+                  <SelectContent>
+                    <SelectItem value="off">Off (send once)</SelectItem>
+                    <SelectItem value={MidiCCCurve.LINEAR.toString()}>Linear</SelectItem>
+                    <SelectItem value={MidiCCCurve.EXP.toString()}>Slow Start</SelectItem>
+                    <SelectItem value={MidiCCCurve.LOG.toString()}>Fast Start</SelectItem>
+                  </SelectContent>
+                </Select>
+              </div>
+              {cc.ramp && (
+                <div className="space-y-2">
+                  <Label>Full Range (ms)</Label>
+                  <Input
+                    type="number" min={0} max={32767} value={rampMs || 0}
+                    onChange={e => onRampMsChange?.(parseInt(e.target.value) || 0)}
+                  />
+                </div>
+              )}
+            </div>
+            {cc.ramp && (
+              <p className="text-[10px] text-muted-foreground">
+                Moves from the last value toward Value while the key is held, 0 ms = 1 s
+              </p>
+            )}
           </>
         )}
       </div>
 
       <div className="space-y-2">
-        <Label>{type === 'NOTE' ? 'Velocity' : 'Value'} (0-127)</Label>
+        <Label>{type === 'NOTE' ? 'Velocity' : 'Value'} (0-{maxValue})</Label>
         <Input
-          type="number" min={0} max={127}
+          type="number" min={0} max={maxValue}
           value={type === 'NOTE' ? velocity : ccValue}
           onChange={e => type === 'NOTE' ? onVelocityChange(parseInt(e.target.value)) : onCCValueChange(parseInt(e.target.value))}
         />
@@ -62,6 +150,33 @@ export function MacroFormMidi({
           onChange={e => onChannelChange(parseInt(e.target.value))}
         />
       </div>
+
+      {type === 'NOTE' && (
+        <div className="col-span-2 space-y-2">
+          <Label>Gate</Label>
+          <div className="flex gap-2">
+            <Input
+              type="number" min={0} max={gate.ticks ? 384 : 32767} value={gate.amount}
+              onChange={e => onGateChange?.(encodeInterval({ ...gate, amount: parseInt(e.target.value) || 0 }))}
+            />
+            <Select
+              onValueChange={v => onGateChange?.(encodeInterval({ ticks: v === "ticks", amount: gate.amount }))}
+              value={gate.ticks ? "ticks" : "ms"}
+            >
+              <SelectTrigger className="w-24">
+                <SelectValue />
+              </SelectTrigger>
+              <SelectContent>
+                <SelectItem value="ms">ms</SelectItem>
+                <SelectItem value="ticks">ticks</SelectItem>
+              </SelectContent>
+            </Select>
+          </div>
+          <p className="text-[10px] text-muted-foreground">
+            0 = Note plays while the key is held{gate.ticks ? ", 24 ticks = 1 beat of the MIDI clock" : ""}
+          </p>
+        </div>
+      )}
     </div>
   );
 }
@@ -2,10 +2,16 @@ import { Input } from "@/components/ui/input";
 import { Label } from "@/components/ui/label";
 import { Select, SelectContent, SelectItem, SelectTrigger, SelectValue } from "@/components/ui/select";
 import { Switch } from "@/components/ui/switch";
+import {
+  ABS_MOUSE_MAX,
+  decodeMouseMotion,
+  encodeMouseMotion,
+  MouseCurve,
+} from "@/lib/types/config.types";
 
 
 interface MacroFormMouseProps {
-  type: 'BUTTON' | 'MOVE' | 'WHEEL';
+  type: 'BUTTON' | 'MOVE' | 'ABS' | 'WHEEL';
   value: number;
   moveX: number;
   moveY: number;
@@ -26,6 +32,13 @@ export function MacroFormMouse({
 
   const MOVE_PIXELS_AFK = 20;
 
+  const motion = decodeMouseMotion(type === 'MOVE' ? value : 0);
+
+  // absolute position edited in % of the screen
+  const toPercent = (v: number) => Math.round((v * 1000) / ABS_MOUSE_MAX) / 10;
+  const fromPercent = (p: number) =>
+    Math.round((Math.max(0, Math.min(100, p)) * ABS_MOUSE_MAX) / 100);
+
   const handleAfkToggle = (checked: boolean) => {
     if (checked) {
       onRepeatCountChange?.(0);
@@ -114,6 +127,46 @@ export function MacroFormMouse({
             </div>
           </div>
 
+          <div className="grid grid-cols-3 gap-4">
+            <div className="space-y-2">
+              <Label>Curve</Label>
+              <Select
+                onValueChange={v => onValueChange(encodeMouseMotion({ ...motion, curve: parseInt(v) }))}
+                value={motion.curve.toString()}
+              >
+                <SelectTrigger>
+                  <SelectValue />
+                </SelectTrigger>
+                <SelectContent>
+                  <SelectItem value={MouseCurve.LINEAR.toString()}>Linear</SelectItem>
+                  <SelectItem value={MouseCurve.EASE_IN_OUT.toString()}>Ease In-Out</SelectItem>
+                  <SelectItem value={MouseCurve.BEZIER.toString()}>Bezier Arc</SelectItem>
+                </SelectContent>
+              </Select>
+            </div>
+            <div className="space-y-2">
+              <Label>Speed (px/ms)</Label>
+              <Input
+                type="number"
+                min={0} max={31}
+                value={motion.speed}
+                onChange={e => onValueChange(encodeMouseMotion({ ...motion, speed: parseInt(e.target.value) || 0 }))}
+              />
+              <p className="text-[10px] text-muted-foreground">0 = Default (4)</p>
+            </div>
+            <div className={`space-y-2 ${motion.curve !== MouseCurve.BEZIER ? 'opacity-50' : ''}`}>
+              <Label>Bend (%)</Label>
+              <Input
+                type="number"
+                min={-100} max={100}
+                value={motion.bend}
+                disabled={motion.curve !== MouseCurve.BEZIER}
+                onChange={e => onValueChange(encodeMouseMotion({ ...motion, bend: parseInt(e.target.value) || 0 }))}
+              />
+              <p className="text-[10px] text-muted-foreground">Arc to the side</p>
+            </div>
+          </div>
+
           <div className="grid grid-cols-2 gap-4">
             <div className={`space-y-2 ${isAfkMode ? 'opacity-80' : ''}`}>
               <Label>Repetitions</Label>
@@ -156,6 +209,47 @@ export function MacroFormMouse({
         </div>
       )}
 
+      {type === 'ABS' && (
+        <div className="space-y-4">
+          <div className="grid grid-cols-2 gap-4">
+            <div className="space-y-2">
+              <Label>X (% of screen)</Label>
+              <Input
+                type="number"
+                min={0} max={100} step={0.1}
+                value={toPercent(moveX)}
+                onChange={e => onMoveChange(fromPercent(parseFloat(e.target.value) || 0), moveY)}
+              />
+              <p className="text-[10px] text-muted-foreground">0 = Left, 100 = Right</p>
+            </div>
+            <div className="space-y-2">
+              <Label>Y (% of screen)</Label>
+              <Input
+                type="number"
+                min={0} max={100} step={0.1}
+                value={toPercent(moveY)}
+                onChange={e => onMoveChange(moveX, fromPercent(parseFloat(e.target.value) || 0))}
+              />
+              <p className="text-[10px] text-muted-foreground">0 = Top, 100 = Bottom</p>
+            </div>
+          </div>
+          <div className="space-y-2">
+            <Label>Click There</Label>
+            <Select onValueChange={v => onValueChange(parseInt(v))} value={value.toString()}>
+              <SelectTrigger>
+                <SelectValue />
+              </SelectTrigger>
+              <SelectContent>
+                <SelectItem value="0">No Click (Move Only)</SelectItem>
+                <SelectItem value="1">Left Click</SelectItem>
+                <SelectItem value="2">Right Click</SelectItem>
+                <SelectItem value="4">Middle Click</SelectItem>
+              </SelectContent>
+            </Select>
+          </div>
+        </div>
+      )}
+
       {type === 'WHEEL' && (
         <div className="space-y-2">
           <Label>Scroll Amount</Label>
@@ -1,27 +1,35 @@
+import { useMemo } from "react";
 import { KeyPress } from "@/lib/types/config.types";
-import { MAX_SCRIPT_SIZE, ScriptPlatform, ScriptPlatformLabels } from "@/lib/types/config.types";
+import { MAX_SCRIPT_SIZE, MAX_SCRIPT_TEXT, ScriptPlatform, ScriptPlatformLabels } from "@/lib/types/config.types";
+import { encodeScript } from "@/lib/utils/script-codec";
 import { Label } from "@/components/ui/label";
 import { Select, SelectContent, SelectItem, SelectTrigger, SelectValue } from "@/components/ui/select";
 import { KeySequenceInput } from "@/components/macro-dialog/key-sequence-input";
 import { Tabs, TabsContent, TabsList, TabsTrigger } from "@/components/ui/tabs";
 import { Textarea } from "@/components/ui/textarea";
 import { Input } from "@/components/ui/input";
+import { Switch } from "@/components/ui/switch";
 
 interface MacroFormScriptProps {
   content: string;
   platform: ScriptPlatform;
+  viaSerial: boolean;
   terminalShortcut: KeyPress[];
   onContentChange: (v: string) => void;
   onPlatformChange: (v: ScriptPlatform) => void;
+  onViaSerialChange: (v: boolean) => void;
   onShortcutChange: (seq: KeyPress[]) => void;
   onFileUpload: (e: React.ChangeEvent<HTMLInputElement>) => void;
   file: File | null;
 }
 
 export function MacroFormScript({
-  content, platform, terminalShortcut, file,
-  onContentChange, onPlatformChange, onShortcutChange, onFileUpload
+  content, platform, viaSerial, terminalShortcut, file,
+  onContentChange, onPlatformChange, onViaSerialChange, onShortcutChange, onFileUpload
 }: MacroFormScriptProps) {
+  // size on the device (packed), scripts are stored compressed
+  const storedSize = useMemo(() => encodeScript(content).length, [content]);
+
   return (
     <div className="space-y-4">
       <div className="space-y-2">
@@ -56,6 +64,20 @@ export function MacroFormScript({
         </div>
       )}
 
+      <div className="flex items-center justify-between p-4 bg-muted/40 rounded-lg border">
+        <div className="space-y-0.5">
+          <Label className="text-base font-semibold">Fast Delivery (USB Serial)</Label>
+          <p className="text-xs text-muted-foreground">
+            Types a short loader that reads the script from the device port. Falls back to typing
+            when the port is busy (close this page first).
+          </p>
+        </div>
+        <Switch
+          checked={viaSerial}
+          onCheckedChange={onViaSerialChange}
+        />
+      </div>
+
       <Tabs defaultValue="editor" className="w-full">
         <TabsList className="grid w-full grid-cols-2">
           <TabsTrigger value="editor">Write Code</TabsTrigger>
@@ -67,13 +89,13 @@ export function MacroFormScript({
           <Textarea
             id="script-editor"
             value={content}
-            onChange={(e) => onContentChange(e.target.value.slice(0, MAX_SCRIPT_SIZE))}
+            onChange={(e) => onContentChange(e.target.value.slice(0, MAX_SCRIPT_TEXT))}
             rows={12}
             className="font-mono text-xs"
             placeholder="#!/bin/bash&#10;echo 'Hello World'"
           />
-          <p className="text-xs text-muted-foreground">
-            {content.length} / {MAX_SCRIPT_SIZE} bytes
+          <p className={`text-xs ${storedSize >= MAX_SCRIPT_SIZE ? "text-destructive" : "text-muted-foreground"}`}>
+            {content.length} / {MAX_SCRIPT_TEXT} bytes ({storedSize} / {MAX_SCRIPT_SIZE} packed)
           </p>
         </TabsContent>
 
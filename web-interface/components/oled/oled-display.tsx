@@ -1,6 +1,6 @@
 'use client';
 
-import { LayerConfig, KeyPress, MODIFIERS } from '@/lib/types/config.types';
+import { LayerConfig, KeyPress, MODIFIERS, MEDIA_KEY_LABELS, SYSTEM_KEY_LABELS, decodeMidiCCMode, MidiCCResolution, SCRIPT_PLATFORM_MASK, SCRIPT_DELIVERY_CDC } from '@/lib/types/config.types';
 import { Card, CardContent } from '@/components/ui/card';
 import { Badge } from '@/components/ui/badge';
 import { Separator } from '@/components/ui/separator';
@@ -176,9 +176,11 @@ export function OLEDDisplay({
       case 2: // LayerToggle
         return { text: `Layer Toggle` };
       case 3: // Script
-        const platformName = macro.scriptPlatform === 0 ? 'Linux' :
-          macro.scriptPlatform === 1 ? 'Windows' : 'macOS';
-        return { text: `Script (${platformName})`, alert: null };
+        const os = (macro.scriptPlatform ?? 0) & SCRIPT_PLATFORM_MASK;
+        const platformName = os === 0 ? 'Linux' :
+          os === 1 ? 'Windows' : 'macOS';
+        const viaUsb = (macro.scriptPlatform ?? 0) & SCRIPT_DELIVERY_CDC ? ', USB' : '';
+        return { text: `Script (${platformName}${viaUsb})`, alert: null };
       case 4: // KeySequence
         return { text: `Sequence: ${formatSequence(macro.keySequence)}`, alert: null };
       case 5: // Mouse Button
@@ -189,10 +191,27 @@ export function OLEDDisplay({
         return { text: `Mouse Wheel (x${Math.abs(macro.value)})`, alert: null };
       case 8: // MIDI Note
         return { text: `Note: ${macro.midiNote}, Vel: ${macro.midiVelocity}, Ch: ${macro.midiChannel}`, alert: null };
-      case 9: // MIDI CC
-        return { text: `CC: ${macro.midiCCNumber}, Value: ${macro.midiCCValue}, Ch: ${macro.midiChannel}`, alert: null };
+      case 9: { // MIDI CC
+        const cc = decodeMidiCCMode(macro.value);
+        const kind = cc.ramp ? 'Ramp' : 'CC';
+        if (cc.resolution === MidiCCResolution.NRPN)
+          return { text: `NRPN ${kind}: ${macro.repeatCount ?? 0}, Value: ${macro.midiCCValue}, Ch: ${macro.midiChannel}`, alert: null };
+        const bits = cc.resolution === MidiCCResolution.BIT14 ? '14' : '';
+        return { text: `${kind}${bits}: ${cc.controller}, Value: ${macro.midiCCValue}, Ch: ${macro.midiChannel}`, alert: null };
+      }
       case 10: // GAME
         return { text: "Atari Breakout", alert: null };
+      case 14: // MEDIA_KEY
+        return { text: MEDIA_KEY_LABELS[macro.value] ?? 'Media Key', alert: null };
+      case 15: // SYSTEM_KEY
+        return { text: `System ${SYSTEM_KEY_LABELS[macro.value] ?? 'Key'}`, alert: null };
+      case 13: // MOUSE_MOVE_ABS
+        return {
+          text: `Go To: ${Math.round(((macro.moveX || 0) * 100) / 32767)}% ${Math.round(((macro.moveY || 0) * 100) / 32767)}%`,
+          alert: null,
+        };
+      case 12: // RECORD
+        return { text: `Record -> Btn ${macro.value}`, alert: null };
       default:
         return { text: 'Unknown Action', alert: null };
     }
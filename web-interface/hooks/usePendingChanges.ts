@@ -28,6 +28,16 @@ export function usePendingChanges(config: GlobalConfig | null) {
 
     console.log("🔍 Calculating changes...");
 
+    // liczba warstw idzie pierwsza: nowe warstwy musza istniec przed
+    // wyslaniem ich nazw i makr
+    if (config.layers.length !== originalConfig.layers.length) {
+      changes.set("setting-layers", {
+        type: "setting",
+        settingName: "layerCount",
+        value: config.layers.length,
+      });
+    }
+
     // ustawienia globalne (OLED Timeout)
     const currentTimeout = config.oledTimeout ?? 300;
     const originalTimeout = originalConfig.oledTimeout ?? 300;
@@ -47,8 +57,12 @@ export function usePendingChanges(config: GlobalConfig | null) {
     config.layers.forEach((layer, layerIdx) => {
       const origLayer = originalConfig.layers[layerIdx];
 
-      // zmiany w nazwie/emoji warstwy
-      if (layer.name !== origLayer.name || layer.emoji !== origLayer.emoji) {
+      // zmiany w nazwie/emoji warstwy (nowa warstwa wysylana w calosci)
+      if (
+        !origLayer ||
+        layer.name !== origLayer.name ||
+        layer.emoji !== origLayer.emoji
+      ) {
         const changeKey = `layer_${layerIdx}`;
         changes.set(changeKey, {
           type: "layer",
@@ -60,9 +74,10 @@ export function usePendingChanges(config: GlobalConfig | null) {
 
       // zmiany w makrach
       layer.macros.forEach((macro, buttonIdx) => {
-        const origMacro = origLayer.macros[buttonIdx];
+        const origMacro = origLayer?.macros[buttonIdx];
 
         const macroChanged =
+          !origMacro ||
           macro.type !== origMacro.type ||
           macro.value !== origMacro.value ||
           macro.macroString !== origMacro.macroString ||
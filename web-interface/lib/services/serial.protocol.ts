@@ -1,5 +1,9 @@
 import { MacroType, KeyPress } from "../types/config.types";
-import { compileKeySequence, getEmojiIndex } from "./serial.utils";
+import {
+  compileKeySequence,
+  getEmojiIndex,
+  SEQ_CHUNK_STEPS,
+} from "./serial.utils";
 
 export class SerialProtocol {
   static buildSetMacroCommand(
@@ -19,20 +23,28 @@ export class SerialProtocol {
     return `SET_MACRO|${layer}|${button}|${type}|${value}|${macroString}|${name}|${emojiIndex}|${repeatCount}|${repeatInterval}|${moveX}|${moveY}`;
   }
 
-  static buildSequenceCommand(
+  // one line per SEQ_CHUNK_STEPS steps, |offset = index of the first step
+  static buildSequenceCommands(
     layer: number,
     button: number,
     name: string,
     emoji: string,
     keySequence: KeyPress[],
-  ): string {
+  ): string[] {
     const emojiIndex = getEmojiIndex(emoji);
-    const steps = compileKeySequence(keySequence).slice(0, 3); // max 3 steps limit hardware
-    const stepsStr = steps
-      .map((s) => `${s.keycode},${s.modifiers},${s.duration || 50}`)
-      .join(",");
+    const steps = compileKeySequence(keySequence);
+    const commands: string[] = [];
 
-    return `SET_MACRO_SEQ|${layer}|${button}|${name}|${emojiIndex}|${steps.length}|${stepsStr}`;
+    for (let offset = 0; offset < steps.length; offset += SEQ_CHUNK_STEPS) {
+      const chunk = steps.slice(offset, offset + SEQ_CHUNK_STEPS);
+      const stepsStr = chunk
+        .map((s) => `${s.keycode},${s.modifiers},${s.duration || 50}`)
+        .join(",");
+      commands.push(
+        `SET_MACRO_SEQ|${layer}|${button}|${name}|${emojiIndex}|${chunk.length}|${stepsStr}|${offset}`,
+      );
+    }
+    return commands;
   }
 
   static buildLayerNameCommand(
@@ -43,4 +55,8 @@ export class SerialProtocol {
     const emojiIndex = getEmojiIndex(emoji);
     return `SET_LAYER_NAME|${layer}|${name}|${emojiIndex}`;
   }
+
+  static buildLayerCountCommand(count: number): string {
+    return `SET_LAYER_COUNT|${count}`;
+  }
 }
@@ -4,15 +4,23 @@ import {
   MacroType,
   ScriptPlatform,
   KeyPress,
+  KeyboardLayout,
+  UnicodeTiming,
+  SeqTiming,
   FIRMWARE_CONSTANTS,
+  DEFAULT_LAYER_COUNT,
   DEFAULT_LAYER_EMOJIS,
+  LayerConfig,
 } from "../types/config.types";
+import { encodeScript } from "../utils/script-codec";
 import { SerialTransport } from "./serial.transport";
 import { SerialProtocol } from "./serial.protocol";
 import {
   getEmojiString,
   compileKeySequence,
   MAX_SCRIPT_SIZE,
+  MAX_SCRIPT_TEXT,
+  PROG_CHUNK_BYTES,
 } from "./serial.utils";
 
 export class SerialService {
@@ -77,8 +85,36 @@ export class SerialService {
       try {
         if (line.startsWith("VERSION|")) {
           config.firmwareVersion = line.split("|")[1];
+        } else if (line.startsWith("MIGRATION_FAILED|")) {
+          config.unmigratedVersion = parseInt(line.split("|")[1]);
+          console.warn(
+            `⚠️ Layout v${config.unmigratedVersion} did not fit, saving replaces it`,
+          );
         } else if (line.startsWith("SETTINGS|")) {
-          config.oledTimeout = parseInt(line.split("|")[1]);
+          const parts = line.split("|");
+          config.oledTimeout = parseInt(parts[1]);
+          if (parts[2] !== undefined) {
+            config.keyboardLayout = parseInt(parts[2]);
+          }
+        } else if (line.startsWith("UNICODE_TIMING|")) {
+          const parts = line.split("|").map((p) => parseInt(p));
+          if (!config.unicodeTiming) config.unicodeTiming = [];
+          config.unicodeTiming[parts[1]] = {
+            mode: parts[2],
+            settleMs: parts[3],
+            keyMs: parts[4],
+            commitMs: parts[5],
+          };
+        } else if (line.startsWith("SEQ_TIMING|")) {
+          const parts = line.split("|").map((p) => parseInt(p));
+          if (!config.seqTiming) config.seqTiming = [];
+          config.seqTiming[parts[1]] = {
+            holdMs: parts[2],
+            gapMs: parts[3],
+            modMs: parts[4],
+          };
+        } else if (line.startsWith("LAYERS|")) {
+          this.parseLayerCount(line, config);
         } else if (line.startsWith("LAYER_NAME|")) {
           this.parseLayerName(line, config);
         } else if (line.startsWith("MACRO|")) {
@@ -90,6 +126,8 @@ export class SerialService {
           this.parseSeqStep(line, config);
         } else if (line.startsWith("SCRIPT_SHORTCUT|")) {
           this.parseScriptShortcut(line, config);
+        } else if (line.startsWith("PROG_DATA|")) {
+          this.parseProgramData(line, config);
         } else if (line.startsWith("SCRIPT_DATA|")) {
           this.parseScriptData(line, config, pendingScriptMacro);
           pendingScriptMacro = null;
@@ -126,14 +164,16 @@ export class SerialService {
       keySequence.length > 0
     ) {
       console.log(`📤 Setting Key Sequence L${layer}B${button}`);
-      const command = SerialProtocol.buildSequenceCommand(
+      const commands = SerialProtocol.buildSequenceCommands(
         layer,
         button,
         name,
         emoji,
         keySequence,
       );
-      await this.sendCommandCheckOK(command);
+      for (const command of commands) {
+        await this.sendCommandCheckOK(command);
+      }
       return;
     }
 
@@ -166,12 +206,17 @@ export class SerialService {
     name: string,
     emoji: string,
   ): Promise<void> {
-    // size validation
-    const encoder = new TextEncoder();
-    const scriptBytes = encoder.encode(scriptContent);
-    if (scriptBytes.length > MAX_SCRIPT_SIZE) {
+    // size validation, the device stores the script packed (LZSS)
+    const textLength = new TextEncoder().encode(scriptContent).length;
+    if (textLength > MAX_SCRIPT_TEXT) {
       throw new Error(
-        `Script too large (${scriptBytes.length} > ${MAX_SCRIPT_SIZE} bytes)`,
+        `Script too large (${textLength} > ${MAX_SCRIPT_TEXT} bytes)`,
+      );
+    }
+    const scriptBytes = encodeScript(scriptContent);
+    if (scriptBytes.length >= MAX_SCRIPT_SIZE) {
+      throw new Error(
+        `Script too large packed (${scriptBytes.length} >= ${MAX_SCRIPT_SIZE} bytes)`,
       );
     }
 
@@ -212,6 +257,65 @@ export class SerialService {
     console.log("✅ Script uploaded successfully");
   }
 
+  /**
+   * Uploads the bytecode of a PROGRAM macro in chunks (SET_MACRO_PROG)
+   */
+  async setMacroProgram(
+    layer: number,
+    button: number,
+    program: number[],
+  ): Promise<void> {
+    console.log(`📤 Setting Program L${layer}B${button} (${program.length} B)`);
+    for (let offset = 0; offset < program.length; offset += PROG_CHUNK_BYTES) {
+      const hex = program
+        .slice(offset, offset + PROG_CHUNK_BYTES)
+        .map((b) => b.toString(16).padStart(2, "0"))
+        .join("");
+      await this.sendCommandCheckOK(
+        `SET_MACRO_PROG|${layer}|${button}|${offset}|${hex}`,
+      );
+    }
+  }
+
+  /**
+   * Record mode: key events captured on the host are compressed into a
+   * PROGRAM macro by the firmware (REC_START / REC_KEY / REC_STOP)
+   */
+  async startRecording(layer: number, button: number): Promise<void> {
+    console.log(`⏺️ Recording into L${layer}B${button}`);
+    await this.sendCommandCheckOK(`REC_START|${layer}|${button}`);
+  }
+
+  async feedRecordedKey(
+    down: boolean,
+    keycode: number,
+    deltaMs: number,
+  ): Promise<void> {
+    await this.transport.writeLine(
+      `REC_KEY|${down ? 1 : 0}|${keycode}|${Math.max(0, Math.round(deltaMs))}`,
+    );
+    const response = await this.transport.readLine();
+    if (!response.startsWith("OK")) {
+      throw new Error(`Recording failed: ${response}`);
+    }
+  }
+
+  /**
+   * Ends the recording, returns the size of the stored program in bytes
+   */
+  async stopRecording(): Promise<number> {
+    await this.transport.writeLine("REC_STOP");
+    const response = await this.transport.readLine(5000);
+    if (!response.startsWith("OK")) {
+      throw new Error(`Recording not stored: ${response}`);
+    }
+    return parseInt(response.split("|")[1] ?? "0", 10);
+  }
+
+  async cancelRecording(): Promise<void> {
+    await this.sendCommandCheckOK("REC_CANCEL");
+  }
+
   async setLayerName(
     layer: number,
     name: string,
@@ -222,11 +326,49 @@ export class SerialService {
     await this.sendCommandCheckOK(command);
   }
 
+  /**
+   * Adds empty layers or drops the last ones, sent before the layer contents
+   */
+  async setLayerCount(count: number): Promise<void> {
+    if (count < 1 || count > FIRMWARE_CONSTANTS.MAX_LAYERS) {
+      throw new Error(
+        `Layer count must be 1-${FIRMWARE_CONSTANTS.MAX_LAYERS}, got ${count}`,
+      );
+    }
+    console.log(`📤 Setting layer count: ${count}`);
+    await this.sendCommandCheckOK(SerialProtocol.buildLayerCountCommand(count));
+  }
+
   async setOledTimeout(seconds: number): Promise<void> {
     console.log(`📤 Setting OLED timeout: ${seconds}s`);
     await this.sendCommandCheckOK(`SET_OLED_TIMEOUT|${seconds}`);
   }
 
+  async setKeyboardLayout(layout: KeyboardLayout): Promise<void> {
+    console.log(`📤 Setting keyboard layout: ${KeyboardLayout[layout]}`);
+    await this.sendCommandCheckOK(`SET_KB_LAYOUT|${layout}`);
+  }
+
+  async setUnicodeTiming(
+    platform: ScriptPlatform,
+    timing: UnicodeTiming,
+  ): Promise<void> {
+    console.log(`📤 Setting unicode timing: ${ScriptPlatform[platform]}`);
+    await this.sendCommandCheckOK(
+      `SET_UNICODE_TIMING|${platform}|${timing.mode}|${timing.settleMs}|${timing.keyMs}|${timing.commitMs}`,
+    );
+  }
+
+  async setSeqTiming(
+    platform: ScriptPlatform,
+    timing: SeqTiming,
+  ): Promise<void> {
+    console.log(`📤 Setting sequence timing: ${ScriptPlatform[platform]}`);
+    await this.sendCommandCheckOK(
+      `SET_SEQ_TIMING|${platform}|${timing.holdMs}|${timing.gapMs}|${timing.modMs}`,
+    );
+  }
+
   async saveFlash(): Promise<void> {
     console.log("📤 Saving to Flash...");
     await this.transport.flush();
@@ -306,24 +448,44 @@ export class SerialService {
     throw lastError || new Error("Command failed after retries");
   }
 
-  private createEmptyConfig(): GlobalConfig {
+  private createEmptyLayer(i: number): LayerConfig {
     return {
-      layers: Array.from({ length: FIRMWARE_CONSTANTS.MAX_LAYERS }, (_, i) => ({
-        name: `Layer ${i + 1}`,
-        emoji: getEmojiString(DEFAULT_LAYER_EMOJIS[i] ?? 0),
-        macros: Array.from({ length: FIRMWARE_CONSTANTS.NUM_BUTTONS }, () => ({
-          type: MacroType.KEY_PRESS,
-          value: 0,
-          macroString: "",
-          name: "Empty",
-          emoji: "",
-        })),
+      name: `Layer ${i + 1}`,
+      emoji: getEmojiString(
+        DEFAULT_LAYER_EMOJIS[i % DEFAULT_LAYER_EMOJIS.length],
+      ),
+      macros: Array.from({ length: FIRMWARE_CONSTANTS.NUM_BUTTONS }, () => ({
+        type: MacroType.KEY_PRESS,
+        value: 0,
+        macroString: "",
+        name: "Empty",
+        emoji: "",
       })),
+    };
+  }
+
+  private createEmptyConfig(): GlobalConfig {
+    return {
+      layers: Array.from({ length: DEFAULT_LAYER_COUNT }, (_, i) =>
+        this.createEmptyLayer(i),
+      ),
       oledTimeout: 300,
       firmwareVersion: "unknown",
     };
   }
 
+  // LAYERS|count|max, comes before the layer names and macros
+  private parseLayerCount(line: string, config: GlobalConfig) {
+    const count = parseInt(line.split("|")[1]);
+    if (isNaN(count) || count < 1 || count > FIRMWARE_CONSTANTS.MAX_LAYERS) {
+      return;
+    }
+    config.layers = Array.from(
+      { length: count },
+      (_, i) => config.layers[i] ?? this.createEmptyLayer(i),
+    );
+  }
+
   private parseLayerName(line: string, config: GlobalConfig) {
     const parts = line.split("|");
     const layerIdx = parseInt(parts[1]);
@@ -429,6 +591,18 @@ export class SerialService {
     });
   }
 
+  private parseProgramData(line: string, config: GlobalConfig) {
+    // PROG_DATA|layer|button|offset|hex
+    const parts = line.split("|");
+    const macro = config.layers[parseInt(parts[1])].macros[parseInt(parts[2])];
+    const offset = parseInt(parts[3]);
+
+    if (!macro.program || offset === 0) macro.program = [];
+    for (let i = 0; i + 1 < parts[4].length; i += 2) {
+      macro.program.push(parseInt(parts[4].substring(i, i + 2), 16));
+    }
+  }
+
   private parseScriptData(
     line: string,
     config: GlobalConfig,
@@ -25,6 +25,13 @@ export const EMOJI_STRINGS = [
 ];
 
 export const MAX_SCRIPT_SIZE = 2048;
+export const MAX_SCRIPT_TEXT = 8192;
+
+// bytes of bytecode per SET_MACRO_PROG line (same as PROG_DATA)
+export const PROG_CHUNK_BYTES = 64;
+
+// key steps per SET_MACRO_SEQ line (the firmware reads 256 byte lines)
+export const SEQ_CHUNK_STEPS = 12;
 
 export function compileKeySequence(sequence: KeyPress[]): KeyPress[] {
   const compiledSteps: KeyPress[] = [];
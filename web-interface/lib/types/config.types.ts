@@ -14,6 +14,11 @@ export enum MacroType {
   MIDI_NOTE = 8,
   MIDI_CC = 9,
   GAME = 10,
+  PROGRAM = 11,
+  RECORD = 12,
+  MOUSE_MOVE_ABS = 13,
+  MEDIA_KEY = 14,
+  SYSTEM_KEY = 15,
 }
 
 export type ConnectionStatus =
@@ -28,12 +33,154 @@ export enum ScriptPlatform {
   MACOS = 2,
 }
 
+// scriptPlatform: platform in bits 0-3, delivery flags above
+export const SCRIPT_PLATFORM_MASK = 0x0f;
+export const SCRIPT_DELIVERY_CDC = 0x10; // bootstrap reads the script from the serial port
+
 export const ScriptPlatformLabels: Record<ScriptPlatform, string> = {
   [ScriptPlatform.LINUX]: "Linux (bash)",
   [ScriptPlatform.WINDOWS]: "Windows (batch/PowerShell)",
   [ScriptPlatform.MACOS]: "macOS (bash/zsh)",
 };
 
+// host keyboard layout used by the firmware for typing text
+export enum KeyboardLayout {
+  US = 0,
+  DE = 1,
+  PL = 2,
+  FR = 3,
+  UK = 4,
+  DVORAK = 5,
+}
+
+export const KeyboardLayoutLabels: Record<KeyboardLayout, string> = {
+  [KeyboardLayout.US]: "English (US)",
+  [KeyboardLayout.DE]: "German (QWERTZ)",
+  [KeyboardLayout.PL]: "Polish (programmer's)",
+  [KeyboardLayout.FR]: "French (AZERTY)",
+  [KeyboardLayout.UK]: "English (UK)",
+  [KeyboardLayout.DVORAK]: "Dvorak (US)",
+};
+
+// TEXT_STRING value: flag | layout overrides the device layout for one macro
+export const TEXT_LAYOUT_OVERRIDE_FLAG = 0x0100;
+
+// MEDIA_KEY value: Consumer Control usage (HID report ID 4)
+export const MEDIA_KEY_LABELS: Record<number, string> = {
+  0x00cd: "Play / Pause",
+  0x00b5: "Next Track",
+  0x00b6: "Previous Track",
+  0x00b7: "Stop",
+  0x00e2: "Mute",
+  0x00e9: "Volume Up",
+  0x00ea: "Volume Down",
+  0x006f: "Brightness Up",
+  0x0070: "Brightness Down",
+};
+
+// SYSTEM_KEY value: System Control code (HID report ID 5)
+export const SYSTEM_KEY_LABELS: Record<number, string> = {
+  1: "Power Down",
+  2: "Sleep",
+  3: "Wake Up",
+};
+
+// MOUSE_MOVE_ABS: moveX / moveY in 0..ABS_MOUSE_MAX of the screen,
+// value = buttons clicked there (0 = move only)
+export const ABS_MOUSE_MAX = 32767;
+
+// MOUSE_MOVE value: bits 0-2 curve, bits 3-7 speed in px per report
+// (0 = default), bits 8-15 Bezier bend in % of the distance (int8)
+export enum MouseCurve {
+  LINEAR = 0,
+  EASE_IN_OUT = 1,
+  BEZIER = 2,
+}
+
+export interface MouseMotion {
+  curve: MouseCurve;
+  speed: number; // px per 1 ms report, 0 = firmware default (4)
+  bend: number; // -100..100, Bezier only
+}
+
+export function encodeMouseMotion(motion: MouseMotion): number {
+  const speed = Math.max(0, Math.min(31, Math.round(motion.speed)));
+  const bend = Math.max(-100, Math.min(100, Math.round(motion.bend)));
+  return (motion.curve & 0x07) | (speed << 3) | ((bend & 0xff) << 8);
+}
+
+export function decodeMouseMotion(value: number): MouseMotion {
+  const curve = value & 0x07;
+  const bend = (value >> 8) & 0xff;
+  return {
+    curve: curve <= MouseCurve.BEZIER ? curve : MouseCurve.LINEAR,
+    speed: (value >> 3) & 0x1f,
+    bend: bend >= 0x80 ? bend - 0x100 : bend,
+  };
+}
+
+// repeat interval / MIDI gate: bit 15 set = MIDI clock ticks (24 per beat),
+// follows the tempo of the DAW (firmware: MIDI_INTERVAL_TICKS)
+export const INTERVAL_TICKS_FLAG = 0x8000;
+export const TICKS_PER_BEAT = 24;
+
+export interface MacroInterval {
+  ticks: boolean;
+  amount: number; // ms or ticks
+}
+
+export function encodeInterval(interval: MacroInterval): number {
+  const amount = Math.max(0, Math.min(0x7fff, Math.round(interval.amount)));
+  return interval.ticks ? INTERVAL_TICKS_FLAG | amount : amount;
+}
+
+export function decodeInterval(value: number): MacroInterval {
+  return { ticks: (value & INTERVAL_TICKS_FLAG) !== 0, amount: value & 0x7fff };
+}
+
+// MIDI_CC value: bits 0-6 controller, 8-9 resolution, 10-11 ramp curve,
+// bit 12 ramp while held (firmware: midi_cc.h)
+export enum MidiCCResolution {
+  BIT7 = 0,
+  BIT14 = 1, // controller 0-31 + LSB on controller + 32
+  NRPN = 2, // parameter number in repeatCount
+}
+
+export enum MidiCCCurve {
+  LINEAR = 0,
+  EXP = 1,
+  LOG = 2,
+}
+
+export const MIDI_CC_RAMP = 1 << 12;
+
+export interface MidiCCMode {
+  controller: number;
+  resolution: MidiCCResolution;
+  curve: MidiCCCurve;
+  ramp: boolean;
+}
+
+export function encodeMidiCCMode(mode: MidiCCMode): number {
+  return (mode.controller & 0x7f) | ((mode.resolution & 0x03) << 8) |
+    ((mode.curve & 0x03) << 10) | (mode.ramp ? MIDI_CC_RAMP : 0);
+}
+
+export function decodeMidiCCMode(value: number): MidiCCMode {
+  return {
+    controller: value & 0x7f,
+    resolution: (value >> 8) & 0x03,
+    curve: (value >> 10) & 0x03,
+    ramp: (value & MIDI_CC_RAMP) !== 0,
+  };
+}
+
+// unicode input method per host (index = ScriptPlatform)
+export enum UnicodeMode {
+  DEFAULT = 0, // Ctrl+Shift+U / hex + Alt+X / Ctrl+Cmd+Space
+  HEX_INPUT = 1, // macOS "Unicode Hex Input" source (Option + hex)
+}
+
 // ==================== INTERFACES ====================
 
 export interface KeyPress {
@@ -61,6 +208,21 @@ export interface MacroEntry {
   midiChannel?: number; // 1-16
   midiCCNumber?: number;
   midiCCValue?: number;
+  program?: number[]; // bytecode MACRO_TYPE_PROGRAM (macro_vm.h)
+}
+
+export interface UnicodeTiming {
+  mode: UnicodeMode;
+  settleMs: number; // czas na otwarcie IME
+  keyMs: number; // przerwa po kazdym raporcie hex (0 = tempo USB)
+  commitMs: number; // przerwa po zatwierdzeniu znaku
+}
+
+// profil czasow sekwencji klawiszy (index = ScriptPlatform, 0 = tempo USB)
+export interface SeqTiming {
+  holdMs: number; // klawisz wcisniety
+  gapMs: number; // przerwa po puszczeniu klawisza
+  modMs: number; // przerwa po zmianie modyfikatorow
 }
 
 export interface LayerConfig {
@@ -72,7 +234,11 @@ export interface LayerConfig {
 export interface GlobalConfig {
   layers: LayerConfig[];
   oledTimeout: number;
+  keyboardLayout?: KeyboardLayout;
+  unicodeTiming?: UnicodeTiming[];
+  seqTiming?: SeqTiming[];
   firmwareVersion?: string;
+  unmigratedVersion?: number; // stary uklad we flash, ktory nie zmiescil sie
 }
 
 export interface ConnectionError {
@@ -86,18 +252,30 @@ export interface ConnectionError {
 
 // ==================== CONSTANTS ====================
 
-export const DEFAULT_LAYER_EMOJIS = [0, 1, 2, 7];
+export const DEFAULT_LAYER_EMOJIS = [0, 1, 2, 7]; // repeated on later layers
+export const DEFAULT_LAYER_COUNT = 4;
 export const DEFAULT_BUTTON_EMOJI = 0;
 export const LAYER_SWITCH_EMOJI = 4;
-export const MAX_SCRIPT_SIZE = 2048; // 2KB
+export const MAX_SCRIPT_SIZE = 2048; // 2KB as stored (packed)
+export const MAX_SCRIPT_TEXT = 8192; // 8KB of text once packed
 
 export const FIRMWARE_CONSTANTS = {
-  MAX_LAYERS: 4,
+  MAX_LAYERS: 32, // upper limit, the device reports its count (LAYERS|n|max)
   NUM_BUTTONS: 7,
   MAX_NAME_LEN: 16,
   MACRO_STRING_LEN: 32,
   MAX_EMOJI_LEN: 8,
   MAX_SCRIPT_SIZE: 2048, // 2KB
+  MAX_SCRIPT_TEXT: 8192, // 8KB
+} as const;
+
+// LAYER_TOGGLE value: mode in the high byte, target layer in the low byte
+export const LAYER_SWITCH = {
+  TARGET_MASK: 0x00ff,
+  MODE_MASK: 0xff00,
+  CYCLE: 0x0000, // next layer, wraps after the last one
+  JUMP: 0x0100, // straight to the target layer
+  MOMENTARY: 0x0200, // target layer while the button is held
 } as const;
 
 export const MODIFIERS = {
@@ -187,10 +365,12 @@ export function createEmptyMacro(): MacroEntry {
   };
 }
 
-export function createLayerSwitchMacro(targetLayer: number): MacroEntry {
+export function createLayerSwitchMacro(
+  value: number = LAYER_SWITCH.CYCLE,
+): MacroEntry {
   return {
     type: MacroType.LAYER_TOGGLE,
-    value: targetLayer,
+    value,
     macroString: "",
     name: "LayerSwitch",
     emoji: getEmojiString(LAYER_SWITCH_EMOJI),
@@ -200,15 +380,15 @@ export function createLayerSwitchMacro(targetLayer: number): MacroEntry {
 export function createDefaultLayer(index: number): LayerConfig {
   return {
     name: `Layer ${index + 1}`,
-    emoji: getEmojiString(DEFAULT_LAYER_EMOJIS[index] ?? 0),
+    emoji: getEmojiString(
+      DEFAULT_LAYER_EMOJIS[index % DEFAULT_LAYER_EMOJIS.length],
+    ),
     macros: Array.from(
       { length: FIRMWARE_CONSTANTS.NUM_BUTTONS },
       (_, btnIdx) => {
         // BTN7 (index 6) = Layer Switch
         if (btnIdx === 6) {
-          return createLayerSwitchMacro(
-            (index + 1) % FIRMWARE_CONSTANTS.MAX_LAYERS,
-          );
+          return createLayerSwitchMacro();
         }
         return createEmptyMacro();
       },
@@ -218,7 +398,7 @@ export function createDefaultLayer(index: number): LayerConfig {
 
 export function createDefaultConfig(): GlobalConfig {
   return {
-    layers: Array.from({ length: FIRMWARE_CONSTANTS.MAX_LAYERS }, (_, i) =>
+    layers: Array.from({ length: DEFAULT_LAYER_COUNT }, (_, i) =>
       createDefaultLayer(i),
     ),
     oledTimeout: 300,
@@ -233,7 +413,9 @@ export function isMacroType(value: unknown): value is MacroType {
     value === MacroType.TEXT_STRING ||
     value === MacroType.LAYER_TOGGLE ||
     value === MacroType.SCRIPT ||
-    value === MacroType.GAME
+    value === MacroType.GAME ||
+    value === MacroType.PROGRAM ||
+    value === MacroType.RECORD
   );
 }
 
@@ -268,6 +450,16 @@ export function formatMacroType(type: MacroType): string {
       return "Script Execution";
     case MacroType.GAME:
       return "Breakout Game";
+    case MacroType.PROGRAM:
+      return "Program";
+    case MacroType.RECORD:
+      return "Record Macro";
+    case MacroType.MOUSE_MOVE_ABS:
+      return "Mouse Go To";
+    case MacroType.MEDIA_KEY:
+      return "Media Key";
+    case MacroType.SYSTEM_KEY:
+      return "System Key";
     default:
       return "Unknown";
   }
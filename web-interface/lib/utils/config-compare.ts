@@ -73,5 +73,8 @@ export function cloneConfig(config: GlobalConfig): GlobalConfig {
       macros: layer.macros.map((macro) => ({ ...macro })),
     })),
     oledTimeout: config.oledTimeout,
+    keyboardLayout: config.keyboardLayout,
+    unicodeTiming: config.unicodeTiming?.map((timing) => ({ ...timing })),
+    seqTiming: config.seqTiming?.map((timing) => ({ ...timing })),
   };
 }
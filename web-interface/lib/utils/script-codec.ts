@@ -0,0 +1,97 @@
+// Packed scripts (firmware: include/script_codec.h)
+//   0xFF, text length (u16 LE), stream length (u16 LE), LZSS stream
+// Flag byte per 8 items (LSB first, 1 = literal), a match is two bytes:
+//   b0 = (distance - 1) & 0xFF, b1 = (distance - 1) >> 8 << 6 | (length - 3)
+
+export const SCRIPT_PACKED_MAGIC = 0xff;
+const HEADER = 5;
+const WINDOW = 1024;
+const MIN_MATCH = 3;
+const MAX_MATCH = 66;
+const MAX_CHAIN = 64; // candidates checked per position
+
+const HASH_BITS = 12;
+
+function hash3(data: Uint8Array, pos: number): number {
+  return (
+    ((data[pos] << 8) ^ (data[pos + 1] << 4) ^ data[pos + 2]) &
+    ((1 << HASH_BITS) - 1)
+  );
+}
+
+/**
+ * Packs script text (UTF-8 bytes) for the device, greedy longest match over
+ * hash chains of the last WINDOW bytes
+ */
+export function packScript(text: Uint8Array): Uint8Array {
+  const out: number[] = [SCRIPT_PACKED_MAGIC, 0, 0, 0, 0];
+  const head = new Int32Array(1 << HASH_BITS).fill(-1);
+  const prev = new Int32Array(text.length).fill(-1);
+
+  const insert = (pos: number) => {
+    if (pos + MIN_MATCH > text.length) return;
+    const h = hash3(text, pos);
+    prev[pos] = head[h];
+    head[h] = pos;
+  };
+
+  let pos = 0;
+  while (pos < text.length) {
+    const flagsAt = out.length;
+    out.push(0);
+    let flags = 0;
+
+    for (let bit = 0; bit < 8 && pos < text.length; bit++) {
+      let best = 0;
+      let bestDist = 0;
+
+      if (pos + MIN_MATCH <= text.length) {
+        let cand = head[hash3(text, pos)];
+        for (let n = 0; cand >= 0 && pos - cand <= WINDOW && n < MAX_CHAIN; n++) {
+          let len = 0;
+          while (
+            len < MAX_MATCH &&
+            pos + len < text.length &&
+            text[cand + len] === text[pos + len]
+          )
+            len++;
+          if (len > best) {
+            best = len;
+            bestDist = pos - cand;
+          }
+          cand = prev[cand];
+        }
+      }
+
+      if (best >= MIN_MATCH) {
+        out.push((bestDist - 1) & 0xff, (((bestDist - 1) >> 8) << 6) | (best - MIN_MATCH));
+        for (let i = 0; i < best; i++) insert(pos + i);
+        pos += best;
+      } else {
+        flags |= 1 << bit;
+        out.push(text[pos]);
+        insert(pos);
+        pos++;
+      }
+    }
+    out[flagsAt] = flags;
+  }
+
+  const streamLen = out.length - HEADER;
+  out[1] = text.length & 0xff;
+  out[2] = text.length >> 8;
+  out[3] = streamLen & 0xff;
+  out[4] = streamLen >> 8;
+  return Uint8Array.from(out);
+}
+
+/**
+ * Bytes a script takes on the device: packed if that is smaller, plain text
+ * otherwise
+ */
+export function encodeScript(content: string): Uint8Array {
+  const text = new TextEncoder().encode(content);
+  if (text.length === 0) return text;
+  const packed = packScript(text);
+  return packed.length < text.length ? packed : text;
+}